@@ -334,6 +334,8 @@ make DESTDIR=%{buildroot} install
 
 %files plugin-file
 %{_libdir}/%{name}-plugins/libgfal_plugin_file.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_file.manifest
+%config(noreplace) %{_sysconfdir}/%{name}.d/file_plugin.conf
 %{_pkgdocdir}/README_PLUGIN_FILE
 
 %if %{?fedora}%{!?fedora:0} <= 30 || %{?rhel}%{!?rhel:0} <= 7
@@ -355,31 +357,37 @@ make DESTDIR=%{buildroot} install
 
 %files plugin-srm
 %{_libdir}/%{name}-plugins/libgfal_plugin_srm.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_srm.manifest
 %{_pkgdocdir}/README_PLUGIN_SRM
 %config(noreplace) %{_sysconfdir}/%{name}.d/srm_plugin.conf
 
 %files plugin-gridftp
 %{_libdir}/%{name}-plugins/libgfal_plugin_gridftp.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_gridftp.manifest
 %{_pkgdocdir}/README_PLUGIN_GRIDFTP
 %config(noreplace) %{_sysconfdir}/%{name}.d/gsiftp_plugin.conf
 
 %files plugin-http
 %{_libdir}/%{name}-plugins/libgfal_plugin_http.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_http.manifest
 %{_pkgdocdir}/README_PLUGIN_HTTP
 %config(noreplace) %{_sysconfdir}/%{name}.d/http_plugin.conf
 
 %files plugin-xrootd
 %{_libdir}/%{name}-plugins/libgfal_plugin_xrootd.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_xrootd.manifest
 %{_pkgdocdir}/README_PLUGIN_XROOTD
 %config(noreplace) %{_sysconfdir}/%{name}.d/xrootd_plugin.conf
 
 %files plugin-sftp
 %{_libdir}/%{name}-plugins/libgfal_plugin_sftp.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_sftp.manifest
 %{_pkgdocdir}/README_PLUGIN_SFTP
 %config(noreplace) %{_sysconfdir}/%{name}.d/sftp_plugin.conf
 
 %files plugin-mock
 %{_libdir}/%{name}-plugins/libgfal_plugin_mock.so*
+%{_libdir}/%{name}-plugins/gfal_plugin_mock.manifest
 %{_pkgdocdir}/README_PLUGIN_MOCK
 %config(noreplace) %{_sysconfdir}/%{name}.d/mock_plugin.conf
 
@@ -18,8 +18,6 @@
  * limitations under the License.
  */
 
-#include <unistd.h>
-
 #include <common/gfal_cancel.h>
 #include <common/gfal_plugin.h>
 #include "gfal_handle.h"
@@ -31,29 +29,79 @@
 //
 
 
+struct gfal_operation_s {
+    gfal2_context_t context;
+    volatile gint running_ops;
+    volatile gboolean cancel;
+};
+
+
+// Operation the calling thread works for, if any
+static GPrivate *current_operation;
+
+// Operations counted by the cancel scopes open in the calling thread, innermost first
+// so each scope ends on the operation it started on, even if another one was attached since
+static GPrivate *scope_operations;
+
+static void free_scope_operations(gpointer scopes)
+{
+    g_slist_free(scopes);
+}
+
+__attribute__((constructor))
+static void init_current_operation()
+{
+    current_operation = g_private_new(NULL);
+    scope_operations = g_private_new(free_scope_operations);
+}
+
+
+// The operation of the calling thread, if it belongs to the given context
+static gfal_operation_t gfal_current_operation(gfal2_context_t context)
+{
+    gfal_operation_t op = g_private_get(current_operation);
+    if (op && op->context == context)
+        return op;
+    return NULL;
+}
+
+
+// Wake up gfal2_cancel and gfal2_operation_cancel when the last operation they wait for ends
+// Waiters take the mutex before checking the counters, so the signal can not be lost
+static void gfal_cancel_notify(gfal2_context_t context)
+{
+    g_mutex_lock(context->mux_cancel);
+    g_cond_broadcast(context->cond_cancel);
+    g_mutex_unlock(context->mux_cancel);
+}
+
+
 int gfal2_cancel(gfal2_context_t context)
 {
     if (!context)
         return -1;
-    else if (context->cancel == TRUE) // avoid recursive calls
+    else if (g_atomic_int_get(&context->cancel) == TRUE) // avoid recursive calls
         return 0;
 
     g_mutex_lock(context->mux_cancel);
     const int n_cancel = g_atomic_int_get(&(context->running_ops));
-    context->cancel = TRUE;
+    g_atomic_int_set(&context->cancel, TRUE);
     g_hook_list_invoke(&context->cancel_hooks, TRUE);
-    g_mutex_unlock(context->mux_cancel);
     while ((g_atomic_int_get(&(context->running_ops))) > 0) {
-        usleep(50);
+        g_cond_wait(context->cond_cancel, context->mux_cancel);
     }
-    context->cancel = FALSE;
+    g_atomic_int_set(&context->cancel, FALSE);
+    g_mutex_unlock(context->mux_cancel);
     return n_cancel;
 }
 
 
 gboolean gfal2_is_canceled(gfal2_context_t context)
 {
-    return context->cancel;
+    if (g_atomic_int_get(&context->cancel))
+        return TRUE;
+    gfal_operation_t op = gfal_current_operation(context);
+    return op != NULL && g_atomic_int_get(&op->cancel);
 }
 
 
@@ -61,31 +109,119 @@ gboolean gfal2_is_canceled(gfal2_context_t context)
 // Return negative value if task is canceled
 int gfal2_start_scope_cancel(gfal2_context_t context, GError** err)
 {
-    if (context && context->cancel) {
+    if (context && gfal2_is_canceled(context)) {
         g_set_error(err, gfal_cancel_quark(), ECANCELED,
                 "[gfal2_cancel] operation canceled by user");
         return -1;
     }
     g_atomic_int_inc(&(context->running_ops));
+    gfal_operation_t op = gfal_current_operation(context);
+    if (op)
+        g_atomic_int_inc(&op->running_ops);
+    g_private_set(scope_operations, g_slist_prepend(g_private_get(scope_operations), op));
     return 0;
 }
 
 
 int gfal2_end_scope_cancel(gfal2_context_t context)
 {
-    if (context)
-        (void) g_atomic_int_dec_and_test(&(context->running_ops));
+    if (context) {
+        gboolean last = FALSE;
+        gfal_operation_t op = NULL;
+        GSList* scopes = g_private_get(scope_operations);
+        if (scopes) {
+            op = scopes->data;
+            g_private_set(scope_operations, g_slist_delete_link(scopes, scopes));
+        }
+        if (op && g_atomic_int_dec_and_test(&op->running_ops))
+            last = g_atomic_int_get(&op->cancel);
+        if (g_atomic_int_dec_and_test(&(context->running_ops)))
+            last = last || g_atomic_int_get(&context->cancel);
+        // only a cancellation waits for the counters to drop to zero
+        if (last)
+            gfal_cancel_notify(context);
+    }
     return 0;
 }
 
 
+gfal_operation_t gfal2_operation_new(gfal2_context_t context)
+{
+    g_assert(context);
+    gfal_operation_t op = g_new0(struct gfal_operation_s, 1);
+    op->context = context;
+    return op;
+}
+
+
+void gfal2_operation_free(gfal_operation_t op)
+{
+    if (op && g_private_get(current_operation) == op)
+        g_private_set(current_operation, NULL);
+    g_free(op);
+}
+
+
+gfal_operation_t gfal2_operation_attach(gfal_operation_t op)
+{
+    gfal_operation_t previous = g_private_get(current_operation);
+    g_private_set(current_operation, op);
+    return previous;
+}
+
+
+gfal_operation_t gfal2_operation_get_attached(void)
+{
+    return g_private_get(current_operation);
+}
+
+
 struct gfal_hook_data_s {
     void* userdata;
     gfal2_context_t context;
     gfal_cancel_hook_cb cb;
+    // operation of the thread that registered the hook
+    gfal_operation_t op;
 };
 
 
+// Only the hooks registered on behalf of the operation are triggered
+static void gfal_ghook_operation_marshaller(GHook *hook, gpointer data)
+{
+    struct gfal_hook_data_s* d = hook->data;
+    if (d->op == data)
+        d->cb(d->context, d->userdata);
+}
+
+
+int gfal2_operation_cancel(gfal_operation_t op)
+{
+    if (!op)
+        return -1;
+    gfal2_context_t context = op->context;
+
+    g_mutex_lock(context->mux_cancel);
+    if (g_atomic_int_get(&op->cancel) == TRUE) {
+        g_mutex_unlock(context->mux_cancel);
+        return 0;
+    }
+    const int n_cancel = g_atomic_int_get(&op->running_ops);
+    g_atomic_int_set(&op->cancel, TRUE);
+    g_hook_list_marshal(&context->cancel_hooks, TRUE, gfal_ghook_operation_marshaller, op);
+    while (g_atomic_int_get(&op->running_ops) > 0) {
+        g_cond_wait(context->cond_cancel, context->mux_cancel);
+    }
+    g_mutex_unlock(context->mux_cancel);
+    return n_cancel;
+}
+
+
+gboolean gfal2_operation_is_canceled(gfal_operation_t op)
+{
+    return g_atomic_int_get(&op->cancel);
+}
+
+
 static void gfal_ghook_cancel_wrapper(gpointer data)
 {
     struct gfal_hook_data_s* d = data;
@@ -103,6 +239,7 @@ gfal_cancel_token_t gfal2_register_cancel_callback(gfal2_context_t context,
     d->context = context;
     d->userdata = userdata;
     d->cb = cb;
+    d->op = gfal_current_operation(context);
     h->data = d;
     h->destroy = &g_free;
     h->func = &gfal_ghook_cancel_wrapper;
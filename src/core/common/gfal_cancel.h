@@ -37,6 +37,7 @@ extern "C"
 
 typedef struct gfal_cancel_token_s* gfal_cancel_token_t;
 typedef void (*gfal_cancel_hook_cb)(gfal2_context_t context, void* userdata);
+typedef struct gfal_operation_s* gfal_operation_t;
 
 /**
  * @brief cancel operation
@@ -52,15 +53,61 @@ int gfal2_cancel(gfal2_context_t context);
 
 /**
  * @brief cancel status
- * @return true if \ref gfal2_cancel has been called
+ * @return true if \ref gfal2_cancel has been called, or if the operation attached
+ *         to the calling thread has been canceled with \ref gfal2_operation_cancel
  *
  * @param context
  * @return true if success
  */
 gboolean gfal2_is_canceled(gfal2_context_t context);
 
+/**
+ * Create a cancellation token for a single operation (i.e. a transfer) of the context,
+ * so it can be canceled without stopping the others.
+ * The token applies to what the threads it is attached to do on the context,
+ * see \ref gfal2_operation_attach
+ */
+gfal_operation_t gfal2_operation_new(gfal2_context_t context);
+
+/**
+ * Release the token. It must not be attached to any thread anymore.
+ */
+void gfal2_operation_free(gfal_operation_t op);
+
+/**
+ * Attach the token to the calling thread: the operations it starts from now on belong to op.
+ * NULL detaches the current one.
+ * @return the token attached before, so it can be restored
+ */
+gfal_operation_t gfal2_operation_attach(gfal_operation_t op);
+
+/**
+ * @return the token attached to the calling thread, or NULL.
+ * The threads started on behalf of the caller attach it as well, so canceling it stops them
+ */
+gfal_operation_t gfal2_operation_get_attached(void);
+
+/**
+ * @brief cancel an operation
+ *
+ * Cancel the operations running on behalf of op, and trigger the cancel hooks
+ * registered by them, blocking until they finish.
+ * Unlike \ref gfal2_cancel, the token remains canceled, and the next operations
+ * started on its behalf fail with ECANCELED.
+ * Thread safe
+ * @return number of operations canceled
+ */
+int gfal2_operation_cancel(gfal_operation_t op);
+
+/**
+ * @return true if \ref gfal2_operation_cancel has been called for op
+ */
+gboolean gfal2_operation_is_canceled(gfal_operation_t op);
+
 /**
  * Register a cancel hook, called in each cancellation
+ * If the calling thread has an operation attached, it is called as well when the operation
+ * alone is canceled.
  * Thread-safe
  */
 gfal_cancel_token_t gfal2_register_cancel_callback(gfal2_context_t context,
@@ -74,11 +121,13 @@ void gfal2_remove_cancel_callback(gfal2_context_t context, gfal_cancel_token_t t
 
 /**
  * Mark the beginning of a cancellable scope
+ * The scope counts for the operation attached to the calling thread, if any
  */
 int gfal2_start_scope_cancel(gfal2_context_t context, GError** err);
 
 /**
- * Mark the end of a cancellable scope
+ * Mark the end of the last cancellable scope begun by the calling thread,
+ * for the operation it began on
  */
 int gfal2_end_scope_cancel(gfal2_context_t context);
 
@@ -20,12 +20,15 @@
 
 #include <glib.h>
 #include <common/gfal_config_internal.h>
+#include <common/gfal_cred_mapping_internal.h>
 #include <logger/gfal_logger.h>
 #include <stdio.h>
 #include <string.h>
 #include <common/gfal_plugin.h>
+#include <common/gfal_plugin_internal.h>
 #include <gfal_api.h>
 #include "gfal_file_handler_container.h"
+#include <file/gfal_stat_cache_internal.h>
 
 // initialization
 __attribute__((constructor))
@@ -135,30 +138,82 @@ gfal2_context_t gfal2_context_new(GError **err)
         return NULL;
     }
     context->initiated = TRUE;
-    context->config = gfal2_init_config(&tmp_err);
-    if (!context->config) {
+    const gfal_registry *registry = gfal_registry_get(&tmp_err);
+    if (!registry) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
         g_free(context);
         return NULL;
     }
+    context->config = gfal2_config_dup(registry->config);
+    gfal_config_snapshot_init(context);
     gfal_initCredentialLocation(context);
     context->plugin_opt.plugin_number = 0;
+    pthread_mutex_init(&context->plugin_opt.instance_lock, NULL);
+    gfal_plugin_dispatch_cache_init(context);
     int ret = gfal_plugins_instance(context, &tmp_err);
     if (ret <= 0 && tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        gfal_plugin_dispatch_cache_destroy(context);
+        pthread_mutex_destroy(&context->plugin_opt.instance_lock);
+        gfal_config_snapshot_destroy(context);
         g_key_file_free(context->config);
         g_free(context);
         return NULL;
     }
     context->client_info = g_ptr_array_new();
+    gfal_cred_mapping_init(context);
     context->mux_cancel = g_mutex_new();
+    context->cond_cancel = g_cond_new();
     g_hook_list_init(&context->cancel_hooks, sizeof(GHook));
     context->fdescs = gfal_file_descriptor_handle_create(NULL);
+    gfal_stat_cache_init(context);
 
     G_RETURN_ERR(context, tmp_err, err);
 }
 
 
+gfal2_context_t gfal2_context_clone(gfal2_context_t parent, GError **err)
+{
+    g_return_val_err_if_fail(parent != NULL, NULL, err, "[gfal2_context_clone] Invalid context");
+    GError *tmp_err = NULL;
+    guint i;
+    gfal2_context_t context = g_new0(struct gfal_handle_, 1);
+    context->initiated = TRUE;
+    context->config = gfal2_config_dup(parent->config);
+    gfal_config_snapshot_init(context);
+    context->plugin_opt.plugin_number = 0;
+    pthread_mutex_init(&context->plugin_opt.instance_lock, NULL);
+    gfal_plugin_dispatch_cache_init(context);
+    if (gfal_plugins_clone(context, parent, &tmp_err) != 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        g_list_free(context->plugin_opt.sorted_plugin);
+        gfal_plugin_dispatch_cache_destroy(context);
+        pthread_mutex_destroy(&context->plugin_opt.instance_lock);
+        gfal_config_snapshot_destroy(context);
+        g_key_file_free(context->config);
+        g_free(context);
+        return NULL;
+    }
+    context->client_info = g_ptr_array_new();
+    for (i = 0; i < parent->client_info->len; ++i) {
+        const char *key, *value;
+        gfal2_get_client_info_pair(parent, i, &key, &value, NULL);
+        gfal2_add_client_info(context, key, value, NULL);
+    }
+    context->agent_name = g_strdup(parent->agent_name);
+    context->agent_version = g_strdup(parent->agent_version);
+    gfal_cred_mapping_init(context);
+    gfal2_cred_copy(context, parent, NULL);
+    context->mux_cancel = g_mutex_new();
+    context->cond_cancel = g_cond_new();
+    g_hook_list_init(&context->cancel_hooks, sizeof(GHook));
+    context->fdescs = gfal_file_descriptor_handle_create(NULL);
+    gfal_stat_cache_init(context);
+
+    return context;
+}
+
+
 void gfal2_context_free(gfal2_context_t context)
 {
     if (context == NULL) {
@@ -168,14 +223,19 @@ void gfal2_context_free(gfal2_context_t context)
 
     gfal_plugins_delete(context, NULL);
     gfal_file_descriptor_handle_destroy(context->fdescs);
+    gfal_stat_cache_destroy(context);
+    gfal_config_snapshot_destroy(context);
     g_key_file_free(context->config);
     g_list_free(context->plugin_opt.sorted_plugin);
+    gfal_plugin_dispatch_cache_destroy(context);
+    pthread_mutex_destroy(&context->plugin_opt.instance_lock);
     g_mutex_free(context->mux_cancel);
+    g_cond_free(context->cond_cancel);
     g_hook_list_clear(&context->cancel_hooks);
     g_free(context->agent_name);
     g_free(context->agent_version);
     g_ptr_array_foreach(context->client_info, gfal_free_keyvalue, NULL);
-    gfal2_cred_clean(context, NULL);
+    gfal_cred_mapping_destroy(context);
     g_free(context);
 }
 
@@ -186,7 +246,7 @@ gchar **gfal2_get_plugin_names(gfal2_context_t context)
     int i;
 
     for (i = 0; i < context->plugin_opt.plugin_number; ++i) {
-        array[i] = g_strdup(context->plugin_opt.plugin_list[i].getName());
+        array[i] = g_strdup(gfal_plugin_get_name(context, &context->plugin_opt.plugin_list[i]));
     }
     array[i] = NULL;
 
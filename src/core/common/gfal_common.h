@@ -53,6 +53,23 @@ typedef struct gfal_handle_* gfal2_context_t;
  */
 gfal2_context_t gfal2_context_new(GError ** err);
 
+/**
+ * @brief Create a gfal2 context from an existing one
+ *
+ * The new context starts with a copy of the parameters, credentials and client information
+ * of parent, but has its own file descriptors and plugin instances. The configuration files
+ * and the plugin libraries are only loaded once per process, and the plugins of the
+ * new context are instantiated the first time they are needed, so this is much cheaper than
+ * \ref gfal2_context_new.
+ *
+ * Plugins registered on parent with gfal2_register_plugin are shared, and must outlive the clone.
+ *
+ * @param parent : context to copy
+ * @param err : GError error report system
+ * @return a context if success, NULL if error
+ */
+gfal2_context_t gfal2_context_clone(gfal2_context_t parent, GError ** err);
+
 /**
  *  Free a gfal2 context
  *  It is safe to delete a NULL context
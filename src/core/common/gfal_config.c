@@ -21,6 +21,7 @@
 #include "gfal_handle.h"
 #include <gfal_api.h>
 #include <string.h>
+#include <common/gfal_config_internal.h>
 
 #ifndef GFAL_CONFIG_DIR_DEFAULT
 #error "GFAL_CONFIG_DIR_DEFAULT should be define at compile time"
@@ -76,33 +77,25 @@ static gchar *check_configuration_dir(GError **err)
 }
 
 
-int gfal_load_configuration_to_conf_manager(GKeyFile *dest,
-    const gchar *path, GError **err)
+// copy all the key/values of src into dest, overriding the existing ones
+static void gfal_config_merge(GKeyFile *dest, GKeyFile *src)
 {
-    GError *tmp_err = NULL;
-    GKeyFile *new_conf = g_key_file_new();
     int groupIndex, keyIndex;
 
-    if (g_key_file_load_from_file(new_conf, path, G_KEY_FILE_NONE, &tmp_err) == FALSE) {
-        gfal2_propagate_prefixed_error_extended(err, tmp_err, __func__,
-            "Error while loading configuration file %s: ", path);
-        return -1;
-    }
-
     gsize nGroups = 0;
-    gchar **groups = g_key_file_get_groups(new_conf, &nGroups);
+    gchar **groups = g_key_file_get_groups(src, &nGroups);
     for (groupIndex = 0; groupIndex < nGroups; ++groupIndex) {
         gsize nKeys = 0;
         GError *tmp_err = NULL;
 
-        gchar **keys = g_key_file_get_keys(new_conf, groups[groupIndex], &nKeys, &tmp_err);
+        gchar **keys = g_key_file_get_keys(src, groups[groupIndex], &nKeys, &tmp_err);
         if (keys == NULL) {
             g_clear_error(&tmp_err);
             continue;
         }
 
         for (keyIndex = 0; keyIndex < nKeys; ++keyIndex) {
-            gchar *value = g_key_file_get_value(new_conf, groups[groupIndex], keys[keyIndex], &tmp_err);
+            gchar *value = g_key_file_get_value(src, groups[groupIndex], keys[keyIndex], &tmp_err);
             if (value == NULL) {
                 g_clear_error(&tmp_err);
                 continue;
@@ -115,6 +108,22 @@ int gfal_load_configuration_to_conf_manager(GKeyFile *dest,
     }
 
     g_strfreev(groups);
+}
+
+
+int gfal_load_configuration_to_conf_manager(GKeyFile *dest,
+    const gchar *path, GError **err)
+{
+    GError *tmp_err = NULL;
+    GKeyFile *new_conf = g_key_file_new();
+
+    if (g_key_file_load_from_file(new_conf, path, G_KEY_FILE_NONE, &tmp_err) == FALSE) {
+        gfal2_propagate_prefixed_error_extended(err, tmp_err, __func__,
+            "Error while loading configuration file %s: ", path);
+        return -1;
+    }
+
+    gfal_config_merge(dest, new_conf);
     g_key_file_free(new_conf);
     return 0;
 }
@@ -170,6 +179,227 @@ GKeyFile* gfal2_init_config(GError **err)
 }
 
 
+GKeyFile* gfal2_config_dup(GKeyFile *config)
+{
+    GKeyFile *res = g_key_file_new();
+    gfal_config_merge(res, config);
+    return res;
+}
+
+
+typedef enum {
+    GFAL_OPT_STRING = 's',
+    GFAL_OPT_INTEGER = 'i',
+    GFAL_OPT_BOOLEAN = 'b',
+    GFAL_OPT_STRING_LIST = 'l'
+} gfal_opt_type;
+
+// Typed option, parsed once per configuration generation
+// found is FALSE when the key is missing or can not be parsed, so the default applies
+typedef struct _gfal_opt_value {
+    gboolean found;
+    union {
+        gchar *string;
+        gint integer;
+        gboolean boolean;
+        gchar **list;
+    } v;
+    gsize length;
+    gfal_opt_type type;
+} gfal_opt_value;
+
+
+static void gfal_opt_value_clear(gfal_opt_value *value)
+{
+    if (value->type == GFAL_OPT_STRING)
+        g_free(value->v.string);
+    else if (value->type == GFAL_OPT_STRING_LIST)
+        g_strfreev(value->v.list);
+}
+
+
+static void gfal_opt_value_free(gpointer data)
+{
+    gfal_opt_value_clear((gfal_opt_value*)data);
+    g_free(data);
+}
+
+
+// the copy returned by gfal_config_snapshot_lookup belongs to the caller
+static void gfal_opt_value_copy(gfal_opt_value *dest, const gfal_opt_value *src)
+{
+    *dest = *src;
+    if (src->type == GFAL_OPT_STRING)
+        dest->v.string = g_strdup(src->v.string);
+    else if (src->type == GFAL_OPT_STRING_LIST)
+        dest->v.list = g_strdupv(src->v.list);
+}
+
+
+// Options are indexed by type, group and key
+typedef struct _gfal_opt_id {
+    gfal_opt_type type;
+    const gchar *group_name;
+    const gchar *key;
+} gfal_opt_id;
+
+
+static guint gfal_opt_id_hash(gconstpointer v)
+{
+    const gfal_opt_id *id = (const gfal_opt_id*)v;
+    return (g_str_hash(id->group_name) * 31 + g_str_hash(id->key)) * 31 + id->type;
+}
+
+
+static gboolean gfal_opt_id_equal(gconstpointer a, gconstpointer b)
+{
+    const gfal_opt_id *id_a = (const gfal_opt_id*)a, *id_b = (const gfal_opt_id*)b;
+    return id_a->type == id_b->type &&
+        strcmp(id_a->key, id_b->key) == 0 &&
+        strcmp(id_a->group_name, id_b->group_name) == 0;
+}
+
+
+// Stored ids own their strings, the ones used for the lookups do not
+static gfal_opt_id *gfal_opt_id_dup(const gfal_opt_id *id)
+{
+    gfal_opt_id *copy = g_new(gfal_opt_id, 1);
+    copy->type = id->type;
+    copy->group_name = g_strdup(id->group_name);
+    copy->key = g_strdup(id->key);
+    return copy;
+}
+
+
+static void gfal_opt_id_free(gpointer data)
+{
+    gfal_opt_id *id = (gfal_opt_id*)data;
+    g_free((gchar*)id->group_name);
+    g_free((gchar*)id->key);
+    g_free(id);
+}
+
+
+void gfal_config_snapshot_init(gfal2_context_t context)
+{
+    context->config_snapshot.values = g_hash_table_new_full(gfal_opt_id_hash, gfal_opt_id_equal,
+        gfal_opt_id_free, gfal_opt_value_free);
+    context->config_snapshot.generation = g_atomic_int_get(&context->config_generation);
+    pthread_rwlock_init(&context->config_snapshot.lock, NULL);
+}
+
+
+void gfal_config_snapshot_destroy(gfal2_context_t context)
+{
+    g_hash_table_destroy(context->config_snapshot.values);
+    pthread_rwlock_destroy(&context->config_snapshot.lock);
+}
+
+
+// Any change invalidates the values parsed so far
+static void gfal_config_changed(gfal2_context_t context)
+{
+    g_atomic_int_inc(&context->config_generation);
+}
+
+
+// Setting a key to the value it already has is not a change
+// (i.e. the srm plugin disables STAT_ON_OPEN for every castor open)
+static void gfal_config_set_done(gfal2_context_t context, const gchar *group_name,
+    const gchar *key, gchar *previous)
+{
+    gchar *current = g_key_file_get_value(context->config, group_name, key, NULL);
+    if (g_strcmp0(previous, current) != 0)
+        gfal_config_changed(context);
+    g_free(current);
+    g_free(previous);
+}
+
+
+// Copy into value the option parsed for the current generation, if any
+static gboolean gfal_config_snapshot_lookup(gfal2_context_t context, const gfal_opt_id *id,
+    gfal_opt_value *value)
+{
+    gboolean hit = FALSE;
+    gfal_config_snapshot *snapshot = &context->config_snapshot;
+
+    pthread_rwlock_rdlock(&snapshot->lock);
+    if (snapshot->generation == g_atomic_int_get(&context->config_generation)) {
+        gfal_opt_value *cached = g_hash_table_lookup(snapshot->values, id);
+        if (cached) {
+            gfal_opt_value_copy(value, cached);
+            hit = TRUE;
+        }
+    }
+    pthread_rwlock_unlock(&snapshot->lock);
+    return hit;
+}
+
+
+// Keep a copy of value, parsed from the configuration as it was at the given generation
+static void gfal_config_snapshot_store(gfal2_context_t context, const gfal_opt_id *id,
+    gint generation, const gfal_opt_value *value)
+{
+    gfal_config_snapshot *snapshot = &context->config_snapshot;
+
+    pthread_rwlock_wrlock(&snapshot->lock);
+    if (snapshot->generation != generation) {
+        g_hash_table_remove_all(snapshot->values);
+        snapshot->generation = generation;
+    }
+    // the configuration changed meanwhile, so value may be stale already
+    if (generation == g_atomic_int_get(&context->config_generation)) {
+        gfal_opt_value *copy = g_new(gfal_opt_value, 1);
+        gfal_opt_value_copy(copy, value);
+        g_hash_table_replace(snapshot->values, gfal_opt_id_dup(id), copy);
+    }
+    pthread_rwlock_unlock(&snapshot->lock);
+}
+
+
+// Parse the option, or get it from the snapshot if it has been parsed already
+// Returns TRUE if the value comes from the snapshot. Otherwise, tmp_err is set if the
+// key is missing or invalid
+static gboolean gfal_config_get_typed(gfal2_context_t context, gfal_opt_type type,
+    const gchar *group_name, const gchar *key, gfal_opt_value *value, GError **tmp_err)
+{
+    gfal_opt_id id = {type, group_name, key};
+
+    if (gfal_config_snapshot_lookup(context, &id, value))
+        return TRUE;
+
+    gint generation = g_atomic_int_get(&context->config_generation);
+    memset(value, 0, sizeof(*value));
+    value->type = type;
+    switch (type) {
+        case GFAL_OPT_STRING:
+            value->v.string = g_key_file_get_string(context->config, group_name, key, tmp_err);
+            break;
+        case GFAL_OPT_INTEGER:
+            value->v.integer = g_key_file_get_integer(context->config, group_name, key, tmp_err);
+            break;
+        case GFAL_OPT_BOOLEAN:
+            value->v.boolean = g_key_file_get_boolean(context->config, group_name, key, tmp_err);
+            break;
+        case GFAL_OPT_STRING_LIST:
+            value->v.list = g_key_file_get_string_list(context->config, group_name, key,
+                &value->length, tmp_err);
+            break;
+    }
+    value->found = (*tmp_err == NULL);
+
+    gfal_config_snapshot_store(context, &id, generation, value);
+    return FALSE;
+}
+
+
+gint gfal2_get_opt_generation(gfal2_context_t context)
+{
+    g_assert(context != NULL);
+    return g_atomic_int_get(&context->config_generation);
+}
+
+
 gchar *gfal2_get_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
@@ -183,16 +413,21 @@ gchar *gfal2_get_opt_string_with_default(gfal2_context_t handle,
 {
     g_assert(handle != NULL);
     GError *tmp_err = NULL;
+    gfal_opt_value value;
 
-    gchar *value = gfal2_get_opt_string(handle, group_name, key, &tmp_err);
+    // missing keys are only logged the first time
+    gfal_config_get_typed(handle, GFAL_OPT_STRING, group_name, key, &value, &tmp_err);
     if (tmp_err) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
                 "Impossible to get string parameter %s:%s, set to default value %s, err %s",
                 group_name, key, default_value, tmp_err->message);
         g_clear_error(&tmp_err);
-        value = g_strdup(default_value);
     }
-    return value;
+    if (!value.found) {
+        g_free(value.v.string);
+        return g_strdup(default_value);
+    }
+    return value.v.string;
 }
 
 
@@ -200,7 +435,9 @@ gint gfal2_set_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, const gchar *value, GError **error)
 {
     g_assert(context != NULL);
+    gchar *previous = g_key_file_get_value(context->config, group_name, key, NULL);
     g_key_file_set_string(context->config, group_name, key, value);
+    gfal_config_set_done(context, group_name, key, previous);
     return 0;
 }
 
@@ -216,17 +453,18 @@ gint gfal2_get_opt_integer(gfal2_context_t context, const gchar *group_name,
 gint gfal2_get_opt_integer_with_default(gfal2_context_t context,
     const gchar *group_name, const gchar *key, gint default_value)
 {
+    g_assert(context != NULL);
     GError *tmp_err = NULL;
+    gfal_opt_value value;
 
-    gint res = gfal2_get_opt_integer(context, group_name, key, &tmp_err);
+    gfal_config_get_typed(context, GFAL_OPT_INTEGER, group_name, key, &value, &tmp_err);
     if (tmp_err) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
             "Impossible to get integer parameter %s:%s, set to default value %d, err %s",
             group_name, key, default_value, tmp_err->message);
         g_clear_error(&tmp_err);
-        res = default_value;
     }
-    return res;
+    return value.found ? value.v.integer : default_value;
 }
 
 
@@ -234,7 +472,9 @@ gint gfal2_set_opt_integer(gfal2_context_t context, const gchar *group_name,
     const gchar *key, gint value, GError **error)
 {
     g_assert(context != NULL);
+    gchar *previous = g_key_file_get_value(context->config, group_name, key, NULL);
     g_key_file_set_integer(context->config, group_name, key, value);
+    gfal_config_set_done(context, group_name, key, previous);
     return 0;
 }
 
@@ -250,18 +490,19 @@ gboolean gfal2_get_opt_boolean(gfal2_context_t context, const gchar *group_name,
 gboolean gfal2_get_opt_boolean_with_default(gfal2_context_t context,
     const gchar *group_name, const gchar *key, gboolean default_value)
 {
+    g_assert(context != NULL);
     GError *tmp_err = NULL;
+    gfal_opt_value value;
 
-    gboolean res = gfal2_get_opt_boolean(context, group_name, key, &tmp_err);
+    gfal_config_get_typed(context, GFAL_OPT_BOOLEAN, group_name, key, &value, &tmp_err);
     if (tmp_err) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
             "Impossible to get boolean parameter %s:%s, set to default value %s, err %s",
             group_name, key, ((default_value) ? "TRUE" : "FALSE"),
             tmp_err->message);
         g_clear_error(&tmp_err);
-        res = default_value;
     }
-    return res;
+    return value.found ? value.v.boolean : default_value;
 }
 
 
@@ -269,7 +510,9 @@ gint gfal2_set_opt_boolean(gfal2_context_t context, const gchar *group_name,
     const gchar *key, gboolean value, GError **error)
 {
     g_assert(context != NULL);
+    gchar *previous = g_key_file_get_value(context->config, group_name, key, NULL);
     g_key_file_set_boolean(context->config, group_name, key, value);
+    gfal_config_set_done(context, group_name, key, previous);
     return 0;
 }
 
@@ -288,7 +531,9 @@ gint gfal2_set_opt_string_list(gfal2_context_t context, const gchar *group_name,
     GError **error)
 {
     g_assert(context != NULL);
+    gchar *previous = g_key_file_get_value(context->config, group_name, key, NULL);
     g_key_file_set_string_list(context->config, group_name, key, list, length);
+    gfal_config_set_done(context, group_name, key, previous);
     return 0;
 }
 
@@ -297,10 +542,11 @@ gchar **gfal2_get_opt_string_list_with_default(gfal2_context_t context,
     const gchar *group_name, const gchar *key, gsize *length,
     char **default_value)
 {
+    g_assert(context != NULL);
     GError *tmp_err = NULL;
+    gfal_opt_value value;
 
-    gchar **res = gfal2_get_opt_string_list(context, group_name, key, length, &tmp_err);
-
+    gfal_config_get_typed(context, GFAL_OPT_STRING_LIST, group_name, key, &value, &tmp_err);
     if (tmp_err) {
         if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) {
             gchar *list_default = default_value ? g_strjoinv(",", default_value) : NULL;
@@ -310,16 +556,23 @@ gchar **gfal2_get_opt_string_list_with_default(gfal2_context_t context,
             g_free(list_default);
         }
         g_clear_error(&tmp_err);
-        res = g_strdupv(default_value);
     }
-    return res;
+    if (length)
+        *length = value.length;
+    if (!value.found) {
+        g_strfreev(value.v.list);
+        return g_strdupv(default_value);
+    }
+    return value.v.list;
 }
 
 
 gint gfal2_load_opts_from_file(gfal2_context_t context, const char *path,
     GError **error)
 {
-    return gfal_load_configuration_to_conf_manager(context->config, path, error);
+    int ret = gfal_load_configuration_to_conf_manager(context->config, path, error);
+    gfal_config_changed(context);
+    return ret;
 }
 
 
@@ -332,7 +585,9 @@ gchar **gfal2_get_opt_keys(gfal2_context_t context, const gchar *group_name, gsi
 gboolean gfal2_remove_opt(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
-    return g_key_file_remove_key(context->config, group_name, key, error);
+    gboolean removed = g_key_file_remove_key(context->config, group_name, key, error);
+    gfal_config_changed(context);
+    return removed;
 }
 
 
@@ -36,6 +36,28 @@ extern "C"
 #define CORE_CONFIG_GROUP "CORE"
 #define CORE_CONFIG_CHECKSUM_TIMEOUT "CHECKSUM_TIMEOUT"
 #define CORE_CONFIG_NAMESPACE_TIMEOUT "NAMESPACE_TIMEOUT"
+#define CORE_CONFIG_ASYNC_THREADS "ASYNC_THREADS"
+#define CORE_CONFIG_READ_AHEAD "READ_AHEAD"
+#define CORE_CONFIG_READ_AHEAD_BLOCK_SIZE "READ_AHEAD_BLOCK_SIZE"
+#define CORE_CONFIG_READ_AHEAD_BLOCKS "READ_AHEAD_BLOCKS"
+#define CORE_CONFIG_WRITE_BEHIND "WRITE_BEHIND"
+#define CORE_CONFIG_WRITE_BEHIND_BUFFER_SIZE "WRITE_BEHIND_BUFFER_SIZE"
+#define CORE_CONFIG_WRITE_BEHIND_BUFFERS "WRITE_BEHIND_BUFFERS"
+#define CORE_CONFIG_COPY_PIPELINE "COPY_PIPELINE"
+#define CORE_CONFIG_COPY_PIPELINE_BUFFERS "COPY_PIPELINE_BUFFERS"
+#define CORE_CONFIG_COPY_PARALLEL_STREAMS "COPY_PARALLEL_STREAMS"
+#define CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE "COPY_PARALLEL_CHUNK_SIZE"
+#define CORE_CONFIG_COPY_CHECKSUM_ON_THE_FLY "COPY_CHECKSUM_ON_THE_FLY"
+#define CORE_CONFIG_COPY_BULK_CONCURRENCY "COPY_BULK_CONCURRENCY"
+#define CORE_CONFIG_COPY_BULK_CONCURRENCY_PER_HOST "COPY_BULK_CONCURRENCY_PER_HOST"
+#define CORE_CONFIG_CHECKSUM_CACHE "CHECKSUM_CACHE"
+#define CORE_CONFIG_CHECKSUM_CACHE_FILE "CHECKSUM_CACHE_FILE"
+#define CORE_CONFIG_CHECKSUM_CACHE_ENTRIES "CHECKSUM_CACHE_ENTRIES"
+#define CORE_CONFIG_CHECKSUM_CACHE_COARSE_TTL "CHECKSUM_CACHE_COARSE_TTL"
+#define CORE_CONFIG_STAT_CACHE "STAT_CACHE"
+#define CORE_CONFIG_STAT_CACHE_TTL "STAT_CACHE_TTL"
+#define CORE_CONFIG_STAT_CACHE_NEGATIVE_TTL "STAT_CACHE_NEGATIVE_TTL"
+#define CORE_CONFIG_STAT_CACHE_ENTRIES "STAT_CACHE_ENTRIES"
 
 
 /**
@@ -232,6 +254,15 @@ gchar ** gfal2_get_opt_string_list(gfal2_context_t context, const gchar *group_n
 gchar ** gfal2_get_opt_string_list_with_default(gfal2_context_t context, const gchar *group_name,
                                           const gchar *key, gsize *length, char** default_value);
 
+/**
+ * Generation of the configuration of the context
+ * It changes every time a parameter is set, removed or loaded from a file, so plugins can keep
+ * the values they derive from the configuration, and read them again only when it changes.
+ * @param context : context of gfal2
+ * @return current generation
+ */
+gint gfal2_get_opt_generation(gfal2_context_t context);
+
 /**
  * @brief load configuration parameters from the file specified by path
  */
@@ -23,10 +23,21 @@
 #define GFAL_CONFIG_INTERNAL_H_
 
 #include <glib.h>
+#include <common/gfal_common.h>
 
 // create or delete configuration manager for gfal2, internal
 GKeyFile* gfal2_init_config(GError **err);
 
+// merge the content of a key file into dest
+int gfal_load_configuration_to_conf_manager(GKeyFile *dest, const gchar *path, GError **err);
+
+// deep copy of a configuration
+GKeyFile* gfal2_config_dup(GKeyFile *config);
+
+// typed cache of the options of a context
+void gfal_config_snapshot_init(gfal2_context_t context);
+void gfal_config_snapshot_destroy(gfal2_context_t context);
+
 void gfal_free_keyvalue(gpointer data, gpointer user_data);
 
 #endif /* GFAL_CONFIG_INTERNAL_H_ */
@@ -15,47 +15,344 @@
  */
 
 #include <gfal_api.h>
+#include <stddef.h>
 #include <string.h>
 #include "gfal_handle.h"
+#include "gfal_cred_mapping_internal.h"
 
 
+// Immutable value, shared between the trie and the callers of gfal2_cred_lookup
+// The value and the url prefix are stored in the same block, right after the header
 typedef struct {
-    size_t prefix_len;
-    char *url_prefix;
-    gfal2_cred_t *cred;
-} gfal2_cred_node_t ;
+    volatile gint refcount;
+    const char *url_prefix;
+    char value[];
+} gfal_cred_value;
 
 
-static gint node_compare(gconstpointer a, gconstpointer b)
+// Credential of a given type registered for the prefix of a node
+typedef struct gfal_cred_entry {
+    struct gfal_cred_entry *next;
+    gfal2_cred_t cred;
+    gfal_cred_value *shared;
+} gfal_cred_entry;
+
+
+// Radix trie node. The url prefix of a node is the concatenation
+// of the labels from the root. Children are sorted by the first byte of their label.
+struct gfal_cred_trie_node {
+    char *label;
+    size_t label_len;
+    struct gfal_cred_trie_node **children;
+    guint n_children;
+    // sorted by type
+    gfal_cred_entry *entries;
+};
+
+
+static gfal_cred_value *cred_value_new(const char *value, const char *url_prefix)
+{
+    size_t value_len = strlen(value) + 1;
+    size_t prefix_len = strlen(url_prefix) + 1;
+    gfal_cred_value *shared = g_malloc(sizeof(gfal_cred_value) + value_len + prefix_len);
+    shared->refcount = 1;
+    memcpy(shared->value, value, value_len);
+    memcpy(shared->value + value_len, url_prefix, prefix_len);
+    shared->url_prefix = shared->value + value_len;
+    return shared;
+}
+
+
+static gfal_cred_value *cred_value_ref(gfal_cred_value *shared)
+{
+    g_atomic_int_inc(&shared->refcount);
+    return shared;
+}
+
+
+static void cred_value_unref(gfal_cred_value *shared)
 {
-    const gfal2_cred_node_t *node_a, *node_b;
-    node_a = a;
-    node_b = b;
-    int comp = -strcmp(node_a->url_prefix, node_b->url_prefix);
-    if (comp == 0) {
-        return strcmp(node_a->cred->type, node_b->cred->type);
+    if (g_atomic_int_dec_and_test(&shared->refcount)) {
+        g_free(shared);
     }
-    return comp;
 }
 
 
-static void node_copy(gpointer src, gpointer user_data)
+static gfal_cred_entry *cred_entry_new(const char *type, gfal_cred_value *shared)
+{
+    gfal_cred_entry *entry = g_new0(gfal_cred_entry, 1);
+    entry->cred.type = g_strdup(type);
+    entry->cred.value = shared->value;
+    entry->shared = shared;
+    return entry;
+}
+
+
+static void cred_entry_free(gfal_cred_entry *entry)
 {
-    gfal2_context_t dest = user_data;
-    const gfal2_cred_node_t *node = src;
-    gfal2_cred_set(dest, node->url_prefix, node->cred, NULL);
+    g_free(entry->cred.type);
+    cred_value_unref(entry->shared);
+    g_free(entry);
 }
 
 
-static void node_free(gpointer ptr)
+static void trie_node_free(struct gfal_cred_trie_node *node)
 {
-    gfal2_cred_node_t *node = ptr;
-    g_free(node->url_prefix);
-    gfal2_cred_free(node->cred);
+    guint i;
+    if (node == NULL) {
+        return;
+    }
+    for (i = 0; i < node->n_children; ++i) {
+        trie_node_free(node->children[i]);
+    }
+    while (node->entries) {
+        gfal_cred_entry *next = node->entries->next;
+        cred_entry_free(node->entries);
+        node->entries = next;
+    }
+    g_free(node->children);
+    g_free(node->label);
     g_free(node);
 }
 
 
+static struct gfal_cred_trie_node *trie_node_new(const char *label, size_t label_len)
+{
+    struct gfal_cred_trie_node *node = g_new0(struct gfal_cred_trie_node, 1);
+    node->label = g_strndup(label, label_len);
+    node->label_len = label_len;
+    return node;
+}
+
+
+// Binary search of the child starting with c
+// Returns its index, or the position where it should be inserted if there is none
+static guint trie_child_index(const struct gfal_cred_trie_node *node, unsigned char c, gboolean *found)
+{
+    guint low = 0, high = node->n_children;
+    while (low < high) {
+        guint mid = (low + high) / 2;
+        unsigned char first = (unsigned char)node->children[mid]->label[0];
+        if (first == c) {
+            *found = TRUE;
+            return mid;
+        }
+        else if (first < c) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    *found = FALSE;
+    return low;
+}
+
+
+static void trie_child_insert(struct gfal_cred_trie_node *node, guint index, struct gfal_cred_trie_node *child)
+{
+    node->children = g_renew(struct gfal_cred_trie_node*, node->children, node->n_children + 1);
+    memmove(node->children + index + 1, node->children + index,
+        (node->n_children - index) * sizeof(struct gfal_cred_trie_node*));
+    node->children[index] = child;
+    ++node->n_children;
+}
+
+
+static void trie_child_remove(struct gfal_cred_trie_node *node, guint index)
+{
+    memmove(node->children + index, node->children + index + 1,
+        (node->n_children - index - 1) * sizeof(struct gfal_cred_trie_node*));
+    --node->n_children;
+}
+
+
+// Return the node for the given prefix, splitting the edges as needed
+static struct gfal_cred_trie_node *trie_node_lookup_or_create(struct gfal_cred_trie_node *node, const char *prefix)
+{
+    while (*prefix != '\0') {
+        gboolean found;
+        guint index = trie_child_index(node, (unsigned char)*prefix, &found);
+        if (!found) {
+            struct gfal_cred_trie_node *child = trie_node_new(prefix, strlen(prefix));
+            trie_child_insert(node, index, child);
+            return child;
+        }
+
+        struct gfal_cred_trie_node *child = node->children[index];
+        size_t common = 1;
+        while (common < child->label_len && prefix[common] == child->label[common]) {
+            ++common;
+        }
+
+        // The edge goes beyond the prefix, or they diverge: split it
+        if (common < child->label_len) {
+            struct gfal_cred_trie_node *middle = trie_node_new(child->label, common);
+            char *remaining = g_strndup(child->label + common, child->label_len - common);
+            g_free(child->label);
+            child->label = remaining;
+            child->label_len -= common;
+            trie_child_insert(middle, 0, child);
+            node->children[index] = middle;
+            child = middle;
+        }
+
+        node = child;
+        prefix += common;
+    }
+    return node;
+}
+
+
+// Remove the nodes left without entries, and merge the ones left with a single child
+// Returns the node that should replace the given one in its parent, NULL if it must be removed
+static struct gfal_cred_trie_node *trie_node_compact(struct gfal_cred_trie_node *node)
+{
+    if (node->entries != NULL || node->n_children > 1) {
+        return node;
+    }
+    if (node->n_children == 0) {
+        trie_node_free(node);
+        return NULL;
+    }
+
+    struct gfal_cred_trie_node *child = node->children[0];
+    char *label = g_malloc(node->label_len + child->label_len + 1);
+    memcpy(label, node->label, node->label_len);
+    memcpy(label + node->label_len, child->label, child->label_len + 1);
+    g_free(child->label);
+    child->label = label;
+    child->label_len += node->label_len;
+    node->n_children = 0;
+    trie_node_free(node);
+    return child;
+}
+
+
+// Remove the entries of the given type (all of them if type is NULL) registered for the prefix
+static void trie_remove(struct gfal_cred_trie_node *node, const char *prefix, const char *type)
+{
+    if (*prefix == '\0') {
+        gfal_cred_entry **entry = &node->entries;
+        while (*entry) {
+            if (type == NULL || strcmp((*entry)->cred.type, type) == 0) {
+                gfal_cred_entry *match = *entry;
+                *entry = match->next;
+                cred_entry_free(match);
+            }
+            else {
+                entry = &(*entry)->next;
+            }
+        }
+        return;
+    }
+
+    gboolean found;
+    guint index = trie_child_index(node, (unsigned char)*prefix, &found);
+    if (!found) {
+        return;
+    }
+    struct gfal_cred_trie_node *child = node->children[index];
+    if (strncmp(child->label, prefix, child->label_len) != 0) {
+        return;
+    }
+    trie_remove(child, prefix + child->label_len, type);
+
+    child = trie_node_compact(child);
+    if (child) {
+        node->children[index] = child;
+    }
+    else {
+        trie_child_remove(node, index);
+    }
+}
+
+
+// Insert the entry keeping the list sorted by type, replacing an existing one of the same type
+static void trie_node_set_entry(struct gfal_cred_trie_node *node, gfal_cred_entry *new_entry)
+{
+    gfal_cred_entry **entry = &node->entries;
+    while (*entry) {
+        int comp = strcmp((*entry)->cred.type, new_entry->cred.type);
+        if (comp == 0) {
+            gfal_cred_entry *match = *entry;
+            new_entry->next = match->next;
+            *entry = new_entry;
+            cred_entry_free(match);
+            return;
+        }
+        else if (comp > 0) {
+            break;
+        }
+        entry = &(*entry)->next;
+    }
+    new_entry->next = *entry;
+    *entry = new_entry;
+}
+
+
+// Deepest entry of the given type with a prefix matching the url
+static const gfal_cred_entry *trie_find(const struct gfal_cred_trie_node *node, const char *type, const char *url)
+{
+    const gfal_cred_entry *best = NULL;
+
+    while (node) {
+        const gfal_cred_entry *entry;
+        for (entry = node->entries; entry != NULL; entry = entry->next) {
+            if (strcmp(entry->cred.type, type) == 0) {
+                best = entry;
+                break;
+            }
+        }
+
+        if (*url == '\0') {
+            break;
+        }
+        gboolean found;
+        guint index = trie_child_index(node, (unsigned char)*url, &found);
+        if (!found) {
+            break;
+        }
+        node = node->children[index];
+        if (strncmp(node->label, url, node->label_len) != 0) {
+            break;
+        }
+        url += node->label_len;
+    }
+    return best;
+}
+
+
+// Longer prefixes first, as a sorted list of prefixes in reverse order would be
+static void trie_foreach(const struct gfal_cred_trie_node *node,
+    void (*func)(const gfal_cred_entry *entry, void *user_data), void *user_data)
+{
+    guint i;
+    const gfal_cred_entry *entry;
+    for (i = node->n_children; i > 0; --i) {
+        trie_foreach(node->children[i - 1], func, user_data);
+    }
+    for (entry = node->entries; entry != NULL; entry = entry->next) {
+        func(entry, user_data);
+    }
+}
+
+
+void gfal_cred_mapping_init(gfal2_context_t handle)
+{
+    handle->cred_mapping = NULL;
+    pthread_rwlock_init(&handle->cred_lock, NULL);
+}
+
+
+void gfal_cred_mapping_destroy(gfal2_context_t handle)
+{
+    trie_node_free(handle->cred_mapping);
+    handle->cred_mapping = NULL;
+    pthread_rwlock_destroy(&handle->cred_lock);
+}
+
+
 gfal2_cred_t *gfal2_cred_new(const char* type, const char *value)
 {
     gfal2_cred_t *cred = g_malloc0(sizeof(gfal2_cred_t));
@@ -86,47 +383,29 @@ gfal2_cred_t* gfal2_cred_dup(const gfal2_cred_t *cred)
 
 int gfal2_cred_set(gfal2_context_t handle, const char *url_prefix, const gfal2_cred_t *cred, GError **error)
 {
-    gfal2_cred_node_t *node = g_malloc0(sizeof(gfal2_cred_node_t));
-    node->prefix_len = strlen(url_prefix);
-    node->url_prefix = g_strdup(url_prefix);
-    node->cred = gfal2_cred_dup(cred);
+    g_return_val_err_if_fail(handle && url_prefix, -1, error, "[gfal2_cred_set] invalid parameters");
 
-    // Remove existing value
-    GList *item = g_list_find_custom(handle->cred_mapping, node, node_compare);
-    if (item) {
-        gfal2_cred_node_t *match = item->data;
-        node_free(match);
-        handle->cred_mapping = g_list_delete_link(handle->cred_mapping, item);
+    pthread_rwlock_wrlock(&handle->cred_lock);
+    if (handle->cred_mapping == NULL) {
+        handle->cred_mapping = trie_node_new("", 0);
     }
 
-    // If cred is NULL, done
-    if (cred == NULL) {
-        node_free(node);
-        return 0;
+    // If cred is NULL, remove whatever is registered for the prefix
+    if (cred == NULL || cred->type == NULL) {
+        trie_remove(handle->cred_mapping, url_prefix, cred ? cred->type : NULL);
     }
-
-    handle->cred_mapping = g_list_insert_sorted(handle->cred_mapping, node, node_compare);
+    else {
+        struct gfal_cred_trie_node *node = trie_node_lookup_or_create(handle->cred_mapping, url_prefix);
+        gfal_cred_value *shared = cred_value_new(cred->value ? cred->value : "", url_prefix);
+        trie_node_set_entry(node, cred_entry_new(cred->type, shared));
+    }
+    pthread_rwlock_unlock(&handle->cred_lock);
     return 0;
 }
 
 
-char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error)
+static char *gfal_cred_get_from_config(gfal2_context_t handle, const char *type)
 {
-    // Pick the first, which is the longest match, since the list is sorted
-    GList *item;
-    for (item = g_list_first(handle->cred_mapping); item != NULL; item = g_list_next(item)) {
-        gfal2_cred_node_t *node = item->data;
-        if (strcmp(node->cred->type, type) == 0 && strncmp(node->url_prefix, url, node->prefix_len) == 0) {
-            if (baseurl) {
-                *baseurl = (char const*)(node->url_prefix);
-            }
-            return g_strdup(node->cred->value);
-        }
-    }
-    if (baseurl) {
-        *baseurl = "";
-    }
-    // If there is no match, use the config
     if (strcmp(type, GFAL_CRED_X509_CERT) == 0) {
         return gfal2_get_opt_string_with_default(handle, "X509", "CERT", NULL);
     }
@@ -140,20 +419,105 @@ char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url,
 }
 
 
+char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error)
+{
+    char *value = NULL;
+
+    pthread_rwlock_rdlock(&handle->cred_lock);
+    const gfal_cred_entry *entry = trie_find(handle->cred_mapping, type, url);
+    if (entry) {
+        if (baseurl) {
+            *baseurl = entry->shared->url_prefix;
+        }
+        value = g_strdup(entry->cred.value);
+    }
+    pthread_rwlock_unlock(&handle->cred_lock);
+
+    if (entry) {
+        return value;
+    }
+    if (baseurl) {
+        *baseurl = "";
+    }
+    // If there is no match, use the config
+    return gfal_cred_get_from_config(handle, type);
+}
+
+
+const char *gfal2_cred_lookup(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error)
+{
+    gfal_cred_value *shared = NULL;
+
+    pthread_rwlock_rdlock(&handle->cred_lock);
+    const gfal_cred_entry *entry = trie_find(handle->cred_mapping, type, url);
+    if (entry) {
+        shared = cred_value_ref(entry->shared);
+    }
+    pthread_rwlock_unlock(&handle->cred_lock);
+
+    if (shared == NULL) {
+        char *value = gfal_cred_get_from_config(handle, type);
+        if (value) {
+            shared = cred_value_new(value, "");
+            g_free(value);
+        }
+    }
+
+    if (baseurl) {
+        *baseurl = shared ? shared->url_prefix : "";
+    }
+    return shared ? shared->value : NULL;
+}
+
+
+void gfal2_cred_release(const char *value)
+{
+    if (value) {
+        cred_value_unref((gfal_cred_value*)(value - offsetof(gfal_cred_value, value)));
+    }
+}
+
+
 int gfal2_cred_clean(gfal2_context_t handle, GError **error)
 {
-    g_list_free_full(handle->cred_mapping, node_free);
+    pthread_rwlock_wrlock(&handle->cred_lock);
+    trie_node_free(handle->cred_mapping);
     handle->cred_mapping = NULL;
+    pthread_rwlock_unlock(&handle->cred_lock);
     return 0;
 }
 
 
+// The values are immutable, so they are shared with the source context
+static void entry_copy(const gfal_cred_entry *entry, void *user_data)
+{
+    struct gfal_cred_trie_node *root = user_data;
+    struct gfal_cred_trie_node *node = trie_node_lookup_or_create(root, entry->shared->url_prefix);
+    trie_node_set_entry(node, cred_entry_new(entry->cred.type, cred_value_ref(entry->shared)));
+}
+
+
 int gfal2_cred_copy(gfal2_context_t dest, const gfal2_context_t src, GError **error)
 {
+    if (dest == src) {
+        return 0;
+    }
     if (gfal2_cred_clean(dest, error) != 0) {
         return -1;
     }
-    g_list_foreach(src->cred_mapping, node_copy, dest);
+
+    struct gfal_cred_trie_node *root = NULL;
+    pthread_rwlock_rdlock(&src->cred_lock);
+    if (src->cred_mapping) {
+        root = trie_node_new("", 0);
+        trie_foreach(src->cred_mapping, entry_copy, root);
+    }
+    pthread_rwlock_unlock(&src->cred_lock);
+
+    pthread_rwlock_wrlock(&dest->cred_lock);
+    trie_node_free(dest->cred_mapping);
+    dest->cred_mapping = root;
+    pthread_rwlock_unlock(&dest->cred_lock);
     return 0;
 }
 
@@ -164,16 +528,19 @@ typedef struct {
 } callback_data;
 
 
-static void foreach_callback_wrapper(gpointer item, gpointer user_data)
+static void foreach_callback_wrapper(const gfal_cred_entry *entry, void *user_data)
 {
     callback_data *data = user_data;
-    gfal2_cred_node_t *node = item;
-    data->callback(node->url_prefix, node->cred, data->user_data);
+    data->callback(entry->shared->url_prefix, &entry->cred, data->user_data);
 }
 
 
 void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data)
 {
     callback_data data = {callback, user_data};
-    g_list_foreach(handle->cred_mapping, foreach_callback_wrapper, &data);
+    pthread_rwlock_rdlock(&handle->cred_lock);
+    if (handle->cred_mapping) {
+        trie_foreach(handle->cred_mapping, foreach_callback_wrapper, &data);
+    }
+    pthread_rwlock_unlock(&handle->cred_lock);
 }
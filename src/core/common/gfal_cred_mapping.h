@@ -82,6 +82,7 @@ gfal2_cred_t *gfal2_cred_dup(const gfal2_cred_t *cred);
  * @note                The empty prefix is initialized by default with the environment X509_USER_* variables
  *                      or the [X509] configuration
  * @note                It will store its own copy of url_prefix and cred
+ * @note                If cred is NULL, all the credentials registered for url_prefix are removed
  */
 int gfal2_cred_set(gfal2_context_t handle, const char *url_prefix, const gfal2_cred_t *cred, GError **error);
 
@@ -96,6 +97,25 @@ int gfal2_cred_set(gfal2_context_t handle, const char *url_prefix, const gfal2_c
  */
 char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error);
 
+/**
+ * Get a credential for a given url, without copying it
+ * @param handle        The gfal2 context
+ * @param type          Credential type
+ * @param url           Full URL. Best matching prefix will be picked.
+ * @param baseurl       If not NULL, the chosen base url will be put here. It stays valid until the value is released.
+ * @param error         In case of error
+ * @return              A credential suitable for the given url. NULL if nothing has been found.
+ *                      The value is shared and immutable: it stays valid even if the credentials of the context change,
+ *                      until released with gfal2_cred_release. Do not g_free it.
+ */
+const char *gfal2_cred_lookup(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error);
+
+/**
+ * Release a value returned by gfal2_cred_lookup
+ * @param value         The value, can be NULL
+ */
+void gfal2_cred_release(const char *value);
+
 /**
  * Remove all loaded credentials
  * @param handle        The gfal2 context
@@ -118,6 +138,7 @@ int gfal2_cred_copy(gfal2_context_t dest, const gfal2_context_t src, GError **er
  * @param handle        The gfal2 context
  * @param callback      Callback for each item
  * @param user_data     To be passed to the callback
+ * @note                The callback must not modify the credentials of the context
  */
 void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data);
 
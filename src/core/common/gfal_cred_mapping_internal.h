@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_CRED_MAPPING_INTERNAL_H_
+#define GFAL_CRED_MAPPING_INTERNAL_H_
+
+#include <common/gfal_common.h>
+
+// prefix trie of the credentials of a context, internal
+void gfal_cred_mapping_init(gfal2_context_t handle);
+void gfal_cred_mapping_destroy(gfal2_context_t handle);
+
+#endif /* GFAL_CRED_MAPPING_INTERNAL_H_ */
@@ -26,11 +26,15 @@ gfal_file_handle gfal_file_handle_new(const char* module_name, gpointer fdesc)
 {
     gfal_file_handle f = g_new(struct _gfal_file_handle, 1);
     g_strlcpy(f->module_name, module_name, GFAL_MODULE_NAME_SIZE);
+    f->plugin = NULL;
     f->lock = g_mutex_new();
     f->offset = 0;
     f->fdesc = fdesc;
     f->ext_data = NULL;
     f->path = NULL;
+    f->readahead = NULL;
+    f->writebehind = NULL;
+    f->write_url = NULL;
     return f;
 }
 
@@ -89,6 +93,7 @@ void gfal_file_handle_delete(gfal_file_handle fh)
     if (fh) {
         g_mutex_free(fh->lock);
         g_free(fh->path);
+        g_free(fh->write_url);
         g_free(fh);
     }
 }
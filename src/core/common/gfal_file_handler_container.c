@@ -28,24 +28,41 @@
 #include "gfal_file_handler_container.h"
 
 
-// generate a new unique key
-static int gfal_file_key_generatorG(gfal_file_handle_container fhandle, GError** err)
+#define GFAL_FDESC_BUSY 1
+
+#define gfal_file_key_index(key) (((key) & (GFAL_FDESC_MAX_SLOTS - 1)) - 1)
+
+
+static gfal_file_handle_slot* gfal_file_slot_get(gfal_file_handle_container fhandle, int index)
 {
-    g_return_val_err_if_fail(fhandle, 0, err,
-            "[gfal_file_descriptor_generatorG] Invalid  arg file handle");
-    int ret = rand();
-    GHashTable* c = fhandle->container;
-    if (g_hash_table_size(c) > G_MAXINT / 2) {
-        gfal2_set_error(err, gfal2_get_plugins_quark(), EMFILE, __func__,
-                "Too many files open");
-        ret = 0;
+    gfal_file_handle_slot* chunk = g_atomic_pointer_get(&fhandle->chunks[index / GFAL_FDESC_CHUNK_SIZE]);
+    if (chunk == NULL)
+        return NULL;
+    return &chunk[index % GFAL_FDESC_CHUNK_SIZE];
+}
+
+// reserve a free slot, m_container must be held
+// return the slot index, or -1 if the table is full
+static int gfal_file_slot_reserve(gfal_file_handle_container fhandle)
+{
+    int index = fhandle->first_free;
+    if (index >= 0) {
+        fhandle->first_free = gfal_file_slot_get(fhandle, index)->next_free;
+        return index;
     }
-    else {
-        while (ret == 0 || g_hash_table_lookup(c, GINT_TO_POINTER(ret)) != NULL) {
-            ret = rand();
-        }
+
+    // index + 1 must fit in the index bits of the descriptor
+    if (fhandle->n_slots >= GFAL_FDESC_MAX_SLOTS - 1)
+        return -1;
+
+    index = fhandle->n_slots;
+    const int n_chunk = index / GFAL_FDESC_CHUNK_SIZE;
+    if (fhandle->chunks[n_chunk] == NULL) {
+        gfal_file_handle_slot* chunk = g_new0(gfal_file_handle_slot, GFAL_FDESC_CHUNK_SIZE);
+        g_atomic_pointer_set(&fhandle->chunks[n_chunk], chunk);
     }
-    return ret;
+    fhandle->n_slots++;
+    return index;
 }
 
 /*
@@ -57,33 +74,75 @@ int gfal_add_new_file_desc(gfal_file_handle_container fhandle, gpointer pfile,
 {
     g_return_val_err_if_fail(fhandle && pfile, 0, err,
             "[gfal_add_new_file_desc] Invalid  arg fhandle and/or pfile");
+    int key = 0;
     pthread_mutex_lock(&(fhandle->m_container));
-    GError* tmp_err = NULL;
-    GHashTable* c = fhandle->container;
-    int key = gfal_file_key_generatorG(fhandle, &tmp_err);
-    if (key != 0) {
-        g_hash_table_insert(c, GINT_TO_POINTER(key), pfile);
+    const int index = gfal_file_slot_reserve(fhandle);
+    if (index < 0) {
+        gfal2_set_error(err, gfal2_get_plugins_quark(), EMFILE, __func__,
+                "Too many files open");
     }
-    if (tmp_err) {
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    else {
+        gfal_file_handle_slot* slot = gfal_file_slot_get(fhandle, index);
+        const gint generation = (g_atomic_int_get(&slot->state) >> 1) & GFAL_FDESC_GENERATION_MASK;
+        g_atomic_pointer_set(&slot->handle, pfile);
+        // publish the handle
+        g_atomic_int_set(&slot->state, (generation << 1) | GFAL_FDESC_BUSY);
+        key = (generation << GFAL_FDESC_INDEX_BITS) | (index + 1);
     }
     pthread_mutex_unlock(&(fhandle->m_container));
     return key;
 }
 
+// return the slot bound to the given file descriptor, or NULL if it is not valid
+// the slot state is returned in state
+static gfal_file_handle_slot* gfal_file_slot_lookup(gfal_file_handle_container fhandle, int key, gint* state)
+{
+    if (key <= 0)
+        return NULL;
+    const int index = gfal_file_key_index(key);
+    const gint generation = key >> GFAL_FDESC_INDEX_BITS;
+    if (index < 0)
+        return NULL;
+    gfal_file_handle_slot* slot = gfal_file_slot_get(fhandle, index);
+    if (slot == NULL)
+        return NULL;
+    *state = g_atomic_int_get(&slot->state);
+    if (*state != ((generation << 1) | GFAL_FDESC_BUSY))
+        return NULL;
+    return slot;
+}
+
 // remove the associated file handle associated with the given file descriptor
 // return true if success else false
 gboolean gfal_remove_file_desc(gfal_file_handle_container fhandle, int key,
         GError** err)
 {
+    gpointer removed = NULL;
+    gint state;
+
     pthread_mutex_lock(&(fhandle->m_container));
-    GHashTable* c = fhandle->container;
-    gboolean p = g_hash_table_remove(c, GINT_TO_POINTER(key));
-    if (!p)
+    gfal_file_handle_slot* slot = gfal_file_slot_lookup(fhandle, key, &state);
+    if (slot) {
+        removed = slot->handle;
+        // bump the generation, so the descriptor becomes stale
+        const gint generation = ((state >> 1) + 1) & GFAL_FDESC_GENERATION_MASK;
+        g_atomic_int_set(&slot->state, generation << 1);
+        g_atomic_pointer_set(&slot->handle, NULL);
+        slot->refs = 0;
+        slot->closing = FALSE;
+        slot->next_free = fhandle->first_free;
+        fhandle->first_free = gfal_file_key_index(key);
+    }
+    pthread_mutex_unlock(&(fhandle->m_container));
+
+    if (!slot) {
         gfal2_set_error(err, gfal2_get_plugins_quark(), EBADF, __func__,
                 "bad file descriptor");
-    pthread_mutex_unlock(&(fhandle->m_container));
-    return p;
+        return FALSE;
+    }
+    if (fhandle->destroyer)
+        fhandle->destroyer(removed);
+    return TRUE;
 }
 
 
@@ -91,17 +150,26 @@ gboolean gfal_remove_file_desc(gfal_file_handle_container fhandle, int key,
 gfal_file_handle_container gfal_file_descriptor_handle_create(GDestroyNotify destroyer)
 {
     gfal_file_handle_container d = g_malloc0(sizeof(struct _gfal_file_handle_container));
-    d->container = g_hash_table_new_full(NULL, NULL, NULL, destroyer);
+    d->first_free = -1;
+    d->destroyer = destroyer;
     pthread_mutex_init(&(d->m_container), NULL);
+    pthread_cond_init(&(d->released), NULL);
     return d;
 }
 
 
 void gfal_file_descriptor_handle_destroy(gfal_file_handle_container fhandle)
 {
-    if (fhandle->container) {
-        g_hash_table_destroy(fhandle->container);
+    int i;
+    for (i = 0; i < fhandle->n_slots; ++i) {
+        gfal_file_handle_slot* slot = gfal_file_slot_get(fhandle, i);
+        if (fhandle->destroyer && (slot->state & GFAL_FDESC_BUSY))
+            fhandle->destroyer(slot->handle);
+    }
+    for (i = 0; i < GFAL_FDESC_MAX_CHUNKS && fhandle->chunks[i] != NULL; ++i) {
+        g_free(fhandle->chunks[i]);
     }
+    pthread_cond_destroy(&fhandle->released);
     pthread_mutex_destroy(&fhandle->m_container);
     g_free(fhandle);
 }
@@ -110,6 +178,8 @@ void gfal_file_descriptor_handle_destroy(gfal_file_handle_container fhandle)
  /*
  *
  * return the file handle associated with the file_desc
+ * This does not take any lock: the slot state is checked before and after
+ * reading the handle, so a concurrent close is detected.
  * @warning does not free the handle
  *
  * */
@@ -118,13 +188,66 @@ gfal_file_handle gfal_file_handle_bind(gfal_file_handle_container h,
 {
     g_return_val_err_if_fail(fd, 0, err, "invalid dir descriptor");
 
+    gint state;
+    gpointer p = NULL;
+    gfal_file_handle_slot* slot = gfal_file_slot_lookup(h, fd, &state);
+    if (slot) {
+        p = g_atomic_pointer_get(&slot->handle);
+        if (g_atomic_int_get(&slot->state) != state)
+            p = NULL;
+    }
+    if (!p) {
+        gfal2_set_error(err, gfal2_get_plugins_quark(), EBADF, __func__,
+            "bad file descriptor");
+    }
+    return (gfal_file_handle)p;
+}
+
+
+gfal_file_handle gfal_file_handle_ref(gfal_file_handle_container h,
+        int fd, GError** err)
+{
+    gint state;
+    gpointer p = NULL;
 
     pthread_mutex_lock(&(h->m_container));
-    gpointer p = g_hash_table_lookup(h->container, GINT_TO_POINTER(fd));
+    gfal_file_handle_slot* slot = gfal_file_slot_lookup(h, fd, &state);
+    if (slot && !slot->closing) {
+        ++slot->refs;
+        p = slot->handle;
+    }
+    pthread_mutex_unlock(&(h->m_container));
+
     if (!p) {
         gfal2_set_error(err, gfal2_get_plugins_quark(), EBADF, __func__,
             "bad file descriptor");
     }
-    pthread_mutex_unlock(&(h->m_container));
     return (gfal_file_handle)p;
 }
+
+
+void gfal_file_handle_unref(gfal_file_handle_container h, int fd)
+{
+    gint state;
+
+    pthread_mutex_lock(&(h->m_container));
+    gfal_file_handle_slot* slot = gfal_file_slot_lookup(h, fd, &state);
+    if (slot && slot->refs > 0 && --slot->refs == 0)
+        pthread_cond_broadcast(&(h->released));
+    pthread_mutex_unlock(&(h->m_container));
+}
+
+
+void gfal_file_handle_wait_unref(gfal_file_handle_container h, int fd)
+{
+    gint state;
+
+    pthread_mutex_lock(&(h->m_container));
+    gfal_file_handle_slot* slot = gfal_file_slot_lookup(h, fd, &state);
+    if (slot) {
+        slot->closing = TRUE;
+        while (slot->refs > 0)
+            pthread_cond_wait(&(h->released), &(h->m_container));
+    }
+    pthread_mutex_unlock(&(h->m_container));
+}
@@ -34,18 +34,57 @@ extern "C"
 {
 #endif
 
+// File descriptors are (generation << GFAL_FDESC_INDEX_BITS) | (slot index + 1)
+// so the first descriptors are small and dense, and a stale descriptor
+// does not resolve to a handle that reused its slot.
+#define GFAL_FDESC_INDEX_BITS 20
+#define GFAL_FDESC_MAX_SLOTS (1 << GFAL_FDESC_INDEX_BITS)
+#define GFAL_FDESC_GENERATION_MASK ((1 << (31 - GFAL_FDESC_INDEX_BITS)) - 1)
+#define GFAL_FDESC_CHUNK_SIZE 1024
+#define GFAL_FDESC_MAX_CHUNKS (GFAL_FDESC_MAX_SLOTS / GFAL_FDESC_CHUNK_SIZE)
+
+typedef struct _gfal_file_handle_slot {
+    // (generation << 1) | busy bit, changed only with m_container held
+    volatile gint state;
+    gpointer handle;
+    // next free slot, when this one is not busy
+    int next_free;
+    // references taken by the operations in flight, and set once the
+    // descriptor is being closed, both changed only with m_container held
+    int refs;
+    gboolean closing;
+} gfal_file_handle_slot;
+
 struct _gfal_file_handle_container {
-	GHashTable* container;
+    // chunks never move once allocated, so lookups do not need any lock
+    gfal_file_handle_slot* chunks[GFAL_FDESC_MAX_CHUNKS];
+    int n_slots;
+    int first_free;
+    GDestroyNotify destroyer;
+    // serializes allocation and release of the slots
 	pthread_mutex_t m_container;
+    // signaled when the last reference to a slot is released
+    pthread_cond_t released;
 };
 
+struct _gfal_plugin_interface;
+
 struct _gfal_file_handle {
 	char module_name[GFAL_MODULE_NAME_SIZE]; // This MUST be the Name of the plugin associated with this handle!
+    // owning plugin, bound by the core on open so the I/O calls do not need
+    // to look it up by name. NULL until bound.
+    struct _gfal_plugin_interface* plugin;
 	GMutex* lock;
 	off_t offset;
 	gpointer ext_data;
 	gpointer fdesc;
     gchar* path;
+    // read-ahead state, owned by the core, NULL if disabled
+    struct gfal_readahead_s* readahead;
+    // write-behind state, owned by the core, NULL if disabled
+    struct gfal_writebehind_s* writebehind;
+    // url opened for writing, owned by the core, NULL if opened read only
+    gchar* write_url;
 };
 
 
@@ -59,6 +98,15 @@ gboolean gfal_remove_file_desc(gfal_file_handle_container fhandle, int key, GErr
 
 gfal_file_handle gfal_file_handle_bind(gfal_file_handle_container h, int fd, GError** err);
 
+// Bind the handle of fd and keep it until gfal_file_handle_unref, for the operations
+// running in the background. Fails with EBADF once fd is being closed
+gfal_file_handle gfal_file_handle_ref(gfal_file_handle_container h, int fd, GError** err);
+
+void gfal_file_handle_unref(gfal_file_handle_container h, int fd);
+
+// No new reference can be taken on fd, and wait until the ones taken are released
+void gfal_file_handle_wait_unref(gfal_file_handle_container h, int fd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@
 #   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
 #endif
 
+#include <pthread.h>
 #include "gfal_plugin_interface.h"
 
 /* enforce proper calling convention */
@@ -35,14 +36,35 @@ extern "C"
 #endif
 
 
+struct _gfal_plugin_module;
+struct _gfal_stat_cache;
+
 struct _gfal_plugin_opts {
     gfal_plugin_interface plugin_list[MAX_PLUGIN_LIST];
     GList* sorted_plugin;
     int plugin_number;
+    // registry module each plugin comes from, NULL for the registered ones
+    const struct _gfal_plugin_module* plugin_module[MAX_PLUGIN_LIST];
+    // GFAL_PLUGIN_READY, _PENDING, _BORROWED or _FAILED
+    volatile gint plugin_state[MAX_PLUGIN_LIST];
+    pthread_mutex_t instance_lock;
+    // scheme -> plugin elected for each plugin_mode, see gfal_find_plugin
+    GHashTable* dispatch_cache;
+    pthread_rwlock_t dispatch_lock;
 };
 typedef struct _gfal_plugin_opts gfal_plugin_opts;
 
 
+// typed values already read from the configuration, see gfal_config.c
+struct _gfal_config_snapshot {
+    GHashTable* values;
+    // generation of the configuration the values were read from
+    gint generation;
+    pthread_rwlock_t lock;
+};
+typedef struct _gfal_config_snapshot gfal_config_snapshot;
+
+
 struct gfal_handle_ {
 	gboolean initiated;
 	// struct of the plugin opts
@@ -50,14 +72,23 @@ struct gfal_handle_ {
 	//struct for the file descriptors
 	gfal_file_handle_container fdescs;
 	GKeyFile *config;
+    // bumped on every change of config
+    volatile gint config_generation;
+    gfal_config_snapshot config_snapshot;
     // cancel logic
     volatile gint running_ops;
-    gboolean cancel;
+    volatile gboolean cancel;
     GMutex* mux_cancel;
+    // signaled when the last operation of the context, or of a gfal_operation_t, ends
+    GCond* cond_cancel;
     GHookList cancel_hooks;
 
-	// Credential mapping
-    GList *cred_mapping;
+	// Credential mapping, as a radix trie of the url prefixes
+    struct gfal_cred_trie_node *cred_mapping;
+    pthread_rwlock_t cred_lock;
+
+    // stat results, see gfal_stat_cache.c
+    struct _gfal_stat_cache* stat_cache;
 
     // client information
     char* agent_name;
@@ -28,15 +28,22 @@
 #include <logger/gfal_logger.h>
 #include <gfal_api.h>
 #include "gfal_plugin.h"
+#include "gfal_plugin_internal.h"
 #include "gfal_constants.h"
 #include "gfal_error.h"
 #include "gfal_file_handler_container.h"
+#include <file/gfal_async_internal.h>
 #include <future/glib.h>
 
 #ifndef GFAL_PLUGIN_DIR_DEFAULT
 #error "GFAL_PLUGIN_DIR_DEFAULT should be define at compile time"
 #endif
 
+// number of entries of plugin_mode
+#define GFAL_PLUGIN_MODE_COUNT (GFAL_PLUGIN_CHANGE_OBJECT_QOS + 1)
+// longer schemes are not cached
+#define GFAL_DISPATCH_SCHEME_MAX 32
+
 
 /*
  * function to use in order to create a new plugin interface
@@ -79,39 +86,169 @@ gboolean gfal_plugin_checker_safe(gfal_plugin_interface* cata_list,
         return FALSE;
 }
 
+
+void gfal_plugin_dispatch_cache_init(gfal2_context_t handle)
+{
+    handle->plugin_opt.dispatch_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    pthread_rwlock_init(&handle->plugin_opt.dispatch_lock, NULL);
+}
+
+
+void gfal_plugin_dispatch_cache_destroy(gfal2_context_t handle)
+{
+    if (handle->plugin_opt.dispatch_cache) {
+        g_hash_table_destroy(handle->plugin_opt.dispatch_cache);
+        handle->plugin_opt.dispatch_cache = NULL;
+        pthread_rwlock_destroy(&handle->plugin_opt.dispatch_lock);
+    }
+}
+
+// Copy the scheme of url into scheme, return FALSE if there is none or if it is too long
+static gboolean gfal_plugin_url_scheme(const char* url, char* scheme, size_t s_scheme)
+{
+    size_t i;
+    for (i = 0; url[i] != ':'; ++i) {
+        if (url[i] == '\0' || i + 1 >= s_scheme)
+            return FALSE;
+        if (!g_ascii_isalnum(url[i]) && url[i] != '+' && url[i] != '-' && url[i] != '.')
+            return FALSE;
+        scheme[i] = url[i];
+    }
+    scheme[i] = '\0';
+    return i > 0;
+}
+
+// Cached dispatch information for a given scheme
+typedef struct _gfal_dispatch_entry {
+    // plugin elected for each plugin_mode, only when no plugin before it,
+    // by priority, could have accepted another url of the scheme
+    gfal_plugin_interface* elected[GFAL_PLUGIN_MODE_COUNT];
+} gfal_dispatch_entry;
+
+
+static gfal_plugin_interface* gfal_plugin_dispatch_lookup(gfal2_context_t handle, const char* scheme,
+        plugin_mode mode)
+{
+    gfal_plugin_interface* elected = NULL;
+    pthread_rwlock_rdlock(&handle->plugin_opt.dispatch_lock);
+    gfal_dispatch_entry* entry = g_hash_table_lookup(handle->plugin_opt.dispatch_cache, scheme);
+    if (entry)
+        elected = entry->elected[mode];
+    pthread_rwlock_unlock(&handle->plugin_opt.dispatch_lock);
+    return elected;
+}
+
+
+static void gfal_plugin_dispatch_store(gfal2_context_t handle, const char* scheme,
+        plugin_mode mode, gfal_plugin_interface* plugin)
+{
+    pthread_rwlock_wrlock(&handle->plugin_opt.dispatch_lock);
+    gfal_dispatch_entry* entry = g_hash_table_lookup(handle->plugin_opt.dispatch_cache, scheme);
+    if (entry == NULL) {
+        entry = g_new0(gfal_dispatch_entry, 1);
+        g_hash_table_insert(handle->plugin_opt.dispatch_cache, g_strdup(scheme), entry);
+    }
+    entry->elected[mode] = plugin;
+    pthread_rwlock_unlock(&handle->plugin_opt.dispatch_lock);
+}
+
+// Forget all the elections, after the plugin set or order changed
+static void gfal_plugin_dispatch_reset(gfal2_context_t handle)
+{
+    if (handle->plugin_opt.dispatch_cache == NULL)
+        return;
+
+    pthread_rwlock_wrlock(&handle->plugin_opt.dispatch_lock);
+    g_hash_table_remove_all(handle->plugin_opt.dispatch_cache);
+    pthread_rwlock_unlock(&handle->plugin_opt.dispatch_lock);
+}
+
+// TRUE if the plugin lists its schemes, and scheme is not one of them
+static gboolean gfal_plugin_scheme_foreign(gfal_plugin_interface* plugin, const char* scheme)
+{
+    const char* const* declared;
+    if (plugin->schemes == NULL)
+        return FALSE;
+    for (declared = plugin->schemes; *declared != NULL; ++declared) {
+        if (strcmp(*declared, scheme) == 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 //
-// Resolve entry point in a plugin and add it to the current plugin list
+// Instantiate the plugin of a module and add it to the current plugin list
 //
-static int gfal_module_init(gfal2_context_t handle, void* dlhandle,
-        const char* module_name, GError** err)
+static int gfal_module_init(gfal2_context_t handle, const gfal_plugin_module* module, GError** err)
 {
     GError* tmp_err = NULL;
-    static gfal_plugin_interface (*constructor)(gfal2_context_t, GError**);
     int* n = &handle->plugin_opt.plugin_number;
     int res = -1;
-    constructor = (gfal_plugin_interface (*)(gfal2_context_t, GError**)) dlsym(dlhandle, GFAL_PLUGIN_INIT_SYM);
-    if (constructor == NULL) {
-        g_set_error(&tmp_err, gfal2_get_plugins_quark(), EINVAL,
-                "No symbol %s found in the plugin %s, failure",
-                GFAL_PLUGIN_INIT_SYM, module_name);
+
+    if (module->lazy) {
+        // only what the manifest says for now, see gfal_plugin_instance
+        gfal_plugin_interface* p = &handle->plugin_opt.plugin_list[*n];
+        memset(p, 0, sizeof(*p));
+        p->priority = module->priority;
+        p->schemes = (const char* const*) module->schemes;
+        handle->plugin_opt.plugin_module[*n] = module;
+        handle->plugin_opt.plugin_state[*n] = GFAL_PLUGIN_PENDING;
+        *n += 1;
+        return 0;
+    }
+
+    handle->plugin_opt.plugin_list[*n] = module->constructor(handle, &tmp_err);
+    handle->plugin_opt.plugin_list[*n].gfal_data = module->dlhandle;
+    if (tmp_err) {
+        g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module->path);
         *n = 0;
     }
     else {
-        handle->plugin_opt.plugin_list[*n] = constructor(handle, &tmp_err);
-        handle->plugin_opt.plugin_list[*n].gfal_data = dlhandle;
-        if (tmp_err) {
-            g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module_name);
-            *n = 0;
-        }
-        else {
-            *n += 1;
-            gfal2_log(G_LOG_LEVEL_MESSAGE, "[gfal_module_load] plugin %s loaded with success ", module_name);
-            res = 0;
-        }
+        handle->plugin_opt.plugin_module[*n] = module;
+        handle->plugin_opt.plugin_state[*n] = GFAL_PLUGIN_READY;
+        *n += 1;
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "[gfal_module_load] plugin %s loaded with success ", module->path);
+        res = 0;
     }
     G_RETURN_ERR(res, tmp_err, err);
 }
 
+
+// name of the plugin, or of its library if it has not been loaded yet
+static const char* gfal_plugin_display_name(gfal2_context_t handle, gfal_plugin_interface* p)
+{
+    if (p->getName)
+        return p->getName();
+    return handle->plugin_opt.plugin_module[p - handle->plugin_opt.plugin_list]->path;
+}
+
+
+const char* gfal_plugin_get_name(gfal2_context_t handle, gfal_plugin_interface* p)
+{
+    // a plugin that can not be loaded is still listed, by the name of its library
+    if (p->getName == NULL)
+        gfal_plugin_instance(handle, p, NULL);
+    return gfal_plugin_display_name(handle, p);
+}
+
+
+gboolean gfal_plugin_manifest_allows(gfal2_context_t handle, gfal_plugin_interface* p, const char* url)
+{
+    const gfal_plugin_module* module = handle->plugin_opt.plugin_module[p - handle->plugin_opt.plugin_list];
+    if (module == NULL || !module->lazy || module->schemes == NULL)
+        return TRUE;
+
+    char scheme[GFAL_DISPATCH_SCHEME_MAX];
+    char** declared;
+    if (url == NULL || !gfal_plugin_url_scheme(url, scheme, sizeof(scheme)))
+        return FALSE;
+    for (declared = module->schemes; *declared != NULL; ++declared) {
+        if (strcmp(*declared, scheme) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
 // unload each loaded plugin
 int gfal_plugins_delete(gfal2_context_t handle, GError** err)
 {
@@ -121,18 +258,20 @@ int gfal_plugins_delete(gfal2_context_t handle, GError** err)
         int i;
         for (i = 0; i < plugin_number; ++i) {
             gfal_plugin_interface* p = &(handle->plugin_opt.plugin_list[i]);
-            if (p->plugin_delete)
+            // pending plugins were never instantiated, and borrowed ones belong to another context
+            if (handle->plugin_opt.plugin_state[i] == GFAL_PLUGIN_READY && p->plugin_delete)
                 p->plugin_delete(gfal_get_plugin_handle(p));
         }
 
         handle->plugin_opt.plugin_number = 0;
+        gfal_plugin_dispatch_reset(handle);
     }
     return 0;
 }
 
 
-// return the proper plugin linked to this file handle
-gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_file_handle fh, GError** err)
+// return the plugin whose name matches the one of the file handle
+static gfal_plugin_interface* gfal_plugin_lookup_file_handle(gfal2_context_t handle, gfal_file_handle fh, GError** err)
 {
     GError* tmp_err = NULL;
     int i;
@@ -141,6 +280,9 @@ gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_
     if (n > 0) {
         cata_list = handle->plugin_opt.plugin_list;
         for (i = 0; i < n; ++i) {
+            // plugins not loaded yet can not have opened anything
+            if (cata_list[i].getName == NULL)
+                continue;
             if (strncmp(cata_list[i].getName(), fh->module_name, GFAL_MODULE_NAME_SIZE) == 0)
                 return &(cata_list[i]);
         }
@@ -154,6 +296,41 @@ gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_
     return cata_list;
 }
 
+// bind a freshly opened handle to its plugin
+// Handles created by a plugin wrapping another one (i.e. srm on top of the turl plugin)
+// are bound by name, since the owner is not necessarily the plugin that was called
+static void gfal_plugin_bind_file_handle(gfal2_context_t handle, gfal_plugin_interface* p, gfal_file_handle fh)
+{
+    if (fh == NULL || fh->plugin != NULL)
+        return;
+    if (strncmp(p->getName(), fh->module_name, GFAL_MODULE_NAME_SIZE) == 0) {
+        fh->plugin = p;
+    }
+    else {
+        GError* tmp_err = NULL;
+        gfal_plugin_interface* owner = gfal_plugin_lookup_file_handle(handle, fh, &tmp_err);
+        if (tmp_err)
+            g_error_free(tmp_err);
+        else
+            fh->plugin = owner;
+    }
+}
+
+// return the proper plugin linked to this file handle
+gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_file_handle fh, GError** err)
+{
+    if (G_LIKELY(fh->plugin != NULL))
+        return fh->plugin;
+
+    GError* tmp_err = NULL;
+    gfal_plugin_interface* p = gfal_plugin_lookup_file_handle(handle, fh, &tmp_err);
+    if (tmp_err)
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    else
+        fh->plugin = p;
+    return p;
+}
+
 // external function to get the list of the plugins loaded
 char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
 {
@@ -165,7 +342,7 @@ char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
         int i;
         gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
         for (i = 0; i < n; ++i, ++cata_list) {
-            resu[i] = strndup(cata_list->getName(), GFAL_URL_MAX_LEN);
+            resu[i] = strndup(gfal_plugin_get_name(handle, cata_list), GFAL_URL_MAX_LEN);
         }
     }
     if (tmp_err)
@@ -185,7 +362,7 @@ gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
         int i;
         gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
         for (i = 0; i < n; ++i, ++cata_list) {
-            const char* plugin_name = cata_list->getName();
+            const char* plugin_name = gfal_plugin_get_name(handle, cata_list);
             if (plugin_name != NULL && strcmp(plugin_name, name) == 0) {
                 resu = cata_list;
                 break;
@@ -194,6 +371,8 @@ gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
         if (resu == NULL)
             g_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOENT,
                     " No plugin loaded with this name %s", name);
+        else if (gfal_plugin_instance(handle, resu, &tmp_err) != 0)
+            resu = NULL;
     }
 
     if (tmp_err)
@@ -201,26 +380,6 @@ gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
     return resu;
 }
 
-//  load the gfal_plugins in the listed library
-static int gfal_module_load(gfal2_context_t handle, char* module_name, GError** err)
-{
-    void* dlhandle = dlopen(module_name, RTLD_NOW);
-    GError * tmp_err = NULL;
-    int res = 0;
-    if (dlhandle == NULL) {
-        gfal2_log(G_LOG_LEVEL_WARNING, "Unable to open the %s plugin specified in the plugin directory: %s",
-            module_name, dlerror());
-    }
-    else {
-        res = gfal_module_init(handle, dlhandle, module_name, &tmp_err);
-    }
-    if (tmp_err) {
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-    }
-    return res;
-}
-
-
 /*
  * Provide a list of the gfal2 plugins path
  * Return NULL terminated table of plugins
@@ -274,11 +433,9 @@ char ** gfal_list_directory_plugins(const char * dir, GError ** err)
 }
 
 
-char ** gfal_localize_plugins(GError** err)
+const char* gfal_plugins_directory(void)
 {
-    GError * tmp_err = NULL;
-    char** res = NULL;
-    char * gfal_plugin_dir = (char*) g_getenv(GFAL_PLUGIN_DIR_ENV);
+    const char* gfal_plugin_dir = g_getenv(GFAL_PLUGIN_DIR_ENV);
     if (gfal_plugin_dir != NULL) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
                 "... %s environment variable specified, try to load the plugins in given dir : %s",
@@ -292,7 +449,14 @@ char ** gfal_localize_plugins(GError** err)
                 GFAL_PLUGIN_DIR_ENV, gfal_plugin_dir);
 
     }
-    res = gfal_list_directory_plugins(gfal_plugin_dir, &tmp_err);
+    return gfal_plugin_dir;
+}
+
+
+char ** gfal_localize_plugins(GError** err)
+{
+    GError * tmp_err = NULL;
+    char** res = gfal_list_directory_plugins(gfal_plugins_directory(), &tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -301,22 +465,18 @@ int gfal_modules_resolve(gfal2_context_t handle, GError** err)
 {
     GError* tmp_err = NULL;
     int res = -1;
-    char** tab_args;
+    int i;
 
-    if ((tab_args = gfal_localize_plugins(&tmp_err)) != NULL) {
-        char** p = tab_args;
-        while (*p != NULL) {
-            if (**p == '\0')
-                break;
-            if (gfal_module_load(handle, *p, &tmp_err) != 0) {
+    const gfal_registry* r = gfal_registry_get(&tmp_err);
+    if (r != NULL) {
+        for (i = 0; i < r->module_number; ++i) {
+            if (gfal_module_init(handle, &r->modules[i], &tmp_err) != 0) {
                 res = -1;
                 break;
             }
-            gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_plugin loaded succesfully : %s", *p);
+            gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_plugin loaded succesfully : %s", r->modules[i].path);
             res = 0;
-            p++;
         }
-        g_strfreev(tab_args);
     }
 
     if (tmp_err)
@@ -324,6 +484,77 @@ int gfal_modules_resolve(gfal2_context_t handle, GError** err)
     return res;
 }
 
+
+int gfal_plugin_instance(gfal2_context_t handle, gfal_plugin_interface* p, GError** err)
+{
+    const int i = p - handle->plugin_opt.plugin_list;
+    const gint state = g_atomic_int_get(&handle->plugin_opt.plugin_state[i]);
+    if (G_LIKELY(state == GFAL_PLUGIN_READY || state == GFAL_PLUGIN_BORROWED))
+        return 0;
+
+    GError* tmp_err = NULL;
+    int res = 0;
+
+    pthread_mutex_lock(&handle->plugin_opt.instance_lock);
+    const gfal_plugin_module* module = handle->plugin_opt.plugin_module[i];
+    if (handle->plugin_opt.plugin_state[i] == GFAL_PLUGIN_FAILED) {
+        gfal2_set_error(&tmp_err, gfal2_get_plugins_quark(), ELIBACC, __func__,
+                "The plugin %s could not be loaded", module->path);
+        res = -1;
+    }
+    else if (handle->plugin_opt.plugin_state[i] == GFAL_PLUGIN_PENDING) {
+        gfal_plugin_interface ifce;
+        if (gfal_registry_open_module(module, &tmp_err) == 0)
+            ifce = module->constructor(handle, &tmp_err);
+        if (tmp_err) {
+            // as for the plugins loaded upfront, a broken library does not hide the others
+            g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module->path);
+            gfal2_log(G_LOG_LEVEL_WARNING, "%s, skipped", tmp_err->message);
+            g_atomic_int_set(&handle->plugin_opt.plugin_state[i], GFAL_PLUGIN_FAILED);
+            res = -1;
+        }
+        else {
+            // the plugin list is already sorted, so the priority is the one of the parent, or the manifest
+            ifce.priority = p->priority;
+            ifce.gfal_data = module->dlhandle;
+            *p = ifce;
+            g_atomic_int_set(&handle->plugin_opt.plugin_state[i], GFAL_PLUGIN_READY);
+            gfal2_log(G_LOG_LEVEL_DEBUG, " plugin %s instantiated on first use", module->path);
+        }
+    }
+    pthread_mutex_unlock(&handle->plugin_opt.instance_lock);
+
+    if (tmp_err)
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    return res;
+}
+
+
+int gfal_plugins_clone(gfal2_context_t handle, gfal2_context_t parent, GError** err)
+{
+    int i;
+    const int n = parent->plugin_opt.plugin_number;
+    if (n <= 0)
+        return 0;
+
+    for (i = 0; i < n; ++i) {
+        gfal_plugin_interface* p = &handle->plugin_opt.plugin_list[i];
+        *p = parent->plugin_opt.plugin_list[i];
+        handle->plugin_opt.plugin_module[i] = parent->plugin_opt.plugin_module[i];
+        if (handle->plugin_opt.plugin_module[i] != NULL) {
+            p->plugin_data = NULL;
+            // no need to try again what failed for the parent
+            handle->plugin_opt.plugin_state[i] =
+                (parent->plugin_opt.plugin_state[i] == GFAL_PLUGIN_FAILED) ? GFAL_PLUGIN_FAILED : GFAL_PLUGIN_PENDING;
+        }
+        else {
+            handle->plugin_opt.plugin_state[i] = GFAL_PLUGIN_BORROWED;
+        }
+    }
+    handle->plugin_opt.plugin_number = n;
+    return gfal_plugins_sort(handle, err);
+}
+
 //
 // compare of the plugin function
 //
@@ -359,13 +590,16 @@ int gfal_plugins_sort(gfal2_context_t handle, GError ** err)
 
         for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
             strbuff = g_string_append(strbuff,
-                    ((gfal_plugin_interface*) l->data)->getName());
+                    gfal_plugin_display_name(handle, (gfal_plugin_interface*) l->data));
             strbuff = g_string_append(strbuff, " -> ");
             l = g_list_next(l);
         }
         gfal2_log(G_LOG_LEVEL_DEBUG, "%s", strbuff->str);
         g_string_free(strbuff, TRUE);
     }
+
+    // plugin set or order changed, previous elections are not valid anymore
+    gfal_plugin_dispatch_reset(handle);
     return 0;
 }
 
@@ -405,15 +639,50 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle, const char * url
     gboolean compatible = FALSE;
     const int n_plugins = gfal_plugins_instance(handle, &tmp_err);
     if (n_plugins > 0) {
+        char scheme[GFAL_DISPATCH_SCHEME_MAX];
+        gboolean cacheable = handle->plugin_opt.dispatch_cache != NULL
+                && (unsigned) acc_mode < GFAL_PLUGIN_MODE_COUNT
+                && gfal_plugin_url_scheme(url, scheme, sizeof(scheme));
+
+        // fast path: confirm the previous election for this scheme and operation
+        gfal_plugin_interface* elected = NULL;
+        if (cacheable) {
+            elected = gfal_plugin_dispatch_lookup(handle, scheme, acc_mode);
+            if (elected) {
+                compatible = gfal_plugin_checker_safe(elected, url, acc_mode, &tmp_err);
+                if (compatible)
+                    return elected;
+            }
+        }
+
+        // by priority, as the election is only kept if no plugin before the elected one
+        // could have accepted another url of the scheme
         GList * plugin_list = g_list_first(handle->plugin_opt.sorted_plugin);
-        while (plugin_list != NULL) {
+        while (plugin_list != NULL && tmp_err == NULL) {
             gfal_plugin_interface* plugin_ifce = plugin_list->data;
-            compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, &tmp_err);
+            plugin_list = g_list_next(plugin_list);
+
+            // the manifest and a failure to load rule out the whole scheme
+            if (!gfal_plugin_manifest_allows(handle, plugin_ifce, url))
+                continue;
+            // already logged, the next plugins may still take the url
+            if (gfal_plugin_instance(handle, plugin_ifce, NULL) != 0)
+                continue;
+
+            // it just refused the url
+            if (plugin_ifce == elected)
+                compatible = FALSE;
+            else
+                compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, &tmp_err);
             if (tmp_err)
                 break;
-            if (compatible)
+            if (compatible) {
+                if (cacheable)
+                    gfal_plugin_dispatch_store(handle, scheme, acc_mode, plugin_ifce);
                 return plugin_ifce;
-            plugin_list = g_list_next(plugin_list);
+            }
+            if (cacheable && plugin_ifce->check_plugin_url != NULL && !gfal_plugin_scheme_foreign(plugin_ifce, scheme))
+                cacheable = FALSE;
         }
     }
     if (tmp_err) {
@@ -439,6 +708,8 @@ int gfal2_register_plugin(gfal2_context_t handle, const gfal_plugin_interface* i
     int i = handle->plugin_opt.plugin_number;
     handle->plugin_opt.plugin_number++;
     handle->plugin_opt.plugin_list[i] = *ifce;
+    handle->plugin_opt.plugin_module[i] = NULL;
+    handle->plugin_opt.plugin_state[i] = GFAL_PLUGIN_READY;
 
     return gfal_plugins_sort(handle, error);
 }
@@ -615,6 +886,8 @@ gfal_file_handle gfal_plugin_opendirG(gfal2_context_t handle, const char* name,
 
     if (p)
         resu = p->opendirG(gfal_get_plugin_handle(p), name, &tmp_err);
+    if (resu)
+        gfal_plugin_bind_file_handle(handle, p, resu);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -642,6 +915,8 @@ gfal_file_handle gfal_plugin_openG(gfal2_context_t handle, const char * path, in
 
     if (p)
         resu = p->openG(gfal_get_plugin_handle(p), path, flag, mode, &tmp_err);
+    if (resu)
+        gfal_plugin_bind_file_handle(handle, p, resu);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -800,6 +1075,116 @@ ssize_t gfal_plugin_preadG(gfal2_context_t handle, gfal_file_handle fh, void* bu
     G_RETURN_ERR(res, tmp_err, err);
 }
 
+// Ranges closer than this are read together, the gap being discarded
+#define GFAL_PREADV_MAX_GAP (4 * 1024)
+// Do not merge ranges beyond this size
+#define GFAL_PREADV_MAX_SPAN (8 * 1024 * 1024)
+
+typedef struct {
+    off_t offset;
+    size_t len;
+    char* base;
+} gfal_preadv_range;
+
+static int gfal_preadv_range_cmp(const void* a, const void* b)
+{
+    const gfal_preadv_range* ra = (const gfal_preadv_range*)a;
+    const gfal_preadv_range* rb = (const gfal_preadv_range*)b;
+    if (ra->offset < rb->offset)
+        return -1;
+    return ra->offset > rb->offset;
+}
+
+// Read until s_buff bytes or the end of the file
+static ssize_t gfal_plugin_pread_full(gfal2_context_t handle, gfal_file_handle fh, char* buff, size_t s_buff,
+        off_t offset, GError** err)
+{
+    size_t done = 0;
+    while (done < s_buff) {
+        ssize_t res = gfal_plugin_preadG(handle, fh, buff + done, s_buff - done, offset + done, err);
+        if (res < 0)
+            return -1;
+        if (res == 0)
+            break;
+        done += res;
+    }
+    return done;
+}
+
+// Simulate a vectored read, sorting the ranges and merging the adjacent ones
+static ssize_t gfal_plugin_simulate_preadvG(gfal2_context_t handle, gfal_file_handle fh, const struct iovec* iov,
+        const off_t* offsets, int iovcnt, GError** err)
+{
+    GError* tmp_err = NULL;
+    ssize_t total = 0;
+    int i, j, k;
+
+    gfal_preadv_range* ranges = g_new(gfal_preadv_range, iovcnt);
+    for (i = 0; i < iovcnt; ++i) {
+        ranges[i].offset = offsets[i];
+        ranges[i].len = iov[i].iov_len;
+        ranges[i].base = iov[i].iov_base;
+    }
+    qsort(ranges, iovcnt, sizeof(gfal_preadv_range), gfal_preadv_range_cmp);
+
+    for (i = 0; i < iovcnt && !tmp_err; i = j) {
+        off_t start = ranges[i].offset;
+        off_t end = start + ranges[i].len;
+        for (j = i + 1; j < iovcnt && ranges[j].offset <= end + GFAL_PREADV_MAX_GAP; ++j) {
+            off_t range_end = ranges[j].offset + ranges[j].len;
+            if (range_end > end) {
+                if (range_end - start > GFAL_PREADV_MAX_SPAN)
+                    break;
+                end = range_end;
+            }
+        }
+
+        if (j == i + 1) {
+            ssize_t res = gfal_plugin_pread_full(handle, fh, ranges[i].base, ranges[i].len, start, &tmp_err);
+            if (res >= 0)
+                total += res;
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "preadv: merged %d ranges into [%lld, %lld)",
+                    j - i, (long long)start, (long long)end);
+            char* buffer = g_malloc(end - start);
+            ssize_t res = gfal_plugin_pread_full(handle, fh, buffer, end - start, start, &tmp_err);
+            for (k = i; k < j && res >= 0; ++k) {
+                off_t available = start + res - ranges[k].offset;
+                if (available > (off_t)ranges[k].len)
+                    available = ranges[k].len;
+                if (available > 0) {
+                    memcpy(ranges[k].base, buffer + (ranges[k].offset - start), available);
+                    total += available;
+                }
+            }
+            g_free(buffer);
+        }
+    }
+    g_free(ranges);
+
+    if (tmp_err)
+        total = -1;
+    G_RETURN_ERR(total, tmp_err, err);
+}
+
+// Execute a preadv function on the appropriate plugin
+ssize_t gfal_plugin_preadvG(gfal2_context_t handle, gfal_file_handle fh, const struct iovec* iov,
+        const off_t* offsets, int iovcnt, GError** err)
+{
+    g_return_val_err_if_fail(handle && fh, -1, err, "[gfal_plugin_preadvG] Invalid args ");
+    GError* tmp_err = NULL;
+    ssize_t res = -1;
+    gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
+    if (!tmp_err) {
+        if (if_cata->preadvG)
+            res = if_cata->preadvG(if_cata->plugin_data, fh, iov, offsets, iovcnt, &tmp_err);
+        else
+            res = gfal_plugin_simulate_preadvG(handle, fh, iov, offsets, iovcnt, &tmp_err);
+    }
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
 // Simulate a pread operation in case of non-parallels write support
 // this is slower than a normal pread/pwrite operation
 static ssize_t gfal_plugin_simulate_pwriteG(gfal2_context_t handle, gfal_plugin_interface* if_cata, gfal_file_handle fh, void* buff, size_t s_buff,
@@ -1082,6 +1467,24 @@ int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* co
 }
 
 
+int gfal_plugin_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+        struct stat* buffs, GError ** errors)
+{
+    GError* tmp_err = NULL;
+    gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_STAT, &tmp_err);
+
+    if (p && p->statG_list) {
+        return p->statG_list(gfal_get_plugin_handle(p), nbfiles, uris, buffs, errors);
+    }
+    // Fallback, each url goes to its own plugin, so let them report any error
+    g_clear_error(&tmp_err);
+    if (nbfiles == 1) {
+        return gfal_plugin_statG(handle, *uris, buffs, errors);
+    }
+    return gfal_stat_list_parallel(handle, nbfiles, uris, buffs, errors);
+}
+
+
 int gfal_plugin_abort_filesG(gfal2_context_t handle, int nbfiles,
         const char* const * uris, const char* token, GError ** errors)
 {
@@ -30,10 +30,12 @@
 #include "gfal_constants.h"
 #include "gfal_file_handle.h"
 #include <transfer/gfal_transfer_plugins.h>
+#include <file/gfal_async_plugins.h>
 
 #include <glib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -52,6 +54,8 @@ extern "C"
 #define GFAL_PLUGIN_PRIORITY_CATALOG 100; /**< The plugin provides namespace operations */
 #define GFAL_PLUGIN_PRIORITY_CACHE 200;   /**< The plugin provides a cache */
 
+#define GFAL_PLUGIN_CAP_READDIRPP_FULL_STAT 0x1 /**< readdirppG gives the same stat as statG */
+
 
 typedef struct _gfal_plugin_interface gfal_plugin_interface;
 typedef gpointer plugin_handle;
@@ -650,9 +654,80 @@ struct _gfal_plugin_interface {
    */
   int (*change_object_qos)(plugin_handle plugin_data, const char* url, const char* target_qos, GError** err);
 
+    // Dispatch
+
+    /**
+     *  OPTIONAL: NULL terminated list of the URL schemes owned by this plugin (ex: {"gsiftp", "ftp", NULL})
+     *
+     *  Plugins are always probed by priority. Listing its schemes tells the core that this plugin rejects
+     *  any URL of another scheme, so the plugin elected for a scheme after it can be remembered and confirmed
+     *  with a single check_plugin_url call. A plugin may list a scheme and still reject some operations or
+     *  URLs for it, then the plugins after it are not remembered for that scheme.
+     *  The array must remain valid while the plugin is loaded.
+     */
+    const char* const* schemes;
+
+    // Asynchronous operations
+
+    /**
+     *  OPTIONAL: Start an operation without waiting for it to finish
+     *
+     *  Called for stat, checksum, unlink, mkdir, open and pread operations submitted to a completion queue,
+     *  see gfal_async_plugins.h for their parameters. The plugin must complete op exactly once, from any thread,
+     *  with gfal2_async_complete (gfal2_async_complete_open for open).
+     *  If the plugin can not run a given operation asynchronously, it can return -1 with an ENOSYS error,
+     *  and the core runs the blocking version in a thread pool.
+     *
+     *  @param plugin_data : internal plugin data
+     *  @param op : the operation
+     *  @param err : GError error support
+     *  @return 0 if the operation has been started, -1 if error occurs. Then op must not be completed.
+     */
+    int (*async_submitG)(plugin_handle plugin_data, gfal2_async_op_t op, GError** err);
+
+    /**
+     *  OPTIONAL: Bulk stat
+     *
+     *  If not provided, the core runs statG for each url, in parallel
+     *
+     *  @param plugin_data : internal plugin data
+     *  @param nbfiles : number of files in the list
+     *  @param urls : the urls of the files
+     *  @param buffs : array of nbfiles stat buffers
+     *  @param errors : array of nbfiles pointers to GError, errors[i] is set if urls[i] can not be stat
+     *  @return 0 if all the files have been stat, a negative value otherwise
+     */
+    int (*statG_list)(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+            struct stat* buffs, GError** errors);
+
+    /**
+     *  OPTIONAL: Vectored read
+     *
+     *  Read iovcnt ranges of the file in as few round trips as possible.
+     *  If not provided, the core sorts the ranges, merges the adjacent ones, and calls preadG
+     *
+     *  @param plugin_data : internal plugin data
+     *  @param fd : file handle
+     *  @param iov : buffers, iov[i] is filled from offsets[i]
+     *  @param offsets : offset of each range in the file
+     *  @param iovcnt : number of ranges
+     *  @param err : error handle, should be used ONLY in case of major failure.
+     *  @return the total number of bytes read, -1 on failure
+     */
+    ssize_t (*preadvG)(plugin_handle plugin_data, gfal_file_handle fd, const struct iovec* iov,
+            const off_t* offsets, int iovcnt, GError** err);
+
+    /**
+     *  OPTIONAL: flags describing what the plugin provides, GFAL_PLUGIN_CAP_*
+     *
+     *  GFAL_PLUGIN_CAP_READDIRPP_FULL_STAT must be set only if readdirppG fills the stat as statG does,
+     *  the core stat cache keeps the stats of the listings only in that case
+     */
+    int capabilities;
+
 	 // reserved for future usage
 	 //! @cond
-     void* future[9];
+     void* future[4];
 	 //! @endcond
 };
 
@@ -692,6 +767,9 @@ int gfal_plugin_lseekG(gfal2_context_t handle, gfal_file_handle fh, off_t offset
 int gfal_plugin_readG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, GError** err);
 
 ssize_t gfal_plugin_preadG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, off_t offset, GError** err);
+
+ssize_t gfal_plugin_preadvG(gfal2_context_t handle, gfal_file_handle fh, const struct iovec* iov,
+        const off_t* offsets, int iovcnt, GError** err);
 ssize_t gfal_plugin_pwriteG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, off_t offset, GError** err);
 
 
@@ -728,6 +806,9 @@ int gfal_plugin_release_file_listG(gfal2_context_t handle, int nbfiles, const ch
 
 int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* const* uris, GError ** errors);
 
+int gfal_plugin_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+        struct stat* buffs, GError ** errors);
+
 int gfal_plugin_abort_filesG(gfal2_context_t handle, int nbfiles, const char* const* uris, const char* token, GError ** err);
 
 ssize_t gfal_plugin_qos_check_classes(gfal2_context_t handle, const char* url, const char* type,
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_PLUGIN_INTERNAL_H_
+#define GFAL_PLUGIN_INTERNAL_H_
+
+#include "gfal_handle.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif  // __cplusplus
+
+// Plugin constructor, as exported by the shared objects
+typedef gfal_plugin_interface (*gfal_plugin_constructor_t)(gfal2_context_t handle, GError** err);
+
+// Shared object providing a plugin, loaded once per process
+typedef struct _gfal_plugin_module {
+    char* path;
+    // set on first use for the plugins listed in a manifest, see gfal_registry_open_module
+    void* dlhandle;
+    gfal_plugin_constructor_t constructor;
+    // listed in a manifest, so only loaded when one of its schemes is dispatched
+    gboolean lazy;
+    int priority;
+    char** schemes;
+} gfal_plugin_module;
+
+// Process-wide state shared by all the contexts, see gfal_registry_get.
+// Published under its lock once fully built, and never freed afterwards.
+// The config and the list of modules do not change from then on, only the dlhandle
+// and constructor of the lazy modules are set later, by gfal_registry_open_module
+typedef struct _gfal_registry {
+    // configuration as parsed from the configuration directory
+    GKeyFile* config;
+    int module_number;
+    gfal_plugin_module modules[MAX_PLUGIN_LIST];
+} gfal_registry;
+
+// State of each entry of the plugin list
+enum {
+    // plugin instantiated for this context
+    GFAL_PLUGIN_READY = 0,
+    // copied from the parent context, instantiated on first use
+    GFAL_PLUGIN_PENDING,
+    // registered on the parent context, which keeps its ownership
+    GFAL_PLUGIN_BORROWED,
+    // listed in a manifest, but could not be instantiated, so it is skipped
+    GFAL_PLUGIN_FAILED
+};
+
+// directory the plugins are loaded from
+const char* gfal_plugins_directory(void);
+
+// list the shared objects of a plugin directory
+char** gfal_list_directory_plugins(const char* dir, GError** err);
+
+// return the process-wide registry, loading it on first call
+const gfal_registry* gfal_registry_get(GError** err);
+
+// dlopen the library of a lazy module, if it was not already
+int gfal_registry_open_module(const gfal_plugin_module* module, GError** err);
+
+// make sure the plugin is instantiated for this context before calling it
+// A plugin that fails is logged once, and then refused without trying again
+int gfal_plugin_instance(gfal2_context_t handle, gfal_plugin_interface* p, GError** err);
+
+// FALSE if p is listed in a manifest which does not declare the scheme of url
+gboolean gfal_plugin_manifest_allows(gfal2_context_t handle, gfal_plugin_interface* p, const char* url);
+
+// name of the plugin, loading it if needed
+const char* gfal_plugin_get_name(gfal2_context_t handle, gfal_plugin_interface* p);
+
+// copy the plugin list of parent, the copies are instantiated on first use
+int gfal_plugins_clone(gfal2_context_t handle, gfal2_context_t parent, GError** err);
+
+// create or delete the per-context plugin dispatch cache, internal
+void gfal_plugin_dispatch_cache_init(gfal2_context_t handle);
+
+void gfal_plugin_dispatch_cache_destroy(gfal2_context_t handle);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* GFAL_PLUGIN_INTERNAL_H_ */
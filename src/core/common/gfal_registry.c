@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <common/gfal_common.h>
+#include <common/gfal_config_internal.h>
+#include <common/gfal_plugin.h>
+#include <common/gfal_plugin_internal.h>
+#include <logger/gfal_logger.h>
+
+
+// The configuration files are parsed, and the plugins opened, by the first context
+// only. The following ones start from a copy of the same state.
+// registry_lock protects the publication of the registry, built before it is set,
+// and the opening of the lazy modules. Their dlhandle and constructor are only read
+// after gfal_registry_open_module returned, so after the lock was taken
+static gfal_registry* registry = NULL;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void gfal_registry_free(gfal_registry* r)
+{
+    int i;
+    for (i = 0; i < r->module_number; ++i) {
+        g_free(r->modules[i].path);
+        g_strfreev(r->modules[i].schemes);
+    }
+    if (r->config)
+        g_key_file_free(r->config);
+    g_free(r);
+}
+
+
+// Merge all the *.manifest files of the plugin directory
+// A manifest has a group per library, named after its file name
+//
+// [libgfal_plugin_file.so]
+// SCHEMES=file
+// PRIORITY=0
+//
+// A broken manifest is ignored, so its plugins are loaded upfront as if it was not there
+static GKeyFile* gfal_registry_load_manifests(const char* dir)
+{
+    GKeyFile* manifests = g_key_file_new();
+    GDir* d = g_dir_open(dir, 0, NULL);
+    if (d == NULL)
+        return manifests;
+
+    const gchar* d_name;
+    while ((d_name = g_dir_read_name(d)) != NULL) {
+        if (!g_str_has_suffix(d_name, GFAL_PLUGIN_MANIFEST_SUFFIX))
+            continue;
+        GError* tmp_err = NULL;
+        char* path = g_build_filename(dir, d_name, NULL);
+        if (gfal_load_configuration_to_conf_manager(manifests, path, &tmp_err) != 0) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring the plugin manifest %s: %s", path, tmp_err->message);
+            g_error_free(tmp_err);
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_DEBUG, " plugin manifest loaded: %s", path);
+        }
+        g_free(path);
+    }
+    g_dir_close(d);
+    return manifests;
+}
+
+
+// On failure, dlhandle is left to NULL if the library itself could not be opened
+static int gfal_registry_dlopen(gfal_plugin_module* module, GError** err)
+{
+    module->dlhandle = dlopen(module->path, RTLD_NOW);
+    if (module->dlhandle == NULL) {
+        gfal2_set_error(err, gfal2_get_plugins_quark(), EINVAL, __func__,
+            "Unable to open the %s plugin specified in the plugin directory: %s", module->path, dlerror());
+        return -1;
+    }
+
+    module->constructor = (gfal_plugin_constructor_t) dlsym(module->dlhandle, GFAL_PLUGIN_INIT_SYM);
+    if (module->constructor == NULL) {
+        gfal2_set_error(err, gfal2_get_plugins_quark(), EINVAL, __func__,
+            "No symbol %s found in the plugin %s, failure", GFAL_PLUGIN_INIT_SYM, module->path);
+        return -1;
+    }
+    return 0;
+}
+
+
+// dlopen the plugins of the plugin directory, but for those listed in a manifest,
+// which are opened the first time they are needed.
+// The shared objects are never closed, as the plugins may leave
+// callbacks behind them (i.e. atexit or thread local destructors)
+static int gfal_registry_load_modules(gfal_registry* r, GError** err)
+{
+    GError* tmp_err = NULL;
+    const char* dir = gfal_plugins_directory();
+    char** paths = gfal_list_directory_plugins(dir, &tmp_err);
+    GKeyFile* manifests = gfal_registry_load_manifests(dir);
+    char** p;
+
+    for (p = paths; p != NULL && *p != NULL && **p != '\0' && tmp_err == NULL; ++p) {
+        if (r->module_number >= MAX_PLUGIN_LIST) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Too many plugins, %s ignored", *p);
+            continue;
+        }
+
+        gfal_plugin_module* module = &r->modules[r->module_number];
+        memset(module, 0, sizeof(*module));
+        module->path = g_strdup(*p);
+
+        char* library = g_path_get_basename(*p);
+        if (g_key_file_has_group(manifests, library)) {
+            module->lazy = TRUE;
+            module->priority = g_key_file_get_integer(manifests, library, "PRIORITY", NULL);
+            module->schemes = g_key_file_get_string_list(manifests, library, "SCHEMES", NULL, NULL);
+            gfal2_log(G_LOG_LEVEL_DEBUG, " %s listed in a manifest, loaded on first use", library);
+            r->module_number++;
+        }
+        else {
+            GError* open_err = NULL;
+            if (gfal_registry_dlopen(module, &open_err) == 0) {
+                r->module_number++;
+            }
+            else if (module->dlhandle == NULL) {
+                // as before, a library that can not be opened is skipped
+                gfal2_log(G_LOG_LEVEL_WARNING, "%s", open_err->message);
+                g_error_free(open_err);
+                g_free(module->path);
+            }
+            else {
+                g_propagate_error(&tmp_err, open_err);
+                g_free(module->path);
+            }
+        }
+        g_free(library);
+    }
+    g_strfreev(paths);
+    g_key_file_free(manifests);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+const gfal_registry* gfal_registry_get(GError** err)
+{
+    GError* tmp_err = NULL;
+
+    pthread_mutex_lock(&registry_lock);
+    if (registry == NULL) {
+        gfal_registry* r = g_new0(gfal_registry, 1);
+        r->config = gfal2_init_config(&tmp_err);
+        if (r->config)
+            gfal_registry_load_modules(r, &tmp_err);
+        // on failure, the next context tries again
+        if (tmp_err)
+            gfal_registry_free(r);
+        else
+            registry = r;
+    }
+    pthread_mutex_unlock(&registry_lock);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+    return registry;
+}
+
+
+int gfal_registry_open_module(const gfal_plugin_module* module, GError** err)
+{
+    GError* tmp_err = NULL;
+    int res = 0;
+
+    pthread_mutex_lock(&registry_lock);
+    if (module->constructor == NULL) {
+        // modules belong to the registry, and are only modified here, under its lock
+        gfal_plugin_module* m = (gfal_plugin_module*) module;
+        res = gfal_registry_dlopen(m, &tmp_err);
+        if (res == 0)
+            gfal2_log(G_LOG_LEVEL_MESSAGE, "[gfal_module_load] plugin %s loaded with success ", m->path);
+        else
+            m->constructor = NULL;
+    }
+    pthread_mutex_unlock(&registry_lock);
+
+    if (tmp_err)
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    return res;
+}
@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <sys/time.h>
+
+#include <file/gfal_file_api.h>
+#include <file/gfal_async_internal.h>
+
+#include <common/gfal_config.h>
+#include <common/gfal_handle.h>
+#include <common/gfal_error.h>
+#include <common/gfal_plugin.h>
+#include <common/gfal_file_handler_container.h>
+#include <logger/gfal_logger.h>
+
+#define GFAL_ASYNC_THREADS_DEFAULT 16
+
+
+// Release the handle referenced by the operation, if any
+static void gfal_async_release_internal(gfal2_async_op_t op)
+{
+    if (op->fd > 0) {
+        gfal_file_handle_unref(op->queue->context->fdescs, op->fd);
+        op->fd = 0;
+    }
+}
+
+
+static void gfal_async_op_free_internal(gfal2_async_op_t op)
+{
+    gfal_async_release_internal(op);
+    if (op->data_free) {
+        op->data_free(op->data);
+    }
+    gfal2_operation_free(op->operation);
+    g_clear_error(&op->error);
+    g_free(op->url);
+    g_free(op->check_type);
+    g_free(op);
+}
+
+
+static void gfal_async_complete_internal(gfal2_async_op_t op, ssize_t result, GError* error)
+{
+    gfal2_async_queue_t queue = op->queue;
+
+    op->result = result;
+    op->error = error;
+    // fd can be closed as soon as the operation is retrieved
+    gfal_async_release_internal(op);
+
+    pthread_mutex_lock(&queue->lock);
+    g_queue_push_tail(&queue->completed, op);
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+
+// Run by the thread pool
+static void gfal_async_worker(gpointer data, gpointer user_data)
+{
+    gfal2_async_op_t op = data;
+    gfal2_async_queue_t queue = user_data;
+    GError* tmp_err = NULL;
+
+    gfal_operation_t previous = gfal2_operation_attach(op->operation);
+    ssize_t result = op->run(queue->context, op, &tmp_err);
+    gfal2_operation_attach(previous);
+
+    gfal_async_complete_internal(op, result, tmp_err);
+}
+
+
+static gfal_plugin_interface* gfal_async_find_plugin(gfal2_async_op_t op, GError** err)
+{
+    gfal2_context_t context = op->queue->context;
+    switch (op->args.type) {
+        case GFAL_ASYNC_STAT:
+            return gfal_find_plugin(context, op->args.url, GFAL_PLUGIN_STAT, err);
+        case GFAL_ASYNC_CHECKSUM:
+            return gfal_find_plugin(context, op->args.url, GFAL_PLUGIN_CHECKSUM, err);
+        case GFAL_ASYNC_UNLINK:
+            return gfal_find_plugin(context, op->args.url, GFAL_PLUGIN_UNLINK, err);
+        case GFAL_ASYNC_MKDIR:
+            return gfal_find_plugin(context, op->args.url, GFAL_PLUGIN_MKDIR, err);
+        case GFAL_ASYNC_OPEN:
+            return gfal_find_plugin(context, op->args.url, GFAL_PLUGIN_OPEN, err);
+        case GFAL_ASYNC_PREAD:
+            return gfal_plugin_map_file_handle(context, op->args.fh, err);
+        default:
+            return NULL;
+    }
+}
+
+
+// Let the plugin start the operation
+// Returns 0 if it did, 1 if the operation must be run by the thread pool
+static int gfal_async_submit_native(gfal2_async_op_t op, GError** err)
+{
+    GError* tmp_err = NULL;
+
+    // no native implementation for operations going through the core (i.e. copies)
+    if (op->args.type == GFAL_ASYNC_COPY) {
+        return 1;
+    }
+
+    gfal_plugin_interface* plugin = gfal_async_find_plugin(op, &tmp_err);
+    if (plugin == NULL || plugin->async_submitG == NULL) {
+        // let the blocking version report any error
+        g_clear_error(&tmp_err);
+        return 1;
+    }
+
+    gfal_operation_t previous = gfal2_operation_attach(op->operation);
+    int ret = plugin->async_submitG(gfal_get_plugin_handle(plugin), op, &tmp_err);
+    gfal2_operation_attach(previous);
+
+    if (ret < 0) {
+        if (tmp_err && tmp_err->code == ENOSYS) {
+            g_clear_error(&tmp_err);
+            return 1;
+        }
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+gfal2_async_queue_t gfal2_async_queue_new(gfal2_context_t context, GError** err)
+{
+    g_return_val_err_if_fail(context != NULL, NULL, err, "[gfal2_async_queue_new] invalid context");
+
+    gfal2_async_queue_t queue = g_new0(struct gfal_async_queue_s, 1);
+    queue->context = context;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    g_queue_init(&queue->completed);
+    return queue;
+}
+
+
+void gfal2_async_queue_free(gfal2_async_queue_t queue)
+{
+    gfal2_async_op_t op;
+
+    if (queue == NULL) {
+        return;
+    }
+    while ((op = gfal2_async_wait(queue, -1)) != NULL) {
+        gfal_async_op_free_internal(op);
+    }
+    if (queue->pool) {
+        g_thread_pool_free(queue->pool, FALSE, TRUE);
+    }
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->lock);
+    g_free(queue);
+}
+
+
+gfal2_async_op_t gfal_async_op_new(gfal2_async_queue_t queue, gfal2_async_type_t type, gpointer user_data)
+{
+    gfal2_async_op_t op = g_new0(struct gfal_async_op_s, 1);
+    op->queue = queue;
+    op->args.type = type;
+    op->user_data = user_data;
+    op->operation = gfal2_operation_new(queue->context);
+    return op;
+}
+
+
+gfal2_async_op_t gfal_async_submit(gfal2_async_op_t op, GError** err)
+{
+    gfal2_async_queue_t queue = op->queue;
+    GError* tmp_err = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    ++queue->pending;
+    pthread_mutex_unlock(&queue->lock);
+
+    int ret = gfal_async_submit_native(op, &tmp_err);
+    if (ret > 0) {
+        pthread_mutex_lock(&queue->lock);
+        if (queue->pool == NULL) {
+            gint max_threads = gfal2_get_opt_integer_with_default(queue->context,
+                    CORE_CONFIG_GROUP, CORE_CONFIG_ASYNC_THREADS, GFAL_ASYNC_THREADS_DEFAULT);
+            if (max_threads <= 0) {
+                max_threads = GFAL_ASYNC_THREADS_DEFAULT;
+            }
+            queue->pool = g_thread_pool_new(gfal_async_worker, queue, max_threads, FALSE, &tmp_err);
+        }
+        pthread_mutex_unlock(&queue->lock);
+
+        if (queue->pool) {
+            g_thread_pool_push(queue->pool, op, &tmp_err);
+        }
+        ret = (tmp_err == NULL) ? 0 : -1;
+    }
+
+    if (ret < 0) {
+        pthread_mutex_lock(&queue->lock);
+        --queue->pending;
+        pthread_mutex_unlock(&queue->lock);
+        gfal_async_op_free_internal(op);
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+    return op;
+}
+
+
+static ssize_t gfal_async_run_stat(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    return gfal2_stat(context, op->args.url, op->args.st, err);
+}
+
+
+gfal2_async_op_t gfal2_async_stat(gfal2_async_queue_t queue, const char* url, struct stat* buff,
+        gpointer user_data, GError** err)
+{
+    g_return_val_err_if_fail(queue && url && buff, NULL, err, "[gfal2_async_stat] invalid parameters");
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_STAT, user_data);
+    op->args.url = op->url = g_strdup(url);
+    op->args.st = buff;
+    op->run = gfal_async_run_stat;
+    return gfal_async_submit(op, err);
+}
+
+
+static ssize_t gfal_async_run_checksum(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    return gfal2_checksum(context, op->args.url, op->args.check_type, op->args.offset, op->args.length,
+            op->args.buffer, op->args.buffer_size, err);
+}
+
+
+gfal2_async_op_t gfal2_async_checksum(gfal2_async_queue_t queue, const char* url, const char* check_type,
+        off_t start_offset, size_t data_length, char* checksum_buffer, size_t buffer_length,
+        gpointer user_data, GError** err)
+{
+    g_return_val_err_if_fail(queue && url && check_type && checksum_buffer, NULL, err,
+            "[gfal2_async_checksum] invalid parameters");
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_CHECKSUM, user_data);
+    op->args.url = op->url = g_strdup(url);
+    op->args.check_type = op->check_type = g_strdup(check_type);
+    op->args.offset = start_offset;
+    op->args.length = data_length;
+    op->args.buffer = checksum_buffer;
+    op->args.buffer_size = buffer_length;
+    op->run = gfal_async_run_checksum;
+    return gfal_async_submit(op, err);
+}
+
+
+static ssize_t gfal_async_run_unlink(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    return gfal2_unlink(context, op->args.url, err);
+}
+
+
+gfal2_async_op_t gfal2_async_unlink(gfal2_async_queue_t queue, const char* url,
+        gpointer user_data, GError** err)
+{
+    g_return_val_err_if_fail(queue && url, NULL, err, "[gfal2_async_unlink] invalid parameters");
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_UNLINK, user_data);
+    op->args.url = op->url = g_strdup(url);
+    op->run = gfal_async_run_unlink;
+    return gfal_async_submit(op, err);
+}
+
+
+static ssize_t gfal_async_run_mkdir(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    return gfal2_mkdir(context, op->args.url, op->args.mode, err);
+}
+
+
+gfal2_async_op_t gfal2_async_mkdir(gfal2_async_queue_t queue, const char* url, mode_t mode,
+        gpointer user_data, GError** err)
+{
+    g_return_val_err_if_fail(queue && url, NULL, err, "[gfal2_async_mkdir] invalid parameters");
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_MKDIR, user_data);
+    op->args.url = op->url = g_strdup(url);
+    op->args.mode = mode;
+    op->run = gfal_async_run_mkdir;
+    return gfal_async_submit(op, err);
+}
+
+
+static ssize_t gfal_async_run_open(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    return gfal2_open2(context, op->args.url, op->args.flags, op->args.mode, err);
+}
+
+
+gfal2_async_op_t gfal2_async_open(gfal2_async_queue_t queue, const char* url, int flags, mode_t mode,
+        gpointer user_data, GError** err)
+{
+    g_return_val_err_if_fail(queue && url, NULL, err, "[gfal2_async_open] invalid parameters");
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_OPEN, user_data);
+    op->args.url = op->url = g_strdup(url);
+    op->args.flags = flags;
+    op->args.mode = mode;
+    op->run = gfal_async_run_open;
+    return gfal_async_submit(op, err);
+}
+
+
+static ssize_t gfal_async_run_pread(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    // the handle has been resolved already, but the cancel scope is handled by gfal2_pread
+    GError* tmp_err = NULL;
+    ssize_t res = -1;
+    if (gfal2_start_scope_cancel(context, &tmp_err) == 0) {
+        res = gfal_plugin_preadG(context, op->args.fh, op->args.buffer, op->args.buffer_size,
+                op->args.offset, &tmp_err);
+        gfal2_end_scope_cancel(context);
+    }
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+
+gfal2_async_op_t gfal2_async_pread(gfal2_async_queue_t queue, int fd, void* buffer, size_t count,
+        off_t offset, gpointer user_data, GError** err)
+{
+    GError* tmp_err = NULL;
+    g_return_val_err_if_fail(queue && buffer, NULL, err, "[gfal2_async_pread] invalid parameters");
+
+    gfal_file_handle fh = NULL;
+    if (fd <= 0) {
+        gfal2_set_error(&tmp_err, gfal2_get_core_quark(), EBADF, __func__, "Incorrect file descriptor");
+    }
+    else {
+        fh = gfal_file_handle_ref(queue->context->fdescs, fd, &tmp_err);
+    }
+    if (fh == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_PREAD, user_data);
+    op->args.fh = fh;
+    op->fd = fd;
+    op->args.buffer = buffer;
+    op->args.buffer_size = count;
+    op->args.length = count;
+    op->args.offset = offset;
+    op->run = gfal_async_run_pread;
+    return gfal_async_submit(op, err);
+}
+
+
+static gfal2_async_op_t gfal_async_pop(gfal2_async_queue_t queue)
+{
+    gfal2_async_op_t op = g_queue_pop_head(&queue->completed);
+    if (op) {
+        --queue->pending;
+    }
+    return op;
+}
+
+
+gfal2_async_op_t gfal2_async_poll(gfal2_async_queue_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    gfal2_async_op_t op = gfal_async_pop(queue);
+    pthread_mutex_unlock(&queue->lock);
+    return op;
+}
+
+
+gfal2_async_op_t gfal2_async_wait(gfal2_async_queue_t queue, int timeout)
+{
+    struct timespec deadline;
+    if (timeout >= 0) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        deadline.tv_sec = now.tv_sec + timeout / 1000;
+        deadline.tv_nsec = now.tv_usec * 1000 + (timeout % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    gfal2_async_op_t op = gfal_async_pop(queue);
+    while (op == NULL && queue->pending > 0) {
+        if (timeout < 0) {
+            pthread_cond_wait(&queue->cond, &queue->lock);
+        }
+        else if (pthread_cond_timedwait(&queue->cond, &queue->lock, &deadline) == ETIMEDOUT) {
+            op = gfal_async_pop(queue);
+            break;
+        }
+        op = gfal_async_pop(queue);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return op;
+}
+
+
+guint gfal2_async_pending(gfal2_async_queue_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    guint pending = queue->pending;
+    pthread_mutex_unlock(&queue->lock);
+    return pending;
+}
+
+
+int gfal2_async_cancel(gfal2_async_op_t op)
+{
+    return gfal2_operation_cancel(op->operation);
+}
+
+
+gfal2_async_type_t gfal2_async_get_type(gfal2_async_op_t op)
+{
+    return op->args.type;
+}
+
+
+gpointer gfal2_async_get_user_data(gfal2_async_op_t op)
+{
+    return op->user_data;
+}
+
+
+ssize_t gfal2_async_get_result(gfal2_async_op_t op, GError** err)
+{
+    if (op->error) {
+        g_propagate_error(err, g_error_copy(op->error));
+    }
+    return op->result;
+}
+
+
+void gfal2_async_op_free(gfal2_async_op_t op)
+{
+    if (op) {
+        gfal_async_op_free_internal(op);
+    }
+}
+
+
+const gfal2_async_args_t* gfal2_async_get_args(gfal2_async_op_t op)
+{
+    return &op->args;
+}
+
+
+gboolean gfal2_async_is_canceled(gfal2_async_op_t op)
+{
+    return gfal2_operation_is_canceled(op->operation) || op->queue->context->cancel;
+}
+
+
+void gfal2_async_complete(gfal2_async_op_t op, ssize_t result, GError* error)
+{
+    if (result < 0 && error == NULL) {
+        gfal2_set_error(&error, gfal2_get_core_quark(), EIO, __func__, "Operation failed without any error");
+    }
+    gfal_async_complete_internal(op, result, error);
+}
+
+
+void gfal2_async_complete_open(gfal2_async_op_t op, gfal_file_handle fh, GError* error)
+{
+    int fd = -1;
+    if (fh) {
+        fd = gfal_add_new_file_desc(op->queue->context->fdescs, fh, &error);
+        if (fd <= 0) {
+            fd = -1;
+        }
+    }
+    gfal2_async_complete(op, fd, error);
+}
+
+
+int gfal_stat_list_parallel(gfal2_context_t context, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError** errors)
+{
+    int i, res = 0;
+    GError* tmp_err = NULL;
+    gfal2_async_op_t op;
+
+    gfal2_async_queue_t queue = gfal2_async_queue_new(context, &tmp_err);
+    if (queue == NULL) {
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+        return -1;
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (gfal2_async_stat(queue, urls[i], &buffs[i], GINT_TO_POINTER(i), &errors[i]) == NULL) {
+            res = -1;
+        }
+    }
+    while ((op = gfal2_async_wait(queue, -1)) != NULL) {
+        i = GPOINTER_TO_INT(gfal2_async_get_user_data(op));
+        if (gfal2_async_get_result(op, &errors[i]) < 0) {
+            res = -1;
+        }
+        gfal2_async_op_free(op);
+    }
+
+    gfal2_async_queue_free(queue);
+    return res;
+}
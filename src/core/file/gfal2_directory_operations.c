@@ -19,12 +19,14 @@
  */
 
 #include <regex.h>
+#include <string.h>
 #include <file/gfal_file_api.h>
 
 #include <common/gfal_handle.h>
 #include <common/gfal_error.h>
 #include <common/gfal_file_handler_container.h>
 #include <common/gfal_cancel.h>
+#include <file/gfal_stat_cache_internal.h>
 
 
 #ifdef __APPLE__
@@ -104,11 +106,35 @@ static size_t gfal_rw_get_root_length(const char *surl)
 }
 
 
+static char *gfal_rw_get_entry_url(const char *dir_url, const char *d_name)
+{
+    char *url = NULL;
+    if (d_name[0] != '/') {
+        const size_t dir_len = strlen(dir_url);
+        if (dir_len > 0 && dir_url[dir_len - 1] == '/') {
+            url = g_strconcat(dir_url, d_name, NULL);
+        }
+        else {
+            url = g_strconcat(dir_url, "/", d_name, NULL);
+        }
+    }
+    else {
+        size_t root_len = gfal_rw_get_root_length(dir_url);
+        char *root = g_strndup(dir_url, root_len);
+        url = g_strconcat(root, d_name, NULL);
+        g_free(root);
+    }
+    return url;
+}
+
+
 static struct dirent *
 gfal_rw_gfalfilehandle_readdirpp(gfal2_context_t context, gfal_file_handle fh, struct stat *st, GError **err)
 {
     g_return_val_err_if_fail(context && fh, NULL, err, "[gfal_posix_gfalfilehandle_readdirpp] incorrect args");
     GError *tmp_err = NULL;
+    gint stamp = 0;
+    const gboolean cache_entries = (fh->path != NULL && gfal_stat_cache_stamp(context, &stamp) == 0);
     struct dirent *ret = gfal_plugin_readdirppG(context, fh, st, &tmp_err);
 
     // try to simulate readdirpp
@@ -116,24 +142,22 @@ gfal_rw_gfalfilehandle_readdirpp(gfal2_context_t context, gfal_file_handle fh, s
         g_clear_error(&tmp_err);
         ret = gfal_plugin_readdirG(context, fh, &tmp_err);
         if (!tmp_err && ret != NULL) {
-            char *url = NULL;
-
-            if (ret->d_name[0] != '/') {
-                url = g_strconcat(fh->path, "/", ret->d_name, NULL);
-            }
-            else {
-                size_t root_len = gfal_rw_get_root_length(fh->path);
-                char *root = g_strndup(fh->path, root_len);
-                url = g_strconcat(root, ret->d_name, NULL);
-                g_free(root);
-            }
-
+            char *url = gfal_rw_get_entry_url(fh->path, ret->d_name);
             if (gfal2_stat(context, url, st, &tmp_err) < 0) {
                 ret = NULL;
             }
             g_free(url);
         }
     }
+    // the stat of the entries is there already, keep it for the stat that usually follows,
+    // unless the plugin fills only part of it
+    else if (ret != NULL && cache_entries && fh->plugin != NULL &&
+             (fh->plugin->capabilities & GFAL_PLUGIN_CAP_READDIRPP_FULL_STAT) &&
+             strcmp(ret->d_name, ".") != 0 && strcmp(ret->d_name, "..") != 0) {
+        char *url = gfal_rw_get_entry_url(fh->path, ret->d_name);
+        gfal_stat_cache_put(context, url, stamp, st, NULL);
+        g_free(url);
+    }
 
     G_RETURN_ERR(ret, tmp_err, err);
 }
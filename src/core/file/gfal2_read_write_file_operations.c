@@ -24,6 +24,9 @@
 #include <common/gfal_error.h>
 #include <common/gfal_file_handler_container.h>
 #include <common/gfal_cancel.h>
+#include <file/gfal_readahead_internal.h>
+#include <file/gfal_writebehind_internal.h>
+#include <file/gfal_stat_cache_internal.h>
 
 
 /*
@@ -40,6 +43,23 @@ static int gfal_rw_file_handle_store(gfal2_context_t handle, gfal_file_handle fh
 }
 
 
+/*
+ *  the data written behind must reach the plugin before any other operation on the file
+ */
+static int gfal_rw_flush_pending(gfal_file_handle fh, GError **err)
+{
+    if (fh->writebehind)
+        return gfal_writebehind_flush(fh->writebehind, err);
+    return 0;
+}
+
+
+static gboolean gfal_rw_open_for_write(int flag)
+{
+    return (flag & O_ACCMODE) != O_RDONLY || (flag & (O_CREAT | O_TRUNC)) != 0;
+}
+
+
 int gfal2_open(gfal2_context_t handle, const char *uri, int flag, GError **err)
 {
     return gfal2_open2(handle, uri, flag, (S_IRWXU | S_IRGRP | S_IROTH), err);
@@ -58,11 +78,27 @@ int gfal2_open2(gfal2_context_t handle, const char *uri, int flag, mode_t mode,
         g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT, "name is empty");
     }
     else {
-        fhandle = gfal_plugin_openG(handle, uri, flag, mode, &tmp_err);
+        const gboolean write = gfal_rw_open_for_write(flag);
+        if (write) {
+            gfal_stat_cache_begin_write(handle, uri);
+        }
+        fhandle = gfal_plugin_openG(handle, uri, flag & ~(GFAL_O_READAHEAD | GFAL_O_WRITEBEHIND), mode, &tmp_err);
+        if (write && fhandle) {
+            fhandle->write_url = g_strdup(uri);
+        }
+        else if (write) {
+            gfal_stat_cache_end_write(handle, uri);
+        }
     }
 
     if (fhandle) {
         key = gfal_rw_file_handle_store(handle, fhandle, &tmp_err);
+        if (key > 0 && gfal_readahead_enabled(handle, flag)) {
+            fhandle->readahead = gfal_readahead_new(handle, key);
+        }
+        else if (key > 0 && gfal_writebehind_enabled(handle, flag)) {
+            fhandle->writebehind = gfal_writebehind_new(handle, fhandle);
+        }
     }
     GFAL2_END_SCOPE_CANCEL(handle);
     G_RETURN_ERR(key, tmp_err, err);
@@ -86,8 +122,11 @@ ssize_t gfal2_read(gfal2_context_t handle, int fd, void *buff, size_t s_buff, GE
     else {
         const int key = fd;
         gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
-        if (fh != NULL) {
-            res = gfal_plugin_readG(handle, fh, buff, s_buff, &tmp_err);
+        if (fh != NULL && gfal_rw_flush_pending(fh, &tmp_err) == 0) {
+            if (fh->readahead)
+                res = gfal_readahead_read(fh->readahead, fh, buff, s_buff, &tmp_err);
+            else
+                res = gfal_plugin_readG(handle, fh, buff, s_buff, &tmp_err);
         }
     }
     GFAL2_END_SCOPE_CANCEL(handle);
@@ -95,6 +134,29 @@ ssize_t gfal2_read(gfal2_context_t handle, int fd, void *buff, size_t s_buff, GE
 }
 
 
+int gfal2_readahead_get_stats(gfal2_context_t handle, int fd, gfal2_readahead_stats_t *stats, GError **err)
+{
+    GError *tmp_err = NULL;
+    int res = -1;
+    if (fd <= 0 || handle == NULL || stats == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EBADF, "Incorrect file descriptor or incorrect handle");
+    }
+    else {
+        gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, fd, &tmp_err);
+        if (fh != NULL) {
+            if (fh->readahead) {
+                gfal_readahead_get_stats(fh->readahead, stats);
+                res = 0;
+            }
+            else {
+                g_set_error(&tmp_err, gfal2_get_core_quark(), EINVAL, "Read-ahead not enabled for this file");
+            }
+        }
+    }
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+
 int gfal2_close(gfal2_context_t handle, int fd, GError **err)
 {
     GError *tmp_err = NULL;
@@ -107,10 +169,30 @@ int gfal2_close(gfal2_context_t handle, int fd, GError **err)
         int key = GPOINTER_TO_INT(fd);
         gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
         if (fh != NULL) {
+            GError *flush_err = NULL;
+            // let the asynchronous reads on fd complete first
+            gfal_file_handle_wait_unref(handle->fdescs, key);
+            gfal_readahead_free(fh->readahead);
+            fh->readahead = NULL;
+            gfal_writebehind_free(fh->writebehind, &flush_err);
+            fh->writebehind = NULL;
+            // the plugin may free fh
+            char *write_url = fh->write_url;
+            fh->write_url = NULL;
             ret = gfal_plugin_closeG(handle, fh, &tmp_err);
+            if (write_url) {
+                gfal_stat_cache_end_write(handle, write_url);
+                g_free(write_url);
+            }
             if (ret == 0) {
                 ret = (gfal_remove_file_desc(handle->fdescs, key, &tmp_err)) ? 0 : -1;
             }
+            // the file is closed anyway, but the data written behind may be lost
+            if (flush_err) {
+                g_clear_error(&tmp_err);
+                tmp_err = flush_err;
+                ret = -1;
+            }
         }
     }
     G_RETURN_ERR(ret, tmp_err, err);
@@ -128,8 +210,11 @@ off_t gfal2_lseek(gfal2_context_t handle, int fd, off_t offset, int whence, GErr
     else {
         const int key = fd;
         gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
-        if (fh != NULL) {
-            res = gfal_plugin_lseekG(handle, fh, offset, whence, &tmp_err);
+        if (fh != NULL && gfal_rw_flush_pending(fh, &tmp_err) == 0) {
+            if (fh->readahead)
+                res = gfal_readahead_lseek(fh->readahead, fh, offset, whence, &tmp_err);
+            else
+                res = gfal_plugin_lseekG(handle, fh, offset, whence, &tmp_err);
         }
     }
     GFAL2_END_SCOPE_CANCEL(handle);
@@ -139,7 +224,20 @@ off_t gfal2_lseek(gfal2_context_t handle, int fd, off_t offset, int whence, GErr
 
 int gfal2_flush(gfal2_context_t handle, int fd, GError **err)
 {
-    return 0;
+    GError *tmp_err = NULL;
+    int res = -1;
+    GFAL2_BEGIN_SCOPE_CANCEL(handle, -1, err);
+    if (fd <= 0 || handle == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EBADF, "Incorrect file descriptor or incorrect handle");
+    }
+    else {
+        gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, fd, &tmp_err);
+        if (fh != NULL) {
+            res = gfal_rw_flush_pending(fh, &tmp_err);
+        }
+    }
+    GFAL2_END_SCOPE_CANCEL(handle);
+    G_RETURN_ERR(res, tmp_err, err);
 }
 
 
@@ -154,7 +252,7 @@ ssize_t gfal2_pread(gfal2_context_t handle, int fd, void *buff, size_t s_buff, o
     else {
         const int key = fd;
         gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
-        if (fh != NULL) {
+        if (fh != NULL && gfal_rw_flush_pending(fh, &tmp_err) == 0) {
             res = gfal_plugin_preadG(handle, fh, buff, s_buff, offset, &tmp_err);
         }
     }
@@ -163,6 +261,30 @@ ssize_t gfal2_pread(gfal2_context_t handle, int fd, void *buff, size_t s_buff, o
 }
 
 
+ssize_t gfal2_preadv(gfal2_context_t handle, int fd, const struct iovec *iov, const off_t *offsets,
+    int iovcnt, GError **err)
+{
+    GError *tmp_err = NULL;
+    ssize_t res = -1;
+    GFAL2_BEGIN_SCOPE_CANCEL(handle, -1, err);
+    if (fd <= 0 || handle == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EBADF, "Incorrect file descriptor or incorrect handle");
+    }
+    else if (iovcnt < 0 || (iovcnt > 0 && (iov == NULL || offsets == NULL))) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EINVAL, "Invalid ranges");
+    }
+    else {
+        const int key = fd;
+        gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
+        if (fh != NULL && gfal_rw_flush_pending(fh, &tmp_err) == 0) {
+            res = gfal_plugin_preadvG(handle, fh, iov, offsets, iovcnt, &tmp_err);
+        }
+    }
+    GFAL2_END_SCOPE_CANCEL(handle);
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+
 ssize_t gfal2_write(gfal2_context_t handle, int fd, const void *buff, size_t s_buff, GError **err)
 {
     GError *tmp_err = NULL;
@@ -175,7 +297,10 @@ ssize_t gfal2_write(gfal2_context_t handle, int fd, const void *buff, size_t s_b
         const int key = fd;
         gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
         if (fh != NULL) {
-            res = gfal_plugin_writeG(handle, fh, (void *) buff, s_buff, &tmp_err);
+            if (fh->writebehind)
+                res = gfal_writebehind_write(fh->writebehind, buff, s_buff, &tmp_err);
+            else
+                res = gfal_plugin_writeG(handle, fh, (void *) buff, s_buff, &tmp_err);
         }
     }
     GFAL2_END_SCOPE_CANCEL(handle);
@@ -194,7 +319,7 @@ ssize_t gfal2_pwrite(gfal2_context_t handle, int fd, const void *buff, size_t s_
     else {
         const int key = fd;
         gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
-        if (fh != NULL) {
+        if (fh != NULL && gfal_rw_flush_pending(fh, &tmp_err) == 0) {
             res = gfal_plugin_pwriteG(handle, fh, (void *) buff, s_buff, offset, &tmp_err);
         }
     }
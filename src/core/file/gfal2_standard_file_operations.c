@@ -24,6 +24,8 @@
 #include <common/gfal_plugin.h>
 #include <common/gfal_error.h>
 #include <common/gfal_cancel.h>
+#include <file/gfal_checksum_cache_internal.h>
+#include <file/gfal_stat_cache_internal.h>
 
 int gfal2_access(gfal2_context_t context, const char *url, int amode, GError **err)
 {
@@ -53,6 +55,7 @@ int gfal2_chmod(gfal2_context_t context, const char *url, mode_t mode, GError **
     }
     else {
         res = gfal_plugin_chmodG(context, url, mode, &tmp_err);
+        gfal_stat_cache_invalidate(context, url);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -70,6 +73,10 @@ int gfal2_rename(gfal2_context_t context, const char *oldurl, const char *newurl
     }
     else {
         res = gfal_plugin_renameG(context, oldurl, newurl, &tmp_err);
+        // either may be a directory, with its children cached under the old names,
+        // or known not to exist under the new one
+        gfal_stat_cache_invalidate_tree(context, oldurl);
+        gfal_stat_cache_invalidate_tree(context, newurl);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -80,12 +87,20 @@ int gfal2_stat(gfal2_context_t context, const char *url, struct stat *buff, GErr
 {
     GError *tmp_err = NULL;
     int res = -1;
+    int cached = -1;
+    gint stamp = 0;
     GFAL2_BEGIN_SCOPE_CANCEL(context, -1, err);
     if (url == NULL || context == NULL || buff == NULL) {
         g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT, "context or/and url or/and buff are incorrect arguments");
     }
+    else if ((cached = gfal_stat_cache_get(context, url, buff, &stamp, &tmp_err)) > 0) {
+        res = (tmp_err == NULL) ? 0 : -1;
+    }
     else {
         res = gfal_plugin_statG(context, url, buff, &tmp_err);
+        if (cached == 0) {
+            gfal_stat_cache_put(context, url, stamp, (res == 0) ? buff : NULL, tmp_err);
+        }
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -124,6 +139,7 @@ int gfal2_mkdir(gfal2_context_t context, const char *url, mode_t mode, GError **
     }
     else {
         res = gfal_plugin_mkdirp(context, url, mode, FALSE, &tmp_err);
+        gfal_stat_cache_invalidate(context, url);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -200,10 +216,15 @@ int gfal2_mkdir_rec(gfal2_context_t context, const char *url, mode_t mode,
                     }
                 }
 
+                // the parents created on the way were cached as missing
+                GList *tmp_list;
+                for (tmp_list = stack_url; tmp_list != NULL; tmp_list = g_list_next(tmp_list)) {
+                    gfal_stat_cache_invalidate(context, (char *) tmp_list->data);
+                }
                 g_list_free_full(stack_url, g_free);
             }
         }
-
+        gfal_stat_cache_invalidate(context, url);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -220,6 +241,7 @@ int gfal2_rmdir(gfal2_context_t context, const char *url, GError **err)
     }
     else {
         res = gfal_plugin_rmdirG(context, url, &tmp_err);
+        gfal_stat_cache_invalidate_tree(context, url);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -237,6 +259,7 @@ int gfal2_symlink(gfal2_context_t context, const char *oldurl, const char *newur
     }
     else {
         res = gfal_plugin_symlinkG(context, oldurl, newurl, &tmp_err);
+        gfal_stat_cache_invalidate(context, newurl);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(((res) ? -1 : 0), tmp_err, err);
@@ -287,6 +310,7 @@ int gfal2_unlink(gfal2_context_t context, const char *url, GError **err)
     }
     else {
         res = gfal_plugin_unlinkG(context, url, &tmp_err);
+        gfal_stat_cache_invalidate(context, url);
     }
     GFAL2_END_SCOPE_CANCEL(context);
     G_RETURN_ERR(res, tmp_err, err);
@@ -533,7 +557,97 @@ int gfal2_unlink_list(gfal2_context_t context, int nbfiles, const char *const *u
     else {
         res = gfal2_start_scope_cancel(context, &tmp_err);
         if (res == 0) {
+            int i;
             res = gfal_plugin_unlink_listG(context, nbfiles, urls, errors);
+            for (i = 0; i < nbfiles; ++i) {
+                gfal_stat_cache_invalidate(context, urls[i]);
+            }
+            gfal2_end_scope_cancel(context);
+        }
+    }
+
+    if (tmp_err) {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+    return res;
+}
+
+
+// Only the urls without a cached stat go to the plugin
+static int gfal_stat_list_cached(gfal2_context_t context, int nbfiles, const char *const *urls,
+    struct stat *buffs, GError **errors)
+{
+    gint stamp = 0;
+    if (gfal_stat_cache_stamp(context, &stamp) < 0) {
+        return gfal_plugin_stat_listG(context, nbfiles, urls, buffs, errors);
+    }
+
+    int i, j, res = 0, n_missed = 0;
+    int *missed = g_new(int, nbfiles);
+    const char **missed_urls = g_new(const char *, nbfiles);
+    for (i = 0; i < nbfiles; ++i) {
+        gint dummy;
+        if (gfal_stat_cache_get(context, urls[i], &buffs[i], &dummy, &errors[i]) > 0) {
+            if (errors[i] != NULL) {
+                res = -1;
+            }
+        }
+        else {
+            missed[n_missed] = i;
+            missed_urls[n_missed] = urls[i];
+            ++n_missed;
+        }
+    }
+
+    if (n_missed == nbfiles) {
+        res = gfal_plugin_stat_listG(context, nbfiles, urls, buffs, errors);
+        for (i = 0; i < nbfiles; ++i) {
+            gfal_stat_cache_put(context, urls[i], stamp, errors[i] ? NULL : &buffs[i], errors[i]);
+        }
+    }
+    else if (n_missed > 0) {
+        struct stat *missed_buffs = g_new0(struct stat, n_missed);
+        GError **missed_errors = g_new0(GError *, n_missed);
+        if (gfal_plugin_stat_listG(context, n_missed, missed_urls, missed_buffs, missed_errors) < 0) {
+            res = -1;
+        }
+        for (j = 0; j < n_missed; ++j) {
+            i = missed[j];
+            errors[i] = missed_errors[j];
+            if (errors[i] == NULL) {
+                memcpy(&buffs[i], &missed_buffs[j], sizeof(struct stat));
+            }
+            gfal_stat_cache_put(context, urls[i], stamp, errors[i] ? NULL : &buffs[i], errors[i]);
+        }
+        g_free(missed_buffs);
+        g_free(missed_errors);
+    }
+
+    g_free(missed);
+    g_free(missed_urls);
+    return res;
+}
+
+
+int gfal2_stat_list(gfal2_context_t context, int nbfiles, const char *const *urls,
+    struct stat *buffs, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int res = 0;
+
+    if (urls == NULL || *urls == NULL || buffs == NULL || context == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT,
+            "urls or/and buffs or/and context are an incorrect arguments");
+        res = -1;
+    }
+    else {
+        res = gfal2_start_scope_cancel(context, &tmp_err);
+        if (res == 0) {
+            res = gfal_stat_list_cached(context, nbfiles, urls, buffs, errors);
             gfal2_end_scope_cancel(context);
         }
     }
@@ -575,6 +689,15 @@ int gfal2_checksum(gfal2_context_t handle, const char *url, const char *check_ty
         return -1;
     }
 
+    // Only the checksums of whole files are cached
+    struct stat st;
+    int cached = -1;
+    if (start_offset == 0 && data_length == 0) {
+        cached = gfal_checksum_cache_get(handle, url, check_type, &st, checksum_buffer, buffer_length);
+        if (cached > 0)
+            return 0;
+    }
+
     GFAL2_BEGIN_SCOPE_CANCEL(handle, -1, err);
     int res = -1;
     GError *tmp_err = NULL;
@@ -586,5 +709,8 @@ int gfal2_checksum(gfal2_context_t handle, const char *url, const char *check_ty
             data_length, &tmp_err);
     }
     GFAL2_END_SCOPE_CANCEL(handle);
+
+    if (res == 0 && cached == 0)
+        gfal_checksum_cache_put(handle, url, check_type, &st, checksum_buffer);
     G_RETURN_ERR(res, tmp_err, err);
 }
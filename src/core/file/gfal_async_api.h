@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ASYNC_API_H_
+#define GFAL_ASYNC_API_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h"
+#endif
+
+#include <glib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <common/gfal_common.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @file gfal_async_api.h
+ * @brief Asynchronous operations
+ *
+ * Operations are submitted to a completion queue, and return immediately.
+ * Their result is retrieved later with \ref gfal2_async_poll or \ref gfal2_async_wait,
+ * in the order they complete.
+ *
+ * Plugins implementing the async_submitG hook run them natively, so a single thread can keep
+ * many operations in flight. For the others, the blocking version of the operation is run
+ * by a pool of threads owned by the queue, of at most CORE:ASYNC_THREADS threads.
+ *
+ * Copies are submitted with \ref gfal2_async_copy, see gfal_transfer.h
+ *
+ * The buffers given to an operation must remain valid until it completes.
+ */
+
+/**
+ * Completion queue
+ */
+typedef struct gfal_async_queue_s* gfal2_async_queue_t;
+
+/**
+ * Submitted operation
+ */
+typedef struct gfal_async_op_s* gfal2_async_op_t;
+
+/**
+ * Type of an asynchronous operation
+ */
+typedef enum {
+    GFAL_ASYNC_STAT = 0,
+    GFAL_ASYNC_CHECKSUM,
+    GFAL_ASYNC_UNLINK,
+    GFAL_ASYNC_MKDIR,
+    GFAL_ASYNC_OPEN,
+    GFAL_ASYNC_PREAD,
+    GFAL_ASYNC_COPY
+} gfal2_async_type_t;
+
+/**
+ * Create a completion queue for the operations of the given context
+ * @param context : gfal2 context, must outlive the queue
+ * @param err : GError error report
+ * @return the queue, or NULL if error occurs
+ */
+gfal2_async_queue_t gfal2_async_queue_new(gfal2_context_t context, GError** err);
+
+/**
+ * Wait for the operations still in flight, and release the queue, together with the
+ * operations not retrieved yet. The operations already retrieved must still be released
+ * with \ref gfal2_async_op_free
+ */
+void gfal2_async_queue_free(gfal2_async_queue_t queue);
+
+/**
+ * Asynchronous version of \ref gfal2_stat
+ * buff must remain valid until the operation completes
+ * @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_stat(gfal2_async_queue_t queue, const char* url, struct stat* buff,
+        gpointer user_data, GError** err);
+
+/**
+ * Asynchronous version of \ref gfal2_checksum
+ * checksum_buffer must remain valid until the operation completes
+ * @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_checksum(gfal2_async_queue_t queue, const char* url, const char* check_type,
+        off_t start_offset, size_t data_length, char* checksum_buffer, size_t buffer_length,
+        gpointer user_data, GError** err);
+
+/**
+ * Asynchronous version of \ref gfal2_unlink
+ * @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_unlink(gfal2_async_queue_t queue, const char* url,
+        gpointer user_data, GError** err);
+
+/**
+ * Asynchronous version of \ref gfal2_mkdir
+ * @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_mkdir(gfal2_async_queue_t queue, const char* url, mode_t mode,
+        gpointer user_data, GError** err);
+
+/**
+ * Asynchronous version of \ref gfal2_open2
+ * The result of the operation is the new file descriptor
+ * @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_open(gfal2_async_queue_t queue, const char* url, int flags, mode_t mode,
+        gpointer user_data, GError** err);
+
+/**
+ * Asynchronous version of \ref gfal2_pread
+ * buffer must remain valid until the operation completes.
+ * A \ref gfal2_close of fd meanwhile waits for the operation to complete
+ * The result of the operation is the number of bytes read
+ * @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_pread(gfal2_async_queue_t queue, int fd, void* buffer, size_t count,
+        off_t offset, gpointer user_data, GError** err);
+
+/**
+ * Get the next completed operation, if any, without blocking
+ * @return the operation, or NULL if none has completed
+ */
+gfal2_async_op_t gfal2_async_poll(gfal2_async_queue_t queue);
+
+/**
+ * Wait for the next completed operation
+ * @param timeout : in milliseconds, a negative value waits as long as needed
+ * @return the operation, or NULL if the timeout expired, or if there is no operation in flight
+ */
+gfal2_async_op_t gfal2_async_wait(gfal2_async_queue_t queue, int timeout);
+
+/**
+ * @return the number of operations submitted and not retrieved yet
+ */
+guint gfal2_async_pending(gfal2_async_queue_t queue);
+
+/**
+ * Cancel an operation: if it has not started yet, it completes with ECANCELED, otherwise
+ * see \ref gfal2_operation_cancel. Blocks until the operation stops running.
+ * It must not have been released.
+ * @return number of operations canceled
+ */
+int gfal2_async_cancel(gfal2_async_op_t op);
+
+/**
+ * @return the type of the operation
+ */
+gfal2_async_type_t gfal2_async_get_type(gfal2_async_op_t op);
+
+/**
+ * @return the user_data given when the operation was submitted
+ */
+gpointer gfal2_async_get_user_data(gfal2_async_op_t op);
+
+/**
+ * Result of a completed operation, as the blocking version would return it
+ * @param err : GError error report, the error of the operation is copied here
+ * @return the result, -1 if the operation failed
+ */
+ssize_t gfal2_async_get_result(gfal2_async_op_t op, GError** err);
+
+/**
+ * Release an operation retrieved with \ref gfal2_async_poll or \ref gfal2_async_wait
+ */
+void gfal2_async_op_free(gfal2_async_op_t op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_ASYNC_API_H_ */
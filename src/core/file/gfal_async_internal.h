@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ASYNC_INTERNAL_H_
+#define GFAL_ASYNC_INTERNAL_H_
+
+#include <pthread.h>
+#include <common/gfal_cancel.h>
+#include <file/gfal_async_plugins.h>
+
+// Asynchronous operations, internal
+
+// Blocking version of an operation, run by the thread pool of the queue
+typedef ssize_t (*gfal_async_run_func)(gfal2_context_t context, gfal2_async_op_t op, GError** err);
+
+struct gfal_async_queue_s {
+    gfal2_context_t context;
+    pthread_mutex_t lock;
+    // signaled when an operation completes
+    pthread_cond_t cond;
+    // completed, not retrieved yet
+    GQueue completed;
+    // submitted, not retrieved yet
+    guint pending;
+    // created when first needed
+    GThreadPool* pool;
+};
+
+struct gfal_async_op_s {
+    gfal2_async_queue_t queue;
+    gfal2_async_args_t args;
+    gpointer user_data;
+    // run on behalf of this token, so it can be canceled alone
+    gfal_operation_t operation;
+    // fallback when there is no native implementation
+    gfal_async_run_func run;
+    // private data of the operation (i.e. the parameters of a copy)
+    gpointer data;
+    GDestroyNotify data_free;
+    // own copies of the strings of args
+    char* url;
+    char* check_type;
+    // descriptor referenced by a read, released once it completes
+    int fd;
+    ssize_t result;
+    GError* error;
+};
+
+// Allocate an operation of the given type, not submitted yet
+gfal2_async_op_t gfal_async_op_new(gfal2_async_queue_t queue, gfal2_async_type_t type, gpointer user_data);
+
+// Submit the operation: to the plugin of its url if it supports async_submitG, to the thread pool otherwise
+// On failure, op is released
+gfal2_async_op_t gfal_async_submit(gfal2_async_op_t op, GError** err);
+
+// Stat each url on its own, with at most CORE:ASYNC_THREADS in flight
+// Fallback for the plugins without statG_list
+int gfal_stat_list_parallel(gfal2_context_t context, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError** errors);
+
+#endif /* GFAL_ASYNC_INTERNAL_H_ */
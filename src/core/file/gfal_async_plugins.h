@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ASYNC_PLUGINS_H_
+#define GFAL_ASYNC_PLUGINS_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <file/gfal_async_api.h>
+#include <common/gfal_file_handle.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Parameters of an asynchronous operation, as given to the async_submitG hook of a plugin
+ * Only the fields used by the type of the operation are set
+ */
+typedef struct {
+    gfal2_async_type_t type;
+    // stat, checksum, unlink, mkdir, open
+    const char* url;
+    // stat
+    struct stat* st;
+    // checksum
+    const char* check_type;
+    // checksum, pread
+    off_t offset;
+    size_t length;
+    // checksum (of size length), pread (of size buffer_size)
+    void* buffer;
+    size_t buffer_size;
+    // mkdir, open
+    mode_t mode;
+    // open
+    int flags;
+    // pread: handle of the file, owned by the plugin
+    gfal_file_handle fh;
+} gfal2_async_args_t;
+
+/**
+ * @return the parameters of the operation
+ */
+const gfal2_async_args_t* gfal2_async_get_args(gfal2_async_op_t op);
+
+/**
+ * @return true if the operation has been canceled, so the plugin should abort it
+ */
+gboolean gfal2_async_is_canceled(gfal2_async_op_t op);
+
+/**
+ * Complete an operation started by async_submitG. Must be called once, from any thread.
+ * @param op : the operation
+ * @param result : what the blocking version would return (i.e. 0 for stat, the number of bytes for pread)
+ * @param error : the error, if result is negative. The operation takes ownership of it
+ */
+void gfal2_async_complete(gfal2_async_op_t op, ssize_t result, GError* error);
+
+/**
+ * Complete an open operation started by async_submitG
+ * @param op : the operation
+ * @param fh : the handle of the opened file, NULL on failure
+ * @param error : the error, if fh is NULL. The operation takes ownership of it
+ */
+void gfal2_async_complete_open(gfal2_async_op_t op, gfal_file_handle fh, GError* error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_ASYNC_PLUGINS_H_ */
@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <file/gfal_checksum_cache_internal.h>
+#include <file/gfal_stat_cache_internal.h>
+
+#include <common/gfal_config.h>
+#include <common/gfal_error.h>
+#include <logger/gfal_logger.h>
+
+#define GFAL_CHKCACHE_MAGIC 0x6766636b
+#define GFAL_CHKCACHE_VERSION 1
+#define GFAL_CHKCACHE_ENTRIES_DEFAULT 8192
+#define GFAL_CHKCACHE_COARSE_TTL_DEFAULT 60
+// Entries per set, an url always goes to the same set
+#define GFAL_CHKCACHE_WAYS 4
+#define GFAL_CHKCACHE_URL_LEN 1024
+#define GFAL_CHKCACHE_TYPE_LEN 32
+#define GFAL_CHKCACHE_VALUE_LEN 128
+
+// The layout is the same in memory and in the file, so the file can be shared
+// by several processes. Each entry is protected by a sequence number, odd while it
+// is written. A reader finding the entry busy, or changed while copied, takes it as a miss,
+// and a writer finding it busy drops its value.
+typedef struct {
+    volatile gint seq;
+    gint used;
+    guint64 hash;
+    gint64 size;
+    gint64 mtime;
+    gint64 mtime_nsec;
+    // when it was stored, the oldest entry of a set is replaced first
+    gint64 stored;
+    char type[GFAL_CHKCACHE_TYPE_LEN];
+    char value[GFAL_CHKCACHE_VALUE_LEN];
+    char url[GFAL_CHKCACHE_URL_LEN];
+} gfal_chkcache_entry;
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 entry_size;
+    guint32 n_sets;
+} gfal_chkcache_header;
+
+typedef struct {
+    gfal_chkcache_entry* entries;
+    guint32 n_sets;
+} gfal_chkcache_table;
+
+
+// The tables live as long as the process, and are shared by all the contexts
+// using the same CHECKSUM_CACHE_FILE. "" is the in memory one.
+static GHashTable* chkcache_tables = NULL;
+static pthread_mutex_t chkcache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static guint64 gfal_chkcache_hash(const char* url)
+{
+    // FNV-1a
+    guint64 hash = 0xcbf29ce484222325ULL;
+    for (; *url != '\0'; ++url) {
+        hash ^= (unsigned char)*url;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+static gfal_chkcache_table* gfal_chkcache_alloc(guint32 n_sets)
+{
+    gfal_chkcache_table* table = g_new0(gfal_chkcache_table, 1);
+    table->n_sets = n_sets;
+    table->entries = g_new0(gfal_chkcache_entry, (gsize)n_sets * GFAL_CHKCACHE_WAYS);
+    return table;
+}
+
+
+static size_t gfal_chkcache_len(guint32 n_sets)
+{
+    return sizeof(gfal_chkcache_header) + (size_t)n_sets * GFAL_CHKCACHE_WAYS * sizeof(gfal_chkcache_entry);
+}
+
+
+// Write an empty cache under a temporary name, and rename it over path
+// The processes that mapped the previous file keep it as it is, it is never truncated under them
+static int gfal_chkcache_create(const char* path, const gfal_chkcache_header* header)
+{
+    gchar* tmp_path = g_strconcat(path, ".XXXXXX", NULL);
+    int fd = mkstemp(tmp_path);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (ftruncate(fd, gfal_chkcache_len(header->n_sets)) < 0 ||
+            pwrite(fd, header, sizeof(*header), 0) != sizeof(*header) ||
+            rename(tmp_path, path) < 0) {
+            int errsv = errno;
+            unlink(tmp_path);
+            close(fd);
+            fd = -1;
+            errno = errsv;
+        }
+    }
+    g_free(tmp_path);
+    return fd;
+}
+
+
+// Open path and lock it, making sure it was not replaced while waiting for the lock
+static int gfal_chkcache_open(const char* path)
+{
+    struct stat fd_st, path_st;
+    for (;;) {
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0)
+            return -1;
+        while (flock(fd, LOCK_EX) < 0 && errno == EINTR)
+            continue;
+        if (fstat(fd, &fd_st) < 0 || stat(path, &path_st) < 0 ||
+            (fd_st.st_dev == path_st.st_dev && fd_st.st_ino == path_st.st_ino))
+            return fd;
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+}
+
+
+// Map the file, replacing it if it is new or has a different layout
+// The number of sets of an existing file wins over n_sets
+static gfal_chkcache_table* gfal_chkcache_map(const char* path, guint32 n_sets)
+{
+    gfal_chkcache_header header;
+    struct stat st;
+    void* map = MAP_FAILED;
+    size_t len = 0;
+
+    // the first process to take the lock initializes the file
+    int fd = gfal_chkcache_open(path);
+    if (fd < 0) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not open the checksum cache %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    memset(&header, 0, sizeof(header));
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != GFAL_CHKCACHE_MAGIC || header.version != GFAL_CHKCACHE_VERSION ||
+        header.entry_size != sizeof(gfal_chkcache_entry) || header.n_sets == 0) {
+        header.magic = GFAL_CHKCACHE_MAGIC;
+        header.version = GFAL_CHKCACHE_VERSION;
+        header.entry_size = sizeof(gfal_chkcache_entry);
+        header.n_sets = n_sets;
+        // the ones waiting for the lock of the old file see it was replaced
+        int new_fd = gfal_chkcache_create(path, &header);
+        if (new_fd < 0)
+            goto out;
+        flock(fd, LOCK_UN);
+        close(fd);
+        fd = new_fd;
+    }
+    len = gfal_chkcache_len(header.n_sets);
+    if (fstat(fd, &st) < 0 || (st.st_size < (off_t)len && ftruncate(fd, len) < 0))
+        goto out;
+    map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+out:
+    if (map == MAP_FAILED)
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not map the checksum cache %s: %s", path, strerror(errno));
+    flock(fd, LOCK_UN);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Checksum cache %s mapped, %u entries",
+        path, header.n_sets * GFAL_CHKCACHE_WAYS);
+    gfal_chkcache_table* table = g_new0(gfal_chkcache_table, 1);
+    table->n_sets = header.n_sets;
+    table->entries = (gfal_chkcache_entry*)((char*)map + sizeof(header));
+    return table;
+}
+
+
+// NULL if the cache is disabled for this context
+// The size of a table is the one configured when it is first used
+static gfal_chkcache_table* gfal_chkcache_get_table(gfal2_context_t context)
+{
+    if (!gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_CHECKSUM_CACHE, FALSE))
+        return NULL;
+
+    gchar* path = gfal2_get_opt_string_with_default(context, CORE_CONFIG_GROUP,
+        CORE_CONFIG_CHECKSUM_CACHE_FILE, "");
+    gint entries = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+        CORE_CONFIG_CHECKSUM_CACHE_ENTRIES, GFAL_CHKCACHE_ENTRIES_DEFAULT);
+    guint32 n_sets = (entries > GFAL_CHKCACHE_WAYS) ? (guint32)entries / GFAL_CHKCACHE_WAYS : 1;
+    if (path == NULL)
+        path = g_strdup("");
+
+    pthread_mutex_lock(&chkcache_lock);
+    if (chkcache_tables == NULL)
+        chkcache_tables = g_hash_table_new(g_str_hash, g_str_equal);
+
+    gfal_chkcache_table* table = g_hash_table_lookup(chkcache_tables, path);
+    if (table == NULL) {
+        if (path[0] != '\0')
+            table = gfal_chkcache_map(path, n_sets);
+        // a file that can not be used falls back to memory, and is not tried again
+        if (table == NULL)
+            table = g_hash_table_lookup(chkcache_tables, "");
+        if (table == NULL) {
+            table = gfal_chkcache_alloc(n_sets);
+            g_hash_table_insert(chkcache_tables, g_strdup(""), table);
+        }
+        if (path[0] != '\0')
+            g_hash_table_insert(chkcache_tables, g_strdup(path), table);
+    }
+    pthread_mutex_unlock(&chkcache_lock);
+
+    g_free(path);
+    return table;
+}
+
+
+// Copy the entry, unless it is being written
+static gboolean gfal_chkcache_read(gfal_chkcache_entry* entry, gfal_chkcache_entry* copy)
+{
+    gint seq = g_atomic_int_get(&entry->seq);
+    if (seq & 1)
+        return FALSE;
+    memcpy(copy, (const void*)entry, sizeof(*copy));
+    __sync_synchronize();
+    if (g_atomic_int_get(&entry->seq) != seq)
+        return FALSE;
+    // the file may have been damaged by someone else
+    copy->type[GFAL_CHKCACHE_TYPE_LEN - 1] = '\0';
+    copy->value[GFAL_CHKCACHE_VALUE_LEN - 1] = '\0';
+    copy->url[GFAL_CHKCACHE_URL_LEN - 1] = '\0';
+    return TRUE;
+}
+
+
+static void gfal_chkcache_write(gfal_chkcache_entry* entry, const gfal_chkcache_entry* value)
+{
+    const size_t offset = offsetof(gfal_chkcache_entry, used);
+    gint seq = g_atomic_int_get(&entry->seq);
+    if ((seq & 1) || !g_atomic_int_compare_and_exchange(&entry->seq, seq, (gint)((guint)seq + 1)))
+        return;
+    memcpy((char*)entry + offset, (const char*)value + offset, sizeof(*entry) - offset);
+    g_atomic_int_set(&entry->seq, (gint)((guint)seq + 2));
+}
+
+
+static gboolean gfal_chkcache_match(const gfal_chkcache_entry* entry, guint64 hash,
+        const char* url, const char* check_type)
+{
+    return entry->used && entry->hash == hash &&
+        strcasecmp(entry->type, check_type) == 0 && strcmp(entry->url, url) == 0;
+}
+
+
+static gboolean gfal_chkcache_cacheable(const char* url, const char* check_type)
+{
+    return strlen(url) < GFAL_CHKCACHE_URL_LEN && strlen(check_type) < GFAL_CHKCACHE_TYPE_LEN;
+}
+
+
+int gfal_checksum_cache_get(gfal2_context_t context, const char* url, const char* check_type,
+        struct stat* st, char* checksum_buffer, size_t buffer_length)
+{
+    GError* tmp_err = NULL;
+    gfal_chkcache_entry entry;
+    int i;
+
+    gfal_chkcache_table* table = gfal_chkcache_get_table(context);
+    if (table == NULL || !gfal_chkcache_cacheable(url, check_type))
+        return -1;
+    // the checksum of the destination of a copy, or of a file open for writing, is
+    // there to verify what was written, so it is always asked
+    if (gfal_stat_cache_writing(context, url))
+        return -1;
+
+    memset(st, 0, sizeof(*st));
+    if (gfal2_stat(context, url, st, &tmp_err) < 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Checksum cache skipped for %s: %s", url, tmp_err->message);
+        g_error_free(tmp_err);
+        return -1;
+    }
+    if (!S_ISREG(st->st_mode) || st->st_mtime == 0)
+        return -1;
+    // most of the remote storages give the modification time in whole seconds, where a
+    // file rewritten with the same size within the same second can not be told apart,
+    // so those entries are only trusted for a while
+    const gint coarse_ttl = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+        CORE_CONFIG_CHECKSUM_CACHE_COARSE_TTL, GFAL_CHKCACHE_COARSE_TTL_DEFAULT);
+    const gboolean coarse = (st->st_mtim.tv_nsec == 0);
+    if (coarse && coarse_ttl <= 0)
+        return -1;
+
+    const guint64 hash = gfal_chkcache_hash(url);
+    gfal_chkcache_entry* set = table->entries + (hash % table->n_sets) * GFAL_CHKCACHE_WAYS;
+    for (i = 0; i < GFAL_CHKCACHE_WAYS; ++i) {
+        if (!gfal_chkcache_read(&set[i], &entry) || !gfal_chkcache_match(&entry, hash, url, check_type))
+            continue;
+        if (entry.size != st->st_size || entry.mtime != st->st_mtime ||
+            entry.mtime_nsec != st->st_mtim.tv_nsec) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Cached %s checksum of %s is stale", check_type, url);
+            return 0;
+        }
+        if (coarse && time(NULL) - entry.stored >= coarse_ttl) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Cached %s checksum of %s has expired", check_type, url);
+            return 0;
+        }
+        if (g_strlcpy(checksum_buffer, entry.value, buffer_length) >= buffer_length)
+            return 0;
+        gfal2_log(G_LOG_LEVEL_DEBUG, "%s checksum of %s found in the cache: %s",
+            check_type, url, checksum_buffer);
+        return 1;
+    }
+    return 0;
+}
+
+
+void gfal_checksum_cache_put(gfal2_context_t context, const char* url, const char* check_type,
+        const struct stat* st, const char* checksum)
+{
+    gfal_chkcache_entry value, entry;
+    int i, victim = -1;
+    gint64 oldest = G_MAXINT64;
+
+    gfal_chkcache_table* table = gfal_chkcache_get_table(context);
+    if (table == NULL || !gfal_chkcache_cacheable(url, check_type) ||
+        strlen(checksum) >= GFAL_CHKCACHE_VALUE_LEN)
+        return;
+
+    memset(&value, 0, sizeof(value));
+    value.used = 1;
+    value.hash = gfal_chkcache_hash(url);
+    value.size = st->st_size;
+    value.mtime = st->st_mtime;
+    value.mtime_nsec = st->st_mtim.tv_nsec;
+    value.stored = time(NULL);
+    // modified while the checksum was computed, or in the same second, which the
+    // modification time could not tell apart from a later rewrite
+    if (st->st_mtim.tv_nsec == 0 && st->st_mtime >= value.stored)
+        return;
+    g_strlcpy(value.type, check_type, sizeof(value.type));
+    g_strlcpy(value.value, checksum, sizeof(value.value));
+    g_strlcpy(value.url, url, sizeof(value.url));
+
+    // the entry of the same url and type, or a free one, or the oldest one
+    gfal_chkcache_entry* set = table->entries + (value.hash % table->n_sets) * GFAL_CHKCACHE_WAYS;
+    for (i = 0; i < GFAL_CHKCACHE_WAYS; ++i) {
+        if (!gfal_chkcache_read(&set[i], &entry))
+            continue;
+        if (gfal_chkcache_match(&entry, value.hash, url, check_type)) {
+            victim = i;
+            break;
+        }
+        gint64 stored = entry.used ? entry.stored : -1;
+        if (stored < oldest) {
+            oldest = stored;
+            victim = i;
+        }
+    }
+    if (victim >= 0)
+        gfal_chkcache_write(&set[victim], &value);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_CHECKSUM_CACHE_INTERNAL_H_
+#define GFAL_CHECKSUM_CACHE_INTERNAL_H_
+
+#include <sys/stat.h>
+#include <file/gfal_file_api.h>
+
+// Cache of the checksums of whole files, keyed by url and checksum type, internal
+// An entry is valid as long as the size and modification time of the file do not change.
+// When the modification time is in whole seconds, as given by most of the remote storages,
+// the entry is also dropped after CHECKSUM_CACHE_COARSE_TTL seconds
+
+// Stat url and look for its checksum
+// Returns 1 and fills checksum_buffer on a hit, 0 on a miss, with st filled so the
+// checksum can be stored once known, and -1 if the url can not be cached
+// (cache disabled, url being written, stat failed, or no modification time to
+// validate against)
+int gfal_checksum_cache_get(gfal2_context_t context, const char* url, const char* check_type,
+        struct stat* st, char* checksum_buffer, size_t buffer_length);
+
+// Store the checksum of url, as it was when stat returned st
+void gfal_checksum_cache_put(gfal2_context_t context, const char* url, const char* check_type,
+        const struct stat* st, const char* checksum);
+
+#endif /* GFAL_CHECKSUM_CACHE_INTERNAL_H_ */
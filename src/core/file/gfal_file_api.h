@@ -30,6 +30,7 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <errno.h>
 #ifndef ENOATTR
@@ -501,6 +502,22 @@ int gfal2_release_file_list(gfal2_context_t context, int nbfiles, const char* co
  */
 int gfal2_unlink_list(gfal2_context_t context, int nbfiles, const char* const* urls, GError ** errors);
 
+/**
+ * @brief Perform a bulk stat
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param nbfiles : number of files
+ * @param urls    : paths of the files to stat
+ * @param buffs   : Pre-allocated array of nbfiles stat structures, buffs[i] is filled if urls[i] succeeds
+ * @param errors  : Pre-allocated array with nbfiles pointers to errors.
+ *                  It is the user's responsability to allocate and free.
+ * @return 0 if success, -1 if error. set err properly in case of error
+ * @note The plugin tried will be the one that matches the first url
+ * @note If bulk stat is not supported, gfal2_stat will be called for each file, in parallel
+ */
+int gfal2_stat_list(gfal2_context_t context, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError ** errors);
+
 /**
  * @brief abort a list of files
  * @param context : gfal2 handle, see \ref gfal2_context_new
@@ -512,6 +529,33 @@ int gfal2_unlink_list(gfal2_context_t context, int nbfiles, const char* const* u
  */
 int gfal2_abort_files(gfal2_context_t context, int nbfiles, const char* const* urls, const char* token, GError ** errors);
 
+/**
+ * Flag for \ref gfal2_open: prefetch the file in the background when read sequentially,
+ * as CORE:READ_AHEAD does for all the files. Only for files opened read only
+ */
+#define GFAL_O_READAHEAD 010000000000
+
+/**
+ * Flag for \ref gfal2_open: coalesce the small writes, and write them in the background,
+ * as CORE:WRITE_BEHIND does for all the files. Only for files opened for writing.
+ * A failure is reported by the next call on the file descriptor, or by \ref gfal2_close
+ */
+#define GFAL_O_WRITEBEHIND 04000000000
+
+/**
+ * Read-ahead counters of a file descriptor
+ */
+typedef struct {
+    // calls to gfal2_read
+    guint64 reads;
+    // reads served entirely from the prefetched blocks
+    guint64 hits;
+    // bytes prefetched in the background
+    guint64 bytes_prefetched;
+    // bytes prefetched, and dropped without being read
+    guint64 bytes_wasted;
+} gfal2_readahead_stats_t;
+
 /**
  * @brief Open a file, return GFAL2 file descriptor
  *
@@ -582,6 +626,17 @@ int gfal2_creat (gfal2_context_t context, const char *filename, mode_t mode, GEr
  */
 ssize_t gfal2_read(gfal2_context_t context, int fd, void* buff, size_t s_buff, GError ** err);
 
+/**
+ * @brief get the read-ahead counters of a file descriptor
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param fd : GFAL2 file descriptor of the file
+ * @param stats : filled with the counters
+ * @param err : GError error report
+ * @return 0 on success, -1 on failure or if the read-ahead is not enabled for the file
+ */
+int gfal2_readahead_get_stats(gfal2_context_t context, int fd, gfal2_readahead_stats_t* stats, GError ** err);
+
 /**
  * @brief write data to a GFAL2 file descriptor
  *
@@ -625,10 +680,12 @@ int gfal2_close(gfal2_context_t context, int fd, GError ** err);
 /**
  * @brief flush all buffered data for the given file descriptor
  *
+ * Only the files opened with write-behind buffer data, see \ref GFAL_O_WRITEBEHIND
+ *
  * @param context : gfal2 handle, see \ref gfal2_context_new
  * @param fd : file descriptor
  * @param err : GError error report
- * @return new cursor position if success, -1 if failure, set err properly in case of error.
+ * @return 0 if success, -1 if failure, set err properly in case of error.
  */
 int gfal2_flush(gfal2_context_t context, int fd, GError ** err);
 
@@ -645,6 +702,24 @@ int gfal2_flush(gfal2_context_t context, int fd, GError ** err);
  */
 ssize_t gfal2_pread(gfal2_context_t context, int fd, void * buffer, size_t count, off_t offset, GError ** err);
 
+/**
+ * @brief read several ranges of a file at once
+ *
+ * Plugins supporting it send all the ranges in a single request (vector read).
+ * Otherwise, the ranges are sorted, and the adjacent ones merged into a single \ref gfal2_pread
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param fd : file descriptor
+ * @param iov : buffers for read data, iov[i] is filled from offsets[i]
+ * @param offsets : offset of each range
+ * @param iovcnt : number of ranges
+ * @param err : GError error report
+ * @return total number of read bytes, -1 on failure, set err properly in case of error.
+ *         A range crossing the end of the file is only partially filled
+ */
+ssize_t gfal2_preadv(gfal2_context_t context, int fd, const struct iovec* iov, const off_t* offsets,
+        int iovcnt, GError ** err);
+
 /**
  * @brief write to file descriptor at a given offset
  *
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <file/gfal_readahead_internal.h>
+#include <file/gfal_async_api.h>
+
+#include <common/gfal_config.h>
+#include <common/gfal_error.h>
+#include <common/gfal_plugin.h>
+#include <logger/gfal_logger.h>
+
+#define GFAL_READAHEAD_BLOCK_SIZE_DEFAULT (1024 * 1024)
+#define GFAL_READAHEAD_BLOCKS_DEFAULT 4
+
+typedef enum {
+    GFAL_RA_EMPTY = 0,
+    GFAL_RA_LOADING,
+    GFAL_RA_READY
+} gfal_ra_state;
+
+typedef struct {
+    gfal_ra_state state;
+    off_t offset;
+    // bytes available, filled so far while loading, -1 if the read failed
+    ssize_t size;
+    // bytes given to the application
+    size_t consumed;
+    char* data;
+} gfal_ra_block;
+
+struct gfal_readahead_s {
+    gfal2_context_t context;
+    int fd;
+    // serializes the reads, only the holder processes the completed blocks
+    pthread_mutex_t lock;
+    // the blocks are filled in the background by asynchronous preads
+    gfal2_async_queue_t queue;
+    size_t block_size;
+    int n_blocks;
+    gfal_ra_block* blocks;
+    // position of the file for gfal2_read and gfal2_lseek
+    off_t position;
+    // where the last read ended, a read starting there is sequential
+    off_t last_end;
+    // size of the file, -1 while the end has not been seen
+    off_t eof;
+    gfal2_readahead_stats_t stats;
+};
+
+
+gboolean gfal_readahead_enabled(gfal2_context_t context, int flags)
+{
+    if ((flags & O_ACCMODE) != O_RDONLY)
+        return FALSE;
+    return (flags & GFAL_O_READAHEAD) ||
+            gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_READ_AHEAD, FALSE);
+}
+
+
+gfal_readahead_t gfal_readahead_new(gfal2_context_t context, int fd)
+{
+    GError* tmp_err = NULL;
+    gfal2_async_queue_t queue = gfal2_async_queue_new(context, &tmp_err);
+    if (queue == NULL) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not enable the read-ahead: %s", tmp_err->message);
+        g_error_free(tmp_err);
+        return NULL;
+    }
+
+    gfal_readahead_t ra = g_new0(struct gfal_readahead_s, 1);
+    ra->context = context;
+    ra->fd = fd;
+    pthread_mutex_init(&ra->lock, NULL);
+    ra->queue = queue;
+    ra->block_size = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_READ_AHEAD_BLOCK_SIZE, GFAL_READAHEAD_BLOCK_SIZE_DEFAULT);
+    ra->n_blocks = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_READ_AHEAD_BLOCKS, GFAL_READAHEAD_BLOCKS_DEFAULT);
+    if ((ssize_t)ra->block_size <= 0)
+        ra->block_size = GFAL_READAHEAD_BLOCK_SIZE_DEFAULT;
+    if (ra->n_blocks <= 0)
+        ra->n_blocks = GFAL_READAHEAD_BLOCKS_DEFAULT;
+    ra->blocks = g_new0(gfal_ra_block, ra->n_blocks);
+    ra->eof = -1;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Read-ahead of %d blocks of %zu bytes for fd %d",
+            ra->n_blocks, ra->block_size, fd);
+    return ra;
+}
+
+
+// Drop a block, what has not been read is wasted
+static void gfal_readahead_evict(gfal_readahead_t ra, gfal_ra_block* block)
+{
+    if (block->state == GFAL_RA_READY && block->size > 0 && (size_t)block->size > block->consumed)
+        ra->stats.bytes_wasted += block->size - block->consumed;
+    block->state = GFAL_RA_EMPTY;
+}
+
+
+// Request the part of the block not filled yet
+static int gfal_readahead_submit(gfal_readahead_t ra, gfal_ra_block* block, GError** err)
+{
+    const off_t offset = block->offset + block->size;
+    if (gfal2_async_pread(ra->queue, ra->fd, block->data + block->size, ra->block_size - block->size,
+            offset, block, err) == NULL) {
+        return -1;
+    }
+    block->state = GFAL_RA_LOADING;
+    return 0;
+}
+
+
+static void gfal_readahead_complete(gfal_readahead_t ra, gfal2_async_op_t op)
+{
+    GError* tmp_err = NULL;
+    gfal_ra_block* block = (gfal_ra_block*)gfal2_async_get_user_data(op);
+    ssize_t res = gfal2_async_get_result(op, &tmp_err);
+    gfal2_async_op_free(op);
+
+    block->state = GFAL_RA_READY;
+    if (res < 0) {
+        // keep what was read, the rest is read again, synchronously, when needed
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Read-ahead of %lld failed: %s",
+                (long long)(block->offset + block->size), tmp_err->message);
+        g_error_free(tmp_err);
+        if (block->size == 0)
+            block->size = -1;
+    }
+    else if (res == 0) {
+        ra->eof = block->offset + block->size;
+    }
+    else {
+        ra->stats.bytes_prefetched += res;
+        block->size += res;
+        // a short read is not the end of the file, only an empty one is
+        if ((size_t)block->size < ra->block_size && gfal_readahead_submit(ra, block, &tmp_err) < 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not prefetch %lld: %s",
+                    (long long)(block->offset + block->size), tmp_err->message);
+            g_error_free(tmp_err);
+        }
+    }
+}
+
+
+// Process the blocks already filled
+static void gfal_readahead_collect(gfal_readahead_t ra)
+{
+    gfal2_async_op_t op;
+    while ((op = gfal2_async_poll(ra->queue)) != NULL) {
+        gfal_readahead_complete(ra, op);
+    }
+}
+
+
+static void gfal_readahead_wait_block(gfal_readahead_t ra, gfal_ra_block* block)
+{
+    gfal2_async_op_t op;
+    while (block->state == GFAL_RA_LOADING && (op = gfal2_async_wait(ra->queue, -1)) != NULL) {
+        gfal_readahead_complete(ra, op);
+    }
+}
+
+
+static gfal_ra_block* gfal_readahead_find(gfal_readahead_t ra, off_t offset)
+{
+    int i;
+    for (i = 0; i < ra->n_blocks; ++i) {
+        gfal_ra_block* block = &ra->blocks[i];
+        if (block->state != GFAL_RA_EMPTY && block->offset <= offset &&
+                offset < block->offset + (off_t)ra->block_size) {
+            return block;
+        }
+    }
+    return NULL;
+}
+
+
+// Request the window of blocks starting at the block containing offset
+static void gfal_readahead_prefetch(gfal_readahead_t ra, off_t offset)
+{
+    GError* tmp_err = NULL;
+    const off_t window_start = offset - (offset % ra->block_size);
+    const off_t window_end = window_start + ra->n_blocks * ra->block_size;
+    off_t block_offset;
+    int i;
+
+    for (block_offset = window_start; block_offset < window_end; block_offset += ra->block_size) {
+        if (ra->eof >= 0 && block_offset >= ra->eof)
+            break;
+        if (gfal_readahead_find(ra, block_offset))
+            continue;
+
+        // reuse a block outside of the window
+        gfal_ra_block* block = NULL;
+        for (i = 0; i < ra->n_blocks && block == NULL; ++i) {
+            gfal_ra_block* candidate = &ra->blocks[i];
+            if (candidate->state == GFAL_RA_EMPTY ||
+                (candidate->state == GFAL_RA_READY &&
+                    (candidate->offset < window_start || candidate->offset >= window_end))) {
+                block = candidate;
+            }
+        }
+        if (block == NULL)
+            break;
+
+        gfal_readahead_evict(ra, block);
+        if (block->data == NULL)
+            block->data = g_malloc(ra->block_size);
+        block->offset = block_offset;
+        block->size = 0;
+        block->consumed = 0;
+        if (gfal_readahead_submit(ra, block, &tmp_err) < 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not prefetch %lld: %s", (long long)block_offset, tmp_err->message);
+            g_clear_error(&tmp_err);
+            break;
+        }
+    }
+}
+
+
+ssize_t gfal_readahead_read(gfal_readahead_t ra, gfal_file_handle fh, void* buff, size_t s_buff, GError** err)
+{
+    GError* tmp_err = NULL;
+    size_t done = 0;
+    gboolean hit = TRUE;
+    int i;
+
+    pthread_mutex_lock(&ra->lock);
+    gfal_readahead_collect(ra);
+
+    const gboolean sequential = (ra->position == ra->last_end);
+    ra->stats.reads += 1;
+
+    while (done < s_buff) {
+        const off_t offset = ra->position + done;
+        if (ra->eof >= 0 && offset >= ra->eof)
+            break;
+
+        gfal_ra_block* block = gfal_readahead_find(ra, offset);
+        if (block == NULL && sequential) {
+            gfal_readahead_prefetch(ra, offset);
+            block = gfal_readahead_find(ra, offset);
+        }
+        if (block && block->state == GFAL_RA_LOADING) {
+            hit = FALSE;
+            gfal_readahead_wait_block(ra, block);
+        }
+
+        // not prefetched, failed, or filled only partially, read directly into the buffer
+        if (block == NULL || block->size < 0 || offset >= block->offset + block->size) {
+            if (block)
+                gfal_readahead_evict(ra, block);
+            hit = FALSE;
+            ssize_t res = gfal_plugin_preadG(ra->context, fh, (char*)buff + done, s_buff - done, offset, &tmp_err);
+            if (res > 0)
+                done += res;
+            break;
+        }
+
+        off_t available = block->offset + block->size - offset;
+        size_t n = MIN((size_t)available, s_buff - done);
+        memcpy((char*)buff + done, block->data + (offset - block->offset), n);
+        block->consumed += n;
+        done += n;
+    }
+
+    ra->position += done;
+    ra->last_end = ra->position;
+    if (hit && done > 0)
+        ra->stats.hits += 1;
+
+    // the blocks already read will not be needed again
+    for (i = 0; i < ra->n_blocks; ++i) {
+        gfal_ra_block* block = &ra->blocks[i];
+        if (block->state == GFAL_RA_READY && block->offset + (off_t)ra->block_size <= ra->position)
+            gfal_readahead_evict(ra, block);
+    }
+    if (sequential && !tmp_err)
+        gfal_readahead_prefetch(ra, ra->position);
+    pthread_mutex_unlock(&ra->lock);
+
+    if (tmp_err && done == 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    g_clear_error(&tmp_err);
+    return done;
+}
+
+
+off_t gfal_readahead_lseek(gfal_readahead_t ra, gfal_file_handle fh, off_t offset, int whence, GError** err)
+{
+    GError* tmp_err = NULL;
+    off_t new_position = -1;
+
+    pthread_mutex_lock(&ra->lock);
+    switch (whence) {
+        case SEEK_SET:
+            new_position = offset;
+            break;
+        case SEEK_CUR:
+            new_position = ra->position + offset;
+            break;
+        case SEEK_END:
+            // the plugin knows the size
+            new_position = gfal_plugin_lseekG(ra->context, fh, offset, SEEK_END, &tmp_err);
+            break;
+        default:
+            gfal2_set_error(&tmp_err, gfal2_get_core_quark(), EINVAL, __func__, "Invalid whence");
+    }
+    if (!tmp_err && new_position < 0) {
+        gfal2_set_error(&tmp_err, gfal2_get_core_quark(), EINVAL, __func__, "Negative offset");
+        new_position = -1;
+    }
+    if (!tmp_err)
+        ra->position = new_position;
+    pthread_mutex_unlock(&ra->lock);
+
+    G_RETURN_ERR(new_position, tmp_err, err);
+}
+
+
+void gfal_readahead_get_stats(gfal_readahead_t ra, gfal2_readahead_stats_t* stats)
+{
+    pthread_mutex_lock(&ra->lock);
+    *stats = ra->stats;
+    pthread_mutex_unlock(&ra->lock);
+}
+
+
+void gfal_readahead_free(gfal_readahead_t ra)
+{
+    int i;
+    if (ra == NULL)
+        return;
+
+    gfal2_async_queue_free(ra->queue);
+    for (i = 0; i < ra->n_blocks; ++i) {
+        // the blocks still loading are discarded by the queue, unaccounted
+        gfal_readahead_evict(ra, &ra->blocks[i]);
+        g_free(ra->blocks[i].data);
+    }
+    gfal2_log(G_LOG_LEVEL_DEBUG,
+            "Read-ahead of fd %d: %" G_GUINT64_FORMAT " reads, %" G_GUINT64_FORMAT " hits, "
+            "%" G_GUINT64_FORMAT " bytes prefetched, %" G_GUINT64_FORMAT " wasted",
+            ra->fd, ra->stats.reads, ra->stats.hits, ra->stats.bytes_prefetched, ra->stats.bytes_wasted);
+
+    g_free(ra->blocks);
+    pthread_mutex_destroy(&ra->lock);
+    g_free(ra);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_READAHEAD_INTERNAL_H_
+#define GFAL_READAHEAD_INTERNAL_H_
+
+#include <file/gfal_file_api.h>
+#include <common/gfal_file_handle.h>
+
+// Read-ahead of the files read sequentially with gfal2_read, internal
+
+typedef struct gfal_readahead_s* gfal_readahead_t;
+
+// True if the files opened with these flags must be read ahead
+gboolean gfal_readahead_enabled(gfal2_context_t context, int flags);
+
+// Attach a read-ahead state to the file descriptor fd
+// Returns NULL if it can not be created, so the file is read without it
+gfal_readahead_t gfal_readahead_new(gfal2_context_t context, int fd);
+
+// Wait for the blocks being prefetched, and release the state
+void gfal_readahead_free(gfal_readahead_t ra);
+
+// gfal2_read, served from the prefetched blocks when possible
+ssize_t gfal_readahead_read(gfal_readahead_t ra, gfal_file_handle fh, void* buff, size_t s_buff, GError** err);
+
+// gfal2_lseek, the position is kept by the read-ahead
+off_t gfal_readahead_lseek(gfal_readahead_t ra, gfal_file_handle fh, off_t offset, int whence, GError** err);
+
+void gfal_readahead_get_stats(gfal_readahead_t ra, gfal2_readahead_stats_t* stats);
+
+#endif /* GFAL_READAHEAD_INTERNAL_H_ */
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <file/gfal_stat_cache_internal.h>
+
+#include <common/gfal_config.h>
+#include <common/gfal_handle.h>
+#include <logger/gfal_logger.h>
+#include <gsimplecache/gcachemain.h>
+
+#define GFAL_STAT_CACHE_TTL_DEFAULT 10
+#define GFAL_STAT_CACHE_NEGATIVE_TTL_DEFAULT 2
+#define GFAL_STAT_CACHE_ENTRIES_DEFAULT 10000
+#define GFAL_STAT_CACHE_MESSAGE_LEN 256
+
+
+typedef struct {
+    // 0 for a stat result, the error code otherwise
+    gint code;
+    GQuark domain;
+    struct stat st;
+    char message[GFAL_STAT_CACHE_MESSAGE_LEN];
+} gfal_stat_cache_entry;
+
+
+struct _gfal_stat_cache {
+    // serializes the stores with the invalidations, and protects writing
+    pthread_mutex_t lock;
+    // created by the first store
+    GSimpleCache* entries;
+    // bumped by every invalidation, a result obtained across one is not stored
+    gint stamp;
+    // urls being written, with the number of writers
+    GHashTable* writing;
+};
+
+
+static void gfal_stat_cache_copy(gpointer original, gpointer copy)
+{
+    memcpy(copy, original, sizeof(gfal_stat_cache_entry));
+}
+
+
+// Length of url without its trailing slashes, but the ones of the scheme stay
+static size_t gfal_stat_cache_trim(const char* url, size_t len)
+{
+    while (len > 1 && url[len - 1] == '/' && !(len >= 3 && url[len - 2] == '/' && url[len - 3] == ':'))
+        --len;
+    return len;
+}
+
+
+static char* gfal_stat_cache_key(const char* url)
+{
+    return g_strndup(url, gfal_stat_cache_trim(url, strlen(url)));
+}
+
+
+// Key of the parent directory, NULL for the root
+static char* gfal_stat_cache_parent(const char* key)
+{
+    const char* path = strstr(key, "://");
+    path = (path != NULL) ? path + 3 : key;
+    const char* slash = strrchr(path, '/');
+    if (slash == NULL)
+        return NULL;
+    return g_strndup(key, gfal_stat_cache_trim(key, slash - key));
+}
+
+
+// Must be called with the lock held
+static void gfal_stat_cache_drop_locked(struct _gfal_stat_cache* cache, const char* key)
+{
+    ++cache->stamp;
+    if (cache->entries != NULL) {
+        char* parent = gfal_stat_cache_parent(key);
+        gsimplecache_remove_kstr(cache->entries, key);
+        if (parent != NULL)
+            gsimplecache_remove_kstr(cache->entries, parent);
+        g_free(parent);
+    }
+}
+
+
+void gfal_stat_cache_init(gfal2_context_t context)
+{
+    struct _gfal_stat_cache* cache = g_new0(struct _gfal_stat_cache, 1);
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->writing = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    context->stat_cache = cache;
+}
+
+
+void gfal_stat_cache_destroy(gfal2_context_t context)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    if (cache != NULL) {
+        gsimplecache_delete(cache->entries);
+        g_hash_table_destroy(cache->writing);
+        pthread_mutex_destroy(&cache->lock);
+        g_free(cache);
+        context->stat_cache = NULL;
+    }
+}
+
+
+int gfal_stat_cache_get(gfal2_context_t context, const char* url, struct stat* st,
+        gint* stamp, GError** err)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    if (!gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_STAT_CACHE, FALSE))
+        return -1;
+
+    char* key = gfal_stat_cache_key(url);
+    GSimpleCache* entries;
+    int ret = 0;
+
+    pthread_mutex_lock(&cache->lock);
+    entries = cache->entries;
+    *stamp = cache->stamp;
+    if (g_hash_table_lookup(cache->writing, key) != NULL)
+        ret = -1;
+    pthread_mutex_unlock(&cache->lock);
+
+    gfal_stat_cache_entry entry;
+    if (ret == 0 && entries != NULL && gsimplecache_get_kstr(entries, key, &entry) == 0) {
+        if (entry.code == 0) {
+            memcpy(st, &entry.st, sizeof(struct stat));
+        }
+        else {
+            g_set_error(err, entry.domain, entry.code, "%s", entry.message);
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "stat of %s found in the cache", url);
+        ret = 1;
+    }
+    g_free(key);
+    return ret;
+}
+
+
+void gfal_stat_cache_put(gfal2_context_t context, const char* url, gint stamp,
+        const struct stat* st, const GError* error)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    gfal_stat_cache_entry entry;
+    gint ttl;
+
+    memset(&entry, 0, sizeof(entry));
+    if (st != NULL) {
+        memcpy(&entry.st, st, sizeof(struct stat));
+        ttl = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+                CORE_CONFIG_STAT_CACHE_TTL, GFAL_STAT_CACHE_TTL_DEFAULT);
+    }
+    else if (error != NULL && error->code == ENOENT) {
+        entry.code = error->code;
+        entry.domain = error->domain;
+        g_strlcpy(entry.message, error->message, sizeof(entry.message));
+        ttl = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+                CORE_CONFIG_STAT_CACHE_NEGATIVE_TTL, GFAL_STAT_CACHE_NEGATIVE_TTL_DEFAULT);
+    }
+    else {
+        return;
+    }
+    if (ttl <= 0)
+        return;
+
+    char* key = gfal_stat_cache_key(url);
+    pthread_mutex_lock(&cache->lock);
+    if (cache->stamp == stamp && g_hash_table_lookup(cache->writing, key) == NULL) {
+        if (cache->entries == NULL) {
+            gint max_entries = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+                    CORE_CONFIG_STAT_CACHE_ENTRIES, GFAL_STAT_CACHE_ENTRIES_DEFAULT);
+            // a long listing does not push out the entries in use
+            cache->entries = gsimplecache_new_full(max_entries > 0 ? max_entries : GFAL_STAT_CACHE_ENTRIES_DEFAULT,
+                    0, 0, GSIMPLECACHE_ADMIT_FREQUENT, gfal_stat_cache_copy, sizeof(gfal_stat_cache_entry));
+        }
+        gsimplecache_add_item_kstr_ttl(cache->entries, key, &entry, (gint64)ttl * 1000);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    g_free(key);
+}
+
+
+int gfal_stat_cache_stamp(gfal2_context_t context, gint* stamp)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    if (!gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_STAT_CACHE, FALSE))
+        return -1;
+    pthread_mutex_lock(&cache->lock);
+    *stamp = cache->stamp;
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+
+void gfal_stat_cache_invalidate(gfal2_context_t context, const char* url)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    char* key = gfal_stat_cache_key(url);
+    pthread_mutex_lock(&cache->lock);
+    gfal_stat_cache_drop_locked(cache, key);
+    pthread_mutex_unlock(&cache->lock);
+    g_free(key);
+}
+
+
+void gfal_stat_cache_invalidate_tree(gfal2_context_t context, const char* url)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    char* key = gfal_stat_cache_key(url);
+    char* prefix = g_strconcat(key, "/", NULL);
+    pthread_mutex_lock(&cache->lock);
+    gfal_stat_cache_drop_locked(cache, key);
+    if (cache->entries != NULL)
+        gsimplecache_remove_prefix(cache->entries, prefix);
+    pthread_mutex_unlock(&cache->lock);
+    g_free(prefix);
+    g_free(key);
+}
+
+
+void gfal_stat_cache_begin_write(gfal2_context_t context, const char* url)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    char* key = gfal_stat_cache_key(url);
+    pthread_mutex_lock(&cache->lock);
+    gint writers = GPOINTER_TO_INT(g_hash_table_lookup(cache->writing, key));
+    gfal_stat_cache_drop_locked(cache, key);
+    // the table owns the key
+    g_hash_table_replace(cache->writing, key, GINT_TO_POINTER(writers + 1));
+    pthread_mutex_unlock(&cache->lock);
+}
+
+
+void gfal_stat_cache_end_write(gfal2_context_t context, const char* url)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    char* key = gfal_stat_cache_key(url);
+    pthread_mutex_lock(&cache->lock);
+    gint writers = GPOINTER_TO_INT(g_hash_table_lookup(cache->writing, key));
+    gfal_stat_cache_drop_locked(cache, key);
+    if (writers > 1) {
+        g_hash_table_replace(cache->writing, key, GINT_TO_POINTER(writers - 1));
+        key = NULL;
+    }
+    else {
+        g_hash_table_remove(cache->writing, key);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    g_free(key);
+}
+
+
+gboolean gfal_stat_cache_writing(gfal2_context_t context, const char* url)
+{
+    struct _gfal_stat_cache* cache = context->stat_cache;
+    char* key = gfal_stat_cache_key(url);
+    pthread_mutex_lock(&cache->lock);
+    gboolean writing = (g_hash_table_lookup(cache->writing, key) != NULL);
+    pthread_mutex_unlock(&cache->lock);
+    g_free(key);
+    return writing;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_STAT_CACHE_INTERNAL_H_
+#define GFAL_STAT_CACHE_INTERNAL_H_
+
+#include <sys/stat.h>
+#include <file/gfal_file_api.h>
+
+// Cache of the stat results of a context, shared by all the protocols, internal
+// Entries expire after a ttl, and are dropped by the operations done on the url
+// through the same context
+
+void gfal_stat_cache_init(gfal2_context_t context);
+
+void gfal_stat_cache_destroy(gfal2_context_t context);
+
+// Look for the stat of url
+// Returns 1 on a hit, with st filled, or err set if url is known not to exist,
+// 0 on a miss, with stamp set so the result can be stored once known,
+// and -1 if url can not be cached (cache disabled, or url being written)
+int gfal_stat_cache_get(gfal2_context_t context, const char* url, struct stat* st,
+        gint* stamp, GError** err);
+
+// Store the result of the stat of url, st, or error when st is NULL
+// Only ENOENT errors are kept. Nothing is stored if url was modified since stamp was taken
+void gfal_stat_cache_put(gfal2_context_t context, const char* url, gint stamp,
+        const struct stat* st, const GError* error);
+
+// Stamp for the results of a listing or of a bulk stat, taken before asking them
+// Returns -1 if the cache is disabled, 0 otherwise
+int gfal_stat_cache_stamp(gfal2_context_t context, gint* stamp);
+
+// Drop url, and its parent directory, after they were modified
+void gfal_stat_cache_invalidate(gfal2_context_t context, const char* url);
+
+// Same, with everything below url, after a directory was renamed or removed
+// Goes through the whole cache
+void gfal_stat_cache_invalidate_tree(gfal2_context_t context, const char* url);
+
+// url is being written, by a copy or through an open file, so its stat is not cached
+// until the matching gfal_stat_cache_end_write. Both drop url. Calls can be nested
+void gfal_stat_cache_begin_write(gfal2_context_t context, const char* url);
+
+void gfal_stat_cache_end_write(gfal2_context_t context, const char* url);
+
+// TRUE between gfal_stat_cache_begin_write and gfal_stat_cache_end_write on url
+gboolean gfal_stat_cache_writing(gfal2_context_t context, const char* url);
+
+#endif /* GFAL_STAT_CACHE_INTERNAL_H_ */
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <file/gfal_writebehind_internal.h>
+
+#include <common/gfal_config.h>
+#include <common/gfal_error.h>
+#include <common/gfal_plugin.h>
+#include <logger/gfal_logger.h>
+
+#define GFAL_WRITEBEHIND_BUFFER_SIZE_DEFAULT (1024 * 1024)
+#define GFAL_WRITEBEHIND_BUFFERS_DEFAULT 2
+
+typedef struct {
+    char* data;
+    size_t used;
+} gfal_wb_buffer;
+
+struct gfal_writebehind_s {
+    gfal2_context_t context;
+    gfal_file_handle fh;
+    pthread_mutex_t lock;
+    // signaled when a buffer is queued, written, or the writer must stop
+    pthread_cond_t cond;
+    size_t buffer_size;
+    // buffers queued or being written, at most max_buffers
+    int max_buffers;
+    int in_flight;
+    // being filled by the application
+    gfal_wb_buffer* current;
+    // full, waiting for the writer, in order
+    GQueue queued;
+    // written, can be reused
+    GQueue spare;
+    // first failure, reported by all the following calls
+    GError* error;
+    gboolean writer_started;
+    gboolean stop;
+    pthread_t writer;
+};
+
+
+gboolean gfal_writebehind_enabled(gfal2_context_t context, int flags)
+{
+    if ((flags & O_ACCMODE) == O_RDONLY)
+        return FALSE;
+    return (flags & GFAL_O_WRITEBEHIND) ||
+            gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_WRITE_BEHIND, FALSE);
+}
+
+
+gfal_writebehind_t gfal_writebehind_new(gfal2_context_t context, gfal_file_handle fh)
+{
+    gfal_writebehind_t wb = g_new0(struct gfal_writebehind_s, 1);
+    wb->context = context;
+    wb->fh = fh;
+    pthread_mutex_init(&wb->lock, NULL);
+    pthread_cond_init(&wb->cond, NULL);
+    wb->buffer_size = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_WRITE_BEHIND_BUFFER_SIZE, GFAL_WRITEBEHIND_BUFFER_SIZE_DEFAULT);
+    wb->max_buffers = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_WRITE_BEHIND_BUFFERS, GFAL_WRITEBEHIND_BUFFERS_DEFAULT);
+    if ((ssize_t)wb->buffer_size <= 0)
+        wb->buffer_size = GFAL_WRITEBEHIND_BUFFER_SIZE_DEFAULT;
+    if (wb->max_buffers <= 0)
+        wb->max_buffers = GFAL_WRITEBEHIND_BUFFERS_DEFAULT;
+    g_queue_init(&wb->queued);
+    g_queue_init(&wb->spare);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Write-behind with %d buffers of %zu bytes",
+            wb->max_buffers, wb->buffer_size);
+    return wb;
+}
+
+
+// Write the whole buffer, the plugin may write less than asked
+static int gfal_writebehind_write_all(gfal_writebehind_t wb, const char* data, size_t size, GError** err)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t res = gfal_plugin_writeG(wb->context, wb->fh, (void*)(data + done), size - done, err);
+        if (res < 0)
+            return -1;
+        if (res == 0) {
+            gfal2_set_error(err, gfal2_get_core_quark(), EIO, __func__, "The plugin did not write anything");
+            return -1;
+        }
+        done += res;
+    }
+    return 0;
+}
+
+
+static void* gfal_writebehind_writer(void* data)
+{
+    gfal_writebehind_t wb = (gfal_writebehind_t)data;
+    GError* tmp_err = NULL;
+
+    pthread_mutex_lock(&wb->lock);
+    while (TRUE) {
+        while (g_queue_is_empty(&wb->queued) && !wb->stop)
+            pthread_cond_wait(&wb->cond, &wb->lock);
+        if (g_queue_is_empty(&wb->queued))
+            break;
+        gfal_wb_buffer* buffer = (gfal_wb_buffer*)g_queue_pop_head(&wb->queued);
+
+        // after a failure, the remaining data is dropped
+        if (wb->error == NULL) {
+            pthread_mutex_unlock(&wb->lock);
+            gfal_writebehind_write_all(wb, buffer->data, buffer->used, &tmp_err);
+            pthread_mutex_lock(&wb->lock);
+            if (tmp_err) {
+                wb->error = tmp_err;
+                tmp_err = NULL;
+            }
+        }
+
+        buffer->used = 0;
+        g_queue_push_tail(&wb->spare, buffer);
+        wb->in_flight -= 1;
+        pthread_cond_broadcast(&wb->cond);
+    }
+    pthread_mutex_unlock(&wb->lock);
+    return NULL;
+}
+
+
+// Copy of the first failure, if any
+static int gfal_writebehind_check_error(gfal_writebehind_t wb, GError** err)
+{
+    if (wb->error) {
+        gfal2_set_error(err, wb->error->domain, wb->error->code, __func__,
+                "Previous write failed: %s", wb->error->message);
+        return -1;
+    }
+    return 0;
+}
+
+
+// Hand the current buffer to the writer, waiting for room if needed
+// Called with the lock held
+static int gfal_writebehind_queue_current(gfal_writebehind_t wb, GError** err)
+{
+    if (wb->current == NULL || wb->current->used == 0)
+        return 0;
+
+    while (wb->in_flight >= wb->max_buffers && wb->error == NULL)
+        pthread_cond_wait(&wb->cond, &wb->lock);
+    if (gfal_writebehind_check_error(wb, err) < 0)
+        return -1;
+
+    if (!wb->writer_started) {
+        int res = pthread_create(&wb->writer, NULL, gfal_writebehind_writer, wb);
+        if (res != 0) {
+            gfal2_set_error(err, gfal2_get_core_quark(), res, __func__, "Could not start the write-behind thread");
+            return -1;
+        }
+        wb->writer_started = TRUE;
+    }
+
+    g_queue_push_tail(&wb->queued, wb->current);
+    wb->current = NULL;
+    wb->in_flight += 1;
+    pthread_cond_broadcast(&wb->cond);
+    return 0;
+}
+
+
+// Called with the lock held
+static int gfal_writebehind_drain(gfal_writebehind_t wb, GError** err)
+{
+    if (gfal_writebehind_queue_current(wb, err) < 0)
+        return -1;
+    while (wb->in_flight > 0)
+        pthread_cond_wait(&wb->cond, &wb->lock);
+    return gfal_writebehind_check_error(wb, err);
+}
+
+
+ssize_t gfal_writebehind_write(gfal_writebehind_t wb, const void* buff, size_t s_buff, GError** err)
+{
+    GError* tmp_err = NULL;
+    size_t done = 0;
+
+    pthread_mutex_lock(&wb->lock);
+    if (gfal_writebehind_check_error(wb, &tmp_err) < 0)
+        goto out;
+
+    // nothing to coalesce, write directly once the previous data is written
+    if (s_buff >= wb->buffer_size && (wb->current == NULL || wb->current->used == 0)) {
+        if (gfal_writebehind_drain(wb, &tmp_err) == 0 &&
+            gfal_writebehind_write_all(wb, buff, s_buff, &tmp_err) == 0) {
+            done = s_buff;
+        }
+        goto out;
+    }
+
+    while (done < s_buff) {
+        if (wb->current == NULL) {
+            wb->current = (gfal_wb_buffer*)g_queue_pop_head(&wb->spare);
+            if (wb->current == NULL) {
+                wb->current = g_new0(gfal_wb_buffer, 1);
+                wb->current->data = g_malloc(wb->buffer_size);
+            }
+        }
+        size_t n = MIN(s_buff - done, wb->buffer_size - wb->current->used);
+        memcpy(wb->current->data + wb->current->used, (const char*)buff + done, n);
+        wb->current->used += n;
+        done += n;
+
+        if (wb->current->used == wb->buffer_size &&
+            gfal_writebehind_queue_current(wb, &tmp_err) < 0) {
+            break;
+        }
+    }
+
+out:
+    pthread_mutex_unlock(&wb->lock);
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return done;
+}
+
+
+int gfal_writebehind_flush(gfal_writebehind_t wb, GError** err)
+{
+    int res;
+    pthread_mutex_lock(&wb->lock);
+    res = gfal_writebehind_drain(wb, err);
+    pthread_mutex_unlock(&wb->lock);
+    return res;
+}
+
+
+static void gfal_writebehind_buffer_free(gpointer data)
+{
+    gfal_wb_buffer* buffer = (gfal_wb_buffer*)data;
+    if (buffer) {
+        g_free(buffer->data);
+        g_free(buffer);
+    }
+}
+
+
+int gfal_writebehind_free(gfal_writebehind_t wb, GError** err)
+{
+    int res;
+    if (wb == NULL)
+        return 0;
+
+    pthread_mutex_lock(&wb->lock);
+    res = gfal_writebehind_drain(wb, err);
+    wb->stop = TRUE;
+    pthread_cond_broadcast(&wb->cond);
+    pthread_mutex_unlock(&wb->lock);
+    if (wb->writer_started)
+        pthread_join(wb->writer, NULL);
+
+    gfal_writebehind_buffer_free(wb->current);
+    g_queue_foreach(&wb->queued, (GFunc)gfal_writebehind_buffer_free, NULL);
+    g_queue_clear(&wb->queued);
+    g_queue_foreach(&wb->spare, (GFunc)gfal_writebehind_buffer_free, NULL);
+    g_queue_clear(&wb->spare);
+    g_clear_error(&wb->error);
+    pthread_cond_destroy(&wb->cond);
+    pthread_mutex_destroy(&wb->lock);
+    g_free(wb);
+    return res;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_WRITEBEHIND_INTERNAL_H_
+#define GFAL_WRITEBEHIND_INTERNAL_H_
+
+#include <file/gfal_file_api.h>
+#include <common/gfal_file_handle.h>
+
+// Write-behind of the small gfal2_write calls, internal
+
+typedef struct gfal_writebehind_s* gfal_writebehind_t;
+
+// True if the files opened with these flags must be written behind
+gboolean gfal_writebehind_enabled(gfal2_context_t context, int flags);
+
+gfal_writebehind_t gfal_writebehind_new(gfal2_context_t context, gfal_file_handle fh);
+
+// Flush, and release the state. Returns -1 if any write failed
+int gfal_writebehind_free(gfal_writebehind_t wb, GError** err);
+
+// gfal2_write, the data is copied and written later by a background thread
+// A failure of a previous write is reported here
+ssize_t gfal_writebehind_write(gfal_writebehind_t wb, const void* buff, size_t s_buff, GError** err);
+
+// Wait until all the data written so far has been given to the plugin
+// Returns -1 if any write failed
+int gfal_writebehind_flush(gfal_writebehind_t wb, GError** err);
+
+#endif /* GFAL_WRITEBEHIND_INTERNAL_H_ */
@@ -42,6 +42,9 @@
 /* main gfal2 API for file operations */
 #include <file/gfal_file_api.h>
 
+/* asynchronous operations */
+#include <file/gfal_async_api.h>
+
 /* operation control API */
 #include <common/gfal_cancel.h>
 
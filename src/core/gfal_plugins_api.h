@@ -27,6 +27,7 @@
 #include <common/gfal_plugin_interface.h>
 #include <common/gfal_file_handle.h>
 #include <transfer/gfal_transfer_plugins.h>
+#include <file/gfal_async_plugins.h>
 
 #undef __GFAL2_H_INSIDE__
 
@@ -18,24 +18,89 @@
  * limitations under the License.
  */
 
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <pthread.h>
 
 #include "gfal_logger.h"
+#include "gfal_logger_ring.h"
 
+#define GFAL_LOG_MAX_DOMAINS 32
 
-static GLogLevelFlags gfal2_log_level = G_LOG_LEVEL_WARNING;
+typedef struct _gfal_log_domain {
+    char* name;
+    // 0 to follow the default level
+    volatile gint level;
+} gfal_log_domain;
 
 
+static volatile gint gfal2_log_level = G_LOG_LEVEL_WARNING;
+// most verbose level of the default and the domains, so most of the
+// disabled messages are discarded with a single comparison
+static volatile gint gfal2_log_max_level = G_LOG_LEVEL_WARNING;
+
+// domains are never removed, so they can be looked up without locking
+static gfal_log_domain log_domains[GFAL_LOG_MAX_DOMAINS];
+static volatile gint log_domain_count = 0;
+
+static volatile gint log_mode = GFAL2_LOG_SYNC;
+// threads between the check of log_mode and the push into the ring
+static volatile gint log_producers = 0;
+
+// serializes the changes of levels and mode
+static pthread_mutex_t log_config_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void gfal_log_update_max_level(void)
+{
+    int i;
+    gint max_level = g_atomic_int_get(&gfal2_log_level);
+    for (i = 0; i < log_domain_count; ++i) {
+        gint level = g_atomic_int_get(&log_domains[i].level);
+        if (level > max_level)
+            max_level = level;
+    }
+    g_atomic_int_set(&gfal2_log_max_level, max_level);
+}
+
+
+static GLogLevelFlags gfal_log_domain_level(const char* domain)
+{
+    if (domain) {
+        int i, n = g_atomic_int_get(&log_domain_count);
+        for (i = 0; i < n; ++i) {
+            if (strcmp(log_domains[i].name, domain) == 0) {
+                gint level = g_atomic_int_get(&log_domains[i].level);
+                if (level)
+                    return level;
+                break;
+            }
+        }
+    }
+    return g_atomic_int_get(&gfal2_log_level);
+}
+
+
+static void gfal_log_emit(GLogLevelFlags level, const char* msg, va_list args)
+{
+    g_atomic_int_inc(&log_producers);
+    if (g_atomic_int_get(&log_mode) != GFAL2_LOG_SYNC && gfal_log_ring_push(level, msg, args)) {
+        g_atomic_int_dec_and_test(&log_producers);
+        return;
+    }
+    g_atomic_int_dec_and_test(&log_producers);
+    g_logv("GFAL2", level, msg, args);
+}
+
 
 void gfal2_log(GLogLevelFlags level, const char* msg, ...)
 {
-    if (level <= gfal2_log_level) {
+    if (gfal2_log_is_enabled(NULL, level)) {
         va_list args;
         va_start(args, msg);
-        g_logv("GFAL2", level, msg, args);
+        gfal_log_emit(level, msg, args);
         va_end(args);
     }
 }
@@ -43,21 +108,123 @@ void gfal2_log(GLogLevelFlags level, const char* msg, ...)
 
 void gfal2_logv(GLogLevelFlags level, const char* msg, va_list args)
 {
-    if (level <= gfal2_log_level) {
-        g_logv("GFAL2", level, msg, args);
+    if (gfal2_log_is_enabled(NULL, level)) {
+        gfal_log_emit(level, msg, args);
     }
 }
 
 
+void gfal2_log_domain(const char* domain, GLogLevelFlags level, const char* msg, ...)
+{
+    if (gfal2_log_is_enabled(domain, level)) {
+        va_list args;
+        va_start(args, msg);
+        gfal_log_emit(level, msg, args);
+        va_end(args);
+    }
+}
+
+
+gboolean gfal2_log_is_enabled(const char* domain, GLogLevelFlags level)
+{
+    if (level > g_atomic_int_get(&gfal2_log_max_level))
+        return FALSE;
+    return level <= gfal_log_domain_level(domain);
+}
+
+
 void gfal2_log_set_level(GLogLevelFlags level)
 {
-    gfal2_log_level = level;
+    pthread_mutex_lock(&log_config_lock);
+    g_atomic_int_set(&gfal2_log_level, level);
+    gfal_log_update_max_level();
+    pthread_mutex_unlock(&log_config_lock);
 }
 
 
 GLogLevelFlags gfal2_log_get_level(void)
 {
-    return gfal2_log_level;
+    return g_atomic_int_get(&gfal2_log_level);
+}
+
+
+int gfal2_log_set_domain_level(const char* domain, GLogLevelFlags level)
+{
+    int i, ret = 0;
+    pthread_mutex_lock(&log_config_lock);
+    for (i = 0; i < log_domain_count; ++i) {
+        if (strcmp(log_domains[i].name, domain) == 0)
+            break;
+    }
+    if (i < log_domain_count) {
+        g_atomic_int_set(&log_domains[i].level, level);
+    }
+    else if (i < GFAL_LOG_MAX_DOMAINS) {
+        log_domains[i].name = g_strdup(domain);
+        log_domains[i].level = level;
+        // published once filled
+        g_atomic_int_set(&log_domain_count, i + 1);
+    }
+    else {
+        ret = -1;
+    }
+    gfal_log_update_max_level();
+    pthread_mutex_unlock(&log_config_lock);
+    return ret;
+}
+
+
+GLogLevelFlags gfal2_log_get_domain_level(const char* domain)
+{
+    return gfal_log_domain_level(domain);
+}
+
+
+static void gfal_log_atexit(void)
+{
+    gfal2_log_set_mode(GFAL2_LOG_SYNC);
+}
+
+
+int gfal2_log_set_mode(gfal2_log_mode_t mode)
+{
+    static gboolean atexit_registered = FALSE;
+    int ret = 0;
+
+    pthread_mutex_lock(&log_config_lock);
+    if (mode == GFAL2_LOG_SYNC) {
+        if (g_atomic_int_get(&log_mode) != GFAL2_LOG_SYNC) {
+            g_atomic_int_set(&log_mode, GFAL2_LOG_SYNC);
+            // let the threads that saw the previous mode finish their push
+            while (g_atomic_int_get(&log_producers) > 0)
+                sched_yield();
+            gfal_log_ring_stop();
+        }
+    }
+    else {
+        ret = gfal_log_ring_start(mode == GFAL2_LOG_ASYNC_BINARY);
+        if (ret == 0) {
+            g_atomic_int_set(&log_mode, mode);
+            // do not lose what is still queued
+            if (!atexit_registered)
+                atexit_registered = (atexit(gfal_log_atexit) == 0);
+        }
+    }
+    pthread_mutex_unlock(&log_config_lock);
+    return ret;
+}
+
+
+gfal2_log_mode_t gfal2_log_get_mode(void)
+{
+    return g_atomic_int_get(&log_mode);
+}
+
+
+void gfal2_log_flush(void)
+{
+    if (g_atomic_int_get(&log_mode) != GFAL2_LOG_SYNC)
+        gfal_log_ring_flush();
 }
 
 
@@ -65,4 +232,3 @@ int gfal2_log_set_handler(GLogFunc func, gpointer user_data)
 {
     return g_log_set_handler("GFAL2", G_LOG_LEVEL_MASK, func, user_data);
 }
-
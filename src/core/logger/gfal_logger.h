@@ -36,6 +36,19 @@ extern "C"
 {
 #endif
 
+/**
+ * How the messages are passed to the handler
+ */
+typedef enum {
+    /// Formatted and passed to the handler by the thread that logs them (default)
+    GFAL2_LOG_SYNC = 0,
+    /// Formatted by the thread that logs them, and passed to the handler by a background thread
+    GFAL2_LOG_ASYNC,
+    /// The format and the arguments are queued as they are, and the background thread
+    /// formats them before passing them to the handler
+    GFAL2_LOG_ASYNC_BINARY
+} gfal2_log_mode_t;
+
 /**
  * Log a message with the given level.
  * The default handler prints to stderr.
@@ -49,6 +62,29 @@ void gfal2_log(GLogLevelFlags level, const char* msg, ...);
 void gfal2_logv(GLogLevelFlags level, const char* msg, va_list args);
 
 
+/**
+ * Log a message with the given level, filtered with the level of the domain
+ * The domain only tells which level applies, the handler gets the message with the "GFAL2" domain.
+ * See \ref gfal2_log_set_domain_level
+ */
+void gfal2_log_domain(const char* domain, GLogLevelFlags level, const char* msg, ...);
+
+/**
+ * Log a message if the level is enabled for the domain
+ * Unlike \ref gfal2_log_domain, the arguments are not evaluated otherwise.
+ */
+#define GFAL2_LOG_DOMAIN(domain, level, ...) \
+    do { \
+        if (gfal2_log_is_enabled(domain, level)) \
+            gfal2_log_domain(domain, level, __VA_ARGS__); \
+    } while (0)
+
+/**
+ * Return TRUE if a message with the given level would be logged for the domain
+ * If domain is NULL, the default level applies.
+ */
+gboolean gfal2_log_is_enabled(const char* domain, GLogLevelFlags level);
+
 /**
  * Set the log level. Only messages with level higher or equal will be passed to the handler.
  * For instance, if set to G_LOG_LEVEL_WARNING,
@@ -61,6 +97,36 @@ void gfal2_log_set_level(GLogLevelFlags level);
  */
 GLogLevelFlags gfal2_log_get_level(void);
 
+/**
+ * Set the log level of a domain (i.e. "GRIDFTP PLUGIN"), which can be more or less verbose
+ * than the default. 0 makes the domain follow the default level again.
+ * Return < 0 if there are too many domains
+ */
+int gfal2_log_set_domain_level(const char* domain, GLogLevelFlags level);
+
+/**
+ * Return the log level that applies to the domain
+ */
+GLogLevelFlags gfal2_log_get_domain_level(const char* domain);
+
+/**
+ * Set how the messages are passed to the handler
+ * In the asynchronous modes, the handler is called from a background thread, and the
+ * messages still queued are passed to it at exit, or when going back to GFAL2_LOG_SYNC.
+ * Return < 0 if the background thread can not be started
+ */
+int gfal2_log_set_mode(gfal2_log_mode_t mode);
+
+/**
+ * Return how the messages are passed to the handler
+ */
+gfal2_log_mode_t gfal2_log_get_mode(void);
+
+/**
+ * Wait until the messages logged so far have been passed to the handler
+ */
+void gfal2_log_flush(void);
+
 /**
  * Set a custom handler
  * See Glib2 message logging system for more informations about log_func.
@@ -0,0 +1,632 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include "gfal_logger.h"
+#include "gfal_logger_ring.h"
+
+//
+// Bounded multi-producer queue of log messages. Each record has a sequence number
+// telling if it is free for the producer at a given position (sequence == position),
+// or ready for the consumer (sequence == position + 1). Producers only contend on
+// enqueue_pos, and the single consumer is the drain thread.
+//
+// Positions wrap around, so they are always compared through their difference.
+//
+
+#define GFAL_LOG_RING_SIZE 1024
+#define GFAL_LOG_RECORD_SIZE 480
+// Producers wake up the drain thread once this many messages are pending,
+// otherwise it picks them up after GFAL_LOG_DRAIN_PERIOD milliseconds
+#define GFAL_LOG_WAKEUP_BACKLOG 64
+#define GFAL_LOG_DRAIN_PERIOD 20
+// Longest conversion specification handled by the binary mode (i.e. "%-20.10s")
+#define GFAL_LOG_SPEC_MAX 32
+
+
+typedef struct _gfal_log_record {
+    volatile gint sequence;
+    GLogLevelFlags level;
+    // TRUE if data holds the format and its packed arguments, instead of the message
+    gboolean packed;
+    // message too long for data
+    char* heap;
+    char data[GFAL_LOG_RECORD_SIZE];
+} gfal_log_record;
+
+
+static gfal_log_record ring[GFAL_LOG_RING_SIZE];
+static volatile gint enqueue_pos = 0;
+static volatile gint dequeue_pos = 0;
+static gboolean ring_initialized = FALSE;
+
+static pthread_mutex_t drain_lock = PTHREAD_MUTEX_INITIALIZER;
+// the drain thread waits on it when the ring is empty
+static pthread_cond_t drain_wakeup = PTHREAD_COND_INITIALIZER;
+// signaled by the drain thread after each batch
+static pthread_cond_t drain_done = PTHREAD_COND_INITIALIZER;
+static volatile gint drain_sleeping = 0;
+static volatile gint drain_running = 0;
+static volatile gint drain_binary = FALSE;
+static pthread_t drain_thread;
+
+
+typedef enum {
+    GFAL_LOG_ARG_NONE,
+    GFAL_LOG_ARG_INT,
+    GFAL_LOG_ARG_LLONG,
+    GFAL_LOG_ARG_ULLONG,
+    GFAL_LOG_ARG_DOUBLE,
+    GFAL_LOG_ARG_LDOUBLE,
+    GFAL_LOG_ARG_STRING,
+    GFAL_LOG_ARG_POINTER
+} gfal_log_arg_type;
+
+
+// A conversion specification of a printf format, starting at '%'
+typedef struct _gfal_log_spec {
+    // flags, width and precision, between the '%' and the length modifier
+    const char* options;
+    size_t options_len;
+    gboolean star_width, star_precision;
+    char length[3];
+    char conversion;
+    // first character after the specification
+    const char* end;
+} gfal_log_spec;
+
+
+// Parse the specification at p
+// Returns FALSE for what the binary mode does not handle: positional arguments,
+// wide characters, %n and the glibc %m
+static gboolean gfal_log_parse_spec(const char* p, gfal_log_spec* spec)
+{
+    const char* q = p + 1;
+    memset(spec, 0, sizeof(*spec));
+    spec->options = q;
+
+    if (*q == '%') {
+        spec->conversion = '%';
+        spec->end = q + 1;
+        return TRUE;
+    }
+
+    while (*q && strchr("-+ #0'", *q))
+        ++q;
+    if (*q == '*') {
+        spec->star_width = TRUE;
+        ++q;
+    }
+    else {
+        while (g_ascii_isdigit(*q))
+            ++q;
+        if (*q == '$')
+            return FALSE;
+    }
+    if (*q == '.') {
+        ++q;
+        if (*q == '*') {
+            spec->star_precision = TRUE;
+            ++q;
+        }
+        else {
+            while (g_ascii_isdigit(*q))
+                ++q;
+        }
+    }
+    spec->options_len = q - spec->options;
+    if (spec->options_len > GFAL_LOG_SPEC_MAX)
+        return FALSE;
+
+    if ((q[0] == 'h' && q[1] == 'h') || (q[0] == 'l' && q[1] == 'l')) {
+        spec->length[0] = q[0];
+        spec->length[1] = q[1];
+        q += 2;
+    }
+    else if (*q && strchr("hlLqjzt", *q)) {
+        spec->length[0] = *q;
+        ++q;
+    }
+
+    if (*q == '\0' || !strchr("diouxXcsfFeEgGaAp", *q))
+        return FALSE;
+    if (spec->length[0] == 'l' && spec->length[1] == '\0' && (*q == 's' || *q == 'c'))
+        return FALSE;
+    spec->conversion = *q;
+    spec->end = q + 1;
+    return TRUE;
+}
+
+
+static gfal_log_arg_type gfal_log_spec_type(const gfal_log_spec* spec)
+{
+    switch (spec->conversion) {
+        case '%':
+            return GFAL_LOG_ARG_NONE;
+        case 'd': case 'i':
+            return GFAL_LOG_ARG_LLONG;
+        case 'o': case 'u': case 'x': case 'X':
+            return GFAL_LOG_ARG_ULLONG;
+        case 'c':
+            return GFAL_LOG_ARG_INT;
+        case 's':
+            return GFAL_LOG_ARG_STRING;
+        case 'p':
+            return GFAL_LOG_ARG_POINTER;
+        default:
+            return (spec->length[0] == 'L') ? GFAL_LOG_ARG_LDOUBLE : GFAL_LOG_ARG_DOUBLE;
+    }
+}
+
+
+// Integers are promoted following their length modifier, so they are all packed as long long
+static long long gfal_log_read_signed(const gfal_log_spec* spec, va_list* args)
+{
+    switch (spec->length[0]) {
+        case 'h':
+            if (spec->length[1] == 'h')
+                return (signed char)va_arg(*args, int);
+            return (short)va_arg(*args, int);
+        case 'l':
+            if (spec->length[1] == 'l')
+                return va_arg(*args, long long);
+            return va_arg(*args, long);
+        case 'q': case 'L':
+            return va_arg(*args, long long);
+        case 'j':
+            return va_arg(*args, intmax_t);
+        case 'z':
+            return va_arg(*args, ssize_t);
+        case 't':
+            return va_arg(*args, ptrdiff_t);
+        default:
+            return va_arg(*args, int);
+    }
+}
+
+
+static unsigned long long gfal_log_read_unsigned(const gfal_log_spec* spec, va_list* args)
+{
+    switch (spec->length[0]) {
+        case 'h':
+            if (spec->length[1] == 'h')
+                return (unsigned char)va_arg(*args, unsigned int);
+            return (unsigned short)va_arg(*args, unsigned int);
+        case 'l':
+            if (spec->length[1] == 'l')
+                return va_arg(*args, unsigned long long);
+            return va_arg(*args, unsigned long);
+        case 'q': case 'L':
+            return va_arg(*args, unsigned long long);
+        case 'j':
+            return va_arg(*args, uintmax_t);
+        case 'z':
+            return va_arg(*args, size_t);
+        case 't':
+            return va_arg(*args, ptrdiff_t);
+        default:
+            return va_arg(*args, unsigned int);
+    }
+}
+
+
+static gboolean gfal_log_pack_value(char* buffer, size_t size, size_t* used,
+    const void* value, size_t len)
+{
+    if (*used + len > size)
+        return FALSE;
+    memcpy(buffer + *used, value, len);
+    *used += len;
+    return TRUE;
+}
+
+
+// Copy the format and its arguments into buffer, so the message can be formatted later
+// Returns FALSE if they do not fit, or if the format can not be handled
+static gboolean gfal_log_pack(char* buffer, size_t size, const char* fmt, va_list* args)
+{
+    size_t used = strlen(fmt) + 1;
+    if (used > size)
+        return FALSE;
+    memcpy(buffer, fmt, used);
+
+    const char* p = fmt;
+    while ((p = strchr(p, '%')) != NULL) {
+        gfal_log_spec spec;
+        if (!gfal_log_parse_spec(p, &spec))
+            return FALSE;
+        p = spec.end;
+
+        gboolean fit = TRUE;
+        if (spec.star_width) {
+            int width = va_arg(*args, int);
+            fit = gfal_log_pack_value(buffer, size, &used, &width, sizeof(width));
+        }
+        if (fit && spec.star_precision) {
+            int precision = va_arg(*args, int);
+            fit = gfal_log_pack_value(buffer, size, &used, &precision, sizeof(precision));
+        }
+        if (!fit)
+            return FALSE;
+
+        switch (gfal_log_spec_type(&spec)) {
+            case GFAL_LOG_ARG_NONE:
+                break;
+            case GFAL_LOG_ARG_INT: {
+                int v = va_arg(*args, int);
+                fit = gfal_log_pack_value(buffer, size, &used, &v, sizeof(v));
+                break;
+            }
+            case GFAL_LOG_ARG_LLONG: {
+                long long v = gfal_log_read_signed(&spec, args);
+                fit = gfal_log_pack_value(buffer, size, &used, &v, sizeof(v));
+                break;
+            }
+            case GFAL_LOG_ARG_ULLONG: {
+                unsigned long long v = gfal_log_read_unsigned(&spec, args);
+                fit = gfal_log_pack_value(buffer, size, &used, &v, sizeof(v));
+                break;
+            }
+            case GFAL_LOG_ARG_DOUBLE: {
+                double v = va_arg(*args, double);
+                fit = gfal_log_pack_value(buffer, size, &used, &v, sizeof(v));
+                break;
+            }
+            case GFAL_LOG_ARG_LDOUBLE: {
+                long double v = va_arg(*args, long double);
+                fit = gfal_log_pack_value(buffer, size, &used, &v, sizeof(v));
+                break;
+            }
+            case GFAL_LOG_ARG_STRING: {
+                const char* v = va_arg(*args, const char*);
+                if (v == NULL)
+                    v = "(null)";
+                fit = gfal_log_pack_value(buffer, size, &used, v, strlen(v) + 1);
+                break;
+            }
+            case GFAL_LOG_ARG_POINTER: {
+                void* v = va_arg(*args, void*);
+                fit = gfal_log_pack_value(buffer, size, &used, &v, sizeof(v));
+                break;
+            }
+        }
+        if (!fit)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+
+// Format a single argument, with the width and precision given by '*' if any
+#define GFAL_LOG_APPEND(out, format, n_stars, stars, value) \
+    do { \
+        if (n_stars == 2) \
+            g_string_append_printf(out, format, stars[0], stars[1], value); \
+        else if (n_stars == 1) \
+            g_string_append_printf(out, format, stars[0], value); \
+        else \
+            g_string_append_printf(out, format, value); \
+    } while (0)
+
+
+// Format the message packed by gfal_log_pack
+static char* gfal_log_unpack(const char* buffer)
+{
+    const char* fmt = buffer;
+    const char* arg = buffer + strlen(fmt) + 1;
+    GString* out = g_string_sized_new(128);
+
+    const char* p = fmt;
+    const char* q;
+    while ((q = strchr(p, '%')) != NULL) {
+        g_string_append_len(out, p, q - p);
+
+        gfal_log_spec spec;
+        gfal_log_parse_spec(q, &spec); // it could be parsed when packed
+        p = spec.end;
+
+        int stars[2], n_stars = 0;
+        if (spec.star_width) {
+            memcpy(&stars[n_stars++], arg, sizeof(int));
+            arg += sizeof(int);
+        }
+        if (spec.star_precision) {
+            memcpy(&stars[n_stars++], arg, sizeof(int));
+            arg += sizeof(int);
+        }
+
+        // same flags, width and precision, with the length of the packed value
+        char format[GFAL_LOG_SPEC_MAX + 8];
+        gfal_log_arg_type type = gfal_log_spec_type(&spec);
+        const char* length = "";
+        if (type == GFAL_LOG_ARG_LLONG || type == GFAL_LOG_ARG_ULLONG)
+            length = "ll";
+        else if (type == GFAL_LOG_ARG_LDOUBLE)
+            length = "L";
+        snprintf(format, sizeof(format), "%%%.*s%s%c", (int)spec.options_len, spec.options,
+            length, spec.conversion);
+
+        switch (type) {
+            case GFAL_LOG_ARG_NONE:
+                g_string_append_c(out, '%');
+                break;
+            case GFAL_LOG_ARG_INT: {
+                int v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+            case GFAL_LOG_ARG_LLONG: {
+                long long v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+            case GFAL_LOG_ARG_ULLONG: {
+                unsigned long long v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+            case GFAL_LOG_ARG_DOUBLE: {
+                double v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+            case GFAL_LOG_ARG_LDOUBLE: {
+                long double v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+            case GFAL_LOG_ARG_STRING: {
+                const char* v = arg;
+                arg += strlen(v) + 1;
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+            case GFAL_LOG_ARG_POINTER: {
+                void* v;
+                memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                GFAL_LOG_APPEND(out, format, n_stars, stars, v);
+                break;
+            }
+        }
+    }
+    g_string_append(out, p);
+    return g_string_free(out, FALSE);
+}
+
+
+static gboolean gfal_log_ring_is_drain_thread(void)
+{
+    return g_atomic_int_get(&drain_running) && pthread_equal(pthread_self(), drain_thread);
+}
+
+
+static void gfal_log_timeout(struct timespec* deadline, long msec)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    deadline->tv_sec = now.tv_sec + msec / 1000;
+    deadline->tv_nsec = now.tv_usec * 1000 + (msec % 1000) * 1000000;
+    if (deadline->tv_nsec >= 1000000000) {
+        deadline->tv_sec += 1;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+
+static void gfal_log_ring_wakeup(void)
+{
+    pthread_mutex_lock(&drain_lock);
+    pthread_cond_signal(&drain_wakeup);
+    pthread_mutex_unlock(&drain_lock);
+}
+
+
+// The ring is full: wait for the drain thread to free some records
+static void gfal_log_ring_wait_room(void)
+{
+    struct timespec deadline;
+    gfal_log_timeout(&deadline, 1);
+    pthread_mutex_lock(&drain_lock);
+    pthread_cond_signal(&drain_wakeup);
+    pthread_cond_timedwait(&drain_done, &drain_lock, &deadline);
+    pthread_mutex_unlock(&drain_lock);
+}
+
+
+gboolean gfal_log_ring_push(GLogLevelFlags level, const char* msg, va_list args)
+{
+    // the handler logging itself, it would wait forever on a full ring
+    if (gfal_log_ring_is_drain_thread())
+        return FALSE;
+
+    gfal_log_record* record;
+    guint pos = g_atomic_int_get(&enqueue_pos);
+    while (TRUE) {
+        record = &ring[pos % GFAL_LOG_RING_SIZE];
+        gint diff = (gint)((guint)g_atomic_int_get(&record->sequence) - pos);
+        if (diff == 0) {
+            if (g_atomic_int_compare_and_exchange(&enqueue_pos, (gint)pos, (gint)(pos + 1)))
+                break;
+        }
+        else if (diff < 0) {
+            gfal_log_ring_wait_room();
+        }
+        pos = g_atomic_int_get(&enqueue_pos);
+    }
+
+    va_list copy;
+    record->level = level;
+    record->heap = NULL;
+    record->packed = FALSE;
+    if (g_atomic_int_get(&drain_binary)) {
+        va_copy(copy, args);
+        record->packed = gfal_log_pack(record->data, sizeof(record->data), msg, &copy);
+        va_end(copy);
+    }
+    if (!record->packed) {
+        va_copy(copy, args);
+        int len = vsnprintf(record->data, sizeof(record->data), msg, copy);
+        va_end(copy);
+        if (len >= (int)sizeof(record->data)) {
+            va_copy(copy, args);
+            record->heap = g_strdup_vprintf(msg, copy);
+            va_end(copy);
+        }
+    }
+    g_atomic_int_set(&record->sequence, (gint)(pos + 1));
+
+    // waking up the thread for every message would cost more than formatting it
+    if (g_atomic_int_get(&drain_sleeping) &&
+        pos + 1 - (guint)g_atomic_int_get(&dequeue_pos) >= GFAL_LOG_WAKEUP_BACKLOG)
+        gfal_log_ring_wakeup();
+    return TRUE;
+}
+
+
+static gboolean gfal_log_ring_is_empty(void)
+{
+    guint pos = g_atomic_int_get(&dequeue_pos);
+    gfal_log_record* record = &ring[pos % GFAL_LOG_RING_SIZE];
+    return (guint)g_atomic_int_get(&record->sequence) != pos + 1;
+}
+
+
+// Pass the queued messages to the handler
+// Only one thread at a time drains the ring
+static int gfal_log_ring_drain(void)
+{
+    int n = 0;
+    guint pos = g_atomic_int_get(&dequeue_pos);
+    while (TRUE) {
+        gfal_log_record* record = &ring[pos % GFAL_LOG_RING_SIZE];
+        if ((guint)g_atomic_int_get(&record->sequence) != pos + 1)
+            break;
+
+        if (record->packed) {
+            char* message = gfal_log_unpack(record->data);
+            g_log("GFAL2", record->level, "%s", message);
+            g_free(message);
+        }
+        else {
+            g_log("GFAL2", record->level, "%s", record->heap ? record->heap : record->data);
+            g_free(record->heap);
+        }
+
+        g_atomic_int_set(&record->sequence, (gint)(pos + GFAL_LOG_RING_SIZE));
+        ++pos;
+        g_atomic_int_set(&dequeue_pos, (gint)pos);
+        ++n;
+    }
+    return n;
+}
+
+
+static void* gfal_log_ring_thread(void* data)
+{
+    while (g_atomic_int_get(&drain_running)) {
+        if (gfal_log_ring_drain() > 0) {
+            pthread_mutex_lock(&drain_lock);
+            pthread_cond_broadcast(&drain_done);
+            pthread_mutex_unlock(&drain_lock);
+            continue;
+        }
+        // producers check drain_sleeping after publishing, so with the lock held
+        // a backlog can not build up between the check and the wait unnoticed
+        struct timespec deadline;
+        gfal_log_timeout(&deadline, GFAL_LOG_DRAIN_PERIOD);
+        pthread_mutex_lock(&drain_lock);
+        g_atomic_int_set(&drain_sleeping, 1);
+        if (g_atomic_int_get(&drain_running) && gfal_log_ring_is_empty())
+            pthread_cond_timedwait(&drain_wakeup, &drain_lock, &deadline);
+        g_atomic_int_set(&drain_sleeping, 0);
+        pthread_mutex_unlock(&drain_lock);
+    }
+    return NULL;
+}
+
+
+int gfal_log_ring_start(gboolean binary)
+{
+    int i;
+    if (!ring_initialized) {
+        for (i = 0; i < GFAL_LOG_RING_SIZE; ++i)
+            ring[i].sequence = i;
+        ring_initialized = TRUE;
+    }
+
+    g_atomic_int_set(&drain_binary, binary);
+    if (g_atomic_int_get(&drain_running))
+        return 0;
+
+    g_atomic_int_set(&drain_running, 1);
+    if (pthread_create(&drain_thread, NULL, gfal_log_ring_thread, NULL) != 0) {
+        g_atomic_int_set(&drain_running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+
+void gfal_log_ring_stop(void)
+{
+    if (!g_atomic_int_get(&drain_running))
+        return;
+
+    pthread_mutex_lock(&drain_lock);
+    g_atomic_int_set(&drain_running, 0);
+    pthread_cond_signal(&drain_wakeup);
+    pthread_mutex_unlock(&drain_lock);
+    pthread_join(drain_thread, NULL);
+
+    // what was queued meanwhile
+    gfal_log_ring_drain();
+}
+
+
+void gfal_log_ring_flush(void)
+{
+    if (!g_atomic_int_get(&drain_running) || gfal_log_ring_is_drain_thread())
+        return;
+
+    guint target = g_atomic_int_get(&enqueue_pos);
+    pthread_mutex_lock(&drain_lock);
+    while (g_atomic_int_get(&drain_running) &&
+           (gint)((guint)g_atomic_int_get(&dequeue_pos) - target) < 0) {
+        struct timespec deadline;
+        gfal_log_timeout(&deadline, 10);
+        pthread_cond_signal(&drain_wakeup);
+        pthread_cond_timedwait(&drain_done, &drain_lock, &deadline);
+    }
+    pthread_mutex_unlock(&drain_lock);
+}
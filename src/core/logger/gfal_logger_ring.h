@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_LOGGER_RING_H_
+#define GFAL_LOGGER_RING_H_
+
+#include <glib.h>
+#include <stdarg.h>
+
+// Ring of pending messages, drained by a background thread, internal
+
+// Start the thread draining the ring
+// If binary is TRUE, messages are queued unformatted, and formatted by the thread
+int gfal_log_ring_start(gboolean binary);
+
+// Drain what is left and stop the thread
+void gfal_log_ring_stop(void);
+
+// Queue a message
+// Returns FALSE if it can not be queued (i.e. called by the thread draining the ring),
+// and then it must be logged directly
+gboolean gfal_log_ring_push(GLogLevelFlags level, const char* msg, va_list args);
+
+// Wait until all the messages queued so far have been passed to the handler
+void gfal_log_ring_flush(void);
+
+#endif /* GFAL_LOGGER_RING_H_ */
@@ -367,7 +367,7 @@ ssize_t gfal_write(int fd, const void *buff, size_t size);
  *
  *  flush the current fiel descriptor, clear the cache  \
  * and commit the changes.
- *  This call is reserved fora futur usage.
+ *  Only the files opened with write-behind buffer data, see GFAL_O_WRITEBEHIND
  *
  * @param fd : gfal file descriptor of the file
  * @return On success, return 0.
@@ -594,5 +594,16 @@ ssize_t gfal_pwrite(int fd, const void *buffer, size_t count, off_t offset)
 
 int gfal_flush(int fd)
 {
-    return 0;
+    GError *tmp_err = NULL;
+    gfal2_context_t handle;
+
+    if ((handle = gfal_posix_get_handle()) == NULL) {
+        return -1;
+    }
+
+    int ret = gfal2_flush(handle, fd, &tmp_err);
+    if (tmp_err) {
+        gfal_posix_register_internal_error(__func__, tmp_err);
+    }
+    return ret;
 }
@@ -30,6 +30,7 @@
 #include <common/gfal_common.h>
 #include <logger/gfal_logger.h>
 #include <common/gfal_constants.h>
+#include <file/gfal_async_api.h>
 
 
 #ifdef __cplusplus
@@ -92,6 +93,12 @@ extern GQuark GFAL_EVENT_TRANSFER_TYPE;   /**< Triggered to register the transfe
 #define GFAL_TRANSFER_TYPE_PUSH "3rd push"
 #define GFAL_TRANSFER_TYPE_PULL "3rd pull"
 
+/**
+ * Log domain of the "Event triggered" messages, so their level can be set
+ * apart from the rest with gfal2_log_set_domain_level
+ */
+#define GFAL_EVENT_LOG_DOMAIN "TRANSFER EVENT"
+
 /** Trigger of the event */
 typedef enum {
     GFAL_EVENT_SOURCE = 0,  /**< Event triggered by the source */
@@ -362,6 +369,21 @@ gint gfalt_remove_event_callback(gfalt_params_t params, gfalt_event_func callbac
 int gfalt_copy_file(gfal2_context_t context, gfalt_params_t params, const char* src,
         const char* dst, GError** err);
 
+/**
+ * @brief asynchronous copy
+ *  Submit a copy to a completion queue, see \ref gfal_async_api.h
+ *  The copy is always run by the thread pool of the queue.
+ *  @param queue completion queue
+ *  @param params parameter handle, copied, can be NULL
+ *  @param src source URL supported by GFAL
+ *  @param dst destination URL supported by GFAL
+ *  @param user_data returned by \ref gfal2_async_get_user_data
+ *  @param err the error is put here
+ *  @return the operation, or NULL if it could not be submitted
+ */
+gfal2_async_op_t gfal2_async_copy(gfal2_async_queue_t queue, gfalt_params_t params,
+        const char* src, const char* dst, gpointer user_data, GError** err);
+
 /**
  * @brief bulk copy operation
  * If not provided by the plugin, it will fallback to a serialized implementation
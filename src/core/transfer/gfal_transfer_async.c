@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <common/gfal_error.h>
+#include <transfer/gfal_transfer.h>
+#include <file/gfal_async_internal.h>
+
+
+typedef struct {
+    gfalt_params_t params;
+    char* dst;
+} gfal_async_copy_data;
+
+
+static void gfal_async_copy_data_free(gpointer ptr)
+{
+    gfal_async_copy_data* data = ptr;
+    gfalt_params_handle_delete(data->params, NULL);
+    g_free(data->dst);
+    g_free(data);
+}
+
+
+static ssize_t gfal_async_run_copy(gfal2_context_t context, gfal2_async_op_t op, GError** err)
+{
+    gfal_async_copy_data* data = op->data;
+    return gfalt_copy_file(context, data->params, op->args.url, data->dst, err);
+}
+
+
+gfal2_async_op_t gfal2_async_copy(gfal2_async_queue_t queue, gfalt_params_t params,
+        const char* src, const char* dst, gpointer user_data, GError** err)
+{
+    g_return_val_err_if_fail(queue && src && dst, NULL, err, "[gfal2_async_copy] invalid parameters");
+
+    gfal_async_copy_data* data = g_new0(gfal_async_copy_data, 1);
+    data->params = params ? gfalt_params_handle_copy(params, NULL) : gfalt_params_handle_new(NULL);
+    data->dst = g_strdup(dst);
+
+    gfal2_async_op_t op = gfal_async_op_new(queue, GFAL_ASYNC_COPY, user_data);
+    op->args.url = op->url = g_strdup(src);
+    op->data = data;
+    op->data_free = gfal_async_copy_data_free;
+    op->run = gfal_async_run_copy;
+    return gfal_async_submit(op, err);
+}
@@ -18,11 +18,19 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <common/gfal_config.h>
 #include <common/gfal_plugin.h>
+#include <common/gfal_plugin_internal.h>
 #include <common/gfal_error.h>
 #include <transfer/gfal_transfer_plugins.h>
 #include <transfer/gfal_transfer_internal.h>
 #include <common/gfal_cancel.h>
+#include <file/gfal_stat_cache_internal.h>
+#include <uri/gfal2_uri.h>
 
 static GQuark scope_copy_domain() {
     return g_quark_from_static_string("GFAL2:CORE:COPY");
@@ -37,7 +45,17 @@ static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url
 
     while (item != NULL && resu == NULL) {
         gfal_plugin_interface* plugin_ifce = (gfal_plugin_interface*)item->data;
-        if (plugin_ifce->check_plugin_url_transfer != NULL) {
+        // a plugin only known by its manifest so far (no getName) must be loaded
+        // to tell if it supports the copy, but only if it declares one of the schemes
+        const gboolean unknown = (plugin_ifce->getName == NULL);
+        const gboolean allowed = gfal_plugin_manifest_allows(context, plugin_ifce, src) ||
+                gfal_plugin_manifest_allows(context, plugin_ifce, dst);
+        gboolean usable = allowed;
+        if (allowed && (unknown || plugin_ifce->check_plugin_url_transfer != NULL)) {
+            // already logged, the next plugins may still do the copy
+            usable = (gfal_plugin_instance(context, plugin_ifce, NULL) == 0);
+        }
+        if (usable && plugin_ifce->check_plugin_url_transfer != NULL) {
             gboolean compatible;
             if ((compatible = plugin_ifce->check_plugin_url_transfer(plugin_ifce->plugin_data, context, src, dst,
                     operation)) == TRUE) {
@@ -60,7 +78,8 @@ static int trigger_listener_plugins(gfal2_context_t context, gfalt_params_t para
         gfal_plugin_interface* plugin_ifce = (gfal_plugin_interface*)item->data;
         if (plugin_ifce->copy_enter_hook) {
             GError* tmp_error = NULL;
-            plugin_ifce->copy_enter_hook(plugin_ifce->plugin_data, context, params, &tmp_error);
+            if (gfal_plugin_instance(context, plugin_ifce, &tmp_error) == 0)
+                plugin_ifce->copy_enter_hook(plugin_ifce->plugin_data, context, params, &tmp_error);
             if (tmp_error) {
                 gfal2_log(G_LOG_LEVEL_MESSAGE, "Copy enter hook failed: %s", tmp_error->message);
                 g_error_free(tmp_error);
@@ -114,6 +133,9 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
         return -1;
     }
 
+    // the plugins stat the destination while they write it
+    gfal_stat_cache_begin_write(context, dst);
+
     void *plugin_data = NULL;
     gfal_plugin_interface* plugin = find_copy_plugin(context, GFAL_FILE_COPY, src, dst,
             &plugin_data, &tmp_err);
@@ -135,6 +157,8 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
         }
     }
 
+    gfal_stat_cache_end_write(context, dst);
+
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::FileCopy");
 
     if (tmp_err != NULL)
@@ -160,36 +184,239 @@ static int set_checksum(gfalt_params_t params, const char* checksum, GError **er
         else {
             char chktype[64];
             size_t chktype_len = colon - checksum;
-            g_strlcpy(chktype, checksum, chktype_len < 64 ? chktype_len : 64);
+            g_strlcpy(chktype, checksum, chktype_len < 64 ? chktype_len + 1 : 64);
             return gfalt_set_checksum(params, mode, chktype, colon + 1, err);
         }
     }
 }
 
 
-static int bulk_fallback(gfal2_context_t context, gfalt_params_t params, size_t nbfiles,
-        const char* const * srcs, const char* const * dsts, const char* const * checksums,
-        GError** op_error, GError*** file_errors)
+// Copy one pair of the bulk with its own copy of the parameters, since
+// the checksum is set per file
+static int bulk_copy_one(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, const char* checksum, GError** file_error)
+{
+    gfalt_params_t file_params = gfalt_params_handle_copy(params, NULL);
+    int ret = set_checksum(file_params, checksum, file_error);
+    if (ret == 0)
+        ret = perform_copy(context, file_params, src, dst, file_error);
+    gfalt_params_handle_delete(file_params, NULL);
+    return ret;
+}
+
+
+// State shared by the workers of the bulk fallback
+typedef struct {
+    gfal2_context_t context;
+    // of the caller, attached to the workers
+    gfal_operation_t operation;
+    gfalt_params_t params;
+    size_t nbfiles;
+    const char* const * srcs;
+    const char* const * dsts;
+    const char* const * checksums;
+    GError** file_errors;
+    // "" when the url has no host
+    char** src_hosts;
+    char** dst_hosts;
+    // 0 if there is no limit per host
+    int max_per_host;
+
+    pthread_mutex_t lock;
+    // signaled when a copy is done, so its hosts have a free slot
+    pthread_cond_t cond;
+    gboolean* started;
+    size_t pending;
+    // host => number of copies running from or to it
+    GHashTable* running;
+    int failed;
+} bulk_copy_t;
+
+
+static char* bulk_copy_host(const char* url)
+{
+    gfal2_uri_view view;
+    char* host = NULL;
+    if (gfal2_parse_uri_view(url, &view, NULL) == 0)
+        host = gfal2_uri_view_dup(&view, &view.host);
+    return host ? host : g_strdup("");
+}
+
+
+static int bulk_copy_running(bulk_copy_t* bulk, const char* host)
+{
+    return GPOINTER_TO_INT(g_hash_table_lookup(bulk->running, host));
+}
+
+
+static void bulk_copy_running_add(bulk_copy_t* bulk, size_t i, int n)
+{
+    const char* src_host = bulk->src_hosts[i];
+    const char* dst_host = bulk->dst_hosts[i];
+    g_hash_table_insert(bulk->running, (gpointer)src_host,
+            GINT_TO_POINTER(bulk_copy_running(bulk, src_host) + n));
+    if (strcmp(src_host, dst_host) != 0) {
+        g_hash_table_insert(bulk->running, (gpointer)dst_host,
+                GINT_TO_POINTER(bulk_copy_running(bulk, dst_host) + n));
+    }
+}
+
+
+// First pair not started whose hosts are below the limit, -1 if none
+// Called with the lock held
+static ssize_t bulk_copy_next(bulk_copy_t* bulk)
 {
-    *file_errors = g_new0(GError*, nbfiles);
-    int ret = 0;
     size_t i;
-    for (i = 0; i < nbfiles; ++i) {
-        int subret = 0;
+    for (i = 0; i < bulk->nbfiles; ++i) {
+        if (bulk->started[i])
+            continue;
+        if (bulk->max_per_host <= 0 ||
+            (bulk_copy_running(bulk, bulk->src_hosts[i]) < bulk->max_per_host &&
+             bulk_copy_running(bulk, bulk->dst_hosts[i]) < bulk->max_per_host)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 
-        if (checksums) {
-            const char* checksum = checksums[i];
-            subret = set_checksum(params, checksum, &(*file_errors)[i]);
+// Fail the pairs not started yet
+// Called with the lock held
+static void bulk_copy_cancel_pending(bulk_copy_t* bulk)
+{
+    size_t i;
+    for (i = 0; i < bulk->nbfiles; ++i) {
+        if (!bulk->started[i]) {
+            bulk->started[i] = TRUE;
+            gfal2_set_error(&bulk->file_errors[i], scope_copy_domain(), ECANCELED, __func__,
+                    "Transfer canceled before starting");
+            bulk->failed += 1;
         }
-        else {
-            subret = set_checksum(params, NULL, &(*file_errors)[i]);
+    }
+    bulk->pending = 0;
+}
+
+
+static void* bulk_copy_worker(void* data)
+{
+    bulk_copy_t* bulk = (bulk_copy_t*)data;
+    gfal_operation_t previous = gfal2_operation_attach(bulk->operation);
+
+    pthread_mutex_lock(&bulk->lock);
+    while (bulk->pending > 0) {
+        if (gfal2_is_canceled(bulk->context)) {
+            bulk_copy_cancel_pending(bulk);
+            break;
         }
-        if (subret < 0) {
-            ret -= 1;
+        ssize_t i = bulk_copy_next(bulk);
+        if (i < 0) {
+            pthread_cond_wait(&bulk->cond, &bulk->lock);
             continue;
         }
+        bulk->started[i] = TRUE;
+        bulk->pending -= 1;
+        bulk_copy_running_add(bulk, i, 1);
+        pthread_mutex_unlock(&bulk->lock);
+
+        int ret = bulk_copy_one(bulk->context, bulk->params, bulk->srcs[i], bulk->dsts[i],
+                bulk->checksums ? bulk->checksums[i] : NULL, &bulk->file_errors[i]);
+
+        pthread_mutex_lock(&bulk->lock);
+        if (ret < 0)
+            bulk->failed += 1;
+        bulk_copy_running_add(bulk, i, -1);
+        pthread_cond_broadcast(&bulk->cond);
+    }
+    pthread_mutex_unlock(&bulk->lock);
+    gfal2_operation_attach(previous);
+    return NULL;
+}
+
+
+static int bulk_fallback_concurrent(gfal2_context_t context, gfalt_params_t params, size_t nbfiles,
+        const char* const * srcs, const char* const * dsts, const char* const * checksums,
+        GError** file_errors, int concurrency, int max_per_host)
+{
+    bulk_copy_t bulk;
+    size_t i;
+
+    memset(&bulk, 0, sizeof(bulk));
+    bulk.context = context;
+    bulk.operation = gfal2_operation_get_attached();
+    bulk.params = params;
+    bulk.nbfiles = nbfiles;
+    bulk.srcs = srcs;
+    bulk.dsts = dsts;
+    bulk.checksums = checksums;
+    bulk.file_errors = file_errors;
+    bulk.max_per_host = max_per_host;
+    bulk.src_hosts = g_new0(char*, nbfiles);
+    bulk.dst_hosts = g_new0(char*, nbfiles);
+    for (i = 0; i < nbfiles; ++i) {
+        bulk.src_hosts[i] = bulk_copy_host(srcs[i]);
+        bulk.dst_hosts[i] = bulk_copy_host(dsts[i]);
+    }
+    bulk.started = g_new0(gboolean, nbfiles);
+    bulk.pending = nbfiles;
+    bulk.running = g_hash_table_new(g_str_hash, g_str_equal);
+    pthread_mutex_init(&bulk.lock, NULL);
+    pthread_cond_init(&bulk.cond, NULL);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Bulk copy of %zu files, %d at a time, %d per host",
+            nbfiles, concurrency, max_per_host);
+
+    // the calling thread is one of the workers
+    int nthreads = 0;
+    pthread_t* threads = g_new0(pthread_t, concurrency - 1);
+    for (i = 0; i < (size_t)concurrency - 1; ++i) {
+        if (pthread_create(&threads[nthreads], NULL, bulk_copy_worker, &bulk) != 0) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Could not start a bulk copy worker, running with %d",
+                    nthreads + 1);
+            break;
+        }
+        ++nthreads;
+    }
+    bulk_copy_worker(&bulk);
+    for (i = 0; i < (size_t)nthreads; ++i)
+        pthread_join(threads[i], NULL);
+    g_free(threads);
+
+    pthread_cond_destroy(&bulk.cond);
+    pthread_mutex_destroy(&bulk.lock);
+    g_hash_table_destroy(bulk.running);
+    g_free(bulk.started);
+    for (i = 0; i < nbfiles; ++i) {
+        g_free(bulk.src_hosts[i]);
+        g_free(bulk.dst_hosts[i]);
+    }
+    g_free(bulk.src_hosts);
+    g_free(bulk.dst_hosts);
+    return -bulk.failed;
+}
 
-        subret = perform_copy(context, params, srcs[i], dsts[i], &(*file_errors)[i]);
+
+static int bulk_fallback(gfal2_context_t context, gfalt_params_t params, size_t nbfiles,
+        const char* const * srcs, const char* const * dsts, const char* const * checksums,
+        GError** op_error, GError*** file_errors)
+{
+    *file_errors = g_new0(GError*, nbfiles);
+
+    int concurrency = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_COPY_BULK_CONCURRENCY, 1);
+    int max_per_host = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_COPY_BULK_CONCURRENCY_PER_HOST, 0);
+    if (concurrency > (int)nbfiles)
+        concurrency = nbfiles;
+    if (concurrency > 1) {
+        return bulk_fallback_concurrent(context, params, nbfiles, srcs, dsts, checksums,
+                *file_errors, concurrency, max_per_host);
+    }
+
+    int ret = 0;
+    size_t i;
+    for (i = 0; i < nbfiles; ++i) {
+        int subret = bulk_copy_one(context, params, srcs[i], dsts[i],
+                checksums ? checksums[i] : NULL, &(*file_errors)[i]);
         if (subret < 0) {
             ret -= 1;
         }
@@ -216,6 +443,11 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
         return -1;
     }
 
+    size_t i;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_stat_cache_begin_write(context, dsts[i]);
+    }
+
     void *plugin_data = NULL;
     gfal_plugin_interface *plugin = find_copy_plugin(context, GFAL_BULK_COPY, srcs[0],
             dsts[0], &plugin_data, &tmp_err);
@@ -231,6 +463,10 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
         }
     }
 
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_stat_cache_end_write(context, dsts[i]);
+    }
+
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::BulkFileCopy");
 
     if (tmp_err != NULL)
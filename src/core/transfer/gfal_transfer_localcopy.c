@@ -18,16 +18,22 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
 #include <string.h>
 
 #include <gfal_api.h>
+#include <common/gfal_config.h>
+#include <common/gfal_plugin.h>
 #include <common/gfal_plugin_interface.h>
+#include <file/gfal_checksum_cache_internal.h>
 #include <checksums/checksums.h>
 #include "gfal_transfer_plugins.h"
 #include "gfal_transfer_internal.h"
 
 
 const size_t DEFAULT_BUFFER_SIZE = 4194304;
+const int DEFAULT_PIPELINE_BUFFERS = 4;
+const size_t DEFAULT_PARALLEL_CHUNK_SIZE = 16777216;
 
 
 static GQuark local_copy_domain() {
@@ -35,124 +41,477 @@ static GQuark local_copy_domain() {
 }
 
 
-static char* get_parent(const char* url)
+static int streamed_copy_serial(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, gfal_file_handle f_src, gfal_file_handle f_dst,
+        size_t alignment, size_t buffersize, gfal_checksum_stream_t checksum, GError** error)
 {
-    char *parent = g_strdup(url);
-    char *slash = strrchr(parent, '/');
-    if (slash) {
-        *slash = '\0';
+    GError *nested_error = NULL;
+    char *buffer;
+    errno = posix_memalign((void**)&buffer, alignment, buffersize);
+    if (errno) {
+        g_set_error(error, local_copy_domain(), errno, "Failed to allocate aligned buffer");
+        return -1;
     }
-    else {
-        g_free(parent);
-        parent = NULL;
+
+    gfalt_perf_data_t perf_data;
+    perf_data.start = perf_data.now = perf_data.last_update = time(NULL);
+    perf_data.done = perf_data.done_since_last_update = 0;
+
+    const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
+    ssize_t s_file = 1;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s with buffer size %ld", src, dst, buffersize);
+
+    while (s_file > 0 && !nested_error) {
+        s_file = gfal_plugin_readG(context, f_src, buffer, buffersize, &nested_error);
+        if (s_file > 0) {
+            if (checksum)
+                gfal_checksum_stream_update(checksum, buffer, s_file);
+            gfal_plugin_writeG(context, f_dst, buffer, s_file, &nested_error);
+        }
+
+        perf_data.done += s_file;
+        perf_data.done_since_last_update += s_file;
+
+        if (nested_error == NULL) {
+            gfalt_check_transfer_state(context, params, local_copy_domain(), src, dst, &perf_data, timeout, &nested_error);
+        }
     }
-    return parent;
+    free(buffer);
+
+    if (nested_error) {
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+    return 0;
 }
 
 
-static int create_parent(gfal2_context_t context, gfalt_params_t params,
-        const char* surl, GError** error)
-{
-    if (!gfalt_get_create_parent_dir(params, NULL))
-        return 0;
+struct pipeline_buffer_t {
+    char* data;
+    ssize_t used;
+};
 
-    char *parent = get_parent(surl);
-    if (!parent) {
-        gfalt_set_error(error, local_copy_domain(), EINVAL, __func__,
-                GFALT_ERROR_DESTINATION, GFALT_ERROR_PARENT, "Could not get the parent directory of %s", surl);
-        return -1;
+
+// Ring of buffers between the reader thread and the writer
+struct pipeline_t {
+    gfal2_context_t context;
+    // of the caller, attached to the reader
+    gfal_operation_t operation;
+    gfal_file_handle f_src;
+    size_t buffersize;
+    // updated by the reader, in the order of the data
+    gfal_checksum_stream_t checksum;
+
+    pthread_mutex_t lock;
+    // signaled when a buffer is filled or released, and when the reader ends
+    pthread_cond_t cond;
+    struct pipeline_buffer_t* buffers;
+    int n_buffers;
+    // full buffers, in order, starting at first
+    int first, count;
+    // set by the writer when the reader must stop
+    gboolean stop;
+    // set by the reader at the end of the source, on error, or when stopped
+    gboolean reader_done;
+    GError* read_error;
+};
+
+
+static void* pipeline_reader(void* data)
+{
+    struct pipeline_t* pipeline = (struct pipeline_t*)data;
+    GError* tmp_err = NULL;
+    gfal_operation_t previous = gfal2_operation_attach(pipeline->operation);
+
+    pthread_mutex_lock(&pipeline->lock);
+    while (TRUE) {
+        while (pipeline->count == pipeline->n_buffers && !pipeline->stop)
+            pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+        if (pipeline->stop)
+            break;
+
+        // the free slot after the full buffers belongs to the reader
+        struct pipeline_buffer_t* buffer =
+                &pipeline->buffers[(pipeline->first + pipeline->count) % pipeline->n_buffers];
+        pthread_mutex_unlock(&pipeline->lock);
+        buffer->used = gfal_plugin_readG(pipeline->context, pipeline->f_src,
+                buffer->data, pipeline->buffersize, &tmp_err);
+        if (buffer->used > 0 && pipeline->checksum)
+            gfal_checksum_stream_update(pipeline->checksum, buffer->data, buffer->used);
+        pthread_mutex_lock(&pipeline->lock);
+
+        if (buffer->used < 0) {
+            pipeline->read_error = tmp_err;
+            break;
+        }
+        else if (buffer->used == 0) {
+            break;
+        }
+        pipeline->count += 1;
+        pthread_cond_broadcast(&pipeline->cond);
     }
+    pipeline->reader_done = TRUE;
+    pthread_cond_broadcast(&pipeline->cond);
+    pthread_mutex_unlock(&pipeline->lock);
+    gfal2_operation_attach(previous);
+    return NULL;
+}
 
-    GError* nested_error = NULL;
-    struct stat st;
-    if (gfal2_stat(context, parent, &st, &nested_error) < 0) {
-        if (nested_error->code != ENOENT) {
-            gfal2_propagate_prefixed_error(error, nested_error, __func__);
+
+static int pipeline_write_all(gfal2_context_t context, gfal_file_handle f_dst,
+        const char* data, size_t size, GError** error)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t res = gfal_plugin_writeG(context, f_dst, (void*)(data + done), size - done, error);
+        if (res < 0)
+            return -1;
+        if (res == 0) {
+            g_set_error(error, local_copy_domain(), EIO, "The destination did not write anything");
             return -1;
         }
-        g_clear_error(&nested_error);
-    }
-    else {
-        return 0;
+        done += res;
     }
+    return 0;
+}
 
-    gfal2_mkdir_rec(context, parent, 0755, &nested_error);
-    if (nested_error != NULL) {
-        gfal2_propagate_prefixed_error(error, nested_error, __func__);
-        return -1;
+
+// Wait for a full buffer, waking up every second so the transfer state is still checked
+// when the source is slow. Returns NULL when there is nothing left to write
+static struct pipeline_buffer_t* pipeline_wait_buffer(struct pipeline_t* pipeline, gboolean* finished)
+{
+    struct pipeline_buffer_t* buffer = NULL;
+
+    pthread_mutex_lock(&pipeline->lock);
+    if (pipeline->count == 0 && !pipeline->reader_done) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        pthread_cond_timedwait(&pipeline->cond, &pipeline->lock, &deadline);
     }
+    if (pipeline->count > 0)
+        buffer = &pipeline->buffers[pipeline->first];
+    *finished = (buffer == NULL && pipeline->reader_done);
+    pthread_mutex_unlock(&pipeline->lock);
+    return buffer;
+}
 
-    return 0;
+
+static void pipeline_release_buffer(struct pipeline_t* pipeline)
+{
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->first = (pipeline->first + 1) % pipeline->n_buffers;
+    pipeline->count -= 1;
+    pthread_cond_broadcast(&pipeline->cond);
+    pthread_mutex_unlock(&pipeline->lock);
 }
 
 
-static int unlink_if_exists(gfal2_context_t context, gfalt_params_t params,
-        const char* surl, GError** error)
+// The source is read by a separate thread into a ring of n_buffers, while this one writes,
+// so the memory used is bounded to n_buffers * buffersize
+static int streamed_copy_pipelined(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, gfal_file_handle f_src, gfal_file_handle f_dst,
+        size_t alignment, size_t buffersize, int n_buffers, gfal_checksum_stream_t checksum, GError** error)
 {
-    GError* nested_error = NULL;
-    struct stat st;
-    if (gfal2_stat(context, surl, &st, &nested_error) != 0) {
-        if (nested_error->code == ENOENT) {
-            g_error_free(nested_error);
-            return 0;
+    GError *nested_error = NULL;
+    struct pipeline_t pipeline;
+    int i;
+
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.context = context;
+    pipeline.operation = gfal2_operation_get_attached();
+    pipeline.f_src = f_src;
+    pipeline.buffersize = buffersize;
+    pipeline.n_buffers = n_buffers;
+    pipeline.checksum = checksum;
+    pipeline.buffers = g_new0(struct pipeline_buffer_t, n_buffers);
+    for (i = 0; i < n_buffers; ++i) {
+        errno = posix_memalign((void**)&pipeline.buffers[i].data, alignment, buffersize);
+        if (errno) {
+            g_set_error(&nested_error, local_copy_domain(), errno, "Failed to allocate aligned buffer");
+            goto free_buffers;
         }
-        gfal2_propagate_prefixed_error(error, nested_error, __func__);
-        return -1;
     }
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.cond, NULL);
 
-    if (S_ISFIFO(st.st_mode) || S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode) || S_ISSOCK(st.st_mode)) {
-        gfal2_log(G_LOG_LEVEL_MESSAGE, "%s is a special file (%o), so keep going", surl, S_IFMT & st.st_mode);
-        return 0;
-    }
+    gfalt_perf_data_t perf_data;
+    perf_data.start = perf_data.now = perf_data.last_update = time(NULL);
+    perf_data.done = perf_data.done_since_last_update = 0;
 
-    if (!gfalt_get_replace_existing_file(params,NULL)) {
-        gfal2_set_error(error, local_copy_domain(), EEXIST, __func__, "The file exists and overwrite is not set");
-        return -1;
+    const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  begin pipelined local transfer %s ->  %s with %d buffers of %ld bytes",
+            src, dst, n_buffers, buffersize);
+
+    pthread_t reader;
+    int res = pthread_create(&reader, NULL, pipeline_reader, &pipeline);
+    if (res != 0) {
+        g_set_error(&nested_error, local_copy_domain(), res, "Could not start the reader thread");
+        goto destroy;
     }
 
-    gfal2_unlink(context, surl, &nested_error);
-    if (nested_error != NULL) {
-        if (nested_error->code != ENOENT) {
-            gfal2_propagate_prefixed_error(error, nested_error, __func__);
-            return -1;
+    gboolean finished = FALSE;
+    while (!finished && !nested_error) {
+        struct pipeline_buffer_t* buffer = pipeline_wait_buffer(&pipeline, &finished);
+        if (buffer) {
+            pipeline_write_all(context, f_dst, buffer->data, buffer->used, &nested_error);
+            perf_data.done += buffer->used;
+            perf_data.done_since_last_update += buffer->used;
+            pipeline_release_buffer(&pipeline);
+        }
+        if (nested_error == NULL) {
+            gfalt_check_transfer_state(context, params, local_copy_domain(), src, dst, &perf_data, timeout, &nested_error);
         }
-        g_error_free(nested_error);
     }
-    else {
-        plugin_trigger_event(params, local_copy_domain(),
-                GFAL_EVENT_DESTINATION, GFAL_EVENT_OVERWRITE_DESTINATION,
-                "Deleted %s", surl);
+
+    // the reader ends after the read in progress, as the serial copy does
+    pthread_mutex_lock(&pipeline.lock);
+    pipeline.stop = TRUE;
+    pthread_cond_broadcast(&pipeline.cond);
+    pthread_mutex_unlock(&pipeline.lock);
+    pthread_join(reader, NULL);
+
+    if (nested_error == NULL && pipeline.read_error != NULL) {
+        nested_error = pipeline.read_error;
+        pipeline.read_error = NULL;
+    }
+    g_clear_error(&pipeline.read_error);
+
+destroy:
+    pthread_cond_destroy(&pipeline.cond);
+    pthread_mutex_destroy(&pipeline.lock);
+free_buffers:
+    for (i = 0; i < n_buffers; ++i) {
+        free(pipeline.buffers[i].data);
     }
+    g_free(pipeline.buffers);
 
+    if (nested_error) {
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
     return 0;
 }
 
 
-struct perf_data_t {
-    time_t start, last_update, now;
+// Ranges of the source handed to the workers of the parallel copy
+struct parallel_copy_t {
+    gfal2_context_t context;
+    // of the caller, attached to the workers
+    gfal_operation_t operation;
+    gfal_file_handle f_src, f_dst;
+    off_t size;
+    size_t chunk_size;
+    size_t alignment, buffersize;
+
+    pthread_mutex_t lock;
+    // signaled when a worker copies a buffer or ends
+    pthread_cond_t cond;
+    // start of the next range to copy
+    off_t next;
     size_t done;
-    size_t done_since_last_update;
+    int running;
+    // set on the first failure, or by the caller to stop the workers
+    gboolean stop;
+    GError* error;
 };
 
 
-static void send_performance_data(gfalt_params_t params, const char* src, const char* dst, const struct perf_data_t* perf)
+// Copy [offset, offset + len) with the buffer, going through it as many times as needed
+static int parallel_copy_range(struct parallel_copy_t* copy, char* buffer, off_t offset, size_t len, GError** error)
 {
-    struct _gfalt_transfer_status status;
+    size_t range_done = 0;
 
-    time_t total_time = perf->now - perf->start;
-    time_t inc_time = perf->now - perf->last_update;
+    while (range_done < len) {
+        size_t to_read = MIN(copy->buffersize, len - range_done);
+        size_t buffer_used = 0;
 
-    status.average_baudrate = (size_t)(perf->done / total_time);
-    status.bytes_transfered = (size_t)(perf->done);
-    status.instant_baudrate = (size_t)(perf->done_since_last_update / inc_time);
-    status.transfer_time    = total_time;
+        while (buffer_used < to_read) {
+            ssize_t res = gfal_plugin_preadG(copy->context, copy->f_src, buffer + buffer_used,
+                    to_read - buffer_used, offset + range_done + buffer_used, error);
+            if (res < 0)
+                return -1;
+            if (res == 0) {
+                g_set_error(error, local_copy_domain(), EIO,
+                        "The source is shorter than expected, it may have been modified during the copy");
+                return -1;
+            }
+            buffer_used += res;
+        }
 
-    plugin_trigger_monitor(params, &status, src, dst);
+        size_t written = 0;
+        while (written < buffer_used) {
+            ssize_t res = gfal_plugin_pwriteG(copy->context, copy->f_dst, buffer + written,
+                    buffer_used - written, offset + range_done + written, error);
+            if (res < 0)
+                return -1;
+            if (res == 0) {
+                g_set_error(error, local_copy_domain(), EIO, "The destination did not write anything");
+                return -1;
+            }
+            written += res;
+        }
+        range_done += buffer_used;
+
+        pthread_mutex_lock(&copy->lock);
+        copy->done += buffer_used;
+        gboolean stop = copy->stop;
+        pthread_cond_broadcast(&copy->cond);
+        pthread_mutex_unlock(&copy->lock);
+        if (stop)
+            return 0;
+    }
+    return 0;
 }
 
 
+static void* parallel_copy_worker(void* data)
+{
+    struct parallel_copy_t* copy = (struct parallel_copy_t*)data;
+    GError* tmp_err = NULL;
+    char* buffer = NULL;
+    gfal_operation_t previous = gfal2_operation_attach(copy->operation);
+
+    int res = posix_memalign((void**)&buffer, copy->alignment, copy->buffersize);
+    if (res != 0) {
+        buffer = NULL;
+        g_set_error(&tmp_err, local_copy_domain(), res, "Failed to allocate aligned buffer");
+    }
+
+    while (tmp_err == NULL) {
+        pthread_mutex_lock(&copy->lock);
+        if (copy->stop || copy->next >= copy->size) {
+            pthread_mutex_unlock(&copy->lock);
+            break;
+        }
+        off_t offset = copy->next;
+        size_t len = MIN(copy->chunk_size, copy->size - offset);
+        copy->next += len;
+        pthread_mutex_unlock(&copy->lock);
+
+        parallel_copy_range(copy, buffer, offset, len, &tmp_err);
+    }
+    free(buffer);
+
+    pthread_mutex_lock(&copy->lock);
+    if (tmp_err) {
+        if (copy->error == NULL)
+            copy->error = tmp_err;
+        else
+            g_error_free(tmp_err);
+        copy->stop = TRUE;
+    }
+    copy->running -= 1;
+    pthread_cond_broadcast(&copy->cond);
+    pthread_mutex_unlock(&copy->lock);
+    gfal2_operation_attach(previous);
+    return NULL;
+}
+
+
+// True if both sides can read and write at any offset, so several ranges can be moved at once
+static gboolean parallel_copy_possible(gfal2_context_t context, gfal_file_handle f_src, gfal_file_handle f_dst)
+{
+    gfal_plugin_interface* src_plugin = gfal_plugin_map_file_handle(context, f_src, NULL);
+    gfal_plugin_interface* dst_plugin = gfal_plugin_map_file_handle(context, f_dst, NULL);
+    return src_plugin != NULL && src_plugin->preadG != NULL &&
+           dst_plugin != NULL && dst_plugin->pwriteG != NULL;
+}
+
+
+// The source is split in ranges of chunk_size bytes, copied by n_streams workers with pread/pwrite,
+// each one with a buffer of buffersize bytes
+static int streamed_copy_parallel(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, gfal_file_handle f_src, gfal_file_handle f_dst,
+        off_t size, size_t alignment, size_t buffersize, int n_streams, size_t chunk_size, GError** error)
+{
+    GError *nested_error = NULL;
+    struct parallel_copy_t copy;
+    pthread_t* workers = g_new0(pthread_t, n_streams);
+    int i;
+
+    memset(&copy, 0, sizeof(copy));
+    copy.context = context;
+    copy.operation = gfal2_operation_get_attached();
+    copy.f_src = f_src;
+    copy.f_dst = f_dst;
+    copy.size = size;
+    copy.chunk_size = chunk_size;
+    copy.alignment = alignment;
+    copy.buffersize = MIN(buffersize, chunk_size);
+    pthread_mutex_init(&copy.lock, NULL);
+    pthread_cond_init(&copy.cond, NULL);
+
+    // no more workers than ranges
+    if ((off_t)n_streams * (off_t)chunk_size > size)
+        n_streams = (size + chunk_size - 1) / chunk_size;
+
+    gfalt_perf_data_t perf_data;
+    perf_data.start = perf_data.now = perf_data.last_update = time(NULL);
+    perf_data.done = perf_data.done_since_last_update = 0;
+
+    const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  begin parallel local transfer %s ->  %s with %d streams and chunks of %zu bytes",
+            src, dst, n_streams, chunk_size);
+
+    pthread_mutex_lock(&copy.lock);
+    for (i = 0; i < n_streams; ++i) {
+        int res = pthread_create(&workers[i], NULL, parallel_copy_worker, &copy);
+        if (res != 0) {
+            g_set_error(&copy.error, local_copy_domain(), res, "Could not start the copy threads");
+            copy.stop = TRUE;
+            break;
+        }
+        copy.running += 1;
+    }
+    const int started = i;
+
+    while (copy.running > 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        pthread_cond_timedwait(&copy.cond, &copy.lock, &deadline);
+
+        perf_data.done_since_last_update += copy.done - perf_data.done;
+        perf_data.done = copy.done;
+        if (!copy.stop) {
+            // the monitor callbacks are called without the lock
+            pthread_mutex_unlock(&copy.lock);
+            gfalt_check_transfer_state(context, params, local_copy_domain(), src, dst, &perf_data, timeout, &nested_error);
+            pthread_mutex_lock(&copy.lock);
+            if (nested_error)
+                copy.stop = TRUE;
+        }
+    }
+    pthread_mutex_unlock(&copy.lock);
+
+    for (i = 0; i < started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    g_free(workers);
+
+    if (nested_error == NULL) {
+        nested_error = copy.error;
+        copy.error = NULL;
+    }
+    g_clear_error(&copy.error);
+    pthread_cond_destroy(&copy.cond);
+    pthread_mutex_destroy(&copy.lock);
+
+    if (nested_error) {
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+// If checksum is not NULL, it is updated with all the data read from the source
 static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
-        const char* src, const char* dst, GError** error)
+        const char* src, const char* dst, gfal_checksum_stream_t checksum, GError** error)
 {
     GError *nested_error = NULL;
 
@@ -165,11 +524,38 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
 
     size_t alignment = gfal2_get_opt_integer_with_default(context, "CORE", "COPY_BUFFER_ALIGNMENT", 512);
     size_t buffersize = gfal2_get_opt_integer_with_default(context, "CORE", "COPY_BUFFERSIZE", DEFAULT_BUFFER_SIZE);
-    char *buffer;
-    errno = posix_memalign((void**)&buffer, alignment, buffersize);
-    if (errno) {
-        g_set_error(error, local_copy_domain(), errno, "Failed to allocate aligned buffer");
-        return -1;
+    gboolean pipelined = gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, FALSE);
+    int n_buffers = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_COPY_PIPELINE_BUFFERS, DEFAULT_PIPELINE_BUFFERS);
+    if (n_buffers < 2)
+        n_buffers = 2;
+    int n_streams = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_COPY_PARALLEL_STREAMS, 1);
+    size_t chunk_size = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, DEFAULT_PARALLEL_CHUNK_SIZE);
+    if ((ssize_t)chunk_size <= 0)
+        chunk_size = DEFAULT_PARALLEL_CHUNK_SIZE;
+
+    // Only files bigger than a range are worth splitting, and their size must be known
+    // The ranges are copied in any order, so the checksum could not follow
+    if (n_streams > 1 && checksum != NULL) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "The checksum is computed during the transfer, parallel copy disabled");
+        n_streams = 1;
+    }
+
+    struct stat src_stat;
+    off_t src_size = -1;
+    if (n_streams > 1) {
+        if (gfal2_stat(context, src, &src_stat, &nested_error) == 0 && S_ISREG(src_stat.st_mode)) {
+            src_size = src_stat.st_size;
+        }
+        else if (nested_error) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Can not get the source size, parallel copy disabled: %s",
+                    nested_error->message);
+            g_clear_error(&nested_error);
+        }
+        if (src_size <= (off_t)chunk_size)
+            n_streams = 1;
     }
 
     int src_open_flags = O_RDONLY;
@@ -188,7 +574,6 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
 
     gfal_file_handle f_src = gfal_plugin_openG(context, src, src_open_flags, 0, &nested_error);
     if (nested_error) {
-        free(buffer);
         gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not open source: ");
         return -1;
     }
@@ -207,50 +592,29 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
 
     gfal_file_handle f_dst = gfal_plugin_openG(context, dst, dst_open_flags, 0755, &nested_error);
     if (nested_error) {
-        free(buffer);
         gfal_plugin_closeG(context, f_src, NULL);
         gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not open destination: ");
         return -1;
     }
 
-    struct perf_data_t perf_data;
-    perf_data.start = perf_data.now = perf_data.last_update = time(NULL);
-    perf_data.done = perf_data.done_since_last_update = 0;
-
-    const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
-    ssize_t s_file = 1;
-
-    gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s with buffer size %ld", src, dst, buffersize);
-
-    while (s_file > 0 && !nested_error) {
-        s_file = gfal_plugin_readG(context, f_src, buffer, buffersize, &nested_error);
-        if (s_file > 0) {
-            gfal_plugin_writeG(context, f_dst, buffer, s_file, &nested_error);
-        }
-
-        perf_data.done += s_file;
-        perf_data.done_since_last_update += s_file;
+    if (n_streams > 1 && !parallel_copy_possible(context, f_src, f_dst)) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "No positional read on the source or write on the destination, "
+                "parallel copy disabled");
+        n_streams = 1;
+    }
 
-        // Make sure we don't have to cancel
-        if (gfal2_is_canceled(context)) {
-            if (nested_error == NULL)
-                g_set_error(&nested_error, local_copy_domain(), ECANCELED, "Transfer canceled");
-        }
-        // Timed-out?
-        else {
-            perf_data.now = time(NULL);
-            if (perf_data.now >= timeout) {
-                if (nested_error == NULL)
-                    g_set_error(&nested_error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
-            }
-            else if (perf_data.now - perf_data.last_update > 5) {
-                send_performance_data(params, src, dst, &perf_data);
-                perf_data.done_since_last_update = 0;
-                perf_data.last_update = perf_data.now;
-            }
-        }
+    if (n_streams > 1) {
+        streamed_copy_parallel(context, params, src, dst, f_src, f_dst, src_size,
+                alignment, buffersize, n_streams, chunk_size, &nested_error);
+    }
+    else if (pipelined) {
+        streamed_copy_pipelined(context, params, src, dst, f_src, f_dst,
+                alignment, buffersize, n_buffers, checksum, &nested_error);
+    }
+    else {
+        streamed_copy_serial(context, params, src, dst, f_src, f_dst,
+                alignment, buffersize, checksum, &nested_error);
     }
-    free(buffer);
 
     gfal_plugin_closeG(context, f_dst, (nested_error)?NULL:(&nested_error));
     gfal_plugin_closeG(context, f_src, (nested_error)?NULL:(&nested_error));
@@ -276,92 +640,67 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
     char checksum_type[1024] = {0};
     char user_checksum[1024] = {0};
     char source_checksum[1024] = {0};
-    gboolean is_strict_mode = gfalt_get_strict_copy_mode(params, NULL);
-    gfalt_checksum_mode_t checksum_mode = GFALT_CHECKSUM_NONE;
-
-    if (!is_strict_mode) {
-        checksum_mode = gfalt_get_checksum(params,
-            checksum_type, sizeof(checksum_type),
-            user_checksum, sizeof(user_checksum),
-            error);
-    }
-
-    if (checksum_type[0] == '\0') {
-        g_strlcpy(checksum_type, "ADLER32", sizeof(checksum_type));
-    }
-
-    // Source checksum
-    if (checksum_mode & GFALT_CHECKSUM_SOURCE) {
-        plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_ENTER, "");
-        gfal2_checksum(context, src, checksum_type, 0, 0, source_checksum, sizeof(source_checksum), &nested_error);
-        if (nested_error != NULL) {
-            gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not get the source checksum: ");
-            return -1;
+    gfalt_checksum_mode_t checksum_mode = gfalt_copy_get_checksum_mode(params,
+        checksum_type, sizeof(checksum_type), user_checksum, sizeof(user_checksum));
+
+    // Source checksum, computed from the data read by the copy when possible
+    // unless it is already in the checksum cache.
+    // A user checksum is compared before the destination is touched, so not on the fly
+    gfal_checksum_stream_t source_stream = NULL;
+    struct stat source_stat;
+    int source_cached = -1;
+    if ((checksum_mode & GFALT_CHECKSUM_SOURCE) && user_checksum[0] == '\0' &&
+        gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_CHECKSUM_ON_THE_FLY, TRUE)) {
+        source_cached = gfal_checksum_cache_get(context, src, checksum_type, &source_stat,
+            source_checksum, sizeof(source_checksum));
+        if (source_cached > 0) {
+            plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_EXIT,
+                "%s:%s found in the cache", checksum_type, source_checksum);
         }
-        plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_EXIT, "");
-    }
-
-    if (user_checksum[0] && source_checksum[0]) {
-        if (gfal_compare_checksums(user_checksum, source_checksum, 1024) != 0) {
-            gfalt_set_error(error, local_copy_domain(), EIO, __func__,
-                    GFALT_ERROR_SOURCE, GFALT_ERROR_CHECKSUM_MISMATCH,
-                    "Source checksum and user-specified checksum do not match: %s != %s", source_checksum, user_checksum);
-            return -1;
+        else {
+            source_stream = gfal_checksum_stream_new(checksum_type);
         }
     }
 
-    if (!is_strict_mode) {
-        // Parent directory
-        create_parent(context, params, dst, &nested_error);
-        if (nested_error != NULL) {
-            gfal2_propagate_prefixed_error(error, nested_error, __func__);
+    if ((checksum_mode & GFALT_CHECKSUM_SOURCE) && source_stream == NULL && source_cached <= 0) {
+        if (gfalt_copy_checksum(context, params, local_copy_domain(), src, GFAL_EVENT_SOURCE,
+                checksum_type, source_checksum, sizeof(source_checksum), error) < 0) {
             return -1;
         }
+    }
 
-        // Remove if exists and overwrite is set
-        if (!is_strict_mode) {
-            unlink_if_exists(context, params, dst, &nested_error);
-            if (nested_error != NULL) {
-                gfal2_propagate_prefixed_error(error, nested_error, __func__);
-                return -1;
-            }
-        }
+    if (gfalt_copy_verify_source(local_copy_domain(), user_checksum, source_checksum, error) < 0 ||
+        gfalt_copy_prepare_destination(context, params, local_copy_domain(), dst, error) < 0) {
+        gfal_checksum_stream_free(source_stream);
+        return -1;
     }
 
     // Do the transfer
-    streamed_copy(context, params, src, dst, &nested_error);
+    if (source_stream) {
+        plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_ENTER,
+                "%s computed during the transfer", checksum_type);
+    }
+    streamed_copy(context, params, src, dst, source_stream, &nested_error);
     if (nested_error != NULL) {
+        gfal_checksum_stream_free(source_stream);
         gfal2_propagate_prefixed_error(error, nested_error, __func__);
         return -1;
     }
 
-    // Destination checksum
-    char *compare_against = user_checksum;
-    char *compare_side = "User defined";
-    if (user_checksum[0] == '\0') {
-        compare_against = source_checksum;
-        compare_side = "Source";
+    if (source_stream) {
+        gfal_checksum_stream_final(source_stream, source_checksum, sizeof(source_checksum));
+        gfal_checksum_stream_free(source_stream);
+        if (source_cached == 0)
+            gfal_checksum_cache_put(context, src, checksum_type, &source_stat, source_checksum);
+        plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_EXIT,
+                "%s:%s", checksum_type, source_checksum);
     }
 
-    if (checksum_mode & GFALT_CHECKSUM_TARGET) {
-        char destination_checksum[1024];
-
-        plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_DESTINATION, GFAL_EVENT_CHECKSUM_ENTER, "");
-
-        gfal2_checksum(context, dst, checksum_type, 0, 0, destination_checksum, sizeof(destination_checksum), &nested_error);
-        if (nested_error != NULL) {
-            gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not get the destination checksum: ");
-            return -1;
-        }
-        plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_DESTINATION, GFAL_EVENT_CHECKSUM_EXIT, "");
-
-        if (gfal_compare_checksums(compare_against, destination_checksum, 1204) != 0) {
-            gfalt_set_error(error, local_copy_domain(), EIO, __func__,
-                GFALT_ERROR_DESTINATION, GFALT_ERROR_CHECKSUM_MISMATCH,
-                "%s checksum and destination checksum do not match: %s != %s",
-                compare_side, compare_against, destination_checksum);
-            return -1;
-        }
+    // Destination checksum
+    if ((checksum_mode & GFALT_CHECKSUM_TARGET) &&
+        gfalt_copy_verify_destination(context, params, local_copy_domain(), dst, checksum_type,
+            user_checksum, source_checksum, error) < 0) {
+        return -1;
     }
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::start_local_copy");
@@ -72,6 +72,62 @@ void gfalt_propagate_prefixed_error(GError **dest, GError *src, const gchar *fun
 void gfalt_set_error(GError **err, GQuark domain, gint code, const gchar *function,
         const char *side, const gchar *note, const gchar *format, ...) G_GNUC_PRINTF (7, 8);
 
+/**
+ * Progress of a transfer, for the performance markers sent by the copy implementations
+ */
+typedef struct _gfalt_perf_data {
+    time_t start, last_update, now;
+    size_t done, done_since_last_update;
+} gfalt_perf_data_t;
+
+/**
+ * Call the monitor callbacks with the throughput since the start, and since the last update
+ */
+int plugin_trigger_performance(gfalt_params_t params, const char* src, const char* dst,
+        const gfalt_perf_data_t* perf);
+
+/**
+ * To be called between two chunks of a copy
+ * Fails if the transfer was canceled or timeout (absolute) passed, and sends
+ * the performance markers every 5 seconds
+ */
+int gfalt_check_transfer_state(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* src, const char* dst, gfalt_perf_data_t* perf, time_t timeout, GError** err);
+
+/**
+ * Checksum type and user checksum of the transfer, as given by gfalt_get_checksum
+ * The checksum is not verified in strict mode, and the type defaults to ADLER32
+ */
+gfalt_checksum_mode_t gfalt_copy_get_checksum_mode(gfalt_params_t params,
+        char* type_buff, size_t type_size, char* user_buff, size_t user_size);
+
+/**
+ * Get the checksum of url, triggering the checksum events of side around it
+ */
+int gfalt_copy_checksum(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* url, gfal_event_side_t side, const char* checksum_type,
+        char* buffer, size_t s_buff, GError** err);
+
+/**
+ * Fails with a checksum mismatch if both checksums are given and they differ
+ */
+int gfalt_copy_verify_source(GQuark domain, const char* user_checksum, const char* source_checksum,
+        GError** err);
+
+/**
+ * Get the checksum of dst and compare it with user_checksum if given, with source_checksum otherwise
+ */
+int gfalt_copy_verify_destination(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* dst, const char* checksum_type, const char* user_checksum, const char* source_checksum,
+        GError** err);
+
+/**
+ * Unless in strict mode, create the parent directory of dst if the parameters ask for it,
+ * and remove dst if it exists and can be replaced. Special files are kept
+ */
+int gfalt_copy_prepare_destination(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* dst, GError** err);
+
 #define GFALT_ERROR_SOURCE      "SOURCE"
 #define GFALT_ERROR_DESTINATION "DESTINATION"
 #define GFALT_ERROR_TRANSFER    "TRANSFER"
@@ -18,12 +18,16 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 #include <time.h>
 
+#include <gfal_api.h>
 #include <transfer/gfal_transfer_internal.h>
 #include <common/gfal_error.h>
+#include <checksums/checksums.h>
 
 
 
@@ -78,6 +82,12 @@ static void plugin_trigger_event_callback(gpointer data, gpointer user_data)
 int plugin_trigger_event(gfalt_params_t params, GQuark domain, gfal_event_side_t side,
         GQuark stage, const char* fmt, ...)
 {
+    const gboolean log_event = gfal2_log_is_enabled(GFAL_EVENT_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE);
+    // nobody to tell
+    if (params->event_callbacks == NULL && !log_event) {
+        return 0;
+    }
+
     char buffer[512] = { 0 };
     va_list msg_args;
     va_start(msg_args, fmt);
@@ -111,8 +121,10 @@ int plugin_trigger_event(gfalt_params_t params, GQuark domain, gfal_event_side_t
             side_str = "BOTH";
     }
 
-    gfal2_log(G_LOG_LEVEL_MESSAGE, "Event triggered: %s %s %s %s", side_str,
+    if (log_event) {
+        gfal2_log_domain(GFAL_EVENT_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, "Event triggered: %s %s %s %s", side_str,
             g_quark_to_string(domain), g_quark_to_string(stage), buffer);
+    }
     return 0;
 }
 
@@ -172,3 +184,225 @@ void gfalt_set_error(GError **err, GQuark domain, gint code, const gchar *functi
     else
         gfal2_set_error(err, domain, code, function, "%s %s", side, buffer);
 }
+
+
+int plugin_trigger_performance(gfalt_params_t params, const char* src, const char* dst,
+        const gfalt_perf_data_t* perf)
+{
+    struct _gfalt_transfer_status status;
+
+    time_t total_time = perf->now - perf->start;
+    time_t inc_time = perf->now - perf->last_update;
+
+    memset(&status, 0, sizeof(status));
+    status.average_baudrate = (total_time > 0) ? (size_t)(perf->done / total_time) : 0;
+    status.bytes_transfered = (size_t)(perf->done);
+    status.instant_baudrate = (inc_time > 0) ? (size_t)(perf->done_since_last_update / inc_time) : 0;
+    status.transfer_time    = total_time;
+
+    return plugin_trigger_monitor(params, &status, src, dst);
+}
+
+
+int gfalt_check_transfer_state(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* src, const char* dst, gfalt_perf_data_t* perf, time_t timeout, GError** err)
+{
+    if (gfal2_is_canceled(context)) {
+        g_set_error(err, domain, ECANCELED, "Transfer canceled");
+        return -1;
+    }
+
+    perf->now = time(NULL);
+    if (perf->now >= timeout) {
+        g_set_error(err, domain, ETIMEDOUT, "Transfer canceled because the timeout expired");
+        return -1;
+    }
+    else if (perf->now - perf->last_update > 5) {
+        plugin_trigger_performance(params, src, dst, perf);
+        perf->done_since_last_update = 0;
+        perf->last_update = perf->now;
+    }
+    return 0;
+}
+
+
+gfalt_checksum_mode_t gfalt_copy_get_checksum_mode(gfalt_params_t params,
+        char* type_buff, size_t type_size, char* user_buff, size_t user_size)
+{
+    gfalt_checksum_mode_t checksum_mode = GFALT_CHECKSUM_NONE;
+
+    type_buff[0] = user_buff[0] = '\0';
+    if (!gfalt_get_strict_copy_mode(params, NULL)) {
+        checksum_mode = gfalt_get_checksum(params, type_buff, type_size, user_buff, user_size, NULL);
+    }
+    if (type_buff[0] == '\0') {
+        g_strlcpy(type_buff, "ADLER32", type_size);
+    }
+    return checksum_mode;
+}
+
+
+int gfalt_copy_checksum(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* url, gfal_event_side_t side, const char* checksum_type,
+        char* buffer, size_t s_buff, GError** err)
+{
+    GError* nested_error = NULL;
+
+    plugin_trigger_event(params, domain, side, GFAL_EVENT_CHECKSUM_ENTER, "");
+    gfal2_checksum(context, url, checksum_type, 0, 0, buffer, s_buff, &nested_error);
+    if (nested_error != NULL) {
+        gfalt_propagate_prefixed_error(err, nested_error, __func__,
+                (side == GFAL_EVENT_SOURCE) ? GFALT_ERROR_SOURCE : GFALT_ERROR_DESTINATION,
+                GFALT_ERROR_CHECKSUM);
+        return -1;
+    }
+    plugin_trigger_event(params, domain, side, GFAL_EVENT_CHECKSUM_EXIT, "");
+    return 0;
+}
+
+
+int gfalt_copy_verify_source(GQuark domain, const char* user_checksum, const char* source_checksum,
+        GError** err)
+{
+    if (user_checksum[0] && source_checksum[0] &&
+        gfal_compare_checksums(user_checksum, source_checksum, 1024) != 0) {
+        gfalt_set_error(err, domain, EIO, __func__,
+                GFALT_ERROR_SOURCE, GFALT_ERROR_CHECKSUM_MISMATCH,
+                "Source checksum and user-specified checksum do not match: %s != %s",
+                source_checksum, user_checksum);
+        return -1;
+    }
+    return 0;
+}
+
+
+int gfalt_copy_verify_destination(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* dst, const char* checksum_type, const char* user_checksum, const char* source_checksum,
+        GError** err)
+{
+    char destination_checksum[1024] = {0};
+    const char* compare_against = user_checksum;
+    const char* compare_side = "User defined";
+    if (user_checksum[0] == '\0') {
+        compare_against = source_checksum;
+        compare_side = "Source";
+    }
+
+    if (gfalt_copy_checksum(context, params, domain, dst, GFAL_EVENT_DESTINATION, checksum_type,
+            destination_checksum, sizeof(destination_checksum), err) < 0) {
+        return -1;
+    }
+    if (gfal_compare_checksums(compare_against, destination_checksum, sizeof(destination_checksum)) != 0) {
+        gfalt_set_error(err, domain, EIO, __func__,
+                GFALT_ERROR_DESTINATION, GFALT_ERROR_CHECKSUM_MISMATCH,
+                "%s checksum and destination checksum do not match: %s != %s",
+                compare_side, compare_against, destination_checksum);
+        return -1;
+    }
+    return 0;
+}
+
+
+static char* get_parent(const char* url)
+{
+    char *parent = g_strdup(url);
+    char *slash = strrchr(parent, '/');
+    if (slash) {
+        *slash = '\0';
+    }
+    else {
+        g_free(parent);
+        parent = NULL;
+    }
+    return parent;
+}
+
+
+static int create_parent(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* surl, GError** error)
+{
+    if (!gfalt_get_create_parent_dir(params, NULL))
+        return 0;
+
+    char *parent = get_parent(surl);
+    if (!parent) {
+        gfalt_set_error(error, domain, EINVAL, __func__,
+                GFALT_ERROR_DESTINATION, GFALT_ERROR_PARENT, "Could not get the parent directory of %s", surl);
+        return -1;
+    }
+
+    GError* nested_error = NULL;
+    struct stat st;
+    if (gfal2_stat(context, parent, &st, &nested_error) == 0) {
+        g_free(parent);
+        return 0;
+    }
+    if (nested_error->code != ENOENT) {
+        g_free(parent);
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+    g_clear_error(&nested_error);
+
+    gfal2_mkdir_rec(context, parent, 0755, &nested_error);
+    g_free(parent);
+    if (nested_error != NULL) {
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+static int unlink_if_exists(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* surl, GError** error)
+{
+    GError* nested_error = NULL;
+    struct stat st;
+    if (gfal2_stat(context, surl, &st, &nested_error) != 0) {
+        if (nested_error->code == ENOENT) {
+            g_error_free(nested_error);
+            return 0;
+        }
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+
+    if (S_ISFIFO(st.st_mode) || S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode) || S_ISSOCK(st.st_mode)) {
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "%s is a special file (%o), so keep going", surl, S_IFMT & st.st_mode);
+        return 0;
+    }
+
+    if (!gfalt_get_replace_existing_file(params, NULL)) {
+        gfalt_set_error(error, domain, EEXIST, __func__,
+                GFALT_ERROR_DESTINATION, GFALT_ERROR_EXISTS, "The file exists and overwrite is not set");
+        return -1;
+    }
+
+    gfal2_unlink(context, surl, &nested_error);
+    if (nested_error != NULL) {
+        if (nested_error->code != ENOENT) {
+            gfal2_propagate_prefixed_error(error, nested_error, __func__);
+            return -1;
+        }
+        g_error_free(nested_error);
+    }
+    else {
+        plugin_trigger_event(params, domain,
+                GFAL_EVENT_DESTINATION, GFAL_EVENT_OVERWRITE_DESTINATION,
+                "Deleted %s", surl);
+    }
+    return 0;
+}
+
+
+int gfalt_copy_prepare_destination(gfal2_context_t context, gfalt_params_t params, GQuark domain,
+        const char* dst, GError** err)
+{
+    if (gfalt_get_strict_copy_mode(params, NULL))
+        return 0;
+    if (create_parent(context, params, domain, dst, err) < 0 ||
+        unlink_if_exists(context, params, domain, dst, err) < 0)
+        return -1;
+    return 0;
+}
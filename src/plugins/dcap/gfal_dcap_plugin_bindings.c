@@ -112,6 +112,37 @@ ssize_t gfal_dcap_preadG(plugin_handle handle, gfal_file_handle fd, void* buff,
     return ret;
 }
 
+/*
+ * map to the libdcap vectored read call
+ */
+ssize_t gfal_dcap_preadvG(plugin_handle handle, gfal_file_handle fd, const struct iovec* iov,
+        const off_t* offsets, int iovcnt, GError** err)
+{
+    gfal_plugin_dcap_handle h = (gfal_plugin_dcap_handle) handle;
+    ssize_t total = 0;
+    int i;
+
+    if (iovcnt <= 0)
+        return 0;
+
+    iovec2* vector = g_new(iovec2, iovcnt);
+    for (i = 0; i < iovcnt; ++i) {
+        vector[i].offset = offsets[i];
+        vector[i].len = iov[i].iov_len;
+        vector[i].buf = iov[i].iov_base;
+        total += iov[i].iov_len;
+    }
+    // dc_readv2 fills all the ranges, or fails
+    int ret = h->ops->readv2(GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fd)), vector, iovcnt);
+    g_free(vector);
+    if (ret < 0) {
+        dcap_report_error(h, __func__, err);
+        return -1;
+    }
+    errno = 0;
+    return total;
+}
+
 /*
  * map to the libdcap pwrite call
  */
@@ -30,6 +30,8 @@ ssize_t gfal_dcap_readG(plugin_handle handle , gfal_file_handle fd, void* buff,
 
 ssize_t gfal_dcap_preadG(plugin_handle handle , gfal_file_handle fd, void* buff, size_t s_buff, off_t offset,  GError** err);
 
+ssize_t gfal_dcap_preadvG(plugin_handle handle, gfal_file_handle fd, const struct iovec* iov, const off_t* offsets, int iovcnt, GError** err);
+
 ssize_t gfal_dcap_pwriteG(plugin_handle handle , gfal_file_handle fd, const void* buff, size_t s_buff, off_t offset,  GError** err);
 
 off_t gfal_dcap_lseekG(plugin_handle handle , gfal_file_handle fd, off_t offset, int whence, GError** err);
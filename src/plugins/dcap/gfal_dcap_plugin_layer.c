@@ -55,6 +55,7 @@ struct dcap_proto_ops * gfal_dcap_internal_loader_base(GError** err)
     pops->opendir = &dc_opendir;
     pops->read = &dc_read;
     pops->pread = &dc_pread;
+    pops->readv2 = &dc_readv2;
     pops->readdir = (readdir_t) &dc_readdir;
     pops->rename = NULL;
     pops->rmdir = &dc_rmdir;
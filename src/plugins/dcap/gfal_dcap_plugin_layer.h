@@ -47,6 +47,7 @@ struct dcap_proto_ops {
 
 	ssize_t (*pread)(int fildes, void *buf, size_t nbytes, off_t offset);
 	ssize_t (*pwrite)(int fildes, const void *buf, size_t nbytes, off_t offset);
+	int (*readv2)(int fildes, iovec2 *vector, int count);
 	struct dirent	*(*readdir)(DIR *);
 	int	(*rename)(const char *, const char *);
 	int	(*rmdir)(const char *);
@@ -80,6 +80,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     dcap_plugin.closeG = &gfal_dcap_closeG;
     dcap_plugin.readG = &gfal_dcap_readG;
     dcap_plugin.preadG = &gfal_dcap_preadG;
+    dcap_plugin.preadvG = &gfal_dcap_preadvG;
     dcap_plugin.writeG = &gfal_dcap_writeG;
     dcap_plugin.pwriteG = &gfal_dcap_pwriteG;
     dcap_plugin.lseekG = &gfal_dcap_lseekG;
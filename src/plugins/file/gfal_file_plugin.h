@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_FILE_PLUGIN_H_
+#define GFAL_FILE_PLUGIN_H_
+
+#include <gfal_plugins_api.h>
+
+static const int FILE_PREFIX_LEN = 7; // file://
+
+GQuark gfal2_get_plugin_file_quark();
+
+// Local to local copy, done by the kernel when possible
+int gfal_plugin_file_copy(plugin_handle plugin_data, gfal2_context_t context,
+        gfalt_params_t params, const char* src, const char* dst, GError** err);
+
+// Checksum of a local file, computed by several threads when it is large
+int gfal_plugin_filechecksum_calc(plugin_handle data, const char *url, const char *check_type,
+        char *checksum_buffer, size_t buffer_length,
+        off_t start_offset, size_t data_length, GError **err);
+
+#endif /* GFAL_FILE_PLUGIN_H_ */
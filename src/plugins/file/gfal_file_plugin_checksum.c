@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <gfal_plugins_api.h>
+#include <checksums/checksums.h>
+
+#include "gfal_file_plugin.h"
+
+// Size of the reads
+static const size_t CHECKSUM_READ_SIZE = 2 << 20;
+
+static const int DEFAULT_CHECKSUM_THREADS = 4;
+static const gint64 DEFAULT_CHECKSUM_CHUNK_SIZE = 64 << 20;
+
+
+// Checksums that can be computed by parts, and the parts combined
+typedef enum {
+    FILE_CHK_ADLER32,
+    FILE_CHK_CRC32,
+    FILE_CHK_CRC32C,
+    FILE_CHK_NOT_COMBINABLE
+} file_chk_type_t;
+
+
+typedef void (*file_chk_update_t)(void *state, const char *data, size_t size);
+
+
+typedef struct {
+    file_chk_type_t type;
+    unsigned long value;
+} file_chk_part_t;
+
+
+typedef struct {
+    const char *path;
+    file_chk_type_t type;
+    off_t start;
+    off_t length;
+    off_t chunk_size;
+    size_t nchunks;
+    file_chk_part_t *parts;
+
+    pthread_mutex_t lock;
+    size_t next_chunk;
+    // errno of the first failure
+    int error;
+} file_chk_parallel_t;
+
+
+static file_chk_type_t file_chk_get_type(const char *check_type)
+{
+    if (strcasecmp(check_type, "adler32") == 0)
+        return FILE_CHK_ADLER32;
+    else if (strcasecmp(check_type, "crc32") == 0)
+        return FILE_CHK_CRC32;
+    else if (strcasecmp(check_type, "crc32c") == 0)
+        return FILE_CHK_CRC32C;
+    return FILE_CHK_NOT_COMBINABLE;
+}
+
+
+static void file_chk_part_init(file_chk_part_t *part, file_chk_type_t type)
+{
+    part->type = type;
+    part->value = (type == FILE_CHK_ADLER32) ? 1 : 0;
+}
+
+
+static void file_chk_part_update(void *state, const char *data, size_t size)
+{
+    file_chk_part_t *part = (file_chk_part_t*)state;
+    switch (part->type) {
+        case FILE_CHK_ADLER32:
+            part->value = gfal_adler32(part->value, data, size);
+            break;
+        case FILE_CHK_CRC32:
+            part->value = crc32(part->value, (const Bytef*)data, (uInt)size);
+            break;
+        case FILE_CHK_CRC32C:
+            part->value = gfal_crc32c(part->value, data, size);
+            break;
+        default:
+            break;
+    }
+}
+
+
+static void file_chk_stream_update(void *state, const char *data, size_t size)
+{
+    gfal_checksum_stream_update((gfal_checksum_stream_t)state, data, size);
+}
+
+
+// Read [offset, offset + length) with pread, and give the data to update
+// A negative length reads up to the end of the file
+// Returns 0, or the errno of the failure
+static int file_chk_read_range(int fd, off_t offset, off_t length, char *buffer,
+    file_chk_update_t update, void *state)
+{
+    while (length != 0) {
+        size_t count = (length < 0 || length > (off_t)CHECKSUM_READ_SIZE) ? CHECKSUM_READ_SIZE : (size_t)length;
+        ssize_t ret = pread(fd, buffer, count, offset);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        if (ret == 0) {
+            // shorter than expected, truncated while reading
+            return (length < 0) ? 0 : EIO;
+        }
+        // ask for the next read while this one is hashed
+        posix_fadvise(fd, offset + ret, CHECKSUM_READ_SIZE, POSIX_FADV_WILLNEED);
+        update(state, buffer, ret);
+        offset += ret;
+        if (length > 0)
+            length -= ret;
+    }
+    return 0;
+}
+
+
+static void *file_chk_parallel_worker(void *data)
+{
+    file_chk_parallel_t *chk = (file_chk_parallel_t*)data;
+    char *buffer = NULL;
+    int error = 0;
+
+    // each worker has its own descriptor, so its own sequential readahead
+    int fd = open(chk->path, O_RDONLY);
+    if (fd < 0) {
+        error = errno;
+    }
+    else {
+        buffer = malloc(CHECKSUM_READ_SIZE);
+        if (buffer == NULL)
+            error = ENOMEM;
+    }
+
+    pthread_mutex_lock(&chk->lock);
+    if (error != 0 && chk->error == 0)
+        chk->error = error;
+    while (chk->error == 0 && chk->next_chunk < chk->nchunks) {
+        size_t chunk = chk->next_chunk++;
+        pthread_mutex_unlock(&chk->lock);
+
+        off_t offset = chk->start + chunk * chk->chunk_size;
+        off_t length = MIN(chk->chunk_size, chk->start + chk->length - offset);
+        posix_fadvise(fd, offset, length, POSIX_FADV_SEQUENTIAL);
+        file_chk_part_init(&chk->parts[chunk], chk->type);
+        error = file_chk_read_range(fd, offset, length, buffer,
+            file_chk_part_update, &chk->parts[chunk]);
+
+        pthread_mutex_lock(&chk->lock);
+        if (error != 0 && chk->error == 0)
+            chk->error = error;
+    }
+    pthread_mutex_unlock(&chk->lock);
+
+    free(buffer);
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+
+// Split the range in chunks hashed by several threads, and combine the results
+static int file_chk_parallel(const char *path, file_chk_type_t type, off_t start, off_t length,
+    off_t chunk_size, int nthreads, unsigned long *value)
+{
+    file_chk_parallel_t chk;
+    size_t i;
+    int started = 0;
+
+    memset(&chk, 0, sizeof(chk));
+    chk.path = path;
+    chk.type = type;
+    chk.start = start;
+    chk.length = length;
+    chk.chunk_size = chunk_size;
+    chk.nchunks = (length + chunk_size - 1) / chunk_size;
+    chk.parts = g_new0(file_chk_part_t, chk.nchunks);
+    pthread_mutex_init(&chk.lock, NULL);
+
+    if ((size_t)nthreads > chk.nchunks)
+        nthreads = chk.nchunks;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Checksum of %lld bytes in %zu chunks with %d threads",
+        (long long)length, chk.nchunks, nthreads);
+
+    // the calling thread is one of the workers
+    pthread_t *threads = g_new0(pthread_t, nthreads);
+    for (i = 1; i < (size_t)nthreads; ++i) {
+        if (pthread_create(&threads[started], NULL, file_chk_parallel_worker, &chk) != 0)
+            break;
+        ++started;
+    }
+    file_chk_parallel_worker(&chk);
+    for (i = 0; i < (size_t)started; ++i)
+        pthread_join(threads[i], NULL);
+    g_free(threads);
+
+    if (chk.error == 0) {
+        *value = chk.parts[0].value;
+        for (i = 1; i < chk.nchunks; ++i) {
+            off_t part_length = MIN(chunk_size, length - (off_t)i * chunk_size);
+            switch (type) {
+                case FILE_CHK_ADLER32:
+                    *value = adler32_combine64(*value, chk.parts[i].value, part_length);
+                    break;
+                case FILE_CHK_CRC32:
+                    *value = crc32_combine64(*value, chk.parts[i].value, part_length);
+                    break;
+                case FILE_CHK_CRC32C:
+                    *value = gfal_crc32c_combine(*value, chk.parts[i].value, part_length);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    pthread_mutex_destroy(&chk.lock);
+    g_free(chk.parts);
+    errno = chk.error;
+    return chk.error ? -1 : 0;
+}
+
+
+// Same formats as the checksum streams
+static int file_chk_format(file_chk_type_t type, unsigned long value, char *buffer, size_t s_buffer)
+{
+    int ret;
+    if (type == FILE_CHK_CRC32)
+        ret = snprintf(buffer, s_buffer, "%lu", value);
+    else
+        ret = snprintf(buffer, s_buffer, "%08lx", value);
+    return (ret >= (int)s_buffer) ? -1 : 0;
+}
+
+
+int gfal_plugin_filechecksum_calc(plugin_handle data, const char *url, const char *check_type,
+    char *checksum_buffer, size_t buffer_length,
+    off_t start_offset, size_t data_length,
+    GError **err)
+{
+    gfal2_context_t context = (gfal2_context_t) data;
+    const char *path = url + FILE_PREFIX_LEN;
+    struct stat st;
+    int ret = 0;
+
+    // adler32, crc32, crc32c, md5, sha1 and sha256
+    gfal_checksum_stream_t stream = gfal_checksum_stream_new(check_type);
+    if (stream == NULL) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
+            "Checksum type %s not supported for local files", check_type);
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+            "Error during checksum calculation, open: %s", strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        gfal_checksum_stream_free(stream);
+        return -1;
+    }
+
+    // data_length of 0 means up to the end
+    off_t length = 0;
+    if (!S_ISREG(st.st_mode)) {
+        length = (data_length > 0) ? (off_t)data_length : -1;
+    }
+    else if (start_offset < st.st_size) {
+        length = st.st_size - start_offset;
+        if (data_length > 0 && (off_t)data_length < length)
+            length = data_length;
+    }
+
+    const file_chk_type_t type = file_chk_get_type(check_type);
+    const int nthreads = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN",
+        "CHECKSUM_THREADS", DEFAULT_CHECKSUM_THREADS);
+    off_t chunk_size = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN",
+        "CHECKSUM_CHUNK_SIZE", DEFAULT_CHECKSUM_CHUNK_SIZE);
+    if (chunk_size < (off_t)CHECKSUM_READ_SIZE)
+        chunk_size = CHECKSUM_READ_SIZE;
+
+    if (type != FILE_CHK_NOT_COMBINABLE && nthreads > 1 && S_ISREG(st.st_mode) && length > chunk_size) {
+        unsigned long value = 0;
+        close(fd);
+        gfal_checksum_stream_free(stream);
+        if (file_chk_parallel(path, type, start_offset, length, chunk_size, nthreads, &value) < 0) {
+            gfal2_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+                "Error during checksum calculation, read: %s", strerror(errno));
+            return -1;
+        }
+        ret = file_chk_format(type, value, checksum_buffer, buffer_length);
+    }
+    else {
+        // md5 and sha can not be split, read sequentially
+        int error = ENOMEM;
+        char *buffer = malloc(CHECKSUM_READ_SIZE);
+        if (buffer != NULL) {
+            posix_fadvise(fd, start_offset, (length > 0) ? length : 0, POSIX_FADV_SEQUENTIAL);
+            error = file_chk_read_range(fd, start_offset, length, buffer, file_chk_stream_update, stream);
+            free(buffer);
+        }
+        close(fd);
+        if (error != 0) {
+            gfal_checksum_stream_free(stream);
+            gfal2_set_error(err, gfal2_get_plugin_file_quark(), error, __func__,
+                "Error during checksum calculation, read: %s", strerror(error));
+            return -1;
+        }
+        ret = gfal_checksum_stream_final(stream, checksum_buffer, buffer_length);
+        gfal_checksum_stream_free(stream);
+    }
+
+    if (ret < 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOBUFS, __func__, "buffer for checksum too short");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#endif
+
+#include "gfal_file_plugin.h"
+
+#if defined __linux__ && defined __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2,27)
+#define HAVE_COPY_FILE_RANGE
+#endif
+#endif
+
+#define FILE_COPY_CHUNK_SIZE_DEFAULT (4 * 1024 * 1024)
+
+// From the cheapest to the most expensive
+typedef enum {
+    FILE_COPY_CLONE,
+    FILE_COPY_RANGE,
+    FILE_COPY_SENDFILE,
+    FILE_COPY_READ_WRITE
+} file_copy_method;
+
+static const char* const file_copy_method_names[] = {
+    "reflink", "copy_file_range", "sendfile", "read/write"
+};
+
+typedef struct {
+    gfal2_context_t context;
+    gfalt_params_t params;
+    const char* src;
+    const char* dst;
+    int src_fd, dst_fd;
+    file_copy_method method;
+    size_t chunk_size;
+    // only allocated by the read/write fallback
+    char* buffer;
+
+    gfalt_perf_data_t perf;
+    time_t timeout;
+} file_copy_t;
+
+
+// Errors meaning the method is not available for these two files, so the next one must be tried
+static gboolean file_copy_unsupported(int errcode)
+{
+    return errcode == ENOSYS || errcode == EOPNOTSUPP || errcode == ENOTTY ||
+           errcode == EXDEV || errcode == EINVAL || errcode == EPERM;
+}
+
+
+// Clone the whole file in one go, if the filesystem shares extents (btrfs, xfs, ...)
+static gboolean file_copy_clone(file_copy_t* copy, off_t size)
+{
+#ifdef FICLONE
+    if (ioctl(copy->dst_fd, FICLONE, copy->src_fd) == 0) {
+        copy->perf.done = copy->perf.done_since_last_update = size;
+        return TRUE;
+    }
+    gfal2_log(G_LOG_LEVEL_DEBUG, "reflink not possible: %s", strerror(errno));
+#endif
+    return FALSE;
+}
+
+
+static ssize_t file_copy_read_write(file_copy_t* copy)
+{
+    if (copy->buffer == NULL) {
+        copy->buffer = malloc(copy->chunk_size);
+        if (copy->buffer == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+
+    ssize_t s_read = read(copy->src_fd, copy->buffer, copy->chunk_size);
+    ssize_t written = 0;
+    while (written < s_read) {
+        ssize_t res = write(copy->dst_fd, copy->buffer + written, s_read - written);
+        if (res < 0)
+            return -1;
+        written += res;
+    }
+    return s_read;
+}
+
+
+// Copy the next chunk, going to the next method when the current one is not supported
+// Returns the number of bytes copied, 0 at the end of the source, or -1 with errno set
+static ssize_t file_copy_chunk(file_copy_t* copy)
+{
+    ssize_t res = -1;
+
+    while (TRUE) {
+        switch (copy->method) {
+            case FILE_COPY_RANGE:
+#ifdef HAVE_COPY_FILE_RANGE
+                res = copy_file_range(copy->src_fd, NULL, copy->dst_fd, NULL, copy->chunk_size, 0);
+                break;
+#else
+                errno = ENOSYS;
+                res = -1;
+                break;
+#endif
+            case FILE_COPY_SENDFILE:
+#ifdef __linux__
+                res = sendfile(copy->dst_fd, copy->src_fd, NULL, copy->chunk_size);
+                break;
+#else
+                errno = ENOSYS;
+                res = -1;
+                break;
+#endif
+            default:
+                return file_copy_read_write(copy);
+        }
+
+        if (res >= 0 || !file_copy_unsupported(errno))
+            return res;
+
+        // both calls use and update the file offsets, so the next method continues from there
+        gfal2_log(G_LOG_LEVEL_DEBUG, "%s not possible: %s",
+                file_copy_method_names[copy->method], strerror(errno));
+        copy->method += 1;
+        gfal2_log(G_LOG_LEVEL_DEBUG, "fallback to %s", file_copy_method_names[copy->method]);
+    }
+}
+
+
+static int file_copy_data(file_copy_t* copy, GError** error)
+{
+    GError* nested_error = NULL;
+    struct stat st;
+
+    if (fstat(copy->src_fd, &st) < 0) {
+        gfalt_set_error(error, gfal2_get_plugin_file_quark(), errno, __func__,
+                GFALT_ERROR_SOURCE, NULL, "Could not stat the source: %s", strerror(errno));
+        return -1;
+    }
+
+    // Files in /proc and alike say they are empty, so only trust the size of regular files with data
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        copy->method = FILE_COPY_CLONE;
+        if (file_copy_clone(copy, st.st_size)) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "%s cloned into %s", copy->src, copy->dst);
+            return 0;
+        }
+        copy->method = FILE_COPY_RANGE;
+    }
+    else {
+        copy->method = FILE_COPY_READ_WRITE;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s -> %s with %s and chunk size %zu",
+            copy->src, copy->dst, file_copy_method_names[copy->method], copy->chunk_size);
+
+    ssize_t res = 1;
+    while (res > 0 && !nested_error) {
+        res = file_copy_chunk(copy);
+        if (res < 0) {
+            gfalt_set_error(&nested_error, gfal2_get_plugin_file_quark(), errno, __func__,
+                    GFALT_ERROR_TRANSFER, NULL, "%s failed: %s",
+                    file_copy_method_names[copy->method], strerror(errno));
+            break;
+        }
+
+        copy->perf.done += res;
+        copy->perf.done_since_last_update += res;
+
+        gfalt_check_transfer_state(copy->context, copy->params, gfal2_get_plugin_file_quark(),
+                copy->src, copy->dst, &copy->perf, copy->timeout, &nested_error);
+    }
+
+    if (nested_error) {
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+static int file_copy(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, GError** error)
+{
+    GError *nested_error = NULL;
+    file_copy_t copy;
+
+    memset(&copy, 0, sizeof(copy));
+    copy.context = context;
+    copy.params = params;
+    copy.src = src;
+    copy.dst = dst;
+    copy.chunk_size = gfal2_get_opt_integer_with_default(context, "CORE", "COPY_BUFFERSIZE",
+            FILE_COPY_CHUNK_SIZE_DEFAULT);
+    if ((ssize_t)copy.chunk_size <= 0)
+        copy.chunk_size = FILE_COPY_CHUNK_SIZE_DEFAULT;
+
+    plugin_trigger_event(params, gfal2_get_plugin_file_quark(),
+            GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_ENTER,
+            "%s => %s", src, dst);
+    plugin_trigger_event(params, gfal2_get_plugin_file_quark(),
+            GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_TYPE,
+            "%s", GFAL_TRANSFER_TYPE_STREAMED);
+
+    copy.src_fd = open(src + FILE_PREFIX_LEN, O_RDONLY);
+    if (copy.src_fd < 0) {
+        gfalt_set_error(error, gfal2_get_plugin_file_quark(), errno, __func__,
+                GFALT_ERROR_SOURCE, NULL, "Could not open source: %s", strerror(errno));
+        return -1;
+    }
+
+    copy.dst_fd = open(dst + FILE_PREFIX_LEN, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (copy.dst_fd < 0) {
+        gfalt_set_error(error, gfal2_get_plugin_file_quark(), errno, __func__,
+                GFALT_ERROR_DESTINATION, NULL, "Could not open destination: %s", strerror(errno));
+        close(copy.src_fd);
+        return -1;
+    }
+
+    copy.perf.start = copy.perf.now = copy.perf.last_update = time(NULL);
+    copy.timeout = copy.perf.start + gfalt_get_timeout(params, NULL);
+
+    file_copy_data(&copy, &nested_error);
+    free(copy.buffer);
+
+    if (close(copy.dst_fd) < 0 && nested_error == NULL) {
+        gfalt_set_error(&nested_error, gfal2_get_plugin_file_quark(), errno, __func__,
+                GFALT_ERROR_DESTINATION, NULL, "Could not close destination: %s", strerror(errno));
+    }
+    close(copy.src_fd);
+
+    if (nested_error) {
+        gfal2_propagate_prefixed_error(error, nested_error, __func__);
+        return -1;
+    }
+
+    plugin_trigger_event(params, gfal2_get_plugin_file_quark(), GFAL_EVENT_NONE,
+            GFAL_EVENT_TRANSFER_EXIT, "%s => %s", src, dst);
+    return 0;
+}
+
+
+int gfal_plugin_file_copy(plugin_handle plugin_data, gfal2_context_t context,
+        gfalt_params_t params, const char* src, const char* dst, GError** err)
+{
+    GError* nested_error = NULL;
+
+    char checksum_type[1024] = {0};
+    char user_checksum[1024] = {0};
+    char source_checksum[1024] = {0};
+    gfalt_checksum_mode_t checksum_mode = gfalt_copy_get_checksum_mode(params,
+        checksum_type, sizeof(checksum_type), user_checksum, sizeof(user_checksum));
+
+    if (checksum_mode & GFALT_CHECKSUM_SOURCE) {
+        if (gfalt_copy_checksum(context, params, gfal2_get_plugin_file_quark(), src, GFAL_EVENT_SOURCE,
+                checksum_type, source_checksum, sizeof(source_checksum), err) < 0 ||
+            gfalt_copy_verify_source(gfal2_get_plugin_file_quark(), user_checksum, source_checksum, err) < 0) {
+            return -1;
+        }
+    }
+
+    if (gfalt_copy_prepare_destination(context, params, gfal2_get_plugin_file_quark(), dst, err) < 0) {
+        return -1;
+    }
+
+    if (file_copy(context, params, src, dst, &nested_error) < 0) {
+        gfal2_propagate_prefixed_error(err, nested_error, __func__);
+        return -1;
+    }
+
+    if ((checksum_mode & GFALT_CHECKSUM_TARGET) &&
+        gfalt_copy_verify_destination(context, params, gfal2_get_plugin_file_quark(), dst, checksum_type,
+            user_checksum, source_checksum, err) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
@@ -35,25 +35,13 @@
 #include <attr/xattr.h>
 #endif
 #endif
-#include <zlib.h>
 
 #include <gfal_plugins_api.h>
 #include <checksums/checksums.h>
 #include <uri/gfal2_uri.h>
 #include <future/glib.h>
 
-typedef struct _chksum_interface{
-    // init checksum handle
-    void*  (*init)(void);
-    // compute checksum chunk
-    ssize_t (*update)(void* chk_handler, const char* buffer, size_t s_size);
-    // return checksum result : > 0 -> success, -1 : buffer to short
-    int (*getResult)(void* chk_handler, char* buffer, size_t s_b);
-} Chksum_interface;
-
-
-static const int FILE_PREFIX_LEN = 7; // file://
-
+#include "gfal_file_plugin.h"
 
 // File plugin GQuark
 GQuark gfal2_get_plugin_file_quark(){
@@ -71,18 +59,14 @@ const char* gfal_file_plugin_getName(){
  * Return 1 if url is a file url
  */
 static int gfal_is_file(const char *url) {
-    GError *err = NULL;
-    gfal2_uri *parsed = gfal2_parse_uri(url, &err);
-    if (!parsed) {
-        g_error_free(err);
+    gfal2_uri_view parsed;
+    if (gfal2_parse_uri_view(url, &parsed, NULL) < 0) {
         return 0;
     }
     // Check if host is at least defined (even if empty), so only file:// is accepted!
-    int check = parsed->scheme != NULL && strcmp(parsed->scheme, "file") == 0 \
-        && parsed->host != NULL && strcmp(parsed->host, "") == 0 \
-        && parsed->path != NULL && parsed->path[0] == '/';
-    gfal2_free_uri(parsed);
-    return check;
+    return gfal2_uri_view_equal(&parsed, &parsed.scheme, "file") \
+        && gfal2_uri_view_equal(&parsed, &parsed.host, "") \
+        && parsed.path.length > 0 && url[parsed.path.offset] == '/';
 }
 
 /*
@@ -113,6 +97,17 @@ static gboolean gfal_file_check_url(plugin_handle handle, const char* url, plugi
 	}
 }
 
+/*
+ * file to file copies are done by the plugin, the rest is streamed by the core
+ */
+static int gfal_file_check_url_transfer(plugin_handle handle, gfal2_context_t context,
+        const char* src, const char* dst, gfal_url2_check check)
+{
+    if (src == NULL || dst == NULL)
+        return FALSE;
+    return check == GFAL_FILE_COPY && gfal_is_file(src) && gfal_is_file(dst);
+}
+
 
 void gfal_plugin_file_report_error(const char* funcname, GError** err){
     gfal2_set_error(err, gfal2_get_plugin_file_quark(), errno,
@@ -393,172 +388,7 @@ int gfal_plugin_file_symlink(plugin_handle plugin_data, const char *oldpath, con
 }
 
 
-// checksum wrapper
-
-static void *adler_init()
-{
-    unsigned long *lp = malloc(sizeof(unsigned long));
-    *lp = adler32(0L, Z_NULL, 0);
-    return (void *) lp;
-}
-
-static ssize_t adler32_update(void *chk_handler, const char *buffer, size_t s)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    *lp = adler32(*lp, (const Bytef *) buffer, (uInt) s);
-    return (ssize_t) s;
-}
-
-static int adler32_getResult(void *chk_handler, char *resu, size_t s_b)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    snprintf(resu, s_b, "%08lx", *lp);
-    free(lp);
-    return 0;
-}
-
-static void *crc32_init()
-{
-    unsigned long *lp = malloc(sizeof(unsigned long));
-    *lp = crc32(0L, Z_NULL, 0);
-    return (void *) lp;
-}
-
-static ssize_t crc32_update(void *chk_handler, const char *buffer, size_t s)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    *lp = crc32(*lp, (const Bytef *) buffer, s);
-    return (ssize_t) s;
-}
-
-static int crc32_getResult(void *chk_handler, char *resu, size_t s_b)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    snprintf(resu, s_b, "%ld", *lp);
-    free(lp);
-    return 0;
-}
-
-
-static void *md5_init()
-{
-    GFAL_MD5_CTX *ctx = (GFAL_MD5_CTX *) malloc(sizeof(GFAL_MD5_CTX));
-    gfal2_md5_init(ctx);
-    return (void *) ctx;
-}
-
-static ssize_t md5_update(void *chk_handler, const char *buffer, size_t s)
-{
-    GFAL_MD5_CTX *ctx = (GFAL_MD5_CTX *) chk_handler;
-    gfal2_md5_update(ctx, buffer, (unsigned long) s);
-    return (ssize_t) s;
-}
-
-static int md5_getResult(void *chk_handler, char *resu, size_t s_b)
-{
-    GFAL_MD5_CTX *ctx = (GFAL_MD5_CTX *) chk_handler;
-    unsigned char buffer[16];
-    if (s_b < 33) // buffer to short
-        return -1;
-    gfal2_md5_final(buffer, ctx);
-    gfal2_md5_to_hex_string(buffer, resu, sizeof(buffer));
-    free(ctx);
-    return 0;
-}
-
-
-// checksum implem
-
-static int gfal_plugin_file_chk_compute(plugin_handle data, const char *url, const char *check_type,
-    char *checksum_buffer, size_t buffer_length,
-    off_t start_offset, size_t data_length,
-    Chksum_interface *i_chk,
-    GError **err)
-{
-    GError *tmp_err = NULL;
-    const ssize_t chunk_size = 2 << 20;
-    gfal2_context_t handle = (gfal2_context_t) data;
-    int fd;
-    ssize_t ret = 0, remain_bytes = ((data_length > 0) ? (data_length) : (chunk_size));
-
-    if ((fd = gfal2_open(handle, url, O_RDONLY, &tmp_err)) < 0) {
-        g_prefix_error(err, "Error during checksum calculation, open ");
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-        return -1;
-    }
-
-    if (gfal2_lseek(handle, fd, start_offset, SEEK_SET, &tmp_err) < 0) {
-        g_prefix_error(err, "Error during checksum calculation, lseek ");
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-        return -1;
-    }
-
-    void *c_handle = i_chk->init();
-    char *buffer = malloc(chunk_size);
-    do {
-        ret = gfal2_read(handle, fd, buffer, MIN(chunk_size, remain_bytes),  &tmp_err);
-        if (data_length > 0) {
-            remain_bytes -= ret;
-        }
-        if (ret > 0) {
-            i_chk->update(c_handle, buffer, ret);
-        }
-    } while (ret > 0 && remain_bytes > 0);
-    free(buffer);
-    gfal2_close(handle, fd, NULL);
-
-    if (i_chk->getResult(c_handle, checksum_buffer, buffer_length) < 0) {
-        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOBUFS, __func__, "buffer for checksum too short");
-        return -1;
-    }
-
-
-    if (ret < 0) {
-        gfal2_set_error(err, gfal2_get_plugin_file_quark(), tmp_err->code, __func__,
-            "Error during checksum calculation, read: %s", tmp_err->message);
-        g_error_free(tmp_err);
-        return -1;
-    }
-    return 0;
-}
-
-
-int gfal_plugin_filechecksum_calc(plugin_handle data, const char *url, const char *check_type,
-    char *checksum_buffer, size_t buffer_length,
-    off_t start_offset, size_t data_length,
-    GError **err)
-{
-    if (strcasecmp(check_type, "adler32") == 0) {
-        Chksum_interface ie = {.init = &adler_init,
-            .update = &adler32_update,
-            .getResult = &adler32_getResult};
-
-        return gfal_plugin_file_chk_compute(data, url, check_type, checksum_buffer,
-            buffer_length, start_offset, data_length,
-            &ie,
-            err);
-    } else if (strcasecmp(check_type, "crc32") == 0) {
-        Chksum_interface ie = {.init = &crc32_init,
-            .update = &crc32_update,
-            .getResult = &crc32_getResult};
-        return gfal_plugin_file_chk_compute(data, url, check_type, checksum_buffer,
-            buffer_length, start_offset, data_length,
-            &ie,
-            err);
-    } else if (strcasecmp(check_type, "md5") == 0) {
-        Chksum_interface ie = {.init = &md5_init,
-            .update = &md5_update,
-            .getResult = &md5_getResult};
-        return gfal_plugin_file_chk_compute(data, url, check_type, checksum_buffer,
-            buffer_length, start_offset, data_length,
-            &ie,
-            err);
-    }
-    gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
-        "Checksum type %s not supported for local files", check_type);
-    return -1;
-}
-
+static const char* const gfal_file_schemes[] = {"file", NULL};
 
 /*
  * Init function, called before all
@@ -571,6 +401,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.plugin_data = handle;
     file_plugin.check_plugin_url = &gfal_file_check_url;
     file_plugin.getName = &gfal_file_plugin_getName;
+    file_plugin.schemes = gfal_file_schemes;
     file_plugin.plugin_delete = NULL;
     file_plugin.accessG = &gfal_plugin_file_access;
     file_plugin.mkdirpG = &gfal_plugin_file_mkdir;
@@ -599,5 +430,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.setxattrG = &gfal_plugin_file_setxattr;
     file_plugin.checksum_calcG = &gfal_plugin_filechecksum_calc;
 
+    file_plugin.check_plugin_url_transfer = &gfal_file_check_url_transfer;
+    file_plugin.copy_file = &gfal_plugin_file_copy;
+
     return file_plugin;
 }
@@ -423,8 +423,9 @@ int gridftp_bulk_check_sources(plugin_handle plugin_data, gfal2_context_t contex
                                      GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_ENTER,
                                      "%s", pairs->srcs[i]);
 
-                ret = gfal_gridftp_checksumG(plugin_data, pairs->srcs[i], chk_type,
-                        chk_value, sizeof(chk_value), 0, 0, &(file_errors[i]));
+                // through the core, so the checksum cache is used
+                ret = gfal2_checksum(context, pairs->srcs[i], chk_type,
+                        0, 0, chk_value, sizeof(chk_value), &(file_errors[i]));
                 if (ret == 0) {
                     if (!pairs->checksums[i].empty()) {
                         if (gfal_compare_checksums(pairs->checksums[i].c_str(), chk_value, sizeof(chk_value)) != 0) {
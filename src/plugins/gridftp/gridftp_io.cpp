@@ -115,7 +115,7 @@ ssize_t gridftp_rw_internal_pread(GridFTPFactory * factory,
         GridFTPFileDesc* desc, void* buffer, size_t s_buff, off_t offset)
 {
     // throw Gfal::CoreException
-    gfal2_log(G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::internal_pread]");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::internal_pread]");
 
     GridFTPSessionHandler handler(factory, desc->url);
     GridFTPRequestState request_state(&handler);
@@ -131,7 +131,7 @@ ssize_t gridftp_rw_internal_pread(GridFTPFactory * factory,
     ssize_t r_size = gridftp_read_stream(GFAL_GRIDFTP_SCOPE_INTERNAL_PREAD, &stream_state, buffer, s_buff, true);
 
     request_state.wait(GFAL_GRIDFTP_SCOPE_INTERNAL_PREAD);
-    gfal2_log(G_LOG_LEVEL_DEBUG, "[GridFTPModule::internal_pread] <-");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, "[GridFTPModule::internal_pread] <-");
     return r_size;
 
 }
@@ -140,7 +140,7 @@ ssize_t gridftp_rw_internal_pread(GridFTPFactory * factory,
 ssize_t gridftp_rw_internal_pwrite(GridFTPFactory * factory,
         GridFTPFileDesc* desc, const void* buffer, size_t s_buff, off_t offset)
 { // throw Gfal::CoreException
-    gfal2_log(G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::internal_pwrite]");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::internal_pwrite]");
 
     GridFTPSessionHandler handler(factory, desc->url);
     GridFTPRequestState request_state(&handler);
@@ -157,7 +157,7 @@ ssize_t gridftp_rw_internal_pwrite(GridFTPFactory * factory,
             &stream, buffer, s_buff, true); // write block
 
     request_state.wait(GFAL_GRIDFTP_SCOPE_INTERNAL_PWRITE);
-    gfal2_log(G_LOG_LEVEL_DEBUG, "[GridFTPModule::internal_pwrite] <-");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, "[GridFTPModule::internal_pwrite] <-");
     return r_size;
 
 }
@@ -225,11 +225,11 @@ ssize_t GridFTPModule::read(gfal_file_handle handle, void* buffer, size_t count)
     globus_mutex_lock(&desc->mutex);
     try {
         if (desc->is_not_seeked() && is_read_only(desc->open_flags) && desc->stream != NULL) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " read in the GET main flow ... ");
+            GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, " read in the GET main flow ... ");
             ret = gridftp_read_stream(GFAL_GRIDFTP_SCOPE_READ, desc->stream, buffer, count, false);
         }
         else {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " read with a pread ... ");
+            GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, " read with a pread ... ");
             ret = gridftp_rw_internal_pread(_handle_factory, desc, buffer, count, desc->current_offset);
         }
     }
@@ -252,11 +252,11 @@ ssize_t GridFTPModule::write(gfal_file_handle handle, const void* buffer,
     globus_mutex_lock(&desc->mutex);
     try {
         if (desc->is_not_seeked() && is_write_only(desc->open_flags) && desc->stream != NULL) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " write in the PUT main flow ... ");
+            GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, " write in the PUT main flow ... ");
             ret = gridftp_write_stream(GFAL_GRIDFTP_SCOPE_WRITE, desc->stream, buffer, count, false);
         }
         else {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " write with a pwrite ... ");
+            GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, " write with a pwrite ... ");
             ret = gridftp_rw_internal_pwrite(_handle_factory, desc, buffer, count, desc->current_offset);
         }
     }
@@ -399,11 +399,11 @@ extern "C" ssize_t gfal_gridftp_readG(plugin_handle ch, gfal_file_handle fd,
 
     GError * tmp_err = NULL;
     int ret = -1;
-    gfal2_log(G_LOG_LEVEL_DEBUG, "  -> [gfal_gridftp_readG]");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, "  -> [gfal_gridftp_readG]");
     CPP_GERROR_TRY
         ret = (int) ((static_cast<GridFTPModule*>(ch))->read(fd, buff, s_buff));
     CPP_GERROR_CATCH(&tmp_err);
-    gfal2_log(G_LOG_LEVEL_DEBUG, "  [gfal_gridftp_readG]<-");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, "  [gfal_gridftp_readG]<-");
     G_RETURN_ERR(ret, tmp_err, err);
 }
 
@@ -416,11 +416,11 @@ extern "C" ssize_t gfal_gridftp_writeG(plugin_handle ch, gfal_file_handle fd,
 
     GError * tmp_err = NULL;
     int ret = -1;
-    gfal2_log(G_LOG_LEVEL_DEBUG, "  -> [gfal_gridftp_writeG]");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, "  -> [gfal_gridftp_writeG]");
     CPP_GERROR_TRY
         ret = (int) ((static_cast<GridFTPModule*>(ch))->write(fd, buff, s_buff));
     CPP_GERROR_CATCH(&tmp_err);
-    gfal2_log(G_LOG_LEVEL_DEBUG, "  [gfal_gridftp_writeG] <-");
+    GFAL2_LOG_DOMAIN(GRIDFTP_CONFIG_GROUP, G_LOG_LEVEL_DEBUG, "  [gfal_gridftp_writeG] <-");
     G_RETURN_ERR(ret, tmp_err, err);
 }
 
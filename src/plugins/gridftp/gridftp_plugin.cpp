@@ -124,6 +124,8 @@ const char *gridftp_plugin_name()
 }
 
 
+static const char* const gridftp_schemes[] = {"gsiftp", "ftp", NULL};
+
 /**
  * Map function for the gridftp interface
  * this function provide the generic PLUGIN interface for the gridftp plugin.
@@ -139,6 +141,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     ret.check_plugin_url = &gridftp_check_url;
     ret.plugin_delete = &gridftp_plugin_unload;
     ret.getName = &gridftp_plugin_name;
+    ret.schemes = gridftp_schemes;
     ret.accessG = &gfal_gridftp_accessG;
     ret.statG = & gfal_gridftp_statG;
     ret.lstatG = &gfal_gridftp_statG;
@@ -429,12 +429,15 @@ struct HttpStreamProvider {
     time_t start, last_update;
     dav_ssize_t read_instant;
     _gfalt_transfer_status perf;
+    // source checksum, computed from the data sent
+    gfal_checksum_stream_t checksum;
 
     HttpStreamProvider(const char* source, const char* destination,
-            gfal2_context_t context, int source_fd, gfalt_params_t params):
+            gfal2_context_t context, int source_fd, gfalt_params_t params,
+            gfal_checksum_stream_t checksum):
         source(source), destination(destination),
         context(context), params(params), source_fd(source_fd), start(time(NULL)),
-        last_update(start), read_instant(0)
+        last_update(start), read_instant(0), checksum(checksum)
     {
         memset(&perf, 0, sizeof(perf));
     }
@@ -458,11 +461,16 @@ static dav_ssize_t gfal_http_streamed_provider(void *userdata,
 
         if (gfal2_lseek(data->context, data->source_fd, 0, SEEK_SET, &error) < 0)
             ret = -1;
+        else if (data->checksum)
+            gfal_checksum_stream_reset(data->checksum);
     }
     else {
         ret = gfal2_read(data->context, data->source_fd, buffer, buflen, &error);
-        if (ret > 0)
+        if (ret > 0) {
             data->read_instant += ret;
+            if (data->checksum)
+                gfal_checksum_stream_update(data->checksum, buffer, ret);
+        }
 
         if (now - data->last_update >= 5) {
             data->perf.bytes_transfered += data->read_instant;
@@ -489,6 +497,7 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
         GfalHttpPluginData* davix,
         const char* src, const char* dst,
         gfalt_checksum_mode_t checksum_mode, const char *checksum_type, const char *user_checksum,
+        gfal_checksum_stream_t source_checksum,
         gfalt_params_t params,
         GError** err)
 {
@@ -528,7 +537,7 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
 
     Davix::DavFile dest(davix->context,req_params, dst_uri );
 
-    HttpStreamProvider provider(src, dst, context, source_fd, params);
+    HttpStreamProvider provider(src, dst, context, source_fd, params, source_checksum);
 
     try {
     	dest.put(&req_params, std::bind(&gfal_http_streamed_provider,&provider,
@@ -598,8 +607,25 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
             user_checksum, sizeof(user_checksum), NULL);
     }
 
+    set_copy_mode_from_urls(context,src_full, dst_full);
+
+    bool only_streaming = false;
+    // If source is not even http, go straight to streamed
+    // or if third party copy is disabled, go straight to streamed
+    if (!is_http_scheme(src) || !is_http_3rdcopy_enabled(context)) {
+        only_streaming = true;
+    }
+
+    // When the data goes through us anyway, the source checksum is computed from it,
+    // but a user checksum is compared before the destination is touched
+    gfal_checksum_stream_t source_stream = NULL;
+    if ((checksum_mode & GFALT_CHECKSUM_SOURCE) && user_checksum[0] == '\0' && only_streaming && is_http_streamed_enabled(context) &&
+        gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_CHECKSUM_ON_THE_FLY, TRUE)) {
+        source_stream = gfal_checksum_stream_new(checksum_type);
+    }
+
     // Source checksum
-    if (checksum_mode & GFALT_CHECKSUM_SOURCE) {
+    if ((checksum_mode & GFALT_CHECKSUM_SOURCE) && source_stream == NULL) {
         plugin_trigger_event(params, http_plugin_domain, GFAL_EVENT_SOURCE,
                 GFAL_EVENT_CHECKSUM_ENTER, "");
 
@@ -639,6 +665,7 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
     if (!gfalt_get_strict_copy_mode(params, NULL)) {
         if (gfal_http_copy_overwrite(plugin_data, params, dst, &nested_error) != 0 ||
             gfal_http_copy_make_parent(plugin_data, params, context, dst, &nested_error) != 0) {
+            gfal_checksum_stream_free(source_stream);
             gfal2_propagate_prefixed_error(err, nested_error, __func__);
             return -1;
         }
@@ -649,16 +676,15 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
                          "%s => %s", src_full, dst_full);
 
 
-    set_copy_mode_from_urls(context,src_full, dst_full);
     // Initial copy mode
     CopyMode copy_mode = get_default_copy_mode(context);
-    
-    bool only_streaming = false;
-    // If source is not even http, go straight to streamed
-    // or if third party copy is disabled, go straight to streamed
-    if (!is_http_scheme(src) || !is_http_3rdcopy_enabled(context)) {
+    if (only_streaming) {
         copy_mode = HTTP_COPY_STREAM;
-        only_streaming = true;
+    }
+
+    if (source_stream) {
+        plugin_trigger_event(params, http_plugin_domain, GFAL_EVENT_SOURCE,
+                GFAL_EVENT_CHECKSUM_ENTER, "%s computed during the transfer", checksum_type);
     }
 
     // Re-try different approaches
@@ -687,7 +713,7 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
         if (copy_mode == HTTP_COPY_STREAM) {
             if (is_http_streamed_enabled(context)) {
                 ret = gfal_http_streamed_copy(context, davix, src, dst,
-                    checksum_mode, checksum_type, user_checksum,
+                    checksum_mode, checksum_type, user_checksum, source_stream,
                     params, &nested_error);
             }
             else if (only_streaming) {
@@ -728,10 +754,18 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
                          "%s => %s", src, dst);
 
     if (nested_error != NULL) {
+        gfal_checksum_stream_free(source_stream);
         gfalt_propagate_prefixed_error(err, nested_error, __func__, GFALT_ERROR_TRANSFER, "");
         return gfal_http_copy_cleanup(plugin_data, dst, err);
     }
 
+    if (source_stream) {
+        gfal_checksum_stream_final(source_stream, src_checksum, sizeof(src_checksum));
+        gfal_checksum_stream_free(source_stream);
+        plugin_trigger_event(params, http_plugin_domain, GFAL_EVENT_SOURCE,
+                GFAL_EVENT_CHECKSUM_EXIT, "%s:%s", checksum_type, src_checksum);
+    }
+
     // Destination checksum validation
     if (checksum_mode & GFALT_CHECKSUM_TARGET) {
         char dst_checksum[1024];
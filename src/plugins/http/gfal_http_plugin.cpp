@@ -91,9 +91,9 @@ static bool gfal_http_get_token(RequestParams & params,
     }
 
     GError *error = NULL;
-    gchar *token = gfal2_cred_get(handle, GFAL_CRED_BEARER,
-                                  url.getString().c_str(),
-                                  NULL, &error);
+    const char *token = gfal2_cred_lookup(handle, GFAL_CRED_BEARER,
+                                          url.getString().c_str(),
+                                          NULL, &error);
     g_clear_error(&error);  // for now, ignore the error messages.
 
     if (!token) {
@@ -102,9 +102,9 @@ static bool gfal_http_get_token(RequestParams & params,
         // we need at least BEARER set for full source URL and hostname
         // BEARER for destination because that one could be also used
         // to create all missing parent directories)
-        token = gfal2_cred_get(handle, GFAL_CRED_BEARER,
-                               url.getHost().c_str(),
-                               NULL, &error);
+        token = gfal2_cred_lookup(handle, GFAL_CRED_BEARER,
+                                  url.getHost().c_str(),
+                                  NULL, &error);
         g_clear_error(&error);  // for now, ignore the error messages.
     }
 
@@ -126,7 +126,7 @@ static bool gfal_http_get_token(RequestParams & params,
     } else {
         params.addHeader("Authorization", ss.str());
     }
-    g_free(token);
+    gfal2_cred_release(token);
     return true;
 }
 
@@ -140,9 +140,9 @@ static void gfal_http_get_ucert(const Davix::Uri &url, RequestParams & params, g
     // Try user defined first
     std::string url_string = url.getString();
 
-    gchar *ucert_p = gfal2_cred_get(handle, GFAL_CRED_X509_CERT, url_string.c_str(), NULL, &error);
+    const char *ucert_p = gfal2_cred_lookup(handle, GFAL_CRED_X509_CERT, url_string.c_str(), NULL, &error);
     g_clear_error(&error);
-    gchar *ukey_p = gfal2_cred_get(handle, GFAL_CRED_X509_KEY, url_string.c_str(), NULL, &error);
+    const char *ukey_p = gfal2_cred_lookup(handle, GFAL_CRED_X509_KEY, url_string.c_str(), NULL, &error);
     g_clear_error(&error);
 
     if (ucert_p) {
@@ -158,8 +158,8 @@ static void gfal_http_get_ucert(const Davix::Uri &url, RequestParams & params, g
             params.setClientCertX509(cred);
         }
     }
-    g_free(ucert_p);
-    g_free(ukey_p);
+    gfal2_cred_release(ucert_p);
+    gfal2_cred_release(ukey_p);
 }
 
 
@@ -620,6 +620,11 @@ void http2gliberr(GError** err, int http, const char* func, const char* msg)
 }
 
 
+static const char* const gfal_http_schemes[] = {
+    "http", "https", "dav", "davs", "s3", "s3s", "gcloud", "gclouds",
+    "http+3rd", "https+3rd", "dav+3rd", "davs+3rd", NULL
+};
+
 /// Init function
 extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 {
@@ -631,12 +636,14 @@ extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError
     // Bind metadata
     http_plugin.check_plugin_url = &gfal_http_check_url;
     http_plugin.getName = &gfal_http_get_name;
+    http_plugin.schemes = gfal_http_schemes;
     http_plugin.priority = GFAL_PLUGIN_PRIORITY_DATA
     ;
     http_plugin.plugin_data = new GfalHttpPluginData(handle);
     http_plugin.plugin_delete = &gfal_http_delete;
 
     http_plugin.statG = &gfal_http_stat;
+    http_plugin.statG_list = &gfal_http_stat_list;
     http_plugin.accessG = &gfal_http_access;
     http_plugin.mkdirpG = &gfal_http_mkdirpG;
     http_plugin.unlinkG = &gfal_http_unlinkG;
@@ -650,6 +657,7 @@ extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError
     // Bind IO
     http_plugin.openG = &gfal_http_fopen;
     http_plugin.readG = &gfal_http_fread;
+    http_plugin.preadvG = &gfal_http_fpreadv;
     http_plugin.writeG = &gfal_http_fwrite;
     http_plugin.lseekG = &gfal_http_fseek;
     http_plugin.closeG = &gfal_http_fclose;
@@ -25,6 +25,7 @@
 #include <davix.hpp>
 
 #define HTTP_CONFIG_OP_TIMEOUT     "OPERATION_TIMEOUT"
+#define HTTP_CONFIG_STAT_LIST_CONCURRENCY "STAT_LIST_CONCURRENCY"
 
 class GfalHttpPluginData {
 public:
@@ -69,6 +70,9 @@ void gfal_http_delete(plugin_handle plugin_data);
 
 int gfal_http_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err);
 
+int gfal_http_stat_list(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError** errors);
+
 int gfal_http_rename(plugin_handle plugin_data, const char* oldurl, const char* newurl, GError** err);
 
 int gfal_http_access(plugin_handle plugin_data, const char* url, int mode, GError** err);
@@ -92,6 +96,9 @@ gfal_file_handle gfal_http_fopen(plugin_handle plugin_data, const char* url, int
 
 ssize_t gfal_http_fread(plugin_handle, gfal_file_handle fd, void* buff, size_t count, GError** err);
 
+ssize_t gfal_http_fpreadv(plugin_handle, gfal_file_handle fd, const struct iovec* iov, const off_t* offsets,
+        int iovcnt, GError** err);
+
 ssize_t gfal_http_fwrite(plugin_handle, gfal_file_handle fd, const void* buff, size_t count, GError** err);
 
 int gfal_http_fclose(plugin_handle, gfal_file_handle fd, GError ** err);
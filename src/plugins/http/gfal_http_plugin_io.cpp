@@ -21,6 +21,7 @@
 #include <cstring>
 #include <glib.h>
 #include <unistd.h>
+#include <vector>
 #include "gfal_http_plugin.h"
 
 
@@ -79,6 +80,33 @@ ssize_t gfal_http_fread(plugin_handle plugin_data, gfal_file_handle fd, void* bu
 
 
 
+ssize_t gfal_http_fpreadv(plugin_handle plugin_data, gfal_file_handle fd, const struct iovec* iov,
+        const off_t* offsets, int iovcnt, GError** err)
+{
+    GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
+    Davix::DavixError* daverr = NULL;
+    GfalHTTPFD* dfd = (GfalHTTPFD*) gfal_file_handle_get_fdesc(fd);
+
+    // Davix sends a single multi-range request
+    std::vector<Davix::DavIOVecInput> input(iovcnt);
+    std::vector<Davix::DavIOVecOuput> output(iovcnt);
+    for (int i = 0; i < iovcnt; ++i) {
+        input[i].diov_buffer = iov[i].iov_base;
+        input[i].diov_offset = offsets[i];
+        input[i].diov_size = iov[i].iov_len;
+    }
+
+    ssize_t reads = davix->posix.preadVec(dfd->davix_fd, input.data(), output.data(), iovcnt, &daverr);
+    if (reads < 0) {
+        davix2gliberr(daverr, err);
+        Davix::DavixError::clearError(&daverr);
+    }
+
+    return reads;
+}
+
+
+
 ssize_t gfal_http_fwrite(plugin_handle plugin_data, gfal_file_handle fd, const void* buff,
         size_t count, GError** err)
 {
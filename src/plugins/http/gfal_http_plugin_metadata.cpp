@@ -18,10 +18,13 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <cstring>
 #include <cerrno>
 #include <glib.h>
 #include <unistd.h>
+#include <thread>
+#include <vector>
 #include "gfal_http_plugin.h"
 
 
@@ -52,6 +55,38 @@ int gfal_http_stat(plugin_handle plugin_data, const char* url,
 
 
 
+int gfal_http_stat_list(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError** errors)
+{
+    GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
+    int concurrency = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN",
+            HTTP_CONFIG_STAT_LIST_CONCURRENCY, 16);
+    if (concurrency < 1)
+        concurrency = 1;
+    if (concurrency > nbfiles)
+        concurrency = nbfiles;
+
+    // Each worker sends one PROPFIND at a time, picking the next url until there is none left
+    std::atomic<int> next(0), failed(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = next++) < nbfiles) {
+            if (gfal_http_stat(plugin_data, urls[i], &buffs[i], &errors[i]) != 0)
+                ++failed;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < concurrency; ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers)
+        t.join();
+
+    return failed ? -1 : 0;
+}
+
+
 int gfal_http_mkdirpG(plugin_handle plugin_data, const char* url, mode_t mode, gboolean rec_flag, GError** err)
 {
     char stripped_url[GFAL_URL_MAX_LEN];
@@ -276,6 +276,7 @@ int lfc_renameG(plugin_handle handle, const char *oldpath, const char *newpath,
             }
             else {
                 gsimplecache_remove_kstr(ops->cache_stat, source_url_path);
+                gsimplecache_remove_kstr(ops->cache_stat, dest_url_path);
             }
         }
     }
@@ -371,7 +372,7 @@ static int lfc_lstatG(plugin_handle handle, const char *path, struct stat *st, G
         if (!tmp_err) {
             struct lfc_filestat statbuf;
 
-            if ((ret = gsimplecache_take_one_kstr(ops->cache_stat, url_path, st)) ==
+            if ((ret = gsimplecache_get_kstr(ops->cache_stat, url_path, st)) ==
                 0) { // take the version of the buffer
                 gfal2_log(G_LOG_LEVEL_DEBUG, " lfc_lstatG -> value taken from cache");
             }
@@ -825,6 +826,19 @@ int lfc_setxattr_comment(plugin_handle handle, const char *path, const char *nam
     return res;
 }
 
+/*
+ * drop the cached stat of a lfn, i.e. after its replicas change
+ */
+static void lfc_cache_stat_remove(struct lfc_ops *ops, const char *path)
+{
+    char *url_path = NULL, *url_host = NULL;
+    if (url_converter(ops, path, &url_host, &url_path, NULL) == 0) {
+        gsimplecache_remove_kstr(ops->cache_stat, url_path);
+    }
+    g_free(url_path);
+    g_free(url_host);
+}
+
 /*
  * setxattr for replicas
  */
@@ -848,9 +862,11 @@ int lfc_setxattr_replica(plugin_handle handle, const char *path, const char *nam
             gfalt_params_handle_delete(params, err);
             if (*err) { ret = -1; }
         }
+        lfc_cache_stat_remove(ops, path);
         return ret;
     }
     else if (sfn[0] == '-') {
+        lfc_cache_stat_remove(ops, path);
         return gfal_lfc_unregister(handle, path, sfn + 1, err);
     }
     else {
@@ -1022,7 +1038,10 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     ops->lfc_conn_timeout = (char *) g_getenv(LFC_ENV_VAR_CONNTIMEOUT);
     ops->handle = handle;
 
-    ops->cache_stat = gsimplecache_new(5000, &internal_stat_copy, sizeof(struct stat));
+    // the entries are read many times, until they expire or the lfn changes
+    gint ttl = gfal2_get_opt_integer_with_default(handle, "LFC PLUGIN", "STAT_CACHE_TTL", 30);
+    ops->cache_stat = gsimplecache_new_full(5000, 0, (gint64)ttl * 1000, GSIMPLECACHE_ADMIT_FREQUENT,
+        &internal_stat_copy, sizeof(struct stat));
     gfal_lfc_regex_compile(&(ops->rex), err);
     lfc_plugin.plugin_data = (void *) ops;
     lfc_plugin.priority = GFAL_PLUGIN_PRIORITY_CATALOG;
@@ -166,6 +166,8 @@ static void gfal_mock_seppuku_hook()
     free(value);
 }
 
+static const char* const gfal_mock_schemes[] = {"mock", NULL};
+
 /*
  * Init function, called before all
  **/
@@ -186,6 +188,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     mock_plugin.plugin_delete = gfal_plugin_mock_delete;
     mock_plugin.check_plugin_url = &gfal_mock_check_url;
     mock_plugin.getName = &gfal_mock_plugin_getName;
+    mock_plugin.schemes = gfal_mock_schemes;
 
     mock_plugin.statG = &gfal_plugin_mock_stat;
     mock_plugin.lstatG = &gfal_plugin_mock_stat;
@@ -284,17 +284,35 @@ static void gfal_sftp_destroy_handle(gfal_sftp_handle_t *handle, gpointer user_d
 }
 
 
-gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+// Connection details are only needed, and fully parsed, when the cache can not be used
+static gfal_sftp_handle_t *gfal_sftp_connect_new(gfal_sftp_context_t *context, const char *url, GError **err)
 {
     gfal2_uri *parsed = gfal2_parse_uri(url, err);
     if (!parsed) {
         return NULL;
     }
+    gfal_sftp_handle_t *handle = gfal_sftp_new_handle(context, parsed, err);
+    gfal2_free_uri(parsed);
+    return handle;
+}
+
+
+gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+{
+    gfal2_uri_view parsed;
+    if (gfal2_parse_uri_view(url, &parsed, err) < 0) {
+        return NULL;
+    }
+
+    char host[NI_MAXHOST];
+    gfal_sftp_handle_t *handle = NULL;
+    if (gfal2_uri_view_copy(&parsed, &parsed.host, host, sizeof(host)) >= 0) {
+        handle = gfal_sftp_cache_pop(context->cache, host, parsed.port);
+    }
 
-    gfal_sftp_handle_t *handle = gfal_sftp_cache_pop(context->cache, parsed->host, parsed->port);
     if (!handle) {
         gfal2_log(G_LOG_LEVEL_DEBUG, "Creating new SFTP handle");
-        handle = gfal_sftp_new_handle(context, parsed, err);
+        handle = gfal_sftp_connect_new(context, url, err);
     } else {
 #if LIBSSH2_VERSION_NUM >= 0x010205
         int seconds = 10;
@@ -303,15 +321,14 @@ gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *
         if (rc < 0) {
             gfal2_log(G_LOG_LEVEL_DEBUG, "Recycled SFTP handle failed to send keepalive. Discard and reconnect");
             gfal_sftp_destroy_handle(handle, NULL);
-            handle = gfal_sftp_new_handle(context, parsed, err);
+            handle = gfal_sftp_connect_new(context, url, err);
         }
 #endif
     }
     if (handle) {
-        handle->path = g_strdup(parsed->path);
+        handle->path = gfal2_uri_view_dup(&parsed, &parsed.path);
     }
 
-    gfal2_free_uri(parsed);
     return handle;
 }
 
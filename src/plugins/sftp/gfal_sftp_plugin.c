@@ -66,6 +66,8 @@ static void gfal_plugin_sftp_delete(plugin_handle plugin_data)
 }
 
 
+static const char* const gfal_sftp_schemes[] = {"sftp", NULL};
+
 gfal_plugin_interface gfal_plugin_init(gfal2_context_t context, GError **err)
 {
     gfal_plugin_interface sftp_plugin;
@@ -79,6 +81,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t context, GError **err)
     sftp_plugin.plugin_delete = gfal_plugin_sftp_delete;
     sftp_plugin.check_plugin_url = &gfal_sftp_check_url;
     sftp_plugin.getName = &gfal_sftp_plugin_get_name;
+    sftp_plugin.schemes = gfal_sftp_schemes;
 
     sftp_plugin.statG = &gfal_sftp_stat;
     sftp_plugin.lstatG = &gfal_sftp_stat;
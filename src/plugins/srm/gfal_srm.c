@@ -204,12 +204,16 @@ void gfal_srm_opt_initG(gfal_srmv2_opt *opts, gfal2_context_t handle)
     gfal_checker_compile(opts, NULL);
     opts->srm_proto_type = PROTO_SRMv2;
     opts->handle = handle;
-    opts->cache = gsimplecache_new(5000, &srm_internal_copy_stat,
-        sizeof(struct extended_stat));
+    // the entries are read many times, until they expire or the surl changes
+    gint ttl = gfal2_get_opt_integer_with_default(handle, srm_config_group, "STAT_CACHE_TTL", 30);
+    opts->cache = gsimplecache_new_full(5000, 0, (gint64)ttl * 1000, GSIMPLECACHE_ADMIT_FREQUENT,
+        &srm_internal_copy_stat, sizeof(struct extended_stat));
     g_static_rec_mutex_init(&opts->srm_context_mutex);
 }
 
 
+static const char* const gfal_srm_schemes[] = {"srm", NULL};
+
 /*
  * Init function, called before all
  * */
@@ -221,6 +225,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     gfal_srm_opt_initG(opts, handle);
     srm_plugin.plugin_data = (void *) opts;
     srm_plugin.check_plugin_url = &gfal_srm_check_url;
+    srm_plugin.schemes = gfal_srm_schemes;
     srm_plugin.plugin_delete = &gfal_srm_destroyG;
     srm_plugin.accessG = &gfal_srm_accessG;
     srm_plugin.mkdirpG = &gfal_srm_mkdirG;
@@ -230,6 +235,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     srm_plugin.opendirG = &gfal_srm_opendirG;
     srm_plugin.readdirG = &gfal_srm_readdirG;
     srm_plugin.readdirppG = &gfal_srm_readdirppG;
+    // the listings and the stat come from the same srm metadata
+    srm_plugin.capabilities = GFAL_PLUGIN_CAP_READDIRPP_FULL_STAT;
     srm_plugin.closedirG = &gfal_srm_closedirG;
     srm_plugin.getName = &gfal_srm_getName;
     srm_plugin.openG = &gfal_srm_openG;
@@ -254,6 +261,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     srm_plugin.abort_files = &gfal_srm2_abort_filesG;
     srm_plugin.renameG = &gfal_srm_renameG;
     srm_plugin.unlink_listG = &gfal_srm_unlink_listG;
+    srm_plugin.statG_list = &gfal_srm_stat_listG;
     return srm_plugin;
 }
 
@@ -80,6 +80,8 @@ typedef struct _gfal_srmv2_opt{
 	// Used to know if the srm context must be cleaned
 	char x509_ucert[GFAL_URL_MAX_LEN], x509_ukey[GFAL_URL_MAX_LEN];
 	char endpoint[GFAL_URL_MAX_LEN];
+	// Generation of the configuration srm_context was set up with
+	gint config_generation;
 } gfal_srmv2_opt;
 
 
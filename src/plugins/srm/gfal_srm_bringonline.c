@@ -22,6 +22,7 @@
 
 #include "gfal_srm.h"
 #include "gfal_srm_internal_layer.h"
+#include "gfal_srm_internal_ls.h"
 #include "gfal_srm_request.h"
 #include "gfal_srm_url_check.h"
 
@@ -131,6 +132,16 @@ static int gfal_srmv2_bring_online_internal(srm_context_t context, gfal_srmv2_op
 }
 
 
+// The locality of the files being staged or released changes, the cached one is stale
+static void gfal_srmv2_bring_online_invalidate(plugin_handle ch, int nbfiles, const char *const *surls)
+{
+    int i;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_srm_cache_stat_remove(ch, surls[i]);
+    }
+}
+
+
 int gfal_srmv2_bring_onlineG(plugin_handle ch, const char *surl,
     time_t pintime, time_t timeout, char *token, size_t tsize,
     int async, GError **err)
@@ -148,6 +159,7 @@ int gfal_srmv2_bring_onlineG(plugin_handle ch, const char *surl,
             pintime, timeout, token, tsize, async, &tmp_err);
     }
     gfal_srm_ifce_easy_context_release(opts, easy);
+    gfal_srmv2_bring_online_invalidate(ch, 1, &surl);
 
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -182,6 +194,7 @@ int gfal_srmv2_bring_online_listG(plugin_handle ch, int nbfiles, const char *con
     int ret = gfal_srmv2_bring_online_internal(easy->srm_context, opts, nbfiles, (const char *const *) decoded,
         pintime, timeout, token, tsize, async, errors);
     gfal_srm_ifce_easy_context_release(opts, easy);
+    gfal_srmv2_bring_online_invalidate(ch, nbfiles, surls);
 
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
@@ -269,6 +282,7 @@ int gfal_srmv2_bring_online_pollG(plugin_handle ch, const char *surl,
             &tmp_err);
     }
     gfal_srm_ifce_easy_context_release(opts, easy);
+    gfal_srmv2_bring_online_invalidate(ch, 1, &surl);
 
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -303,6 +317,7 @@ int gfal_srmv2_bring_online_poll_listG(plugin_handle ch, int nbfiles,
     int ret = gfal_srmv2_bring_online_poll_internal(easy->srm_context, nbfiles, (const char *const *) decoded,
         token, errors);
     gfal_srm_ifce_easy_context_release(opts, easy);
+    gfal_srmv2_bring_online_invalidate(ch, nbfiles, surls);
 
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
@@ -370,6 +385,7 @@ int gfal_srmv2_release_fileG(plugin_handle ch, const char *surl,
             &tmp_err);
     }
     gfal_srm_ifce_easy_context_release(opts, easy);
+    gfal_srmv2_bring_online_invalidate(ch, 1, &surl);
 
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -404,6 +420,7 @@ int gfal_srmv2_release_file_listG(plugin_handle ch, int nbfiles, const char *con
     int ret = gfal_srmv2_release_file_internal(easy->srm_context, opts, nbfiles, (const char *const *) decoded,
         token, errors);
     gfal_srm_ifce_easy_context_release(opts, easy);
+    gfal_srmv2_bring_online_invalidate(ch, nbfiles, surls);
 
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
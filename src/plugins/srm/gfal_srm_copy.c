@@ -266,9 +266,15 @@ static int srm_validate_source_checksum(plugin_handle handle, gfal2_context_t co
 
     int ret = 0;
 
-    gboolean turl_fallback = (checksum_mode & GFALT_CHECKSUM_SOURCE);
-    ret = gfal_srm_checksumG_fallback(handle, src, checksum_algorithm,
-        checksum_source, checksum_source_size, 0, 0, turl_fallback, &tmp_err);
+    // Through the core when the turl can be used, so the checksum cache is used
+    if (checksum_mode & GFALT_CHECKSUM_SOURCE) {
+        ret = gfal2_checksum(context, src, checksum_algorithm, 0, 0,
+            checksum_source, checksum_source_size, &tmp_err);
+    }
+    else {
+        ret = gfal_srm_checksumG_fallback(handle, src, checksum_algorithm,
+            checksum_source, checksum_source_size, 0, 0, FALSE, &tmp_err);
+    }
 
     if (ret != 0) {
         gfalt_propagate_prefixed_error(err, tmp_err, __func__, GFALT_ERROR_SOURCE, GFALT_ERROR_CHECKSUM);
@@ -37,27 +37,27 @@ static int gfal_srm_guess_service_endpoint(gfal_srmv2_opt *opts, const char *sur
     enum gfal_srm_proto *srm_type, GError **err)
 {
     GError *tmp_err = NULL;
-    gfal2_uri *parsed = gfal2_parse_uri(surl, &tmp_err);
-    if (!parsed) {
+    gfal2_uri_view parsed;
+    if (gfal2_parse_uri_view(surl, &parsed, &tmp_err) < 0) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
         return -1;
     }
 
-    if (parsed->port) {
+    // length is 0 if the host is undefined
+    const char *host = surl + MAX(parsed.host.offset, 0);
+    if (parsed.port) {
         snprintf(buff_endpoint, s_buff,
-            "%s%s:%d%s", GFAL_ENDPOINT_DEFAULT_PREFIX,
-            parsed->host, parsed->port, GFAL_DEFAULT_SERVICE_ENDPOINT_SUFFIX
+            "%s%.*s:%d%s", GFAL_ENDPOINT_DEFAULT_PREFIX,
+            parsed.host.length, host, parsed.port, GFAL_DEFAULT_SERVICE_ENDPOINT_SUFFIX
         );
     }
     else {
         snprintf(buff_endpoint, s_buff,
-            "%s%s%s", GFAL_ENDPOINT_DEFAULT_PREFIX,
-            parsed->host, GFAL_DEFAULT_SERVICE_ENDPOINT_SUFFIX
+            "%s%.*s%s", GFAL_ENDPOINT_DEFAULT_PREFIX,
+            parsed.host.length, host, GFAL_DEFAULT_SERVICE_ENDPOINT_SUFFIX
         );
     }
     *srm_type = opts->srm_proto_type;
-
-    gfal2_free_uri(parsed);
     return 0;
 }
 
@@ -169,17 +169,18 @@ static int gfal_get_endpoint_and_setype_from_bdiiG(gfal_srmv2_opt *opts, const c
     int ret = -1;
     GError *tmp_err = NULL;
 
-    gfal2_uri *parsed = gfal2_parse_uri(surl, &tmp_err);
-    if (parsed != NULL) { // get the hostname
+    gfal2_uri_view parsed;
+    char host[GFAL_URL_MAX_LEN];
+    if (gfal2_parse_uri_view(surl, &parsed, &tmp_err) == 0) { // get the hostname
+        const char *hostname = (gfal2_uri_view_copy(&parsed, &parsed.host, host, sizeof(host)) >= 0) ? host : NULL;
         // questioning the bdii
-        if ((ret = gfal_mds_get_se_types_and_endpoints(opts->handle, parsed->host, &tab_se_type, &tab_endpoint,
+        if ((ret = gfal_mds_get_se_types_and_endpoints(opts->handle, hostname, &tab_se_type, &tab_endpoint,
             &tmp_err)) == 0) {
             ret = gfal_select_best_protocol_and_endpointG(opts, tab_se_type, tab_endpoint, buff_endpoint,
                 GFAL_URL_MAX_LEN, srm_type, &tmp_err); // map the response if correct
             g_strfreev(tab_endpoint);
             g_strfreev(tab_se_type);
         }
-        gfal2_free_uri(parsed);
     }
     G_RETURN_ERR(ret, tmp_err, err);
 }
@@ -27,6 +27,7 @@
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_endpoint.h"
 #include "gfal_srm_getput.h"
+#include "gfal_srm_internal_ls.h"
 
 
 // Make sure the TURL returned by the endpoint is one of the requested protocols
@@ -483,6 +484,8 @@ int gfal_srm_putdone(gfal_srmv2_opt *opts, const char *surl, const char *token,
         ret = gfal_srm_putdone_srmv2_internal(easy->srm_context, easy->path, token, &tmp_err);
     }
     gfal_srm_ifce_easy_context_release(opts, easy);
+    // the file has been written, or removed
+    gfal_srm_cache_stat_remove(opts, surl);
 
     if (ret < 0)
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -139,6 +139,9 @@ static srm_context_t gfal_srm_ifce_context_setup(gfal2_context_t handle,
 
 static int is_same_context(gfal_srmv2_opt *opts, const char *endpoint, const char *ucert, const char *ukey)
 {
+    // timeouts and keep alive are only read when the context is set up
+    if (opts->config_generation != gfal2_get_opt_generation(opts->handle))
+        return 0;
     if (strcmp(opts->endpoint, endpoint) != 0)
         return 0;
     if ((ucert && strcmp(opts->x509_ucert, ucert) != 0) || (!ucert && opts->x509_ucert[0]))
@@ -162,13 +165,14 @@ gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
         return NULL;
     }
 
-    gchar *ucert = gfal2_cred_get(opts->handle, GFAL_CRED_X509_CERT, surl, &baseurl, err);
+    const char *ucert = gfal2_cred_lookup(opts->handle, GFAL_CRED_X509_CERT, surl, &baseurl, err);
     if (*err) {
         return NULL;
     }
 
-    gchar *ukey = gfal2_cred_get(opts->handle, GFAL_CRED_X509_KEY, surl, &baseurl, err);
+    const char *ukey = gfal2_cred_lookup(opts->handle, GFAL_CRED_X509_KEY, surl, &baseurl, err);
     if (*err) {
+        gfal2_cred_release(ucert);
         return NULL;
     }
 
@@ -197,6 +201,7 @@ gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
     if (opts->srm_context == NULL) {
         switch (srm_types) {
             case PROTO_SRMv2:
+                opts->config_generation = gfal2_get_opt_generation(opts->handle);
                 opts->srm_context = gfal_srm_ifce_context_setup(opts->handle, full_endpoint,
                     ucert, ukey,
                     opts->srm_ifce_error_buffer, sizeof(opts->srm_ifce_error_buffer),
@@ -237,8 +242,8 @@ gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
         g_static_rec_mutex_unlock(&opts->srm_context_mutex);
     }
 
-    g_free(ucert);
-    g_free(ukey);
+    gfal2_cred_release(ucert);
+    gfal2_cred_release(ukey);
 
     easy->srm_context = opts->srm_context;
     return easy;
@@ -126,6 +126,47 @@ int gfal_statG_srmv2__generic_internal(srm_context_t context, struct stat *buf,
     G_RETURN_ERR(ret, tmp_err, err);
 }
 
+int gfal_statG_srmv2__list_internal(srm_context_t context, int nbfiles, const char *const *surls,
+    struct stat *buffs, TFileLocality *locs, GError **errors)
+{
+    struct srm_ls_input input;
+    struct srm_ls_output output;
+    int ret = -1, i;
+
+    input.nbfiles = nbfiles;
+    input.surls = (char **) surls;
+    input.numlevels = 0;
+    input.offset = 0;
+    input.count = 0;
+
+    if (gfal_srm_ls_internal(context, &input, &output, &errors[0]) < 0) {
+        for (i = 1; i < nbfiles; ++i)
+            errors[i] = g_error_copy(errors[0]);
+        return -1;
+    }
+
+    ret = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        struct srmv2_mdfilestatus *status = &output.statuses[i];
+        if (status->status != 0) {
+            gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), status->status, __func__,
+                "Error reported from srm_ifce : %d %s",
+                status->status, status->explanation ? status->explanation : "without explanation!");
+            ret = -1;
+        }
+        else {
+            memcpy(&buffs[i], &status->stat, sizeof(struct stat));
+            locs[i] = status->locality;
+            // SRM returns the time in UTC
+            gfal_srm_adjust_time(&buffs[i]);
+        }
+    }
+
+    gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(output.statuses, nbfiles);
+    gfal_srm_external_call.srm_srm2__TReturnStatus_delete(output.retstatus);
+    return ret;
+}
+
 int gfal_srm_cache_stat_add(plugin_handle ch, const char *surl, const struct stat *value, const TFileLocality *loc)
 {
     char buff_key[GFAL_URL_MAX_LEN];
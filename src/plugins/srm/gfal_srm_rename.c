@@ -60,6 +60,7 @@ int gfal_srm_renameG(plugin_handle plugin_data, const char *oldurl,
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, oldurl, &tmp_err);
     if (easy != NULL) {
         gfal_srm_cache_stat_remove(plugin_data, oldurl);
+        gfal_srm_cache_stat_remove(plugin_data, urlnew);
 
         char *decodednew = gfal2_srm_get_decoded_path(urlnew);
         ret = gfal_srm_rename_internal_srmv2(easy->srm_context, easy->path, decodednew, &tmp_err);
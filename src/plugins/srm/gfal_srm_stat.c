@@ -23,6 +23,7 @@
 #include "gfal_srm_namespace.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_endpoint.h"
+#include "gfal_srm_url_check.h"
 
 
 int gfal_statG_srmv2_internal(srm_context_t context, struct stat *buf, TFileLocality *loc, const char *surl,
@@ -47,7 +48,7 @@ int gfal_srm_statG(plugin_handle ch, const char *surl, struct stat *buf, GError
 
     // Try cache first
     gfal_srm_construct_key(surl, GFAL_SRM_LSTAT_PREFIX, key_buff, GFAL_URL_MAX_LEN);
-    if (gsimplecache_take_one_kstr(opts->cache, key_buff, &xstat) == 0) {
+    if (gsimplecache_get_kstr(opts->cache, key_buff, &xstat) == 0) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
             " srm_statG -> value taken from the cache");
         ret = 0;
@@ -75,3 +76,88 @@ int gfal_srm_statG(plugin_handle ch, const char *surl, struct stat *buf, GError
 
     return ret;
 }
+
+/*
+ * bulk stat, the surls not in the cache are sent in a single srm_ls request
+ * to the endpoint of the first one
+ *
+ * */
+int gfal_srm_stat_listG(plugin_handle ch, int nbfiles, const char *const *surls, struct stat *buffs, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int ret = 0, i, j;
+    char key_buff[GFAL_URL_MAX_LEN];
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    struct extended_stat xstat;
+
+    if (!ch || nbfiles <= 0 || surls == NULL || buffs == NULL) {
+        gfal2_set_error(&tmp_err, gfal2_get_plugin_srm_quark(), EINVAL, __func__, "incorrect args");
+        for (i = 0; i < nbfiles; ++i)
+            errors[i] = g_error_copy(tmp_err);
+        g_error_free(tmp_err);
+        return -1;
+    }
+
+    // Try cache first
+    int *missing = g_new(int, nbfiles);
+    int nbmissing = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_srm_construct_key(surls[i], GFAL_SRM_LSTAT_PREFIX, key_buff, GFAL_URL_MAX_LEN);
+        if (gsimplecache_get_kstr(opts->cache, key_buff, &xstat) == 0) {
+            buffs[i] = xstat.stat;
+        }
+        else {
+            missing[nbmissing++] = i;
+        }
+    }
+    gfal2_log(G_LOG_LEVEL_DEBUG, "   [gfal_srm_stat_listG] %d values taken from the cache, %d to stat",
+        nbfiles - nbmissing, nbmissing);
+    if (nbmissing == 0) {
+        g_free(missing);
+        return 0;
+    }
+
+    // Ask server otherwise
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[missing[0]], &tmp_err);
+    if (easy != NULL) {
+        // the number of files is not bounded, so they are not kept on the stack
+        char **decoded = g_new(char*, nbmissing);
+        struct stat *st = g_new(struct stat, nbmissing);
+        TFileLocality *locs = g_new(TFileLocality, nbmissing);
+        GError **errs = g_new(GError*, nbmissing);
+
+        for (j = 0; j < nbmissing; ++j) {
+            decoded[j] = gfal2_srm_get_decoded_path(surls[missing[j]]);
+            errs[j] = NULL;
+        }
+
+        ret = gfal_statG_srmv2__list_internal(easy->srm_context, nbmissing,
+            (const char *const *) decoded, st, locs, errs);
+
+        for (j = 0; j < nbmissing; ++j) {
+            i = missing[j];
+            if (errs[j]) {
+                gfal2_propagate_prefixed_error(&errors[i], errs[j], __func__);
+            }
+            else {
+                buffs[i] = st[j];
+                gfal_srm_cache_stat_add(ch, surls[i], &st[j], &locs[j]);
+            }
+            g_free(decoded[j]);
+        }
+        g_free(decoded);
+        g_free(st);
+        g_free(locs);
+        g_free(errs);
+    }
+    else {
+        for (j = 0; j < nbmissing; ++j)
+            gfal2_propagate_prefixed_error(&errors[missing[j]], g_error_copy(tmp_err), __func__);
+        g_error_free(tmp_err);
+        ret = -1;
+    }
+    gfal_srm_ifce_easy_context_release(opts, easy);
+    g_free(missing);
+
+    return ret;
+}
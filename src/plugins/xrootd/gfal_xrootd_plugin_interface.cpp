@@ -20,8 +20,10 @@
 
 #include <condition_variable>
 #include <iostream>
+#include <map>
 #include <mutex>
 #include <sys/stat.h>
+#include <vector>
 
 // This header provides all the required functions except chmod
 #include <XrdPosix/XrdPosixXrootd.hh>
@@ -33,6 +35,9 @@
 #include <XrdCl/XrdClFileSystem.hh>
 #include <XrdCl/XrdClXRootDResponses.hh>
 
+// For vectored reads
+#include <XrdOuc/XrdOucIOVec.hh>
+
 // For setting the log level
 #include <XrdCl/XrdClDefaultEnv.hh>
  
@@ -115,6 +120,31 @@ ssize_t gfal_xrootd_readG(plugin_handle handle, gfal_file_handle fd, void *buff,
 }
 
 
+ssize_t gfal_xrootd_preadvG(plugin_handle handle, gfal_file_handle fd,
+        const struct iovec* iov, const off_t* offsets, int iovcnt, GError ** err)
+{
+    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
+    if (!fdesc) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
+        return -1;
+    }
+    // Sent as a single kXR_readv request
+    std::vector<XrdOucIOVec> chunks(iovcnt);
+    for (int i = 0; i < iovcnt; ++i) {
+        chunks[i].offset = offsets[i];
+        chunks[i].size = iov[i].iov_len;
+        chunks[i].info = 0;
+        chunks[i].data = (char*) iov[i].iov_base;
+    }
+    ssize_t l = XrdPosixXrootd::VRead(*fdesc, chunks.data(), iovcnt);
+    if (l < 0) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Failed while reading from file");
+        return -1;
+    }
+    return l;
+}
+
+
 ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd,
         const void *buff, size_t count, GError ** err)
 {
@@ -317,6 +347,130 @@ void StatInfo2Xattr(const XrdCl::StatInfo* stinfo,  char * buff)
     }
 }
 
+static void xrootd_statinfo_to_stat(const XrdCl::StatInfo* stinfo, struct stat* st)
+{
+    st->st_size = stinfo->GetSize();
+    st->st_mtime = stinfo->GetModTime();
+    st->st_mode = 0;
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsDir))
+        st->st_mode |= S_IFDIR;
+    else
+        st->st_mode |= S_IFREG;
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsReadable))
+        st->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsWritable))
+        st->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
+    if (stinfo->TestFlags(XrdCl::StatInfo::XBitSet))
+        st->st_mode |= (S_IXUSR | S_IXGRP | S_IXOTH);
+}
+
+
+static void xrootd_status_to_gerror(GError** err, const XrdCl::XRootDStatus& status, const char* func)
+{
+    int errNo = status.errNo;
+    if (status.code == XrdCl::errErrorResponse)
+        errNo = xrootd_errno_to_posix_errno(errNo);
+    gfal2_xrootd_set_error(err, errNo, func, status.ToStr().c_str());
+}
+
+
+// Counts down the stat requests of a bulk stat still in flight
+struct StatListCompletion
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    int remaining;
+    int failed;
+
+    StatListCompletion(int n): remaining(n), failed(0)
+    {
+    }
+
+    void Done(bool ok)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!ok)
+            ++failed;
+        if (--remaining == 0)
+            cv.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return remaining == 0; });
+    }
+};
+
+// Callback class for one file of a bulk stat, deletes itself
+class StatListHandler: public XrdCl::ResponseHandler
+{
+private:
+    StatListCompletion& completion;
+    struct stat* st;
+    GError** err;
+
+public:
+    StatListHandler(StatListCompletion& completion, struct stat* st, GError** err):
+        completion(completion), st(st), err(err)
+    {
+    }
+
+    void HandleResponse(XrdCl::XRootDStatus* status, XrdCl::AnyObject* response)
+    {
+        bool ok = status->IsOK();
+        if (ok) {
+            XrdCl::StatInfo* stinfo = NULL;
+            response->Get<XrdCl::StatInfo*>(stinfo);
+            reset_stat(*st);
+            xrootd_statinfo_to_stat(stinfo, st);
+        }
+        else {
+            xrootd_status_to_gerror(err, *status, "gfal_xrootd_stat_listG");
+        }
+        delete status;
+        delete response;
+        completion.Done(ok);
+        delete this;
+    }
+};
+
+
+int gfal_xrootd_stat_listG(plugin_handle handle, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError** errors)
+{
+    set_xrootd_log_level();
+
+    // All the requests are sent before waiting for any response, one FileSystem per host
+    std::map<std::string, XrdCl::FileSystem*> filesystems;
+    StatListCompletion completion(nbfiles);
+
+    for (int i = 0; i < nbfiles; ++i) {
+        std::string sanitizedUrl = prepare_url((gfal2_context_t) handle, urls[i]);
+        XrdCl::URL xrdcl_url(sanitizedUrl);
+
+        XrdCl::FileSystem*& fs = filesystems[xrdcl_url.GetHostId()];
+        if (fs == NULL)
+            fs = new XrdCl::FileSystem(xrdcl_url);
+
+        StatListHandler* handler = new StatListHandler(completion, &buffs[i], &errors[i]);
+        XrdCl::XRootDStatus status = fs->Stat(xrdcl_url.GetPath(), handler);
+        if (!status.IsOK()) {
+            delete handler;
+            xrootd_status_to_gerror(&errors[i], status, __func__);
+            completion.Done(false);
+        }
+    }
+    completion.Wait();
+
+    std::map<std::string, XrdCl::FileSystem*>::iterator i;
+    for (i = filesystems.begin(); i != filesystems.end(); ++i)
+        delete i->second;
+
+    return completion.failed ? -1 : 0;
+}
+
+
 // Callback class for directory listing
 class DirListHandler: public XrdCl::ResponseHandler
 {
@@ -373,21 +527,6 @@ public:
         cv.notify_all();
     }
 
-    void StatInfo2Stat(const XrdCl::StatInfo* stinfo, struct stat* st)
-    {
-        st->st_size = stinfo->GetSize();
-        st->st_mtime = stinfo->GetModTime();
-        st->st_mode = 0;
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsDir))
-            st->st_mode |= S_IFDIR;
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsReadable))
-            st->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsWritable))
-            st->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
-        if (stinfo->TestFlags(XrdCl::StatInfo::XBitSet))
-            st->st_mode |= (S_IXUSR | S_IXGRP | S_IXOTH);
-    }
-
     struct dirent* Get(struct stat* st = NULL)
     {
         if (!done) {
@@ -416,7 +555,7 @@ public:
 
         if (st != NULL) {
             if (stinfo != NULL) {
-                StatInfo2Stat(stinfo, st);
+                xrootd_statinfo_to_stat(stinfo, st);
             }
             else {
 
@@ -428,7 +567,7 @@ public:
                     errstr = status.ToString();
                     return NULL;
                 }
-                StatInfo2Stat(stinfo, st);
+                xrootd_statinfo_to_stat(stinfo, st);
                 delete stinfo;
             }
         }
@@ -34,10 +34,16 @@ extern "C" {
 
 int gfal_xrootd_statG(plugin_handle handle, const char* name, struct stat* buff, GError ** err);
 
+int gfal_xrootd_stat_listG(plugin_handle handle, int nbfiles, const char* const* urls,
+        struct stat* buffs, GError** errors);
+
 gfal_file_handle gfal_xrootd_openG(plugin_handle handle, const char *path, int flag, mode_t mode, GError ** err);
 
 ssize_t gfal_xrootd_readG(plugin_handle handle, gfal_file_handle fd, void *buff, size_t count, GError ** err);
 
+ssize_t gfal_xrootd_preadvG(plugin_handle handle, gfal_file_handle fd, const struct iovec* iov,
+        const off_t* offsets, int iovcnt, GError ** err);
+
 ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd, const void *buff, size_t count, GError ** err);
 
 off_t gfal_xrootd_lseekG(plugin_handle handle, gfal_file_handle fd, off_t offset, int whence, GError **err);
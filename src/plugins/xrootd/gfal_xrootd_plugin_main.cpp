@@ -29,6 +29,8 @@ extern "C" {
 
 gboolean gfal_xrootd_check_url(plugin_handle ch, const char* url,  plugin_mode mode, GError** err);
 
+static const char* const gfal_xrootd_schemes[] = {"root", "xroot", NULL};
+
 gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 {
     static XrdPosixXrootd singleXroot;
@@ -43,6 +45,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 
     xrootd_plugin.getName = &gfal_xrootd_getName;
     xrootd_plugin.check_plugin_url = &gfal_xrootd_check_url;
+    xrootd_plugin.schemes = gfal_xrootd_schemes;
 
     xrootd_plugin.openG = &gfal_xrootd_openG;
     xrootd_plugin.closeG = &gfal_xrootd_closeG;
@@ -52,9 +55,11 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 
     xrootd_plugin.statG = &gfal_xrootd_statG;
     xrootd_plugin.lstatG = &gfal_xrootd_statG;
+    xrootd_plugin.statG_list = &gfal_xrootd_stat_listG;
 
     xrootd_plugin.preadG = NULL; // &gfal_xrootd_preadG;
     xrootd_plugin.pwriteG = NULL; // &gfal_xrootd_pwriteG;
+    xrootd_plugin.preadvG = &gfal_xrootd_preadvG;
 
     xrootd_plugin.mkdirpG = &gfal_xrootd_mkdirpG;
     xrootd_plugin.chmodG = &gfal_xrootd_chmodG;
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "checksums.h"
+
+// SHA-1 and SHA-256, as described by FIPS 180-4
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+
+static uint32_t load_be32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+
+static void store_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+
+// The message schedule is computed in the rounds, in a window of 16 words.
+// Computed ahead, the compilers vectorize it in a way that stalls on every store.
+
+static void sha1_block(uint32_t state[5], const unsigned char *block)
+{
+    uint32_t w[16];
+    uint32_t a, b, c, d, e, t;
+    int i;
+
+    for (i = 0; i < 16; ++i)
+        w[i] = load_be32(block + i * 4);
+
+#define SHA1_W(i) ((i) < 16 ? w[i] : (w[(i) & 15] = \
+    ROTL32(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ w[((i) + 2) & 15] ^ w[(i) & 15], 1)))
+#define SHA1_ROUND(f, k) \
+    t = ROTL32(a, 5) + (f) + e + (k) + SHA1_W(i); \
+    e = d; d = c; c = ROTL32(b, 30); b = a; a = t;
+
+    a = state[0]; b = state[1]; c = state[2]; d = state[3]; e = state[4];
+    for (i = 0; i < 20; ++i) {
+        SHA1_ROUND((b & c) | (~b & d), 0x5a827999);
+    }
+    for (; i < 40; ++i) {
+        SHA1_ROUND(b ^ c ^ d, 0x6ed9eba1);
+    }
+    for (; i < 60; ++i) {
+        SHA1_ROUND((b & c) | (b & d) | (c & d), 0x8f1bbcdc);
+    }
+    for (; i < 80; ++i) {
+        SHA1_ROUND(b ^ c ^ d, 0xca62c1d6);
+    }
+#undef SHA1_ROUND
+#undef SHA1_W
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+static void sha256_block(uint32_t state[8], const unsigned char *block)
+{
+    uint32_t w[16];
+    uint32_t a, b, c, d, e, f, g, h, t1, t2, wi;
+    int i;
+
+    for (i = 0; i < 16; ++i)
+        w[i] = load_be32(block + i * 4);
+
+    a = state[0]; b = state[1]; c = state[2]; d = state[3];
+    e = state[4]; f = state[5]; g = state[6]; h = state[7];
+    for (i = 0; i < 64; ++i) {
+        if (i < 16) {
+            wi = w[i];
+        }
+        else {
+            uint32_t w15 = w[(i + 1) & 15], w2 = w[(i + 14) & 15];
+            uint32_t s0 = ROTR32(w15, 7) ^ ROTR32(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = ROTR32(w2, 17) ^ ROTR32(w2, 19) ^ (w2 >> 10);
+            wi = w[i & 15] = w[i & 15] + s0 + w[(i + 9) & 15] + s1;
+        }
+        t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + wi;
+        t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+
+// Both hashes buffer the data in blocks of 64 bytes
+static void sha_update(uint32_t *state, void (*block_fn)(uint32_t*, const unsigned char*),
+    unsigned char *buffer, uint64_t *count, const unsigned char *p, size_t size)
+{
+    size_t used = (size_t)(*count & 63);
+    *count += size;
+
+    if (used > 0) {
+        size_t n = 64 - used;
+        if (n > size)
+            n = size;
+        memcpy(buffer + used, p, n);
+        p += n;
+        size -= n;
+        if (used + n < 64)
+            return;
+        block_fn(state, buffer);
+    }
+    while (size >= 64) {
+        block_fn(state, p);
+        p += 64;
+        size -= 64;
+    }
+    if (size > 0)
+        memcpy(buffer, p, size);
+}
+
+
+static void sha_pad(uint32_t *state, void (*block_fn)(uint32_t*, const unsigned char*),
+    unsigned char *buffer, uint64_t count)
+{
+    size_t used = (size_t)(count & 63);
+    uint64_t bits = count * 8;
+    int i;
+
+    buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(buffer + used, 0, 64 - used);
+        block_fn(state, buffer);
+        used = 0;
+    }
+    memset(buffer + used, 0, 56 - used);
+    for (i = 0; i < 8; ++i)
+        buffer[56 + i] = (unsigned char)(bits >> (56 - i * 8));
+    block_fn(state, buffer);
+}
+
+
+void gfal2_sha1_init(GFAL_SHA1_CTX *ctx)
+{
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->state[4] = 0xc3d2e1f0;
+    ctx->count = 0;
+}
+
+
+void gfal2_sha1_update(GFAL_SHA1_CTX *ctx, const void *data, size_t size)
+{
+    sha_update(ctx->state, sha1_block, ctx->buffer, &ctx->count, (const unsigned char*)data, size);
+}
+
+
+void gfal2_sha1_final(unsigned char *result, GFAL_SHA1_CTX *ctx)
+{
+    int i;
+    sha_pad(ctx->state, sha1_block, ctx->buffer, ctx->count);
+    for (i = 0; i < 5; ++i)
+        store_be32(result + i * 4, ctx->state[i]);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+
+void gfal2_sha256_init(GFAL_SHA256_CTX *ctx)
+{
+    ctx->state[0] = 0x6a09e667;
+    ctx->state[1] = 0xbb67ae85;
+    ctx->state[2] = 0x3c6ef372;
+    ctx->state[3] = 0xa54ff53a;
+    ctx->state[4] = 0x510e527f;
+    ctx->state[5] = 0x9b05688c;
+    ctx->state[6] = 0x1f83d9ab;
+    ctx->state[7] = 0x5be0cd19;
+    ctx->count = 0;
+}
+
+
+void gfal2_sha256_update(GFAL_SHA256_CTX *ctx, const void *data, size_t size)
+{
+    sha_update(ctx->state, sha256_block, ctx->buffer, &ctx->count, (const unsigned char*)data, size);
+}
+
+
+void gfal2_sha256_final(unsigned char *result, GFAL_SHA256_CTX *ctx)
+{
+    int i;
+    sha_pad(ctx->state, sha256_block, ctx->buffer, ctx->count);
+    for (i = 0; i < 8; ++i)
+        store_be32(result + i * 4, ctx->state[i]);
+    memset(ctx, 0, sizeof(*ctx));
+}
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include "checksums.h"
+
+// The vector kernels need the intrinsics to be usable from functions
+// with a target attribute, which older compilers do not allow
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ >= 7)
+#define GFAL_CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+// Largest prime smaller than 65536
+#define ADLER_MOD 65521
+// Largest n such that 255n(n+1)/2 + (n+1)(ADLER_MOD-1) <= 2^32-1
+#define ADLER_NMAX 5552
+
+#define CRC32C_POLY 0x82f63b78
+
+
+static uint32_t adler32_scalar(uint32_t adler, const unsigned char *p, size_t size)
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+
+    while (size > 0) {
+        size_t n = (size < ADLER_NMAX) ? size : ADLER_NMAX;
+        size -= n;
+        while (n >= 8) {
+            s1 += p[0]; s2 += s1;
+            s1 += p[1]; s2 += s1;
+            s1 += p[2]; s2 += s1;
+            s1 += p[3]; s2 += s1;
+            s1 += p[4]; s2 += s1;
+            s1 += p[5]; s2 += s1;
+            s1 += p[6]; s2 += s1;
+            s1 += p[7]; s2 += s1;
+            p += 8;
+            n -= 8;
+        }
+        while (n-- > 0) {
+            s1 += *p++;
+            s2 += s1;
+        }
+        s1 %= ADLER_MOD;
+        s2 %= ADLER_MOD;
+    }
+    return s1 | (s2 << 16);
+}
+
+
+// Slicing by 8, tables built once
+static uint32_t crc32c_table[8][256];
+
+
+static void crc32c_table_init(void)
+{
+    uint32_t i, j, crc;
+    for (i = 0; i < 256; ++i) {
+        crc = i;
+        for (j = 0; j < 8; ++j)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        crc32c_table[0][i] = crc;
+    }
+    for (i = 0; i < 256; ++i) {
+        crc = crc32c_table[0][i];
+        for (j = 1; j < 8; ++j) {
+            crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+            crc32c_table[j][i] = crc;
+        }
+    }
+}
+
+
+static uint32_t crc32c_scalar(uint32_t crc, const unsigned char *p, size_t size)
+{
+    crc = ~crc;
+    while (size > 0 && ((uintptr_t)p & 7) != 0) {
+        crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        --size;
+    }
+    while (size >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+              crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+              crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+              crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+
+#ifdef GFAL_CHECKSUM_X86
+
+// The vector adler32 kernels process blocks of bytes, accumulating
+//  - s1: the sum of the bytes, from psadbw
+//  - s2: the sum of each byte weighted by its distance to the end of the block, from pmaddubsw
+//  - ps: s1 before each block, added to s2 times the block size at the end
+// Same as zlib-ng and Chromium
+
+__attribute__((target("sse4.2")))
+static inline uint32_t hsum_sse42(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+
+__attribute__((target("sse4.2")))
+static uint32_t adler32_sse42(uint32_t adler, const unsigned char *p, size_t size)
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+    size_t blocks = size / 32;
+    size -= blocks * 32;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    while (blocks > 0) {
+        size_t n = ADLER_NMAX / 32;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        __m128i v_ps = _mm_setr_epi32(s1 * n, 0, 0, 0);
+        __m128i v_s2 = _mm_setr_epi32(s2, 0, 0, 0);
+        __m128i v_s1 = zero;
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i*)p);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i*)(p + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            p += 32;
+        } while (--n);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        s1 = (s1 + hsum_sse42(v_s1)) % ADLER_MOD;
+        s2 = hsum_sse42(v_s2) % ADLER_MOD;
+    }
+    return adler32_scalar(s1 | (s2 << 16), p, size);
+}
+
+
+__attribute__((target("avx2")))
+static inline uint32_t hsum_avx2(__m256i v)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(sum);
+}
+
+
+__attribute__((target("avx2")))
+static uint32_t adler32_avx2(uint32_t adler, const unsigned char *p, size_t size)
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+    size_t blocks = size / 32;
+    size -= blocks * 32;
+
+    const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+            16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    while (blocks > 0) {
+        size_t n = ADLER_NMAX / 32;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        __m256i v_ps = _mm256_setr_epi32(s1 * n, 0, 0, 0, 0, 0, 0, 0);
+        __m256i v_s2 = _mm256_setr_epi32(s2, 0, 0, 0, 0, 0, 0, 0);
+        __m256i v_s1 = zero;
+        do {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i*)p);
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+            p += 32;
+        } while (--n);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+
+        s1 = (s1 + hsum_avx2(v_s1)) % ADLER_MOD;
+        s2 = hsum_avx2(v_s2) % ADLER_MOD;
+    }
+    return adler32_scalar(s1 | (s2 << 16), p, size);
+}
+
+
+static const unsigned char adler32_tap64[64] __attribute__((aligned(64))) = {
+    64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49,
+    48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33,
+    32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+    16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+};
+
+
+__attribute__((target("avx512f,avx512bw")))
+static uint32_t adler32_avx512(uint32_t adler, const unsigned char *p, size_t size)
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = adler >> 16;
+    size_t blocks = size / 64;
+    size -= blocks * 64;
+
+    const __m512i tap = _mm512_load_si512((const void*)adler32_tap64);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi16(1);
+
+    while (blocks > 0) {
+        size_t n = ADLER_NMAX / 64;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        __m512i v_ps = _mm512_maskz_set1_epi32(1, s1 * n);
+        __m512i v_s2 = _mm512_maskz_set1_epi32(1, s2);
+        __m512i v_s1 = zero;
+        do {
+            const __m512i bytes = _mm512_loadu_si512((const void*)p);
+            v_ps = _mm512_add_epi32(v_ps, v_s1);
+            v_s1 = _mm512_add_epi32(v_s1, _mm512_sad_epu8(bytes, zero));
+            v_s2 = _mm512_add_epi32(v_s2, _mm512_madd_epi16(_mm512_maddubs_epi16(bytes, tap), ones));
+            p += 64;
+        } while (--n);
+        v_s2 = _mm512_add_epi32(v_s2, _mm512_slli_epi32(v_ps, 6));
+
+        s1 = (s1 + (uint32_t)_mm512_reduce_add_epi32(v_s1)) % ADLER_MOD;
+        s2 = (uint32_t)_mm512_reduce_add_epi32(v_s2) % ADLER_MOD;
+    }
+    return adler32_scalar(s1 | (s2 << 16), p, size);
+}
+
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t size)
+{
+    uint64_t crc64;
+    crc = ~crc;
+    while (size > 0 && ((uintptr_t)p & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --size;
+    }
+    crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while (size-- > 0)
+        crc = _mm_crc32_u8(crc, *p++);
+    return ~crc;
+}
+
+#endif /* GFAL_CHECKSUM_X86 */
+
+
+static const gfal_checksum_kernels_t kernels_scalar = {"scalar", adler32_scalar, crc32c_scalar};
+#ifdef GFAL_CHECKSUM_X86
+static const gfal_checksum_kernels_t kernels_sse42 = {"sse4.2", adler32_sse42, crc32c_sse42};
+static const gfal_checksum_kernels_t kernels_avx2 = {"avx2", adler32_avx2, crc32c_sse42};
+static const gfal_checksum_kernels_t kernels_avx512 = {"avx512", adler32_avx512, crc32c_sse42};
+#endif
+
+static const gfal_checksum_kernels_t *kernels_supported[5] = {NULL};
+static const gfal_checksum_kernels_t *kernels_best = &kernels_scalar;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+
+static void gfal_checksum_kernels_init(void)
+{
+    int n = 0;
+    crc32c_table_init();
+    kernels_supported[n++] = &kernels_scalar;
+#ifdef GFAL_CHECKSUM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2"))
+        kernels_supported[n++] = &kernels_sse42;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("avx2"))
+        kernels_supported[n++] = &kernels_avx2;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("avx512bw"))
+        kernels_supported[n++] = &kernels_avx512;
+#endif
+    kernels_best = kernels_supported[n - 1];
+}
+
+
+const gfal_checksum_kernels_t * const *gfal_checksum_kernels_supported(void)
+{
+    pthread_once(&kernels_once, gfal_checksum_kernels_init);
+    return kernels_supported;
+}
+
+
+const gfal_checksum_kernels_t *gfal_checksum_kernels(void)
+{
+    pthread_once(&kernels_once, gfal_checksum_kernels_init);
+    return kernels_best;
+}
+
+
+unsigned long gfal_adler32(unsigned long adler, const void *data, size_t size)
+{
+    return gfal_checksum_kernels()->adler32((uint32_t)adler, (const unsigned char*)data, size);
+}
+
+
+unsigned long gfal_crc32c(unsigned long crc, const void *data, size_t size)
+{
+    return gfal_checksum_kernels()->crc32c((uint32_t)crc, (const unsigned char*)data, size);
+}
+
+
+// Same as zlib crc32_combine, for the Castagnoli polynomial
+
+static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+
+static void gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+    int n;
+    for (n = 0; n < 32; n++)
+        square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+
+unsigned long gfal_crc32c_combine(unsigned long crc1, unsigned long crc2, uint64_t len2)
+{
+    uint32_t even[32], odd[32], row;
+    uint32_t crc = (uint32_t)crc1;
+    int n;
+
+    if (len2 == 0)
+        return crc1;
+
+    // operator for one zero bit
+    odd[0] = CRC32C_POLY;
+    row = 1;
+    for (n = 1; n < 32; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    // two zero bits, then four
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // apply len2 zero bytes to crc1
+    do {
+        gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc = gf2_matrix_times(even, crc);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc = gf2_matrix_times(odd, crc);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc ^ (uint32_t)crc2;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <zlib.h>
+#include "checksums.h"
+
+// When there are several checksums, each one goes through this much data
+// at a time, so it is still in the cache for the next one
+#define GFAL_CHECKSUM_STREAM_SLICE (16 * 1024)
+
+typedef enum {
+    GFAL_CHECKSUM_ADLER32,
+    GFAL_CHECKSUM_CRC32,
+    GFAL_CHECKSUM_CRC32C,
+    GFAL_CHECKSUM_MD5,
+    GFAL_CHECKSUM_SHA1,
+    GFAL_CHECKSUM_SHA256
+} gfal_checksum_type_t;
+
+typedef struct {
+    gfal_checksum_type_t type;
+    // adler32, crc32 and crc32c
+    unsigned long value;
+    union {
+        GFAL_MD5_CTX md5;
+        GFAL_SHA1_CTX sha1;
+        GFAL_SHA256_CTX sha256;
+    } ctx;
+} gfal_checksum_digest_t;
+
+struct gfal_checksum_stream_s {
+    size_t count;
+    gfal_checksum_digest_t digests[];
+};
+
+
+static int gfal_checksum_type_from_name(const char *type, gfal_checksum_type_t *checksum_type)
+{
+    if (type == NULL)
+        return -1;
+    else if (strcasecmp(type, "adler32") == 0)
+        *checksum_type = GFAL_CHECKSUM_ADLER32;
+    else if (strcasecmp(type, "crc32") == 0)
+        *checksum_type = GFAL_CHECKSUM_CRC32;
+    else if (strcasecmp(type, "crc32c") == 0)
+        *checksum_type = GFAL_CHECKSUM_CRC32C;
+    else if (strcasecmp(type, "md5") == 0)
+        *checksum_type = GFAL_CHECKSUM_MD5;
+    else if (strcasecmp(type, "sha1") == 0)
+        *checksum_type = GFAL_CHECKSUM_SHA1;
+    else if (strcasecmp(type, "sha256") == 0)
+        *checksum_type = GFAL_CHECKSUM_SHA256;
+    else
+        return -1;
+    return 0;
+}
+
+
+gfal_checksum_stream_t gfal_checksum_stream_new_multiple(const char * const *types, size_t count)
+{
+    gfal_checksum_stream_t stream;
+    size_t i;
+
+    if (count == 0)
+        return NULL;
+
+    stream = calloc(1, sizeof(struct gfal_checksum_stream_s) + count * sizeof(gfal_checksum_digest_t));
+    if (stream == NULL)
+        return NULL;
+    stream->count = count;
+    for (i = 0; i < count; ++i) {
+        if (gfal_checksum_type_from_name(types[i], &stream->digests[i].type) < 0) {
+            free(stream);
+            return NULL;
+        }
+    }
+    gfal_checksum_stream_reset(stream);
+    return stream;
+}
+
+
+gfal_checksum_stream_t gfal_checksum_stream_new(const char *type)
+{
+    return gfal_checksum_stream_new_multiple(&type, 1);
+}
+
+
+void gfal_checksum_stream_reset(gfal_checksum_stream_t stream)
+{
+    size_t i;
+    for (i = 0; i < stream->count; ++i) {
+        gfal_checksum_digest_t *digest = &stream->digests[i];
+        switch (digest->type) {
+            case GFAL_CHECKSUM_ADLER32:
+                digest->value = 1;
+                break;
+            case GFAL_CHECKSUM_CRC32:
+            case GFAL_CHECKSUM_CRC32C:
+                digest->value = 0;
+                break;
+            case GFAL_CHECKSUM_MD5:
+                gfal2_md5_init(&digest->ctx.md5);
+                break;
+            case GFAL_CHECKSUM_SHA1:
+                gfal2_sha1_init(&digest->ctx.sha1);
+                break;
+            case GFAL_CHECKSUM_SHA256:
+                gfal2_sha256_init(&digest->ctx.sha256);
+                break;
+        }
+    }
+}
+
+
+static void gfal_checksum_digest_update(gfal_checksum_digest_t *digest, const unsigned char *p, size_t size)
+{
+    switch (digest->type) {
+        case GFAL_CHECKSUM_ADLER32:
+            digest->value = gfal_adler32(digest->value, p, size);
+            break;
+        case GFAL_CHECKSUM_CRC32:
+            // zlib takes 32 bits lengths
+            while (size > 0) {
+                uInt n = (size > 0x40000000) ? 0x40000000 : (uInt) size;
+                digest->value = crc32(digest->value, p, n);
+                p += n;
+                size -= n;
+            }
+            break;
+        case GFAL_CHECKSUM_CRC32C:
+            digest->value = gfal_crc32c(digest->value, p, size);
+            break;
+        case GFAL_CHECKSUM_MD5:
+            gfal2_md5_update(&digest->ctx.md5, p, (unsigned long) size);
+            break;
+        case GFAL_CHECKSUM_SHA1:
+            gfal2_sha1_update(&digest->ctx.sha1, p, size);
+            break;
+        case GFAL_CHECKSUM_SHA256:
+            gfal2_sha256_update(&digest->ctx.sha256, p, size);
+            break;
+    }
+}
+
+
+void gfal_checksum_stream_update(gfal_checksum_stream_t stream, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *) data;
+    size_t i;
+
+    if (stream->count == 1) {
+        gfal_checksum_digest_update(&stream->digests[0], p, size);
+        return;
+    }
+
+    while (size > 0) {
+        size_t n = (size > GFAL_CHECKSUM_STREAM_SLICE) ? GFAL_CHECKSUM_STREAM_SLICE : size;
+        for (i = 0; i < stream->count; ++i)
+            gfal_checksum_digest_update(&stream->digests[i], p, n);
+        p += n;
+        size -= n;
+    }
+}
+
+
+static void gfal_checksum_to_hex_string(const unsigned char *bytes, size_t s_bytes, char *hex)
+{
+    static const char hex_str[] = "0123456789abcdef";
+    size_t i;
+    for (i = 0; i < s_bytes; ++i) {
+        *hex++ = hex_str[(bytes[i] >> 4) & 0x0f];
+        *hex++ = hex_str[bytes[i] & 0x0f];
+    }
+    *hex = '\0';
+}
+
+
+int gfal_checksum_stream_final_nth(gfal_checksum_stream_t stream, size_t index, char *buffer, size_t s_buffer)
+{
+    unsigned char digest[32];
+    gfal_checksum_digest_t *d;
+    GFAL_MD5_CTX md5;
+    GFAL_SHA1_CTX sha1;
+    GFAL_SHA256_CTX sha256;
+
+    if (index >= stream->count)
+        return -1;
+    d = &stream->digests[index];
+
+    // final destroys the contexts, so work on copies and the stream can still be updated
+    switch (d->type) {
+        case GFAL_CHECKSUM_ADLER32:
+        case GFAL_CHECKSUM_CRC32C:
+            if (snprintf(buffer, s_buffer, "%08lx", d->value) >= (int) s_buffer)
+                return -1;
+            break;
+        case GFAL_CHECKSUM_CRC32:
+            if (snprintf(buffer, s_buffer, "%lu", d->value) >= (int) s_buffer)
+                return -1;
+            break;
+        case GFAL_CHECKSUM_MD5:
+            if (s_buffer < 33)
+                return -1;
+            md5 = d->ctx.md5;
+            gfal2_md5_final(digest, &md5);
+            gfal_checksum_to_hex_string(digest, 16, buffer);
+            break;
+        case GFAL_CHECKSUM_SHA1:
+            if (s_buffer < 41)
+                return -1;
+            sha1 = d->ctx.sha1;
+            gfal2_sha1_final(digest, &sha1);
+            gfal_checksum_to_hex_string(digest, 20, buffer);
+            break;
+        case GFAL_CHECKSUM_SHA256:
+            if (s_buffer < 65)
+                return -1;
+            sha256 = d->ctx.sha256;
+            gfal2_sha256_final(digest, &sha256);
+            gfal_checksum_to_hex_string(digest, 32, buffer);
+            break;
+    }
+    return 0;
+}
+
+
+int gfal_checksum_stream_final(gfal_checksum_stream_t stream, char *buffer, size_t s_buffer)
+{
+    return gfal_checksum_stream_final_nth(stream, 0, buffer, s_buffer);
+}
+
+
+void gfal_checksum_stream_free(gfal_checksum_stream_t stream)
+{
+    free(stream);
+}
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,6 +55,105 @@ void gfal2_md5_final(unsigned char *result, GFAL_MD5_CTX *ctx);
 
 void gfal2_md5_to_hex_string(const unsigned char *bytes, char *hex, size_t hex_size);
 
+
+// sha1 and sha256 checksum calculation
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t count;
+    unsigned char buffer[64];
+} GFAL_SHA1_CTX;
+
+void gfal2_sha1_init(GFAL_SHA1_CTX *ctx);
+
+void gfal2_sha1_update(GFAL_SHA1_CTX *ctx, const void *data, size_t size);
+
+void gfal2_sha1_final(unsigned char *result, GFAL_SHA1_CTX *ctx);
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t count;
+    unsigned char buffer[64];
+} GFAL_SHA256_CTX;
+
+void gfal2_sha256_init(GFAL_SHA256_CTX *ctx);
+
+void gfal2_sha256_update(GFAL_SHA256_CTX *ctx, const void *data, size_t size);
+
+void gfal2_sha256_final(unsigned char *result, GFAL_SHA256_CTX *ctx);
+
+
+// adler32 and crc32c, with the vector instructions supported by the cpu
+
+typedef struct {
+    const char *name;
+    uint32_t (*adler32)(uint32_t adler, const unsigned char *data, size_t size);
+    uint32_t (*crc32c)(uint32_t crc, const unsigned char *data, size_t size);
+} gfal_checksum_kernels_t;
+
+/**
+ * The implementations this cpu can run, from the slowest to the fastest, NULL terminated
+ */
+const gfal_checksum_kernels_t * const *gfal_checksum_kernels_supported(void);
+
+/**
+ * The fastest implementation this cpu can run
+ */
+const gfal_checksum_kernels_t *gfal_checksum_kernels(void);
+
+/**
+ * Same as zlib adler32, starting from 1
+ */
+unsigned long gfal_adler32(unsigned long adler, const void *data, size_t size);
+
+/**
+ * Castagnoli crc32, starting from 0
+ */
+unsigned long gfal_crc32c(unsigned long crc, const void *data, size_t size);
+
+/**
+ * crc32c of the concatenation of two blocks, given the crc32c of each
+ * and the length of the second one. Same as zlib crc32_combine
+ */
+unsigned long gfal_crc32c_combine(unsigned long crc1, unsigned long crc2, uint64_t len2);
+
+
+// incremental checksum of a stream of data, for the adler32, crc32, crc32c, md5, sha1 and sha256 types
+
+typedef struct gfal_checksum_stream_s* gfal_checksum_stream_t;
+
+/**
+ * Returns NULL if the checksum type is not supported
+ */
+gfal_checksum_stream_t gfal_checksum_stream_new(const char *type);
+
+void gfal_checksum_stream_update(gfal_checksum_stream_t stream, const void *data, size_t size);
+
+/**
+ * Start again, as if no data had been given
+ */
+void gfal_checksum_stream_reset(gfal_checksum_stream_t stream);
+
+/**
+ * Put the checksum of the data given so far in buffer, formatted as the file plugin does
+ * Returns -1 if the buffer is too short
+ */
+int gfal_checksum_stream_final(gfal_checksum_stream_t stream, char *buffer, size_t s_buffer);
+
+/**
+ * Several checksums of the same data, computed in a single pass over each update
+ * Returns NULL if any of the types is not supported
+ */
+gfal_checksum_stream_t gfal_checksum_stream_new_multiple(const char * const *types, size_t count);
+
+/**
+ * gfal_checksum_stream_final for the checksum at index in the types given to
+ * gfal_checksum_stream_new_multiple
+ */
+int gfal_checksum_stream_final_nth(gfal_checksum_stream_t stream, size_t index, char *buffer, size_t s_buffer);
+
+void gfal_checksum_stream_free(gfal_checksum_stream_t stream);
+
 #ifdef __cplusplus
 }
 #endif
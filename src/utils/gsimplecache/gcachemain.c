@@ -26,133 +26,353 @@
 #include <pthread.h>
 #include "gcachemain.h"
 
-static const guint64 max_list_len = MAX_LIST_LEN;
 
+typedef struct _Internal_item {
+    char* key;
+    // monotonic time in microseconds, 0 if it does not expire
+    gint64 expires;
+    // read since it was stored
+    gboolean hit;
+    // most recently used first
+    struct _Internal_item* prev;
+    struct _Internal_item* next;
+    char item[];
+} Internal_item;
 
+typedef struct {
+    pthread_mutex_t mux;
+    GHashTable* table;
+    Internal_item* head;
+    Internal_item* tail;
+    guint64 max_number_item;
+    // bloom filter of the keys rejected recently, see GSIMPLECACHE_ADMIT_FREQUENT
+    guint64* doorkeeper;
+    guint doorkeeper_bits;
+    guint64 doorkeeper_count;
+    GSimpleCache_Stats stats;
+} GSimpleCache_Shard;
 
+struct _GSimpleCache_Handle {
+    GSimpleCache_CopyConstructor do_copy;
+    size_t size_item;
+    gint64 ttl_ms;
+    GSimpleCache_Admission admission;
+    guint n_shards;
+    GSimpleCache_Shard shards[];
+};
 
-typedef struct _Internal_item{
-	int ref_count;
-	char item[];
-} Internal_item;
 
-struct _GSimpleCache_Handle{
-	GHashTable*  table;
-	GSimpleCache_CopyConstructor do_copy;
-	size_t size_item;
-    size_t max_number_item;
-	pthread_mutex_t mux;
-};
+static gint64 gsimplecache_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
 
-static void gsimplecache_destroy_item_internal(gpointer a){
-	Internal_item* i = (Internal_item*) a;
-	g_free(i);
+static guint32 gsimplecache_hash2(const char* key)
+{
+    // FNV-1a, independent from g_str_hash which picks the shard
+    guint32 hash = 2166136261U;
+    for (; *key != '\0'; ++key) {
+        hash ^= (unsigned char)*key;
+        hash *= 16777619U;
+    }
+    return hash;
 }
 
 
-static gboolean hash_strings_are_equals(gconstpointer a, gconstpointer b){
-	return (strcmp((char*) a, (char*) b)== 0);
+static void gsimplecache_destroy_item_internal(gpointer a)
+{
+    Internal_item* i = (Internal_item*) a;
+    g_free(i->key);
+    g_free(i);
 }
 
-/**
- * Construct a new cache with a capacity of max_size bytes
- * */
-GSimpleCache* gsimplecache_new(guint64 max_number_item, GSimpleCache_CopyConstructor value_copy, size_t size_item){
-	GSimpleCache* ret = (GSimpleCache*) g_new(struct _GSimpleCache_Handle,1);
-	ret->table = g_hash_table_new_full(&g_str_hash, &hash_strings_are_equals, &free, &gsimplecache_destroy_item_internal );
-	ret->do_copy = value_copy;
-	ret->size_item = size_item;
-    ret->max_number_item = max_number_item;
-	pthread_mutex_init(&ret->mux,NULL);
-	return ret;
+
+static void gsimplecache_unlink(GSimpleCache_Shard* shard, Internal_item* i)
+{
+    if (i->prev)
+        i->prev->next = i->next;
+    else
+        shard->head = i->next;
+    if (i->next)
+        i->next->prev = i->prev;
+    else
+        shard->tail = i->prev;
+    i->prev = i->next = NULL;
 }
 
-/**
- *  delete a cache object, all internals object are free
- * */
-void gsimplecache_delete(GSimpleCache* cache){
-	if(cache != NULL){
-		pthread_mutex_lock(&cache->mux);
-		g_hash_table_destroy (cache->table);		
-		pthread_mutex_unlock(&cache->mux);
-		pthread_mutex_destroy(&cache->mux);
-		g_free(cache);
-	}
+
+static void gsimplecache_push_front(GSimpleCache_Shard* shard, Internal_item* i)
+{
+    i->prev = NULL;
+    i->next = shard->head;
+    if (shard->head)
+        shard->head->prev = i;
+    shard->head = i;
+    if (shard->tail == NULL)
+        shard->tail = i;
 }
 
-Internal_item* gsimplecache_find_kstr_internal(GSimpleCache* cache, const char* key){
-	Internal_item* ret = (Internal_item*) g_hash_table_lookup(cache->table, (gconstpointer) key);
-	if(ret != NULL ){
-		return ret;
-	}	
-	return NULL;
+
+static void gsimplecache_drop(GSimpleCache_Shard* shard, Internal_item* i)
+{
+    gsimplecache_unlink(shard, i);
+    g_hash_table_remove(shard->table, i->key);
 }
 
-static gboolean gsimplecache_remove_internal_kstr(GSimpleCache* cache, const char* key){
-		return g_hash_table_remove(cache->table, (gconstpointer) key);	
+
+static gboolean gsimplecache_expired(const Internal_item* i, gint64 now)
+{
+    return i->expires != 0 && i->expires <= now;
 }
 
-// simple lazy space maker, can be improved
-static void gsimplecache_manage_space(GSimpleCache* cache){
-    size_t len = (size_t) g_hash_table_size (cache->table);
-    if(len >= cache->max_number_item){
-        g_hash_table_remove_all(cache->table);
+
+// Returns TRUE if key was offered since the filter was last cleared, and remembers it
+static gboolean gsimplecache_doorkeeper(GSimpleCache_Shard* shard, const char* key)
+{
+    const guint32 hash = gsimplecache_hash2(key);
+    const guint b1 = hash % shard->doorkeeper_bits;
+    const guint b2 = ((hash >> 16) | (hash << 16)) % shard->doorkeeper_bits;
+    const guint64 m1 = (guint64)1 << (b1 % 64);
+    const guint64 m2 = (guint64)1 << (b2 % 64);
+
+    gboolean seen = (shard->doorkeeper[b1 / 64] & m1) && (shard->doorkeeper[b2 / 64] & m2);
+    if (!seen) {
+        // forget everything once as many keys as the shard holds have been offered
+        if (++shard->doorkeeper_count > shard->max_number_item) {
+            memset(shard->doorkeeper, 0, shard->doorkeeper_bits / 8);
+            shard->doorkeeper_count = 1;
+        }
+        shard->doorkeeper[b1 / 64] |= m1;
+        shard->doorkeeper[b2 / 64] |= m2;
+    }
+    return seen;
+}
+
+
+// Make room for a new key, returns FALSE if it must not be stored
+static gboolean gsimplecache_manage_space(GSimpleCache* cache, GSimpleCache_Shard* shard,
+        const char* key, gint64 now)
+{
+    while (g_hash_table_size(shard->table) >= shard->max_number_item) {
+        Internal_item* victim = shard->tail;
+        if (gsimplecache_expired(victim, now)) {
+            shard->stats.expirations++;
+        }
+        else if (cache->admission == GSIMPLECACHE_ADMIT_FREQUENT && victim->hit &&
+                 !gsimplecache_doorkeeper(shard, key)) {
+            victim->hit = FALSE;
+            gsimplecache_unlink(shard, victim);
+            gsimplecache_push_front(shard, victim);
+            shard->stats.rejections++;
+            return FALSE;
+        }
+        else {
+            shard->stats.evictions++;
+        }
+        gsimplecache_drop(shard, victim);
     }
+    return TRUE;
 }
 
 
+static GSimpleCache_Shard* gsimplecache_get_shard(GSimpleCache* cache, const char* key)
+{
+    return &cache->shards[g_str_hash(key) % cache->n_shards];
+}
+
 
-void gsimplecache_add_item_internal(GSimpleCache* cache, const char* key, void* item){
-	Internal_item* ret = gsimplecache_find_kstr_internal(cache, key);	
-	if(ret == NULL){
-        gsimplecache_manage_space(cache);
-		ret = malloc(sizeof(struct _Internal_item) + cache->size_item);
-		ret->ref_count = 2;
-		cache->do_copy(item, ret->item);
-		g_hash_table_insert(cache->table, strdup(key), ret);
-	}else{
-		(ret->ref_count)++;
-	}
+/**
+ * Construct a new cache of max_number_item entries, split in shards
+ * */
+GSimpleCache* gsimplecache_new_full(guint64 max_number_item, guint n_shards, gint64 ttl_ms,
+        GSimpleCache_Admission admission, GSimpleCache_CopyConstructor value_copy, size_t size_item)
+{
+    guint i;
+    if (max_number_item == 0)
+        max_number_item = 1;
+    if (n_shards == 0)
+        n_shards = GSIMPLECACHE_SHARDS_DEFAULT;
+    if (n_shards > max_number_item)
+        n_shards = (guint) max_number_item;
+
+    GSimpleCache* ret = g_malloc0(sizeof(GSimpleCache) + n_shards * sizeof(GSimpleCache_Shard));
+    ret->do_copy = value_copy;
+    ret->size_item = size_item;
+    ret->ttl_ms = ttl_ms;
+    ret->admission = admission;
+    ret->n_shards = n_shards;
+
+    for (i = 0; i < n_shards; ++i) {
+        GSimpleCache_Shard* shard = &ret->shards[i];
+        pthread_mutex_init(&shard->mux, NULL);
+        // the key is owned by the item
+        shard->table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, gsimplecache_destroy_item_internal);
+        shard->max_number_item = (max_number_item + n_shards - 1) / n_shards;
+        // about 8 bits per entry, in whole words
+        shard->doorkeeper_bits = (guint)(((shard->max_number_item * 8) + 63) / 64) * 64;
+        shard->doorkeeper = g_new0(guint64, shard->doorkeeper_bits / 64);
+    }
+    return ret;
 }
 
 
+GSimpleCache* gsimplecache_new(guint64 max_number_item, GSimpleCache_CopyConstructor value_copy, size_t size_item)
+{
+    return gsimplecache_new_full(max_number_item, 0, 0, GSIMPLECACHE_ADMIT_ALL, value_copy, size_item);
+}
+
 /**
- * Add an item to the cache or increment the reference of this item of one if already exist
+ *  delete a cache object, all internals object are free
  * */
-void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item){
-	pthread_mutex_lock(&cache->mux);	
-	gsimplecache_add_item_internal(cache, key, item);
-	pthread_mutex_unlock(&cache->mux);
+void gsimplecache_delete(GSimpleCache* cache)
+{
+    guint i;
+    if (cache != NULL) {
+        for (i = 0; i < cache->n_shards; ++i) {
+            GSimpleCache_Shard* shard = &cache->shards[i];
+            g_hash_table_destroy(shard->table);
+            g_free(shard->doorkeeper);
+            pthread_mutex_destroy(&shard->mux);
+        }
+        g_free(cache);
+    }
 }
 
 
+void gsimplecache_add_item_kstr_ttl(GSimpleCache* cache, const char* key, void* item, gint64 ttl_ms)
+{
+    GSimpleCache_Shard* shard = gsimplecache_get_shard(cache, key);
+    const gint64 now = gsimplecache_now();
+
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = (Internal_item*) g_hash_table_lookup(shard->table, key);
+    if (ret == NULL) {
+        if (gsimplecache_manage_space(cache, shard, key, now)) {
+            ret = g_malloc0(sizeof(Internal_item) + cache->size_item);
+            ret->key = g_strdup(key);
+            g_hash_table_insert(shard->table, ret->key, ret);
+        }
+    }
+    else {
+        gsimplecache_unlink(shard, ret);
+        ret->hit = FALSE;
+    }
+    if (ret != NULL) {
+        cache->do_copy(item, ret->item);
+        ret->expires = (ttl_ms > 0) ? now + ttl_ms * 1000 : 0;
+        gsimplecache_push_front(shard, ret);
+        shard->stats.insertions++;
+    }
+    pthread_mutex_unlock(&shard->mux);
+}
+
+
+/**
+ * Add an item to the cache, or replace its value if it already exists
+ * */
+void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item)
+{
+    gsimplecache_add_item_kstr_ttl(cache, key, item, cache->ttl_ms);
+}
+
 
 /**
  * remove the item in the cache, return TRUE if removed else FALSE
  * destroy the internal item automatically
  * */
-gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key){
-	pthread_mutex_lock(&cache->mux);
-	gboolean ret = gsimplecache_remove_internal_kstr(cache, key);
-	pthread_mutex_unlock(&cache->mux);	
-	return ret;
+gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key)
+{
+    GSimpleCache_Shard* shard = gsimplecache_get_shard(cache, key);
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = (Internal_item*) g_hash_table_lookup(shard->table, key);
+    if (ret)
+        gsimplecache_drop(shard, ret);
+    pthread_mutex_unlock(&shard->mux);
+    return ret != NULL;
+}
+
+
+guint64 gsimplecache_remove_prefix(GSimpleCache* cache, const char* prefix)
+{
+    const size_t len = strlen(prefix);
+    guint64 removed = 0;
+    guint i;
+    for (i = 0; i < cache->n_shards; ++i) {
+        GSimpleCache_Shard* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->mux);
+        Internal_item* item = shard->head;
+        while (item != NULL) {
+            Internal_item* next = item->next;
+            if (strncmp(item->key, prefix, len) == 0) {
+                gsimplecache_drop(shard, item);
+                ++removed;
+            }
+            item = next;
+        }
+        pthread_mutex_unlock(&shard->mux);
+    }
+    return removed;
+}
+
+
+void gsimplecache_remove_all(GSimpleCache* cache)
+{
+    guint i;
+    for (i = 0; i < cache->n_shards; ++i) {
+        GSimpleCache_Shard* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->mux);
+        g_hash_table_remove_all(shard->table);
+        shard->head = shard->tail = NULL;
+        pthread_mutex_unlock(&shard->mux);
+    }
 }
 
 /**
- * find the value in the cache, and decrease its internal reference count of 1.
+ * find the value in the cache
  * If the item exist, set the item resu to the correct value and return 0 else return -1
- * 
  * */
-int gsimplecache_take_one_kstr(GSimpleCache* cache, const char* key, void* res){
-	pthread_mutex_lock(&cache->mux);	
-	Internal_item* ret = gsimplecache_find_kstr_internal(cache, key);
-	if(ret){
-		(ret->ref_count)--;
-		cache->do_copy(ret->item, res);
-		if(ret->ref_count <= 0)
-			gsimplecache_remove_internal_kstr(cache, key);
-	}
-	pthread_mutex_unlock(&cache->mux);	
-	return (ret)?0:-1;
+int gsimplecache_get_kstr(GSimpleCache* cache, const char* key, void* res)
+{
+    GSimpleCache_Shard* shard = gsimplecache_get_shard(cache, key);
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = (Internal_item*) g_hash_table_lookup(shard->table, key);
+    if (ret && gsimplecache_expired(ret, gsimplecache_now())) {
+        gsimplecache_drop(shard, ret);
+        shard->stats.expirations++;
+        ret = NULL;
+    }
+    if (ret) {
+        gsimplecache_unlink(shard, ret);
+        gsimplecache_push_front(shard, ret);
+        ret->hit = TRUE;
+        cache->do_copy(ret->item, res);
+        shard->stats.hits++;
+    }
+    else {
+        shard->stats.misses++;
+    }
+    pthread_mutex_unlock(&shard->mux);
+    return (ret)?0:-1;
 }
 
+
+void gsimplecache_get_stats(GSimpleCache* cache, GSimpleCache_Stats* stats)
+{
+    guint i;
+    memset(stats, 0, sizeof(*stats));
+    for (i = 0; i < cache->n_shards; ++i) {
+        GSimpleCache_Shard* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->mux);
+        stats->hits += shard->stats.hits;
+        stats->misses += shard->stats.misses;
+        stats->insertions += shard->stats.insertions;
+        stats->evictions += shard->stats.evictions;
+        stats->expirations += shard->stats.expirations;
+        stats->rejections += shard->stats.rejections;
+        stats->size += g_hash_table_size(shard->table);
+        pthread_mutex_unlock(&shard->mux);
+    }
+}
@@ -22,23 +22,91 @@
 
 #include <glib.h>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 
-#define MAX_LIST_LEN 20000
+#define GSIMPLECACHE_SHARDS_DEFAULT 16
 
 /**
  * copy the original object to a new one
  */
 typedef void (*GSimpleCache_CopyConstructor)(gpointer original, gpointer copy);
 
+/**
+ * What happens to a new key when its shard is full
+ */
+typedef enum {
+    /** always stored, the least recently used entry is evicted */
+    GSIMPLECACHE_ADMIT_ALL = 0,
+    /** the least recently used entry is evicted only if it has not been read since stored,
+     *  or if the new key was already offered recently. Otherwise the entry gets a second chance,
+     *  and the new key is dropped. Keeps the entries in use through a long listing */
+    GSIMPLECACHE_ADMIT_FREQUENT
+} GSimpleCache_Admission;
+
+typedef struct {
+    guint64 hits;
+    guint64 misses;
+    guint64 insertions;
+    /** entries dropped to make room */
+    guint64 evictions;
+    /** entries dropped because their ttl had passed */
+    guint64 expirations;
+    /** new keys not stored because of the admission policy */
+    guint64 rejections;
+    /** entries currently stored */
+    guint64 size;
+} GSimpleCache_Stats;
+
 typedef struct _GSimpleCache_Handle GSimpleCache;
 
+/**
+ * Least recently used cache of max_number_item entries of size_item bytes, without expiration
+ */
 GSimpleCache* gsimplecache_new(guint64 max_number_item, GSimpleCache_CopyConstructor value_copy, size_t size_item);
 
+/**
+ * Same, split in n_shards independently locked shards (0 for the default),
+ * with entries expiring ttl_ms milliseconds after being stored (0 never)
+ */
+GSimpleCache* gsimplecache_new_full(guint64 max_number_item, guint n_shards, gint64 ttl_ms,
+        GSimpleCache_Admission admission, GSimpleCache_CopyConstructor value_copy, size_t size_item);
+
 void gsimplecache_delete(GSimpleCache* cache);
 
+/**
+ * Store a copy of item, replacing the value of key if any, with the default ttl
+ */
 void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item);
 
-int gsimplecache_take_one_kstr(GSimpleCache* cache, const char* key, void* res);
+/**
+ * Same, with a ttl in milliseconds for this entry only (0 never expires)
+ */
+void gsimplecache_add_item_kstr_ttl(GSimpleCache* cache, const char* key, void* item, gint64 ttl_ms);
+
+/**
+ * Copy the value of key into res, and return 0, or -1 if not found or expired
+ * The entry stays in the cache
+ */
+int gsimplecache_get_kstr(GSimpleCache* cache, const char* key, void* res);
 
+/**
+ * Remove the entry of key, return TRUE if it was there
+ */
 gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key);
 
+/**
+ * Remove the entries whose key starts with prefix, return how many there were
+ * Goes through the whole cache
+ */
+guint64 gsimplecache_remove_prefix(GSimpleCache* cache, const char* prefix);
+
+void gsimplecache_remove_all(GSimpleCache* cache);
+
+void gsimplecache_get_stats(GSimpleCache* cache, GSimpleCache_Stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,101 +18,192 @@
  * limitations under the License.
  */
 
-#include <assert.h>
 #include <ctype.h>
 #include <errno.h>
-#include <regex.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "gfal2_uri.h"
 
 
-// From RFC3986, appendix B
-#define URI_REGEX "^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\\?([^#]*))?(#(.*))?"
-//                  12            3  4          5       6  7        8 9
-#define AUTHORITY_REGEX "^(([^@]*)@)?(([[:alnum:]][-_[:alnum:]]*(\\.[-_[:alnum:]]+)*)|(\\[[a-zA-Z0-9:]+\\]))?(:[[:digit:]]+)?"
-//                        12         34                         5                    6                  3 7
+// The parser follows RFC3986, appendix B
+//   ^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?
+// and the authority is split as
+//   ^(([^@]*)@)?(([[:alnum:]][-_[:alnum:]]*(\.[-_[:alnum:]]+)*)|(\[[a-zA-Z0-9:]+\]))?(:[[:digit:]]+)?
 
 static GQuark scope_uri(){
 	return g_quark_from_static_string("Gfal::Uri_util");
 }
 
 
-static char *_strdupmatch(const char *str, regmatch_t *match)
+static void _set_slice(gfal2_uri_slice *slice, const char *uri, const char *begin, const char *end)
 {
-    if (match->rm_so < 0)
-        return NULL;
+    slice->offset = begin - uri;
+    slice->length = end - begin;
+}
 
-    size_t match_len = match->rm_eo - match->rm_so;
-    return g_strndup(str + match->rm_so, match_len);
+
+static int _is_host_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '-' || c == '_';
 }
 
 
-gfal2_uri *gfal2_parse_uri(const char *uri, GError **err)
+static int _is_ipv6_char(char c)
 {
-    char buffer[128];
-
-    regex_t preg;
-    int ret = regcomp(&preg, URI_REGEX, REG_EXTENDED | REG_ICASE);
-    assert(ret == 0);
-
-    regmatch_t pmatch[10];
-    ret = regexec(&preg, uri, 10, pmatch, 0);
-    if (ret != 0) {
-        regerror(ret, &preg, buffer, sizeof(buffer));
-        regfree(&preg);
-        gfal2_set_error(err, scope_uri(), EINVAL, __func__, "Could not match the uri: %s", buffer);
-        return NULL;
-    }
+    return isalnum((unsigned char)c) || c == ':';
+}
 
-    // URI
-    gfal2_uri *parsed = g_malloc0(sizeof(*parsed));
-    parsed->scheme = _strdupmatch(uri, &pmatch[2]);
-    parsed->path = _strdupmatch(uri, &pmatch[5]);
-    parsed->query = _strdupmatch(uri, &pmatch[7]);
-    parsed->fragment = _strdupmatch(uri, &pmatch[9]);
-    parsed->original = uri;
+// Parse the authority between begin and end
+// As with the regular expression, trailing garbage is ignored
+static void _parse_authority(const char *uri, const char *begin, const char *end, gfal2_uri_view *view)
+{
+    // Authority defined but empty
+    if (begin == end) {
+        _set_slice(&view->host, uri, begin, end);
+        return;
+    }
 
+    const char *p = memchr(begin, '@', end - begin);
+    if (p) {
+        _set_slice(&view->userinfo, uri, begin, p);
+        begin = p + 1;
+    }
 
-    // Authority not defined
-    if (pmatch[4].rm_so < 0) {
-        parsed->userinfo = parsed->host = NULL;
-        parsed->port = 0;
+    p = begin;
+    if (p < end && *p == '[') {
+        ++p;
+        while (p < end && _is_ipv6_char(*p))
+            ++p;
+        if (p < end && *p == ']' && p - begin > 1) {
+            ++p;
+            _set_slice(&view->host, uri, begin, p);
+        }
+        else {
+            p = begin;
+        }
     }
-    // Authority defined but empty
-    else if (pmatch[4].rm_so == pmatch[4].rm_eo) {
-        parsed->host = g_strdup("");
-    }
-    // Authority has content
-    if (pmatch[4].rm_so != pmatch[4].rm_eo) {
-        char *authority = _strdupmatch(uri, &pmatch[4]);
-
-        regex_t authreg;
-        ret = regcomp(&authreg, AUTHORITY_REGEX, REG_EXTENDED | REG_ICASE);
-        assert(ret == 0);
-
-        regmatch_t authmatch[8];
-        ret = regexec(&authreg, authority, 8, authmatch, 0);
-        if (ret != 0) {
-            regerror(ret, &preg, buffer, sizeof(buffer));
-            regfree(&preg);
-            gfal2_free_uri(parsed);
-            gfal2_set_error(err, scope_uri(), EINVAL, __func__, "Could not match the authority: %s", buffer);
-            return NULL;
+    else if (p < end && isalnum((unsigned char)*p)) {
+        ++p;
+        while (p < end && _is_host_char(*p))
+            ++p;
+        while (p + 1 < end && *p == '.' && _is_host_char(*(p + 1))) {
+            p += 2;
+            while (p < end && _is_host_char(*p))
+                ++p;
         }
+        _set_slice(&view->host, uri, begin, p);
+    }
+
+    if (p + 1 < end && *p == ':' && isdigit((unsigned char)*(p + 1))) {
+        unsigned port = 0;
+        for (++p; p < end && isdigit((unsigned char)*p); ++p)
+            port = port * 10 + (*p - '0');
+        view->port = port;
+    }
+}
 
-        parsed->userinfo = _strdupmatch(authority, &authmatch[2]);
-        parsed->host = _strdupmatch(authority, &authmatch[3]);
-        if (authmatch[7].rm_so > -1) {
-            parsed->port = atol(authority + authmatch[7].rm_so + 1);
-        }
 
-        regfree(&authreg);
-        g_free(authority);
+int gfal2_parse_uri_view(const char *uri, gfal2_uri_view *view, GError **err)
+{
+    static const gfal2_uri_slice undefined = {-1, 0};
+
+    if (uri == NULL) {
+        gfal2_set_error(err, scope_uri(), EINVAL, __func__, "Could not match the uri: NULL");
+        return -1;
     }
 
-    regfree(&preg);
+    view->scheme = view->userinfo = view->host = undefined;
+    view->path = view->query = view->fragment = undefined;
+    view->port = 0;
+    view->original = uri;
+
+    const char *p = uri;
+
+    // Scheme
+    const char *sep = p;
+    while (*sep != '\0' && *sep != ':' && *sep != '/' && *sep != '?' && *sep != '#')
+        ++sep;
+    if (*sep == ':' && sep != p) {
+        _set_slice(&view->scheme, uri, p, sep);
+        p = sep + 1;
+    }
+
+    // Authority
+    if (p[0] == '/' && p[1] == '/') {
+        p += 2;
+        const char *authority = p;
+        while (*p != '\0' && *p != '/' && *p != '?' && *p != '#')
+            ++p;
+        _parse_authority(uri, authority, p, view);
+    }
 
+    // Path, always defined
+    const char *path = p;
+    while (*p != '\0' && *p != '?' && *p != '#')
+        ++p;
+    _set_slice(&view->path, uri, path, p);
+
+    // Query
+    if (*p == '?') {
+        const char *query = ++p;
+        while (*p != '\0' && *p != '#')
+            ++p;
+        _set_slice(&view->query, uri, query, p);
+    }
+
+    // Fragment
+    if (*p == '#') {
+        const char *fragment = ++p;
+        p += strlen(p);
+        _set_slice(&view->fragment, uri, fragment, p);
+    }
+
+    return 0;
+}
+
+
+gboolean gfal2_uri_view_equal(const gfal2_uri_view *view, const gfal2_uri_slice *slice, const char *str)
+{
+    if (slice->offset < 0)
+        return FALSE;
+    return strncmp(view->original + slice->offset, str, slice->length) == 0 && str[slice->length] == '\0';
+}
+
+
+int gfal2_uri_view_copy(const gfal2_uri_view *view, const gfal2_uri_slice *slice, char *buff, size_t s_buff)
+{
+    if (slice->offset < 0 || (size_t)slice->length >= s_buff)
+        return -1;
+    memcpy(buff, view->original + slice->offset, slice->length);
+    buff[slice->length] = '\0';
+    return slice->length;
+}
+
+
+char *gfal2_uri_view_dup(const gfal2_uri_view *view, const gfal2_uri_slice *slice)
+{
+    if (slice->offset < 0)
+        return NULL;
+    return g_strndup(view->original + slice->offset, slice->length);
+}
+
+
+gfal2_uri *gfal2_parse_uri(const char *uri, GError **err)
+{
+    gfal2_uri_view view;
+    if (gfal2_parse_uri_view(uri, &view, err) < 0)
+        return NULL;
+
+    gfal2_uri *parsed = g_malloc0(sizeof(*parsed));
+    parsed->scheme = gfal2_uri_view_dup(&view, &view.scheme);
+    parsed->userinfo = gfal2_uri_view_dup(&view, &view.userinfo);
+    parsed->host = gfal2_uri_view_dup(&view, &view.host);
+    parsed->port = view.port;
+    parsed->path = gfal2_uri_view_dup(&view, &view.path);
+    parsed->query = gfal2_uri_view_dup(&view, &view.query);
+    parsed->fragment = gfal2_uri_view_dup(&view, &view.fragment);
+    parsed->original = uri;
     return parsed;
 }
 
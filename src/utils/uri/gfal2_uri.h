@@ -47,11 +47,55 @@ typedef struct gfal2_uri {
     const char *original;
 } gfal2_uri;
 
+// Component of an URI, as a slice of the original string
+// offset is -1 when the component is undefined
+typedef struct gfal2_uri_slice {
+    int offset;
+    int length;
+} gfal2_uri_slice;
+
+// Borrowed view of an URI. No memory is allocated, all the components point
+// to the original string, which must outlive the view.
+// The same NULL/empty semantic of gfal2_uri applies.
+typedef struct gfal2_uri_view {
+    gfal2_uri_slice scheme;
+    gfal2_uri_slice userinfo;
+    gfal2_uri_slice host;
+    unsigned port;
+    gfal2_uri_slice path;
+    gfal2_uri_slice query;
+    gfal2_uri_slice fragment;
+
+    const char *original;
+} gfal2_uri_view;
+
 /*
  * Parse an URI
  */
 gfal2_uri* gfal2_parse_uri(const char *uri, GError **err);
 
+/*
+ * Parse an URI into view, without allocating memory
+ * Returns 0 on success, -1 on error
+ */
+int gfal2_parse_uri_view(const char *uri, gfal2_uri_view *view, GError **err);
+
+/*
+ * Returns TRUE if the component is defined and equal to str
+ */
+gboolean gfal2_uri_view_equal(const gfal2_uri_view *view, const gfal2_uri_slice *slice, const char *str);
+
+/*
+ * Copy the component into buff, null terminated
+ * Returns the length of the component, or -1 if it is undefined or does not fit
+ */
+int gfal2_uri_view_copy(const gfal2_uri_view *view, const gfal2_uri_slice *slice, char *buff, size_t s_buff);
+
+/*
+ * Returns a newly allocated copy of the component, or NULL if it is undefined
+ */
+char *gfal2_uri_view_dup(const gfal2_uri_view *view, const gfal2_uri_slice *slice);
+
 /*
  * Free an URI. It is safe to call if uri is NULL.
  */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of the checksum implementations
+// usage: gfal_checksum_benchmark [buffer size in MB] [repetitions]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <zlib.h>
+#include <utils/checksums/checksums.h>
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void report(const char *name, size_t bytes, double elapsed)
+{
+    printf("%-28s %10.1f MB/s\n", name, bytes / elapsed / (1024 * 1024));
+}
+
+
+static void bench_stream(const char * const *types, size_t ntypes, const char *name,
+    const unsigned char *data, size_t size, int repetitions)
+{
+    char result[128];
+    gfal_checksum_stream_t stream = gfal_checksum_stream_new_multiple(types, ntypes);
+    int i;
+    double start = now();
+    for (i = 0; i < repetitions; ++i) {
+        gfal_checksum_stream_reset(stream);
+        gfal_checksum_stream_update(stream, data, size);
+        gfal_checksum_stream_final(stream, result, sizeof(result));
+    }
+    report(name, size * repetitions, now() - start);
+    gfal_checksum_stream_free(stream);
+}
+
+
+int main(int argc, char **argv)
+{
+    size_t size = ((argc > 1) ? atol(argv[1]) : 64) * 1024 * 1024;
+    int repetitions = (argc > 2) ? atoi(argv[2]) : 8;
+    unsigned char *data = malloc(size);
+    volatile unsigned long sink = 0;
+    double start;
+    size_t i;
+    int r;
+
+    if (data == NULL || repetitions <= 0) {
+        fprintf(stderr, "usage: %s [buffer size in MB] [repetitions]\n", argv[0]);
+        return 1;
+    }
+    for (i = 0; i < size; ++i)
+        data[i] = (unsigned char)(i * 7 + i / 251);
+
+    printf("%zu MB, %d times, best implementation %s\n\n", size / (1024 * 1024), repetitions,
+        gfal_checksum_kernels()->name);
+
+    start = now();
+    for (r = 0; r < repetitions; ++r)
+        sink += adler32(1, data, size);
+    report("adler32 zlib", size * repetitions, now() - start);
+
+    const gfal_checksum_kernels_t * const *kernels = gfal_checksum_kernels_supported();
+    for (; *kernels; ++kernels) {
+        char name[64];
+        snprintf(name, sizeof(name), "adler32 %s", (*kernels)->name);
+        start = now();
+        for (r = 0; r < repetitions; ++r)
+            sink += (*kernels)->adler32(1, data, size);
+        report(name, size * repetitions, now() - start);
+
+        snprintf(name, sizeof(name), "crc32c %s", (*kernels)->name);
+        start = now();
+        for (r = 0; r < repetitions; ++r)
+            sink += (*kernels)->crc32c(0, data, size);
+        report(name, size * repetitions, now() - start);
+    }
+    printf("\n");
+
+    const char *all[] = {"adler32", "crc32", "crc32c", "md5", "sha1", "sha256"};
+    for (i = 0; i < sizeof(all) / sizeof(all[0]); ++i)
+        bench_stream(&all[i], 1, all[i], data, size, repetitions);
+
+    const char *adler_md5[] = {"adler32", "md5"};
+    bench_stream(adler_md5, 2, "adler32+md5 single pass", data, size, repetitions);
+
+    free(data);
+    return (int)(sink & 0);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of creating a context, from scratch and as a clone of another one
+// usage: gfal_context_benchmark [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <gfal_api.h>
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void report(const char *name, int iterations, double elapsed)
+{
+    printf("%-20s %10.1f us\n", name, elapsed * 1e6 / iterations);
+}
+
+
+static int failed(const char *what, GError *error)
+{
+    fprintf(stderr, "%s failed: %s\n", what, error->message);
+    g_error_free(error);
+    return 1;
+}
+
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+    GError *error = NULL;
+    gfal2_context_t context;
+    double start;
+    int i;
+
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    start = now();
+    for (i = 0; i < iterations; ++i) {
+        if ((context = gfal2_context_new(&error)) == NULL)
+            return failed("gfal2_context_new", error);
+        gfal2_context_free(context);
+    }
+    report("gfal2_context_new", iterations, now() - start);
+
+    gfal2_context_t parent = gfal2_context_new(&error);
+    if (parent == NULL)
+        return failed("gfal2_context_new", error);
+
+    start = now();
+    for (i = 0; i < iterations; ++i) {
+        if ((context = gfal2_context_clone(parent, &error)) == NULL)
+            return failed("gfal2_context_clone", error);
+        gfal2_context_free(context);
+    }
+    report("gfal2_context_clone", iterations, now() - start);
+
+    gfal2_context_free(parent);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of looking up the credentials of a url among many prefixes
+// usage: gfal_cred_benchmark [prefixes] [lookups]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gfal_api.h>
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char **argv)
+{
+    int n_prefixes = (argc > 1) ? atoi(argv[1]) : 5000;
+    int iterations = (argc > 2) ? atoi(argv[2]) : 200000;
+    GError *error = NULL;
+    char url[128], expected[32];
+    double start;
+    int i, mismatches = 0;
+
+    if (n_prefixes <= 0 || iterations <= 0) {
+        fprintf(stderr, "usage: %s [prefixes] [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    gfal2_context_t context = gfal2_context_new(&error);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    for (i = 0; i < n_prefixes; ++i) {
+        char prefix[128], token[32];
+        snprintf(prefix, sizeof(prefix), "davs://storage%d.example.com:443/vo/data/%d", i % 50, i);
+        snprintf(token, sizeof(token), "token-%d", i);
+        gfal2_cred_t *cred = gfal2_cred_new(GFAL_CRED_BEARER, token);
+        gfal2_cred_set(context, prefix, cred, NULL);
+        gfal2_cred_free(cred);
+    }
+
+    // one of the last prefixes
+    i = n_prefixes - n_prefixes / 150 - 1;
+    snprintf(url, sizeof(url), "davs://storage%d.example.com:443/vo/data/%d/file.root", i % 50, i);
+    snprintf(expected, sizeof(expected), "token-%d", i);
+
+    start = now();
+    for (i = 0; i < iterations; ++i) {
+        const char *value = gfal2_cred_lookup(context, GFAL_CRED_BEARER, url, NULL, NULL);
+        if (value == NULL || strcmp(value, expected) != 0)
+            ++mismatches;
+        gfal2_cred_release(value);
+    }
+    double elapsed = now() - start;
+
+    printf("gfal2_cred_lookup with %d prefixes: %.1f ns/lookup\n", n_prefixes, elapsed * 1e9 / iterations);
+    if (mismatches)
+        printf("%d lookups did not return %s\n", mismatches, expected);
+
+    gfal2_context_free(context);
+    return 0;
+}
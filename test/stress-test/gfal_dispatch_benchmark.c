@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of dispatching an I/O call to the plugin of its file handle
+// usage: gfal_dispatch_benchmark [millions of calls] [plugins registered before]
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_file_handler_container.h>
+#include <common/gfal_plugin.h>
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void report(const char *name, int iterations, double elapsed)
+{
+    printf("%-16s %8.1f ns/call\n", name, elapsed * 1e9 / iterations);
+}
+
+
+static const char *bench_plugin_get_name(void)
+{
+    return "BENCHMARK PLUGIN";
+}
+
+
+static const char *bench_filler_get_name(void)
+{
+    return "BENCHMARK FILLER";
+}
+
+
+static gboolean bench_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "bench://", 8) == 0;
+}
+
+
+static gboolean bench_filler_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return FALSE;
+}
+
+
+static gfal_file_handle bench_plugin_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    return gfal_file_handle_new(bench_plugin_get_name(), NULL);
+}
+
+
+static ssize_t bench_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err)
+{
+    return count;
+}
+
+
+static int bench_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static void register_plugins(gfal2_context_t context, int n_fillers)
+{
+    gfal_plugin_interface plugin;
+    int i;
+
+    // plugins that never match, so the lookup by name has something to go through
+    for (i = 0; i < n_fillers; ++i) {
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = bench_filler_get_name;
+        plugin.check_plugin_url = bench_filler_url;
+        gfal2_register_plugin(context, &plugin, NULL);
+    }
+
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = bench_plugin_get_name;
+    plugin.check_plugin_url = bench_plugin_url;
+    plugin.openG = bench_plugin_open;
+    plugin.preadG = bench_plugin_pread;
+    plugin.closeG = bench_plugin_close;
+    gfal2_register_plugin(context, &plugin, NULL);
+}
+
+
+int main(int argc, char **argv)
+{
+    int iterations = ((argc > 1) ? atoi(argv[1]) : 2) * 1000000;
+    int n_fillers = (argc > 2) ? atoi(argv[2]) : 8;
+    GError *error = NULL;
+    char buffer[16];
+    double start;
+    int i;
+
+    if (iterations <= 0 || n_fillers < 0) {
+        fprintf(stderr, "usage: %s [millions of calls] [plugins registered before]\n", argv[0]);
+        return 1;
+    }
+
+    gfal2_context_t context = gfal2_context_new(&error);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    register_plugins(context, n_fillers);
+
+    int fd = gfal2_open(context, "bench://path", O_RDONLY, &error);
+    gfal_file_handle fh = gfal_plugin_openG(context, "bench://path", O_RDONLY, 0, &error);
+    if (fd <= 0 || fh == NULL) {
+        fprintf(stderr, "Could not open the file: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    start = now();
+    for (i = 0; i < iterations; ++i)
+        gfal2_pread(context, fd, buffer, sizeof(buffer), 0, NULL);
+    report("gfal2_pread", iterations, now() - start);
+
+    start = now();
+    for (i = 0; i < iterations; ++i)
+        gfal_plugin_map_file_handle(context, fh, NULL);
+    report("bound handle", iterations, now() - start);
+
+    start = now();
+    for (i = 0; i < iterations; ++i) {
+        fh->plugin = NULL;
+        gfal_plugin_map_file_handle(context, fh, NULL);
+    }
+    report("lookup by name", iterations, now() - start);
+
+    gfal_plugin_closeG(context, fh, NULL);
+    gfal2_close(context, fd, NULL);
+    gfal2_context_free(context);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// How the file descriptor lookups scale with the number of threads
+// usage: gfal_fd_bind_benchmark [millions of lookups] [max threads]
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_file_handler_container.h>
+
+#define MAX_THREADS 64
+
+
+typedef struct {
+    gfal_file_handle_container container;
+    int fd;
+    long iterations;
+    long failures;
+} bind_worker_t;
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void *bind_worker(void *data)
+{
+    bind_worker_t *worker = data;
+    long i;
+    for (i = 0; i < worker->iterations; ++i) {
+        if (gfal_file_handle_bind(worker->container, worker->fd, NULL) == NULL)
+            ++worker->failures;
+    }
+    return NULL;
+}
+
+
+int main(int argc, char **argv)
+{
+    long total_lookups = ((argc > 1) ? atol(argv[1]) : 4) * 1000000;
+    int max_threads = (argc > 2) ? atoi(argv[2]) : MAX_THREADS;
+    int dummy[MAX_THREADS];
+    int fds[MAX_THREADS];
+    int n_threads, i;
+
+    if (total_lookups <= 0 || max_threads <= 0 || max_threads > MAX_THREADS) {
+        fprintf(stderr, "usage: %s [millions of lookups] [max threads, up to %d]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    gfal_file_handle_container container = gfal_file_descriptor_handle_create(NULL);
+    for (i = 0; i < max_threads; ++i)
+        fds[i] = gfal_add_new_file_desc(container, &dummy[i], NULL);
+
+    for (n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+        pthread_t threads[MAX_THREADS];
+        bind_worker_t workers[MAX_THREADS];
+        long failures = 0;
+
+        double start = now();
+        for (i = 0; i < n_threads; ++i) {
+            workers[i].container = container;
+            workers[i].fd = fds[i];
+            workers[i].iterations = total_lookups / n_threads;
+            workers[i].failures = 0;
+            pthread_create(&threads[i], NULL, bind_worker, &workers[i]);
+        }
+        for (i = 0; i < n_threads; ++i) {
+            pthread_join(threads[i], NULL);
+            failures += workers[i].failures;
+        }
+        double elapsed = now() - start;
+
+        printf("%2d threads: %8.2f Mlookups/s", n_threads, total_lookups / elapsed / 1000000.0);
+        if (failures)
+            printf(" (%ld failed)", failures);
+        printf("\n");
+    }
+
+    gfal_file_descriptor_handle_destroy(container);
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Time spent by the thread that logs, in bursts that fit the ring, for each logging mode
+// usage: gfal_logger_benchmark [bursts] [messages per burst]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <gfal_api.h>
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void report(const char *name, int messages, double elapsed)
+{
+    printf("%-14s %8.1f ns/message\n", name, elapsed * 1e9 / messages);
+}
+
+
+static void discard_handler(const gchar *log_domain, GLogLevelFlags log_level,
+    const gchar *message, gpointer user_data)
+{
+}
+
+
+int main(int argc, char **argv)
+{
+    int bursts = (argc > 1) ? atoi(argv[1]) : 200;
+    int burst_size = (argc > 2) ? atoi(argv[2]) : 500;
+    const char *modes[] = {"sync", "async", "async binary"};
+    double start, logging;
+    int mode, burst, i;
+
+    if (bursts <= 0 || burst_size <= 0) {
+        fprintf(stderr, "usage: %s [bursts] [messages per burst]\n", argv[0]);
+        return 1;
+    }
+
+    gfal2_log_set_handler(discard_handler, NULL);
+    gfal2_log_set_level(G_LOG_LEVEL_DEBUG);
+
+    for (mode = GFAL2_LOG_SYNC; mode <= GFAL2_LOG_ASYNC_BINARY; ++mode) {
+        if (gfal2_log_set_mode((gfal2_log_mode_t)mode) != 0) {
+            fprintf(stderr, "could not switch to the %s mode\n", modes[mode]);
+            return 1;
+        }
+        logging = 0;
+        for (burst = 0; burst < bursts; ++burst) {
+            start = now();
+            for (i = 0; i < burst_size; ++i) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "read %zu bytes at %lld from %s (%.2f MB/s)",
+                    (size_t)4096, (long long)i * 4096, "gsiftp://host.cern.ch/path/to/file", 12.5);
+            }
+            logging += now() - start;
+            // not counted, as the consumer would catch up between bursts
+            gfal2_log_flush();
+        }
+        report(modes[mode], bursts * burst_size, logging);
+    }
+    gfal2_log_set_mode(GFAL2_LOG_SYNC);
+
+    gfal2_log_set_level(G_LOG_LEVEL_WARNING);
+    start = now();
+    for (i = 0; i < bursts * burst_size; ++i) {
+        GFAL2_LOG_DOMAIN("LOGGER BENCHMARK", G_LOG_LEVEL_DEBUG, "read %d", i);
+    }
+    report("disabled", bursts * burst_size, now() - start);
+    return 0;
+}
@@ -20,6 +20,8 @@
 
 #include <gfal_api.h>
 #include <gtest/gtest.h>
+#include <pthread.h>
+#include <unistd.h>
 
 
 TEST(gfalCancel, test_cancel_simple){
@@ -65,3 +67,206 @@ TEST(gfalGlobal, testCancelCallback){
 }
 
 
+
+
+struct CancelWorker {
+    gfal2_context_t context;
+    gfal_operation_t op;
+    volatile gint started;
+    gboolean canceled;
+};
+
+
+// Stands for a plugin operation, running until it is canceled
+static void* cancel_worker(void* data)
+{
+    CancelWorker* w = (CancelWorker*)data;
+    GError* tmp_err = NULL;
+    gfal2_operation_attach(w->op);
+    if (gfal2_start_scope_cancel(w->context, &tmp_err) < 0) {
+        g_error_free(tmp_err);
+        return NULL;
+    }
+    g_atomic_int_set(&w->started, 1);
+    while (!gfal2_is_canceled(w->context))
+        usleep(100);
+    w->canceled = TRUE;
+    gfal2_end_scope_cancel(w->context);
+    gfal2_operation_attach(NULL);
+    return NULL;
+}
+
+
+static void cancel_worker_start(CancelWorker* w, gfal2_context_t c, gfal_operation_t op, pthread_t* th)
+{
+    w->context = c;
+    w->op = op;
+    w->started = 0;
+    w->canceled = FALSE;
+    pthread_create(th, NULL, cancel_worker, w);
+    while (!g_atomic_int_get(&w->started))
+        usleep(100);
+}
+
+
+TEST(gfalCancel, testCancelWaitsForOperations)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    CancelWorker workers[4];
+    pthread_t threads[4];
+    for (int i = 0; i < 4; ++i)
+        cancel_worker_start(&workers[i], c, NULL, &threads[i]);
+
+    ASSERT_EQ(4, gfal2_cancel(c));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(workers[i].canceled);
+        pthread_join(threads[i], NULL);
+    }
+    // the context can be used again
+    ASSERT_FALSE(gfal2_is_canceled(c));
+    gfal2_context_free(c);
+}
+
+
+TEST(gfalCancel, testCancelOperation)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    gfal_operation_t op1 = gfal2_operation_new(c);
+    gfal_operation_t op2 = gfal2_operation_new(c);
+
+    CancelWorker w1, w2;
+    pthread_t th1, th2;
+    cancel_worker_start(&w1, c, op1, &th1);
+    cancel_worker_start(&w2, c, op2, &th2);
+
+    ASSERT_EQ(1, gfal2_operation_cancel(op1));
+    ASSERT_TRUE(w1.canceled);
+    pthread_join(th1, NULL);
+    ASSERT_TRUE(gfal2_operation_is_canceled(op1));
+
+    // the other operation is still running
+    usleep(1000);
+    ASSERT_FALSE(w2.canceled);
+    ASSERT_FALSE(gfal2_is_canceled(c));
+
+    // a canceled token stays canceled
+    gfal_operation_t previous = gfal2_operation_attach(op1);
+    ASSERT_EQ(NULL, previous);
+    ASSERT_EQ(-1, gfal2_start_scope_cancel(c, &tmp_err));
+    ASSERT_EQ(ECANCELED, tmp_err->code);
+    g_clear_error(&tmp_err);
+    gfal2_operation_attach(NULL);
+
+    ASSERT_EQ(1, gfal2_cancel(c));
+    ASSERT_TRUE(w2.canceled);
+    pthread_join(th2, NULL);
+
+    gfal2_operation_free(op1);
+    gfal2_operation_free(op2);
+    gfal2_context_free(c);
+}
+
+
+TEST(gfalCancel, testCancelOperationCallback)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    gfal_operation_t op1 = gfal2_operation_new(c);
+    gfal_operation_t op2 = gfal2_operation_new(c);
+
+    int i1 = 0, i2 = 0, global = 0;
+    gfal2_operation_attach(op1);
+    gfal_cancel_token_t tok1 = gfal2_register_cancel_callback(c, &gfal_cancel_hook_cb_s, &i1);
+    gfal2_operation_attach(op2);
+    gfal_cancel_token_t tok2 = gfal2_register_cancel_callback(c, &gfal_cancel_hook_cb_s, &i2);
+    gfal2_operation_attach(NULL);
+    gfal_cancel_token_t tok = gfal2_register_cancel_callback(c, &gfal_cancel_hook_cb_s, &global);
+
+    ASSERT_EQ(0, gfal2_operation_cancel(op1));
+    ASSERT_EQ(1, i1);
+    ASSERT_EQ(0, i2);
+    ASSERT_EQ(0, global);
+
+    // cancelling the context triggers all of them
+    ASSERT_EQ(0, gfal2_cancel(c));
+    ASSERT_EQ(2, i1);
+    ASSERT_EQ(1, i2);
+    ASSERT_EQ(1, global);
+
+    gfal2_remove_cancel_callback(c, tok1);
+    gfal2_remove_cancel_callback(c, tok2);
+    gfal2_remove_cancel_callback(c, tok);
+    gfal2_operation_free(op1);
+    gfal2_operation_free(op2);
+    gfal2_context_free(c);
+}
+
+
+struct CancelOperation {
+    gfal_operation_t op;
+    volatile gint done;
+    int result;
+};
+
+
+static void* cancel_operation(void* data)
+{
+    CancelOperation* c = (CancelOperation*)data;
+    c->result = gfal2_operation_cancel(c->op);
+    g_atomic_int_set(&c->done, 1);
+    return NULL;
+}
+
+
+// Cancel op from another thread, TRUE if it did not wait for any operation
+static gboolean cancel_operation_idle(gfal_operation_t op)
+{
+    CancelOperation c = {op, 0, -1};
+    pthread_t th;
+    pthread_create(&th, NULL, cancel_operation, &c);
+    for (int i = 0; i < 1000 && !g_atomic_int_get(&c.done); ++i)
+        usleep(1000);
+    if (!g_atomic_int_get(&c.done)) {
+        // still waiting for a scope that will never end
+        pthread_detach(th);
+        return FALSE;
+    }
+    pthread_join(th, NULL);
+    return c.result == 0;
+}
+
+
+// Each scope ends on the operation it began on, whatever is attached meanwhile
+TEST(gfalCancel, testCancelScopeReattach)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    gfal_operation_t op1 = gfal2_operation_new(c);
+    gfal_operation_t op2 = gfal2_operation_new(c);
+
+    gfal2_operation_attach(op1);
+    ASSERT_EQ(0, gfal2_start_scope_cancel(c, &tmp_err));
+    gfal2_operation_attach(op2);
+    ASSERT_EQ(0, gfal2_start_scope_cancel(c, &tmp_err));
+    gfal2_operation_attach(NULL);
+    gfal2_end_scope_cancel(c);
+    gfal2_end_scope_cancel(c);
+
+    ASSERT_TRUE(cancel_operation_idle(op1));
+    ASSERT_TRUE(cancel_operation_idle(op2));
+    ASSERT_EQ(0, gfal2_cancel(c));
+
+    gfal2_operation_free(op1);
+    gfal2_operation_free(op2);
+    gfal2_context_free(c);
+}
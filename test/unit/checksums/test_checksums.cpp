@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/checksums/checksums.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+
+static std::vector<unsigned char> random_data(size_t size, unsigned seed)
+{
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (unsigned char)(seed >> 16);
+    }
+    return data;
+}
+
+
+static std::string stream_checksum(const char *type, const void *data, size_t size, size_t step)
+{
+    char buffer[128];
+    gfal_checksum_stream_t stream = gfal_checksum_stream_new(type);
+    EXPECT_TRUE(stream != NULL) << type;
+    if (stream == NULL)
+        return "";
+    const unsigned char *p = (const unsigned char*)data;
+    for (size_t done = 0; done < size; done += step)
+        gfal_checksum_stream_update(stream, p + done, std::min(step, size - done));
+    EXPECT_EQ(0, gfal_checksum_stream_final(stream, buffer, sizeof(buffer)));
+    gfal_checksum_stream_free(stream);
+    return buffer;
+}
+
+
+// All the implementations must give the same result as zlib, for any length and alignment
+TEST(ChecksumKernels, Adler32)
+{
+    const size_t sizes[] = {0, 1, 31, 32, 33, 63, 64, 65, 5551, 5552, 5553, 100000, (1 << 20) + 7};
+    std::vector<unsigned char> data = random_data((1 << 20) + 64, 42);
+    std::vector<unsigned char> ones((1 << 20) + 64, 0xff);
+
+    const gfal_checksum_kernels_t * const *kernels = gfal_checksum_kernels_supported();
+    ASSERT_TRUE(kernels[0] != NULL);
+    for (; *kernels; ++kernels) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            for (size_t offset = 0; offset < 3; ++offset) {
+                uLong expected = adler32(1, &data[offset], sizes[i]);
+                EXPECT_EQ(expected, (*kernels)->adler32(1, &data[offset], sizes[i]))
+                    << (*kernels)->name << " " << sizes[i] << " " << offset;
+                // the largest sums
+                expected = adler32(1, &ones[offset], sizes[i]);
+                EXPECT_EQ(expected, (*kernels)->adler32(1, &ones[offset], sizes[i]))
+                    << (*kernels)->name << " " << sizes[i] << " " << offset;
+            }
+        }
+        // continuing a previous value
+        EXPECT_EQ(adler32(0xfff0fff0, &data[0], 100000), (*kernels)->adler32(0xfff0fff0, &data[0], 100000));
+    }
+}
+
+
+TEST(ChecksumKernels, Crc32c)
+{
+    const size_t sizes[] = {0, 1, 7, 8, 9, 63, 64, 1000, 100003};
+    std::vector<unsigned char> data = random_data(100016, 7);
+
+    const gfal_checksum_kernels_t * const *kernels = gfal_checksum_kernels_supported();
+    const gfal_checksum_kernels_t *scalar = kernels[0];
+    for (; *kernels; ++kernels) {
+        EXPECT_EQ(0xe3069283, (*kernels)->crc32c(0, (const unsigned char*)"123456789", 9)) << (*kernels)->name;
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            for (size_t offset = 0; offset < 9; offset += 3) {
+                EXPECT_EQ(scalar->crc32c(0, &data[offset], sizes[i]),
+                    (*kernels)->crc32c(0, &data[offset], sizes[i]))
+                    << (*kernels)->name << " " << sizes[i] << " " << offset;
+            }
+        }
+        // in two parts
+        EXPECT_EQ(scalar->crc32c(0, &data[0], 1000),
+            (*kernels)->crc32c((*kernels)->crc32c(0, &data[0], 333), &data[333], 667));
+    }
+}
+
+
+TEST(ChecksumStream, Types)
+{
+    EXPECT_EQ("024d0127", stream_checksum("adler32", "abc", 3, 3));
+    EXPECT_EQ("891568578", stream_checksum("crc32", "abc", 3, 3));
+    EXPECT_EQ("e3069283", stream_checksum("CRC32C", "123456789", 9, 2));
+    EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", stream_checksum("md5", "abc", 3, 1));
+    EXPECT_EQ("a9993e364706816aba3e25717850c26c9cd0d89d", stream_checksum("sha1", "abc", 3, 1));
+    EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        stream_checksum("SHA256", "abc", 3, 3));
+    EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        stream_checksum("sha256", "", 0, 1));
+    EXPECT_TRUE(gfal_checksum_stream_new("sha512") == NULL);
+}
+
+
+TEST(ChecksumStream, LongMessages)
+{
+    std::string million(1000000, 'a');
+    // the block boundaries must not matter
+    const size_t steps[] = {1000000, 64, 63, 4097};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+        EXPECT_EQ("34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+            stream_checksum("sha1", million.data(), million.size(), steps[i]));
+        EXPECT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+            stream_checksum("sha256", million.data(), million.size(), steps[i]));
+    }
+    const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    EXPECT_EQ("84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+        stream_checksum("sha1", two_blocks, strlen(two_blocks), 5));
+    EXPECT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+        stream_checksum("sha256", two_blocks, strlen(two_blocks), 5));
+}
+
+
+TEST(ChecksumStream, Multiple)
+{
+    const char *types[] = {"adler32", "md5", "sha256", "crc32c", "crc32"};
+    const size_t ntypes = sizeof(types) / sizeof(types[0]);
+    std::vector<unsigned char> data = random_data(3 * 1024 * 1024 + 11, 3);
+
+    gfal_checksum_stream_t stream = gfal_checksum_stream_new_multiple(types, ntypes);
+    ASSERT_TRUE(stream != NULL);
+    gfal_checksum_stream_update(stream, &data[0], 1000);
+    gfal_checksum_stream_update(stream, &data[1000], data.size() - 1000);
+
+    char buffer[128];
+    for (size_t i = 0; i < ntypes; ++i) {
+        ASSERT_EQ(0, gfal_checksum_stream_final_nth(stream, i, buffer, sizeof(buffer)));
+        EXPECT_EQ(stream_checksum(types[i], &data[0], data.size(), data.size()), buffer) << types[i];
+    }
+    EXPECT_EQ(-1, gfal_checksum_stream_final_nth(stream, ntypes, buffer, sizeof(buffer)));
+    EXPECT_EQ(-1, gfal_checksum_stream_final_nth(stream, 2, buffer, 64));
+
+    gfal_checksum_stream_reset(stream);
+    ASSERT_EQ(0, gfal_checksum_stream_final(stream, buffer, sizeof(buffer)));
+    EXPECT_STREQ("00000001", buffer);
+    gfal_checksum_stream_free(stream);
+
+    const char *unsupported[] = {"adler32", "whirlpool"};
+    EXPECT_TRUE(gfal_checksum_stream_new_multiple(unsupported, 2) == NULL);
+}
+
+
+TEST(ChecksumKernels, Crc32cCombine)
+{
+    std::vector<unsigned char> data = random_data(100000, 11);
+    const unsigned long whole = gfal_crc32c(0, &data[0], data.size());
+
+    const size_t splits[] = {0, 1, 4096, 65537, 99999, 100000};
+    for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); ++i) {
+        unsigned long first = gfal_crc32c(0, &data[0], splits[i]);
+        unsigned long second = gfal_crc32c(0, &data[splits[i]], data.size() - splits[i]);
+        EXPECT_EQ(whole, gfal_crc32c_combine(first, second, data.size() - splits[i])) << splits[i];
+    }
+}
@@ -119,4 +119,66 @@ TEST_F(ConfigFixture, KeyList)
     EXPECT_EQ(NULL, keys[2]);
 
     g_strfreev(keys);
-}
\ No newline at end of file
+}
+
+TEST_F(ConfigFixture, DefaultsFollowChanges)
+{
+    GError *error = NULL;
+
+    // missing, so the default is returned, every time
+    EXPECT_EQ(10, gfal2_get_opt_integer_with_default(context, "SNAPSHOT", "INT", 10));
+    EXPECT_EQ(20, gfal2_get_opt_integer_with_default(context, "SNAPSHOT", "INT", 20));
+    EXPECT_TRUE(gfal2_get_opt_boolean_with_default(context, "SNAPSHOT", "BOOL", TRUE));
+
+    gfal2_set_opt_integer(context, "SNAPSHOT", "INT", 42, &error);
+    gfal2_set_opt_boolean(context, "SNAPSHOT", "BOOL", FALSE, &error);
+    EXPECT_EQ(42, gfal2_get_opt_integer_with_default(context, "SNAPSHOT", "INT", 10));
+    EXPECT_FALSE(gfal2_get_opt_boolean_with_default(context, "SNAPSHOT", "BOOL", TRUE));
+
+    gfal2_set_opt_string(context, "SNAPSHOT", "STRING", "first", &error);
+    gchar *value = gfal2_get_opt_string_with_default(context, "SNAPSHOT", "STRING", "default");
+    EXPECT_STREQ("first", value);
+    g_free(value);
+    gfal2_set_opt_string(context, "SNAPSHOT", "STRING", "second", &error);
+    value = gfal2_get_opt_string_with_default(context, "SNAPSHOT", "STRING", "default");
+    EXPECT_STREQ("second", value);
+    g_free(value);
+
+    const gchar *list[] = {"a", "b", "c"};
+    gsize length = 0;
+    gfal2_set_opt_string_list(context, "SNAPSHOT", "LIST", list, 3, &error);
+    gchar **values = gfal2_get_opt_string_list_with_default(context, "SNAPSHOT", "LIST", &length, NULL);
+    EXPECT_EQ(3, length);
+    EXPECT_STREQ("c", values[2]);
+    g_strfreev(values);
+
+    gfal2_remove_opt(context, "SNAPSHOT", "INT", &error);
+    EXPECT_EQ(10, gfal2_get_opt_integer_with_default(context, "SNAPSHOT", "INT", 10));
+
+    // an invalid value falls back to the default too
+    gfal2_set_opt_string(context, "SNAPSHOT", "INT", "abc", &error);
+    EXPECT_EQ(10, gfal2_get_opt_integer_with_default(context, "SNAPSHOT", "INT", 10));
+    g_clear_error(&error);
+}
+
+
+TEST_F(ConfigFixture, Generation)
+{
+    GError *error = NULL;
+
+    gint generation = gfal2_get_opt_generation(context);
+    gfal2_get_opt_integer_with_default(context, "SNAPSHOT", "INT", 10);
+    EXPECT_EQ(generation, gfal2_get_opt_generation(context));
+
+    gfal2_set_opt_integer(context, "SNAPSHOT", "INT", 5, &error);
+    EXPECT_NE(generation, gfal2_get_opt_generation(context));
+
+    // setting the same value again is not a change
+    generation = gfal2_get_opt_generation(context);
+    gfal2_set_opt_integer(context, "SNAPSHOT", "INT", 5, &error);
+    EXPECT_EQ(generation, gfal2_get_opt_generation(context));
+
+    gfal2_remove_opt(context, "SNAPSHOT", "INT", &error);
+    EXPECT_NE(generation, gfal2_get_opt_generation(context));
+    g_clear_error(&error);
+}
@@ -16,6 +16,8 @@
 
 #include <gfal_api.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 #include "common/gfal_gtest_asserts.h"
 
 class CredTest: public testing::Test {
@@ -172,3 +174,134 @@ TEST_F(CredTest, copy)
 
     gfal2_context_free(new_context);
 }
+
+
+static void collect_callback(const char *url_prefix, const gfal2_cred_t *cred, void *user_data)
+{
+    std::vector<std::string> *prefixes = (std::vector<std::string>*)user_data;
+    prefixes->push_back(std::string(url_prefix) + " " + cred->type);
+}
+
+
+TEST_F(CredTest, foreach_order)
+{
+    GError *error = NULL;
+    const char *prefixes[] = {
+        "gsiftp://host.com/path", "gsiftp://host.com/path/subdir", "gsiftp://host.com/other",
+        "davs://host.com/", "gsiftp://host.com/pa", ""
+    };
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+        int ret = gfal2_cred_set(context, prefixes[i], x509, &error);
+        ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    }
+    int ret = gfal2_cred_set(context, "gsiftp://host.com/path", user, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // Longest prefixes first, then by type
+    std::vector<std::string> visited;
+    gfal2_cred_foreach(context, collect_callback, &visited);
+    ASSERT_EQ(7, visited.size());
+    ASSERT_EQ("gsiftp://host.com/path/subdir X509_CERT", visited[0]);
+    ASSERT_EQ("gsiftp://host.com/path USER", visited[1]);
+    ASSERT_EQ("gsiftp://host.com/path X509_CERT", visited[2]);
+    ASSERT_EQ("gsiftp://host.com/pa X509_CERT", visited[3]);
+    ASSERT_EQ("gsiftp://host.com/other X509_CERT", visited[4]);
+    ASSERT_EQ("davs://host.com/ X509_CERT", visited[5]);
+    ASSERT_EQ(" X509_CERT", visited[6]);
+}
+
+
+TEST_F(CredTest, remove)
+{
+    GError *error = NULL;
+    int ret = gfal2_cred_set(context, "gsiftp://host.com/path", x509, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_cred_set(context, "gsiftp://host.com/path/subdir", x509_2, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    ret = gfal2_cred_set(context, "gsiftp://host.com/path/subdir", NULL, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    const char *baseurl = NULL;
+    char *resp = gfal2_cred_get(context, GFAL_CRED_X509_CERT, "gsiftp://host.com/path/subdir/file", &baseurl, &error);
+    ASSERT_STREQ(resp, x509->value);
+    ASSERT_STREQ("gsiftp://host.com/path", baseurl);
+    g_free(resp);
+
+    ret = gfal2_cred_set(context, "gsiftp://host.com/path", NULL, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    resp = gfal2_cred_get(context, GFAL_CRED_USER, "gsiftp://host.com/path/subdir/file", &baseurl, &error);
+    ASSERT_EQ(NULL, resp);
+    ASSERT_STREQ("", baseurl);
+}
+
+
+TEST_F(CredTest, lookup_release)
+{
+    GError *error = NULL;
+    int ret = gfal2_cred_set(context, "gsiftp://host.com/path", x509, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    const char *baseurl = NULL;
+    const char *value = gfal2_cred_lookup(context, GFAL_CRED_X509_CERT, "gsiftp://host.com/path/file", &baseurl, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+    ASSERT_STREQ(x509->value, value);
+    ASSERT_STREQ("gsiftp://host.com/path", baseurl);
+
+    // The value outlives the mapping
+    ret = gfal2_cred_set(context, "gsiftp://host.com/path", x509_2, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_cred_clean(context, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_STREQ(x509->value, value);
+    ASSERT_STREQ("gsiftp://host.com/path", baseurl);
+    gfal2_cred_release(value);
+
+    // Fallback to the configuration
+    ret = gfal2_set_opt_string(context, "X509", "CERT", "/path/to/my/cert", &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    value = gfal2_cred_lookup(context, GFAL_CRED_X509_CERT, "gsiftp://host.com/path/file", &baseurl, &error);
+    ASSERT_STREQ("/path/to/my/cert", value);
+    ASSERT_STREQ("", baseurl);
+    gfal2_cred_release(value);
+
+    value = gfal2_cred_lookup(context, GFAL_CRED_USER, "gsiftp://host.com/path/file", &baseurl, &error);
+    ASSERT_EQ(NULL, value);
+    gfal2_cred_release(value);
+}
+
+
+// The longest prefix wins among many
+TEST_F(CredTest, lookup_many_prefixes)
+{
+    const int n_prefixes = 5000;
+    GError *error = NULL;
+
+    for (int i = 0; i < n_prefixes; ++i) {
+        char prefix[128], token[32];
+        snprintf(prefix, sizeof(prefix), "davs://storage%d.example.com:443/vo/data/%d", i % 50, i);
+        snprintf(token, sizeof(token), "token-%d", i);
+        gfal2_cred_t *cred = gfal2_cred_new(GFAL_CRED_BEARER, token);
+        int ret = gfal2_cred_set(context, prefix, cred, &error);
+        gfal2_cred_free(cred);
+        ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    }
+    gfal2_cred_t *cred = gfal2_cred_new(GFAL_CRED_BEARER, "token-host");
+    int ret = gfal2_cred_set(context, "davs://storage17.example.com:443", cred, &error);
+    gfal2_cred_free(cred);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    const char *baseurl = NULL;
+    const char *value = gfal2_cred_lookup(context, GFAL_CRED_BEARER,
+        "davs://storage17.example.com:443/vo/data/4967/file.root", &baseurl, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+    ASSERT_STREQ("token-4967", value);
+    ASSERT_STREQ("davs://storage17.example.com:443/vo/data/4967", baseurl);
+    gfal2_cred_release(value);
+
+    value = gfal2_cred_lookup(context, GFAL_CRED_BEARER,
+        "davs://storage17.example.com:443/other/file.root", &baseurl, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+    ASSERT_STREQ("token-host", value);
+    gfal2_cred_release(value);
+}
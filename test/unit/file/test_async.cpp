@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <set>
+#include <vector>
+
+
+// Plugin completing the stat operations natively, from its own thread
+static GAsyncQueue *native_pending = NULL;
+
+
+static const char *async_plugin_get_name(void)
+{
+    return "ASYNC PLUGIN";
+}
+
+
+static gboolean async_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "async://", 8) == 0;
+}
+
+
+static int async_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_size = strlen(url);
+    return 0;
+}
+
+
+static int async_plugin_mkdir(plugin_handle plugin_data, const char *url, mode_t mode, gboolean pflag, GError **err)
+{
+    return 0;
+}
+
+
+static int async_plugin_stat_list(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+    struct stat* buffs, GError** errors)
+{
+    int res = 0;
+    for (int i = 0; i < nbfiles; ++i) {
+        if (strstr(urls[i], "missing")) {
+            gfal2_set_error(&errors[i], g_quark_from_static_string("ASYNC PLUGIN"), ENOENT, __func__, "No such file");
+            res = -1;
+        }
+        else {
+            memset(&buffs[i], 0, sizeof(buffs[i]));
+            buffs[i].st_size = i;
+        }
+    }
+    return res;
+}
+
+
+static int async_plugin_submit(plugin_handle plugin_data, gfal2_async_op_t op, GError **err)
+{
+    const gfal2_async_args_t *args = gfal2_async_get_args(op);
+    if (args->type != GFAL_ASYNC_STAT) {
+        gfal2_set_error(err, g_quark_from_static_string("ASYNC PLUGIN"), ENOSYS, __func__, "Not supported");
+        return -1;
+    }
+    g_async_queue_push(native_pending, op);
+    return 0;
+}
+
+
+static gpointer async_plugin_thread(gpointer data)
+{
+    gfal2_async_op_t op;
+    while ((op = (gfal2_async_op_t)g_async_queue_pop(native_pending)) != (gfal2_async_op_t)data) {
+        const gfal2_async_args_t *args = gfal2_async_get_args(op);
+        memset(args->st, 0, sizeof(*args->st));
+        args->st->st_size = strlen(args->url);
+        args->st->st_mode = S_IFREG;
+        gfal2_async_complete(op, 0, NULL);
+    }
+    return NULL;
+}
+
+
+// Plugin without native support, so the operations are run by the thread pool
+static const char *sync_plugin_get_name(void)
+{
+    return "SYNC PLUGIN";
+}
+
+
+static gboolean sync_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "sync://", 7) == 0;
+}
+
+
+// slow stats running at the same time, and the most seen at once
+static volatile gint slow_in_flight = 0;
+static volatile gint slow_max_in_flight = 0;
+
+
+static int sync_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    if (strstr(url, "slow")) {
+        gint in_flight = g_atomic_int_add(&slow_in_flight, 1) + 1;
+        gint max_in_flight = g_atomic_int_get(&slow_max_in_flight);
+        while (in_flight > max_in_flight &&
+               !g_atomic_int_compare_and_exchange(&slow_max_in_flight, max_in_flight, in_flight)) {
+            max_in_flight = g_atomic_int_get(&slow_max_in_flight);
+        }
+        usleep(100000);
+        g_atomic_int_add(&slow_in_flight, -1);
+    }
+    if (strstr(url, "missing")) {
+        gfal2_set_error(err, g_quark_from_static_string("SYNC PLUGIN"), ENOENT, __func__, "No such file");
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_size = strlen(url);
+    return 0;
+}
+
+
+static gfal_file_handle sync_plugin_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    return gfal_file_handle_new(sync_plugin_get_name(), NULL);
+}
+
+
+static volatile bool slow_pread_done = false;
+
+
+static ssize_t sync_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err)
+{
+    if (offset == 1000) {
+        usleep(100000);
+        slow_pread_done = true;
+    }
+    memset(buff, 'a' + (offset % 26), count);
+    return count;
+}
+
+
+static int sync_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class AsyncTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfal2_async_queue_t queue;
+    GThread *native_thread;
+
+public:
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = async_plugin_get_name;
+        plugin.check_plugin_url = async_plugin_url;
+        plugin.statG = async_plugin_stat;
+        plugin.mkdirpG = async_plugin_mkdir;
+        plugin.async_submitG = async_plugin_submit;
+        plugin.statG_list = async_plugin_stat_list;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = sync_plugin_get_name;
+        plugin.check_plugin_url = sync_plugin_url;
+        plugin.statG = sync_plugin_stat;
+        plugin.openG = sync_plugin_open;
+        plugin.preadG = sync_plugin_pread;
+        plugin.closeG = sync_plugin_close;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+        native_pending = g_async_queue_new();
+        native_thread = g_thread_create(async_plugin_thread, &native_thread, TRUE, NULL);
+
+        queue = gfal2_async_queue_new(context, &error);
+        ASSERT_NE((void*)NULL, queue);
+        slow_in_flight = slow_max_in_flight = 0;
+    }
+
+    virtual void TearDown() {
+        gfal2_async_queue_free(queue);
+        g_async_queue_push(native_pending, &native_thread);
+        g_thread_join(native_thread);
+        g_async_queue_unref(native_pending);
+        gfal2_context_free(context);
+    }
+};
+
+
+TEST_F(AsyncTest, NativeStat)
+{
+    const int n_ops = 1000;
+    GError *error = NULL;
+    std::vector<struct stat> buffers(n_ops);
+
+    for (int i = 0; i < n_ops; ++i) {
+        char url[64];
+        snprintf(url, sizeof(url), "async://host/%d", i);
+        ASSERT_NE((void*)NULL, gfal2_async_stat(queue, url, &buffers[i], GINT_TO_POINTER(i), &error));
+    }
+
+    std::set<int> done;
+    gfal2_async_op_t op;
+    while ((op = gfal2_async_wait(queue, -1)) != NULL) {
+        int i = GPOINTER_TO_INT(gfal2_async_get_user_data(op));
+        ASSERT_EQ(GFAL_ASYNC_STAT, gfal2_async_get_type(op));
+        ASSERT_EQ(0, gfal2_async_get_result(op, &error));
+        ASSERT_EQ(NULL, error);
+        char url[64];
+        snprintf(url, sizeof(url), "async://host/%d", i);
+        ASSERT_EQ(strlen(url), buffers[i].st_size);
+        done.insert(i);
+        gfal2_async_op_free(op);
+    }
+    ASSERT_EQ(n_ops, done.size());
+    ASSERT_EQ(0, gfal2_async_pending(queue));
+}
+
+
+TEST_F(AsyncTest, Fallback)
+{
+    GError *error = NULL;
+    struct stat st[8];
+
+    // run in parallel by the thread pool
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_NE((void*)NULL, gfal2_async_stat(queue, "sync://host/slow", &st[i], NULL, &error));
+    }
+    ASSERT_EQ(8, gfal2_async_pending(queue));
+    for (int i = 0; i < 8; ++i) {
+        gfal2_async_op_t op = gfal2_async_wait(queue, -1);
+        ASSERT_NE((void*)NULL, op);
+        ASSERT_EQ(0, gfal2_async_get_result(op, &error));
+        gfal2_async_op_free(op);
+    }
+    ASSERT_GT(slow_max_in_flight, 1);
+
+    // the plugin does not support mkdir natively
+    ASSERT_NE((void*)NULL, gfal2_async_mkdir(queue, "async://host/dir", 0755, NULL, &error));
+    gfal2_async_op_t op = gfal2_async_wait(queue, -1);
+    ASSERT_EQ(GFAL_ASYNC_MKDIR, gfal2_async_get_type(op));
+    ASSERT_EQ(0, gfal2_async_get_result(op, &error));
+    gfal2_async_op_free(op);
+
+    // errors are reported by the operation
+    ASSERT_NE((void*)NULL, gfal2_async_stat(queue, "sync://host/missing", &st[0], NULL, &error));
+    op = gfal2_async_wait(queue, -1);
+    ASSERT_EQ(-1, gfal2_async_get_result(op, &error));
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(ENOENT, error->code);
+    g_clear_error(&error);
+    gfal2_async_op_free(op);
+
+    ASSERT_NE((void*)NULL, gfal2_async_unlink(queue, "nobody://host/file", NULL, &error));
+    op = gfal2_async_wait(queue, -1);
+    ASSERT_EQ(-1, gfal2_async_get_result(op, &error));
+    ASSERT_NE((void*)NULL, error);
+    g_clear_error(&error);
+    gfal2_async_op_free(op);
+
+    // nothing in flight
+    ASSERT_EQ(NULL, gfal2_async_wait(queue, -1));
+    ASSERT_EQ(NULL, gfal2_async_poll(queue));
+}
+
+
+TEST_F(AsyncTest, OpenRead)
+{
+    GError *error = NULL;
+    char buffer[4][16];
+
+    ASSERT_NE((void*)NULL, gfal2_async_open(queue, "sync://host/file", O_RDONLY, 0, NULL, &error));
+    gfal2_async_op_t op = gfal2_async_wait(queue, -1);
+    int fd = gfal2_async_get_result(op, &error);
+    ASSERT_GT(fd, 0);
+    gfal2_async_op_free(op);
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_NE((void*)NULL, gfal2_async_pread(queue, fd, buffer[i], sizeof(buffer[i]), i, buffer[i], &error));
+    }
+    while ((op = gfal2_async_wait(queue, -1)) != NULL) {
+        char *b = (char*)gfal2_async_get_user_data(op);
+        ASSERT_EQ(sizeof(buffer[0]), gfal2_async_get_result(op, &error));
+        ASSERT_EQ('a' + (b - buffer[0]) / sizeof(buffer[0]), b[0]);
+        gfal2_async_op_free(op);
+    }
+
+    ASSERT_EQ(NULL, gfal2_async_pread(queue, 12345, buffer[0], sizeof(buffer[0]), 0, NULL, &error));
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(EBADF, error->code);
+    g_clear_error(&error);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(AsyncTest, CloseDuringRead)
+{
+    GError *error = NULL;
+    char buffer[16];
+
+    ASSERT_NE((void*)NULL, gfal2_async_open(queue, "sync://host/file", O_RDONLY, 0, NULL, &error));
+    gfal2_async_op_t op = gfal2_async_wait(queue, -1);
+    int fd = gfal2_async_get_result(op, &error);
+    ASSERT_GT(fd, 0);
+    gfal2_async_op_free(op);
+
+    // the read keeps the handle until it completes
+    slow_pread_done = false;
+    ASSERT_NE((void*)NULL, gfal2_async_pread(queue, fd, buffer, sizeof(buffer), 1000, NULL, &error));
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+    EXPECT_TRUE(slow_pread_done);
+
+    op = gfal2_async_wait(queue, -1);
+    ASSERT_NE((void*)NULL, op);
+    ASSERT_EQ(sizeof(buffer), gfal2_async_get_result(op, &error));
+    gfal2_async_op_free(op);
+
+    // and fd is closed
+    ASSERT_EQ(NULL, gfal2_async_pread(queue, fd, buffer, sizeof(buffer), 0, NULL, &error));
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(EBADF, error->code);
+    g_clear_error(&error);
+}
+
+
+TEST_F(AsyncTest, Cancel)
+{
+    GError *error = NULL;
+    struct stat st;
+
+    // a single thread, so the second operation waits for the first one
+    gfal2_async_queue_free(queue);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_ASYNC_THREADS, 1, NULL);
+    queue = gfal2_async_queue_new(context, &error);
+
+    gfal2_async_op_t slow = gfal2_async_stat(queue, "sync://host/slow", &st, NULL, &error);
+    gfal2_async_op_t canceled = gfal2_async_stat(queue, "sync://host/file", &st, NULL, &error);
+    ASSERT_NE((void*)NULL, slow);
+    ASSERT_NE((void*)NULL, canceled);
+    gfal2_async_cancel(canceled);
+
+    ASSERT_EQ(NULL, gfal2_async_wait(queue, 10));
+
+    gfal2_async_op_t op;
+    while ((op = gfal2_async_wait(queue, -1)) != NULL) {
+        if (op == canceled) {
+            ASSERT_EQ(-1, gfal2_async_get_result(op, &error));
+            ASSERT_NE((void*)NULL, error);
+            ASSERT_EQ(ECANCELED, error->code);
+            g_clear_error(&error);
+        }
+        else {
+            ASSERT_EQ(0, gfal2_async_get_result(op, &error));
+        }
+        gfal2_async_op_free(op);
+    }
+}
+
+
+TEST_F(AsyncTest, StatListNative)
+{
+    const char *urls[] = {"async://host/a", "async://host/missing", "async://host/c"};
+    struct stat st[3];
+    GError *errors[3] = {NULL, NULL, NULL};
+
+    ASSERT_LT(gfal2_stat_list(context, 3, urls, st, errors), 0);
+    ASSERT_EQ(NULL, errors[0]);
+    ASSERT_EQ(0, st[0].st_size);
+    ASSERT_NE((void*)NULL, errors[1]);
+    ASSERT_EQ(ENOENT, errors[1]->code);
+    ASSERT_EQ(NULL, errors[2]);
+    ASSERT_EQ(2, st[2].st_size);
+    g_clear_error(&errors[1]);
+}
+
+
+TEST_F(AsyncTest, StatListFallback)
+{
+    const int n_files = 8;
+    const char *urls[n_files];
+    struct stat st[n_files];
+    GError *errors[n_files];
+
+    for (int i = 0; i < n_files; ++i) {
+        urls[i] = (i == 3) ? "sync://host/missing" : "sync://host/slow";
+        errors[i] = NULL;
+    }
+
+    // run in parallel
+    ASSERT_LT(gfal2_stat_list(context, n_files, urls, st, errors), 0);
+    ASSERT_GT(slow_max_in_flight, 1);
+
+    for (int i = 0; i < n_files; ++i) {
+        if (i == 3) {
+            ASSERT_NE((void*)NULL, errors[i]);
+            ASSERT_EQ(ENOENT, errors[i]->code);
+            g_clear_error(&errors[i]);
+        }
+        else {
+            ASSERT_EQ(NULL, errors[i]);
+            ASSERT_EQ(strlen(urls[i]), st[i].st_size);
+        }
+    }
+
+    // all good
+    urls[3] = "sync://host/other";
+    ASSERT_EQ(0, gfal2_stat_list(context, n_files, urls, st, errors));
+    ASSERT_EQ(NULL, errors[3]);
+    ASSERT_EQ(strlen(urls[3]), st[3].st_size);
+
+    // invalid arguments are reported for each file
+    ASSERT_LT(gfal2_stat_list(context, 2, urls, NULL, errors), 0);
+    ASSERT_EQ(EFAULT, errors[0]->code);
+    ASSERT_EQ(EFAULT, errors[1]->code);
+    g_clear_error(&errors[0]);
+    g_clear_error(&errors[1]);
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Files served by the plugin, "chk://host/missing" does not exist
+static off_t file_size = 1000;
+static time_t file_mtime = 1500000000;
+static long file_mtime_nsec = 123456789;
+static int checksum_calls = 0;
+// Checksum of the destination, verified by the copy
+static std::string copy_dst_checksum;
+
+
+static const char *chk_plugin_get_name(void)
+{
+    return "CHECKSUM CACHE PLUGIN";
+}
+
+
+static gboolean chk_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "chk://", 6) == 0;
+}
+
+
+static int chk_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    if (strstr(url, "missing")) {
+        gfal2_set_error(err, g_quark_from_static_string("CHECKSUM CACHE PLUGIN"), ENOENT, __func__, "Not found");
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    buf->st_size = file_size;
+    buf->st_mtime = file_mtime;
+    buf->st_mtim.tv_nsec = file_mtime_nsec;
+    return 0;
+}
+
+
+// The value changes on each call, so a cached one is told apart
+static int chk_plugin_checksum(plugin_handle data, const char *url, const char *check_type,
+    char *checksum_buffer, size_t buffer_length, off_t start_offset, size_t data_length,
+    GError **err)
+{
+    ++checksum_calls;
+    snprintf(checksum_buffer, buffer_length, "%s-%d", check_type, checksum_calls);
+    return 0;
+}
+
+
+static int chk_plugin_check_copy(plugin_handle plugin_data, gfal2_context_t context,
+    const char *src, const char *dst, gfal_url2_check check)
+{
+    return strncmp(src, "chk://", 6) == 0 && strncmp(dst, "chk://", 6) == 0;
+}
+
+
+static int chk_plugin_copy(plugin_handle plugin_data, gfal2_context_t context, gfalt_params_t params,
+    const char *src, const char *dst, GError **err)
+{
+    char buffer[64];
+    if (gfal2_checksum(context, dst, "adler32", 0, 0, buffer, sizeof(buffer), err) < 0) {
+        return -1;
+    }
+    copy_dst_checksum = buffer;
+    return 0;
+}
+
+
+static gfal2_context_t chk_context_new(const char *cache_file)
+{
+    GError *error = NULL;
+    gfal2_context_t context = gfal2_context_new(&error);
+    if (context == NULL) {
+        return NULL;
+    }
+    gfal_plugin_interface plugin;
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = chk_plugin_get_name;
+    plugin.check_plugin_url = chk_plugin_url;
+    plugin.statG = chk_plugin_stat;
+    plugin.checksum_calcG = chk_plugin_checksum;
+    plugin.check_plugin_url_transfer = chk_plugin_check_copy;
+    plugin.copy_file = chk_plugin_copy;
+    gfal2_register_plugin(context, &plugin, NULL);
+    gfal2_set_opt_boolean(context, "CORE", "CHECKSUM_CACHE", TRUE, NULL);
+    if (cache_file) {
+        gfal2_set_opt_string(context, "CORE", "CHECKSUM_CACHE_FILE", cache_file, NULL);
+    }
+    return context;
+}
+
+
+class ChecksumCacheTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    char url[64];
+
+public:
+    virtual void SetUp() {
+        // the in memory cache is shared by the whole process, so each test has its own url
+        static int test_number = 0;
+        snprintf(url, sizeof(url), "chk://host/file%d", ++test_number);
+        context = chk_context_new(NULL);
+        ASSERT_NE((void*)NULL, context);
+        checksum_calls = 0;
+        file_size = 1000;
+        file_mtime = 1500000000;
+        file_mtime_nsec = 123456789;
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+
+    std::string checksum(const char *target, const char *type = "adler32", off_t offset = 0, size_t length = 0) {
+        GError *error = NULL;
+        char buffer[64];
+        int ret = gfal2_checksum(context, target, type, offset, length, buffer, sizeof(buffer), &error);
+        EXPECT_EQ(0, ret);
+        EXPECT_EQ((void*)NULL, error);
+        g_clear_error(&error);
+        return buffer;
+    }
+};
+
+
+TEST_F(ChecksumCacheTest, Disabled)
+{
+    gfal2_set_opt_boolean(context, "CORE", "CHECKSUM_CACHE", FALSE, NULL);
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ("adler32-2", checksum(url));
+    EXPECT_EQ(2, checksum_calls);
+}
+
+
+TEST_F(ChecksumCacheTest, Hit)
+{
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ(1, checksum_calls);
+
+    // each type is cached on its own
+    EXPECT_EQ("md5-2", checksum(url, "md5"));
+    EXPECT_EQ("md5-2", checksum(url, "MD5"));
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ(2, checksum_calls);
+
+    // also shared with the other contexts
+    gfal2_context_t other = chk_context_new(NULL);
+    GError *error = NULL;
+    char buffer[64];
+    ASSERT_EQ(0, gfal2_checksum(other, url, "adler32", 0, 0, buffer, sizeof(buffer), &error));
+    EXPECT_STREQ("adler32-1", buffer);
+    gfal2_context_free(other);
+}
+
+
+TEST_F(ChecksumCacheTest, Invalidated)
+{
+    EXPECT_EQ("adler32-1", checksum(url));
+
+    file_mtime += 1;
+    EXPECT_EQ("adler32-2", checksum(url));
+    EXPECT_EQ("adler32-2", checksum(url));
+
+    file_size += 1;
+    EXPECT_EQ("adler32-3", checksum(url));
+    EXPECT_EQ("adler32-3", checksum(url));
+    EXPECT_EQ(3, checksum_calls);
+}
+
+
+TEST_F(ChecksumCacheTest, NotCached)
+{
+    // ranges
+    EXPECT_EQ("adler32-1", checksum(url, "adler32", 10, 0));
+    EXPECT_EQ("adler32-2", checksum(url, "adler32", 0, 10));
+    EXPECT_EQ("adler32-3", checksum(url));
+    EXPECT_EQ("adler32-3", checksum(url));
+
+    // no stat to validate against
+    EXPECT_EQ("adler32-4", checksum("chk://host/missing"));
+    EXPECT_EQ("adler32-5", checksum("chk://host/missing"));
+
+    // no modification time
+    file_mtime = 0;
+    EXPECT_EQ("adler32-6", checksum(url));
+    EXPECT_EQ("adler32-7", checksum(url));
+}
+
+
+TEST_F(ChecksumCacheTest, WholeSeconds)
+{
+    file_mtime_nsec = 0;
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ("adler32-1", checksum(url));
+
+    file_mtime += 1;
+    EXPECT_EQ("adler32-2", checksum(url));
+    EXPECT_EQ("adler32-2", checksum(url));
+
+    // only trusted for a while
+    gfal2_set_opt_integer(context, "CORE", "CHECKSUM_CACHE_COARSE_TTL", 1, NULL);
+    sleep(2);
+    EXPECT_EQ("adler32-3", checksum(url));
+    EXPECT_EQ("adler32-3", checksum(url));
+
+    // a file modified within the current second could still change unnoticed
+    file_mtime = time(NULL) + 1;
+    EXPECT_EQ("adler32-4", checksum(url));
+    EXPECT_EQ("adler32-5", checksum(url));
+
+    // or not at all
+    gfal2_set_opt_integer(context, "CORE", "CHECKSUM_CACHE_COARSE_TTL", 0, NULL);
+    file_mtime = 1500000000;
+    EXPECT_EQ("adler32-6", checksum(url));
+    EXPECT_EQ("adler32-7", checksum(url));
+    EXPECT_EQ(7, checksum_calls);
+}
+
+
+TEST_F(ChecksumCacheTest, CopyDestination)
+{
+    char dst[80];
+    snprintf(dst, sizeof(dst), "%s-copy", url);
+    EXPECT_EQ("adler32-1", checksum(dst));
+    EXPECT_EQ("adler32-1", checksum(dst));
+
+    // the copy verifies what it wrote, not what was there before
+    GError *error = NULL;
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    EXPECT_EQ(0, gfalt_copy_file(context, params, url, dst, &error));
+    EXPECT_EQ((void*)NULL, error);
+    g_clear_error(&error);
+    gfalt_params_handle_delete(params, NULL);
+    EXPECT_EQ("adler32-2", copy_dst_checksum);
+    EXPECT_EQ(2, checksum_calls);
+}
+
+
+TEST_F(ChecksumCacheTest, File)
+{
+    char path[] = "/tmp/gfal2_checksum_cache_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    // stored by another process
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        gfal2_context_t child = chk_context_new(path);
+        GError *error = NULL;
+        char buffer[64];
+        int ret = gfal2_checksum(child, url, "adler32", 0, 0, buffer, sizeof(buffer), &error);
+        _exit(ret == 0 && strcmp(buffer, "adler32-1") == 0 ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+
+    gfal2_set_opt_string(context, "CORE", "CHECKSUM_CACHE_FILE", path, NULL);
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ(0, checksum_calls);
+
+    unlink(path);
+}
+
+
+TEST_F(ChecksumCacheTest, FileReplaced)
+{
+    char path[] = "/tmp/gfal2_checksum_cache_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+
+    // a file of another layout, mapped by another process
+    char junk[4096];
+    memset(junk, 'x', sizeof(junk));
+    ASSERT_EQ((ssize_t)sizeof(junk), write(fd, junk, sizeof(junk)));
+    void *map = mmap(NULL, sizeof(junk), PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT_NE(MAP_FAILED, map);
+    struct stat old_st;
+    ASSERT_EQ(0, fstat(fd, &old_st));
+
+    gfal2_set_opt_string(context, "CORE", "CHECKSUM_CACHE_FILE", path, NULL);
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ("adler32-1", checksum(url));
+    EXPECT_EQ(1, checksum_calls);
+
+    // the new cache is another file, the old one is left alone
+    struct stat new_st;
+    ASSERT_EQ(0, stat(path, &new_st));
+    EXPECT_NE(old_st.st_ino, new_st.st_ino);
+    EXPECT_EQ(0, memcmp(map, junk, sizeof(junk)));
+
+    munmap(map, sizeof(junk));
+    close(fd);
+    unlink(path);
+}
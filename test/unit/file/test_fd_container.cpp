@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <common/gfal_file_handler_container.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+
+
+static int destroyed = 0;
+
+static void count_destroy(gpointer)
+{
+    ++destroyed;
+}
+
+
+TEST(gfalFileDescriptors, denseAllocation)
+{
+    GError *tmp_err = NULL;
+    gfal_file_handle_container c = gfal_file_descriptor_handle_create(NULL);
+    int dummy[3];
+
+    // descriptors are allocated densely from 1
+    for (int i = 0; i < 3; ++i) {
+        int fd = gfal_add_new_file_desc(c, &dummy[i], &tmp_err);
+        ASSERT_EQ(NULL, tmp_err);
+        ASSERT_EQ(i + 1, fd);
+    }
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ((gpointer)&dummy[i], (gpointer)gfal_file_handle_bind(c, i + 1, &tmp_err));
+    }
+
+    gfal_file_descriptor_handle_destroy(c);
+}
+
+
+TEST(gfalFileDescriptors, staleDescriptor)
+{
+    GError *tmp_err = NULL;
+    gfal_file_handle_container c = gfal_file_descriptor_handle_create(NULL);
+    int a, b;
+
+    int fd_a = gfal_add_new_file_desc(c, &a, &tmp_err);
+    ASSERT_TRUE(gfal_remove_file_desc(c, fd_a, &tmp_err));
+
+    // the slot is reused, but not the descriptor
+    int fd_b = gfal_add_new_file_desc(c, &b, &tmp_err);
+    ASSERT_NE(fd_a, fd_b);
+    ASSERT_EQ((gpointer)&b, (gpointer)gfal_file_handle_bind(c, fd_b, &tmp_err));
+
+    ASSERT_EQ(NULL, gfal_file_handle_bind(c, fd_a, &tmp_err));
+    ASSERT_NE((void*)NULL, tmp_err);
+    ASSERT_EQ(EBADF, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    ASSERT_FALSE(gfal_remove_file_desc(c, fd_a, &tmp_err));
+    ASSERT_EQ(EBADF, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    // never allocated
+    ASSERT_EQ(NULL, gfal_file_handle_bind(c, 12345, &tmp_err));
+    g_clear_error(&tmp_err);
+
+    gfal_file_descriptor_handle_destroy(c);
+}
+
+
+TEST(gfalFileDescriptors, destroyer)
+{
+    GError *tmp_err = NULL;
+    gfal_file_handle_container c = gfal_file_descriptor_handle_create(count_destroy);
+    int dummy;
+
+    destroyed = 0;
+    int fd = gfal_add_new_file_desc(c, &dummy, &tmp_err);
+    gfal_add_new_file_desc(c, &dummy, &tmp_err);
+    gfal_remove_file_desc(c, fd, &tmp_err);
+    ASSERT_EQ(1, destroyed);
+    gfal_file_descriptor_handle_destroy(c);
+    ASSERT_EQ(2, destroyed);
+}
+
+
+// The last descriptor can still be found and closed
+TEST(gfalFileDescriptors, tableFull)
+{
+    GError *tmp_err = NULL;
+    gfal_file_handle_container c = gfal_file_descriptor_handle_create(NULL);
+    int dummy;
+
+    int last = 0, count = 0, fd;
+    while ((fd = gfal_add_new_file_desc(c, &dummy, &tmp_err)) > 0) {
+        last = fd;
+        ++count;
+    }
+    ASSERT_EQ(GFAL_FDESC_MAX_SLOTS - 1, count);
+    ASSERT_NE((void*)NULL, tmp_err);
+    ASSERT_EQ(EMFILE, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    ASSERT_EQ((gpointer)&dummy, (gpointer)gfal_file_handle_bind(c, last, &tmp_err));
+    ASSERT_TRUE(gfal_remove_file_desc(c, last, &tmp_err));
+
+    // the slot is free again
+    fd = gfal_add_new_file_desc(c, &dummy, &tmp_err);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ((gpointer)&dummy, (gpointer)gfal_file_handle_bind(c, fd, &tmp_err));
+    ASSERT_TRUE(gfal_remove_file_desc(c, fd, &tmp_err));
+
+    gfal_file_descriptor_handle_destroy(c);
+}
+
+
+struct BindWorker {
+    gfal_file_handle_container container;
+    int fd;
+    gpointer expected;
+    long failures;
+};
+
+
+static void* bind_worker(void* data)
+{
+    BindWorker* worker = static_cast<BindWorker*>(data);
+    for (long i = 0; i < 100000; ++i) {
+        if (gfal_file_handle_bind(worker->container, worker->fd, NULL) != worker->expected)
+            ++worker->failures;
+    }
+    return NULL;
+}
+
+// Lookups from several threads at once, without any lock, all find their handle
+TEST(gfalFileDescriptors, concurrentBind)
+{
+    const int n_threads = 8;
+    gfal_file_handle_container c = gfal_file_descriptor_handle_create(NULL);
+    int dummy[n_threads];
+    pthread_t threads[n_threads];
+    BindWorker workers[n_threads];
+
+    for (int i = 0; i < n_threads; ++i) {
+        workers[i].container = c;
+        workers[i].fd = gfal_add_new_file_desc(c, &dummy[i], NULL);
+        workers[i].expected = &dummy[i];
+        workers[i].failures = 0;
+        ASSERT_GT(workers[i].fd, 0);
+    }
+    for (int i = 0; i < n_threads; ++i) {
+        pthread_create(&threads[i], NULL, bind_worker, &workers[i]);
+    }
+    for (int i = 0; i < n_threads; ++i) {
+        pthread_join(threads[i], NULL);
+        EXPECT_EQ(0, workers[i].failures);
+    }
+
+    gfal_file_descriptor_handle_destroy(c);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <zlib.h>
+
+// Checksums of local files, done by the file plugin built into this test
+extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+
+// The plugin never splits in chunks smaller than its reads, of 2 MB
+static const size_t chunk_size = 2 << 20;
+static const size_t file_size = 5 * chunk_size + 12345;
+// the types that are split between threads
+static const char *types[] = {"adler32", "crc32", "crc32c"};
+
+
+// Bit by bit, so it does not share anything with the implementation under test
+static unsigned long reference_crc32c(const unsigned char *data, size_t size)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+    }
+    return crc ^ 0xffffffff;
+}
+
+
+static std::string reference(const char *type, const std::string &content, size_t offset, size_t length)
+{
+    const unsigned char *data = (const unsigned char*)content.data() + offset;
+    char buffer[64];
+    if (strcmp(type, "adler32") == 0)
+        snprintf(buffer, sizeof(buffer), "%08lx", adler32(adler32(0, NULL, 0), data, length));
+    else if (strcmp(type, "crc32") == 0)
+        snprintf(buffer, sizeof(buffer), "%lu", crc32(crc32(0, NULL, 0), data, length));
+    else
+        snprintf(buffer, sizeof(buffer), "%08lx", reference_crc32c(data, length));
+    return buffer;
+}
+
+
+class FileChecksumTest: public testing::Test {
+protected:
+    static char dir[64];
+    static std::string url;
+    static std::string content;
+    gfal2_context_t context;
+
+public:
+    // written once, the file is several chunks large
+    static void SetUpTestCase() {
+        strcpy(dir, "/tmp/gfal2_filechecksum_XXXXXX");
+        ASSERT_NE((char*)NULL, mkdtemp(dir));
+        url = std::string("file://") + dir + "/file";
+
+        content.resize(file_size);
+        unsigned seed = 42;
+        for (size_t i = 0; i < content.size(); ++i) {
+            seed = seed * 1103515245 + 12345;
+            content[i] = (char)(seed >> 16);
+        }
+        int fd = open(url.c_str() + 7, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ((ssize_t)content.size(), write(fd, content.data(), content.size()));
+        close(fd);
+    }
+
+    static void TearDownTestCase() {
+        std::string cmd = std::string("rm -rf ") + dir;
+        ASSERT_EQ(0, system(cmd.c_str()));
+    }
+
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+        gfal_plugin_interface plugin = gfal_plugin_init(context, NULL);
+        gfal2_register_plugin(context, &plugin, NULL);
+        gfal2_set_opt_integer(context, "FILE PLUGIN", "CHECKSUM_THREADS", 4, NULL);
+        gfal2_set_opt_integer(context, "FILE PLUGIN", "CHECKSUM_CHUNK_SIZE", chunk_size, NULL);
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+
+    // Compared with the reference of [offset, offset + length), length of 0 meaning up to the end
+    void expect_checksum(const char *type, off_t offset, size_t length) {
+        GError *error = NULL;
+        char buffer[64] = {0};
+        int ret = gfal2_checksum(context, url.c_str(), type, offset, length,
+            buffer, sizeof(buffer), &error);
+        EXPECT_EQ(0, ret) << type;
+        EXPECT_EQ((void*)NULL, error) << type << ": " << error->message;
+        g_clear_error(&error);
+        EXPECT_EQ(reference(type, content, offset, length ? length : file_size - offset), buffer)
+            << type << " of " << length << " bytes at " << offset;
+    }
+};
+
+char FileChecksumTest::dir[64];
+std::string FileChecksumTest::url;
+std::string FileChecksumTest::content;
+
+
+TEST_F(FileChecksumTest, WholeFile)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(types); ++i)
+        expect_checksum(types[i], 0, 0);
+}
+
+
+// A range starting and ending inside the chunks, spanning several of them
+TEST_F(FileChecksumTest, Range)
+{
+    const off_t offset = chunk_size + 1234567;
+    for (size_t i = 0; i < G_N_ELEMENTS(types); ++i) {
+        expect_checksum(types[i], offset, 3 * chunk_size + 7);
+        expect_checksum(types[i], offset, 0);
+    }
+}
+
+
+// The same as read sequentially by a single thread
+TEST_F(FileChecksumTest, SingleThread)
+{
+    gfal2_set_opt_integer(context, "FILE PLUGIN", "CHECKSUM_THREADS", 1, NULL);
+    for (size_t i = 0; i < G_N_ELEMENTS(types); ++i)
+        expect_checksum(types[i], 333, 0);
+}
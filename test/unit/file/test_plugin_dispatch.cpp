@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_file_handler_container.h>
+#include <common/gfal_plugin.h>
+#include <gtest/gtest.h>
+
+
+static const char *dispatch_plugin_get_name(void)
+{
+    return "DISPATCH PLUGIN";
+}
+
+
+static const char *dispatch_wrapper_get_name(void)
+{
+    return "DISPATCH WRAPPER";
+}
+
+
+static const char *dispatch_filler_get_name(void)
+{
+    return "DISPATCH FILLER";
+}
+
+
+static gboolean dispatch_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "dispatch://", 11) == 0;
+}
+
+
+static gboolean dispatch_wrapper_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "wrapper://", 10) == 0;
+}
+
+
+static gboolean dispatch_filler_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return FALSE;
+}
+
+
+static gfal_file_handle dispatch_plugin_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    return gfal_file_handle_new(dispatch_plugin_get_name(), NULL);
+}
+
+
+// Opens through the core, as srm or lfc do, and returns the handle of the plugin below
+static gfal_file_handle dispatch_wrapper_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    return gfal_plugin_openG((gfal2_context_t)plugin_data, "dispatch://inner", flag, mode, err);
+}
+
+
+static ssize_t dispatch_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err)
+{
+    return count;
+}
+
+
+static int dispatch_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static void register_dispatch_plugins(gfal2_context_t c, int n_fillers)
+{
+    gfal_plugin_interface plugin;
+
+    // plugins that never match, so the lookup by name has something to go through
+    for (int i = 0; i < n_fillers; ++i) {
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = dispatch_filler_get_name;
+        plugin.check_plugin_url = dispatch_filler_url;
+        ASSERT_EQ(0, gfal2_register_plugin(c, &plugin, NULL));
+    }
+
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = dispatch_plugin_get_name;
+    plugin.check_plugin_url = dispatch_plugin_url;
+    plugin.openG = dispatch_plugin_open;
+    plugin.preadG = dispatch_plugin_pread;
+    plugin.closeG = dispatch_plugin_close;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &plugin, NULL));
+
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.plugin_data = c;
+    plugin.getName = dispatch_wrapper_get_name;
+    plugin.check_plugin_url = dispatch_wrapper_url;
+    plugin.openG = dispatch_wrapper_open;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &plugin, NULL));
+}
+
+
+TEST(gfalPluginDispatch, bindOnOpen)
+{
+    char buffer[16];
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+    register_dispatch_plugins(c, 0);
+
+    gfal_file_handle fh = gfal_plugin_openG(c, "dispatch://path", O_RDONLY, 0, &tmp_err);
+    ASSERT_EQ(NULL, tmp_err);
+    ASSERT_NE((void *) NULL, fh->plugin);
+    ASSERT_STREQ("DISPATCH PLUGIN", fh->plugin->getName());
+    ASSERT_EQ(fh->plugin, gfal_plugin_map_file_handle(c, fh, &tmp_err));
+    ASSERT_EQ(0, gfal_plugin_closeG(c, fh, &tmp_err));
+
+    // the handle comes from a plugin other than the one elected for the url
+    fh = gfal_plugin_openG(c, "wrapper://path", O_RDONLY, 0, &tmp_err);
+    ASSERT_EQ(NULL, tmp_err);
+    ASSERT_NE((void *) NULL, fh->plugin);
+    ASSERT_STREQ("DISPATCH PLUGIN", fh->plugin->getName());
+    ASSERT_EQ(0, gfal_plugin_closeG(c, fh, &tmp_err));
+
+    // handles created outside of the core are bound on first use
+    fh = gfal_file_handle_new("DISPATCH PLUGIN", NULL);
+    ASSERT_EQ(NULL, fh->plugin);
+    ASSERT_EQ(sizeof(buffer), gfal_plugin_preadG(c, fh, buffer, sizeof(buffer), 0, &tmp_err));
+    ASSERT_NE((void *) NULL, fh->plugin);
+    ASSERT_EQ(0, gfal_plugin_closeG(c, fh, &tmp_err));
+
+    fh = gfal_file_handle_new("NOBODY", NULL);
+    ASSERT_EQ(-1, gfal_plugin_preadG(c, fh, buffer, sizeof(buffer), 0, &tmp_err));
+    ASSERT_NE((void *) NULL, tmp_err);
+    ASSERT_EQ(EBADF, tmp_err->code);
+    g_clear_error(&tmp_err);
+    gfal_file_handle_delete(fh);
+
+    gfal2_context_free(c);
+}
+
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+// Size of the files served by the plugin, byte i is (i % 251)
+static const off_t file_size = 100000;
+static int pread_calls = 0;
+static int preadv_calls = 0;
+
+
+static const char *preadv_plugin_get_name(void)
+{
+    return "PREADV PLUGIN";
+}
+
+
+static gboolean preadv_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "vec://", 6) == 0 || strncmp(url, "native://", 9) == 0;
+}
+
+
+static gfal_file_handle preadv_plugin_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    return gfal_file_handle_new(preadv_plugin_get_name(), GINT_TO_POINTER(strncmp(url, "native://", 9) == 0));
+}
+
+
+static ssize_t preadv_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err)
+{
+    ++pread_calls;
+    if (offset >= file_size) {
+        return 0;
+    }
+    // short reads, as a network protocol would do
+    if (count > 30000) {
+        count = 30000;
+    }
+    if (offset + (off_t)count > file_size) {
+        count = file_size - offset;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ((char*)buff)[i] = (offset + i) % 251;
+    }
+    return count;
+}
+
+
+static ssize_t preadv_plugin_preadv(plugin_handle plugin_data, gfal_file_handle fd,
+    const struct iovec *iov, const off_t *offsets, int iovcnt, GError **err)
+{
+    if (!gfal_file_handle_get_fdesc(fd)) {
+        gfal2_set_error(err, g_quark_from_static_string("PREADV PLUGIN"), ENOSYS, __func__, "Not supported");
+        return -1;
+    }
+    ++preadv_calls;
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        for (size_t j = 0; j < iov[i].iov_len; ++j) {
+            ((char*)iov[i].iov_base)[j] = (offsets[i] + j) % 251;
+        }
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+
+static int preadv_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class PreadvTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+
+public:
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = preadv_plugin_get_name;
+        plugin.check_plugin_url = preadv_plugin_url;
+        plugin.openG = preadv_plugin_open;
+        plugin.preadG = preadv_plugin_pread;
+        plugin.closeG = preadv_plugin_close;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+        pread_calls = preadv_calls = 0;
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+
+    void checkRange(const std::vector<char> &buffer, off_t offset, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            ASSERT_EQ((char)((offset + i) % 251), buffer[i]) << "at " << offset + i;
+        }
+    }
+};
+
+
+TEST_F(PreadvTest, Merge)
+{
+    GError *error = NULL;
+    int fd = gfal2_open(context, "vec://host/file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+
+    // unsorted, adjacent, overlapping and with small gaps: a single read
+    const off_t offsets[] = {2000, 0, 1000, 1500, 3100};
+    const size_t lens[] = {1000, 1000, 1000, 1000, 100};
+    std::vector<char> buffers[5];
+    struct iovec iov[5];
+    for (int i = 0; i < 5; ++i) {
+        buffers[i].resize(lens[i]);
+        iov[i].iov_base = buffers[i].data();
+        iov[i].iov_len = lens[i];
+    }
+
+    ASSERT_EQ(4100, gfal2_preadv(context, fd, iov, offsets, 5, &error));
+    ASSERT_EQ(NULL, error);
+    ASSERT_EQ(1, pread_calls);
+    for (int i = 0; i < 5; ++i) {
+        checkRange(buffers[i], offsets[i], lens[i]);
+    }
+
+    gfal2_close(context, fd, &error);
+}
+
+
+TEST_F(PreadvTest, Scattered)
+{
+    GError *error = NULL;
+    int fd = gfal2_open(context, "vec://host/file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+
+    // far apart ranges are read one by one, short reads are completed
+    const off_t offsets[] = {90000, 0, 60000};
+    const size_t lens[] = {500, 50000, 10};
+    std::vector<char> buffers[3];
+    struct iovec iov[3];
+    for (int i = 0; i < 3; ++i) {
+        buffers[i].resize(lens[i]);
+        iov[i].iov_base = buffers[i].data();
+        iov[i].iov_len = lens[i];
+    }
+
+    ASSERT_EQ(50510, gfal2_preadv(context, fd, iov, offsets, 3, &error));
+    ASSERT_EQ(4, pread_calls);
+    for (int i = 0; i < 3; ++i) {
+        checkRange(buffers[i], offsets[i], lens[i]);
+    }
+
+    // ranges crossing the end of the file are partially filled
+    const off_t eof_offsets[] = {file_size - 100, file_size + 10};
+    ASSERT_EQ(100, gfal2_preadv(context, fd, iov, eof_offsets, 2, &error));
+    checkRange(buffers[0], eof_offsets[0], 100);
+
+    ASSERT_EQ(0, gfal2_preadv(context, fd, iov, offsets, 0, &error));
+    ASSERT_EQ(-1, gfal2_preadv(context, 12345, iov, offsets, 3, &error));
+    ASSERT_EQ(EBADF, error->code);
+    g_clear_error(&error);
+
+    gfal2_close(context, fd, &error);
+}
+
+
+TEST_F(PreadvTest, Native)
+{
+    GError *error = NULL;
+    int fd = gfal2_open(context, "vec://host/file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+    gfal2_close(context, fd, &error);
+
+    gfal_plugin_interface plugin;
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = preadv_plugin_get_name;
+    plugin.check_plugin_url = preadv_plugin_url;
+    plugin.openG = preadv_plugin_open;
+    plugin.preadG = preadv_plugin_pread;
+    plugin.preadvG = preadv_plugin_preadv;
+    plugin.closeG = preadv_plugin_close;
+
+    gfal2_context_free(context);
+    context = gfal2_context_new(&error);
+    ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+    fd = gfal2_open(context, "native://host/file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+
+    const off_t offsets[] = {50000, 10};
+    std::vector<char> buffers[2];
+    struct iovec iov[2];
+    for (int i = 0; i < 2; ++i) {
+        buffers[i].resize(100);
+        iov[i].iov_base = buffers[i].data();
+        iov[i].iov_len = 100;
+    }
+    ASSERT_EQ(200, gfal2_preadv(context, fd, iov, offsets, 2, &error));
+    ASSERT_EQ(1, preadv_calls);
+    ASSERT_EQ(0, pread_calls);
+    checkRange(buffers[0], offsets[0], 100);
+    checkRange(buffers[1], offsets[1], 100);
+
+    gfal2_close(context, fd, &error);
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+// Size of the files served by the plugin, byte i is (i % 251)
+static const off_t file_size = 1000000;
+static volatile gint pread_calls = 0;
+static volatile gint read_calls = 0;
+// if set, pread returns half of what is asked, as a pread simulated over read may do
+static volatile gint short_reads = 0;
+
+
+static const char *ra_plugin_get_name(void)
+{
+    return "READAHEAD PLUGIN";
+}
+
+
+static gboolean ra_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "ra://", 5) == 0;
+}
+
+
+static gfal_file_handle ra_plugin_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    if (flag & GFAL_O_READAHEAD) {
+        gfal2_set_error(err, g_quark_from_static_string("READAHEAD PLUGIN"), EINVAL, __func__, "Unexpected flag");
+        return NULL;
+    }
+    off_t *position = g_new0(off_t, 1);
+    return gfal_file_handle_new(ra_plugin_get_name(), position);
+}
+
+
+static ssize_t ra_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err)
+{
+    g_atomic_int_inc(&pread_calls);
+    usleep(1000);
+    if (offset >= file_size) {
+        return 0;
+    }
+    if (offset + (off_t)count > file_size) {
+        count = file_size - offset;
+    }
+    if (short_reads && count > 1) {
+        count /= 2;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ((char*)buff)[i] = (offset + i) % 251;
+    }
+    return count;
+}
+
+
+static ssize_t ra_plugin_read(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, GError **err)
+{
+    g_atomic_int_inc(&read_calls);
+    off_t *position = (off_t*)gfal_file_handle_get_fdesc(fd);
+    ssize_t res = ra_plugin_pread(plugin_data, fd, buff, count, *position, err);
+    g_atomic_int_add(&pread_calls, -1);
+    if (res > 0) {
+        *position += res;
+    }
+    return res;
+}
+
+
+static off_t ra_plugin_lseek(plugin_handle plugin_data, gfal_file_handle fd,
+    off_t offset, int whence, GError **err)
+{
+    off_t *position = (off_t*)gfal_file_handle_get_fdesc(fd);
+    switch (whence) {
+        case SEEK_SET:
+            *position = offset;
+            break;
+        case SEEK_CUR:
+            *position += offset;
+            break;
+        case SEEK_END:
+            *position = file_size + offset;
+            break;
+    }
+    return *position;
+}
+
+
+static int ra_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    g_free(gfal_file_handle_get_fdesc(fd));
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class ReadAheadTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+
+public:
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = ra_plugin_get_name;
+        plugin.check_plugin_url = ra_plugin_url;
+        plugin.openG = ra_plugin_open;
+        plugin.readG = ra_plugin_read;
+        plugin.preadG = ra_plugin_pread;
+        plugin.lseekG = ra_plugin_lseek;
+        plugin.closeG = ra_plugin_close;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+        gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_READ_AHEAD_BLOCK_SIZE, 64 * 1024, NULL);
+        gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_READ_AHEAD_BLOCKS, 4, NULL);
+        pread_calls = read_calls = 0;
+        short_reads = 0;
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+
+    void checkRange(const char *buffer, off_t offset, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            ASSERT_EQ((char)((offset + i) % 251), buffer[i]) << "at " << offset + i;
+        }
+    }
+};
+
+
+TEST_F(ReadAheadTest, Sequential)
+{
+    GError *error = NULL;
+    int fd = gfal2_open(context, "ra://host/file", O_RDONLY | GFAL_O_READAHEAD, &error);
+    ASSERT_GT(fd, 0) << error->message;
+
+    char buffer[4096];
+    off_t offset = 0;
+    ssize_t ret;
+    while ((ret = gfal2_read(context, fd, buffer, sizeof(buffer), &error)) > 0) {
+        checkRange(buffer, offset, ret);
+        offset += ret;
+    }
+    ASSERT_EQ(0, ret);
+    ASSERT_EQ(file_size, offset);
+
+    // one request per block, instead of one per read
+    // plus the window beyond the end, requested before the end was found
+    const int n_blocks = (file_size + 64 * 1024 - 1) / (64 * 1024);
+    ASSERT_EQ(0, read_calls);
+    ASSERT_LE(pread_calls, n_blocks + 4);
+
+    gfal2_readahead_stats_t stats;
+    ASSERT_EQ(0, gfal2_readahead_get_stats(context, fd, &stats, &error));
+    ASSERT_EQ((file_size + sizeof(buffer) - 1) / sizeof(buffer) + 1, stats.reads);
+    ASSERT_GT(stats.hits, stats.reads * 9 / 10);
+    ASSERT_EQ(file_size, stats.bytes_prefetched);
+    ASSERT_EQ(0, stats.bytes_wasted);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(ReadAheadTest, Seek)
+{
+    GError *error = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_READ_AHEAD, TRUE, NULL);
+    int fd = gfal2_open(context, "ra://host/file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+
+    char buffer[1000];
+    ASSERT_EQ(sizeof(buffer), gfal2_read(context, fd, buffer, sizeof(buffer), &error));
+    checkRange(buffer, 0, sizeof(buffer));
+
+    // random access is not prefetched
+    ASSERT_EQ(500000, gfal2_lseek(context, fd, 500000, SEEK_SET, &error));
+    ASSERT_EQ(sizeof(buffer), gfal2_read(context, fd, buffer, sizeof(buffer), &error));
+    checkRange(buffer, 500000, sizeof(buffer));
+
+    ASSERT_EQ(file_size - 100, gfal2_lseek(context, fd, -100, SEEK_END, &error));
+    ASSERT_EQ(100, gfal2_read(context, fd, buffer, sizeof(buffer), &error));
+    checkRange(buffer, file_size - 100, 100);
+    ASSERT_EQ(0, gfal2_read(context, fd, buffer, sizeof(buffer), &error));
+
+    ASSERT_EQ(10, gfal2_lseek(context, fd, 10, SEEK_SET, &error));
+    ASSERT_EQ(sizeof(buffer), gfal2_read(context, fd, buffer, sizeof(buffer), &error));
+    checkRange(buffer, 10, sizeof(buffer));
+    ASSERT_EQ(sizeof(buffer) + 10, gfal2_lseek(context, fd, 0, SEEK_CUR, &error));
+
+    gfal2_readahead_stats_t stats;
+    ASSERT_EQ(0, gfal2_readahead_get_stats(context, fd, &stats, &error));
+    ASSERT_EQ(5, stats.reads);
+    ASSERT_GT(stats.bytes_wasted, 0);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(ReadAheadTest, Disabled)
+{
+    GError *error = NULL;
+
+    // not for writing
+    int fd = gfal2_open(context, "ra://host/file", O_RDWR | GFAL_O_READAHEAD, &error);
+    ASSERT_GT(fd, 0);
+
+    char buffer[4096];
+    ASSERT_EQ(sizeof(buffer), gfal2_read(context, fd, buffer, sizeof(buffer), &error));
+    ASSERT_EQ(1, read_calls);
+
+    gfal2_readahead_stats_t stats;
+    ASSERT_EQ(-1, gfal2_readahead_get_stats(context, fd, &stats, &error));
+    ASSERT_EQ(EINVAL, error->code);
+    g_clear_error(&error);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+// A short read in the middle of the file is not the end of it
+TEST_F(ReadAheadTest, ShortReads)
+{
+    GError *error = NULL;
+    short_reads = 1;
+    int fd = gfal2_open(context, "ra://host/file", O_RDONLY | GFAL_O_READAHEAD, &error);
+    ASSERT_GT(fd, 0);
+
+    char buffer[10000];
+    off_t offset = 0;
+    ssize_t ret;
+    while ((ret = gfal2_read(context, fd, buffer, sizeof(buffer), &error)) > 0) {
+        checkRange(buffer, offset, ret);
+        offset += ret;
+    }
+    ASSERT_EQ(0, ret);
+    ASSERT_EQ(file_size, offset);
+
+    gfal2_readahead_stats_t stats;
+    ASSERT_EQ(0, gfal2_readahead_get_stats(context, fd, &stats, &error));
+    ASSERT_EQ(file_size, stats.bytes_prefetched);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <unistd.h>
+
+// Namespace served by the plugin, url -> stat
+static std::map<std::string, struct stat> files;
+static int stat_calls = 0;
+// stat of the destination seen by the copy, once written
+static int copy_dst_stat = 0;
+
+static GQuark domain = g_quark_from_static_string("STAT CACHE PLUGIN");
+
+
+static const char *stc_plugin_get_name(void)
+{
+    return "STAT CACHE PLUGIN";
+}
+
+
+static gboolean stc_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "stc://", 6) == 0;
+}
+
+
+static void stc_create(const std::string &url, mode_t mode, off_t size = 0)
+{
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    st.st_mode = mode;
+    st.st_size = size;
+    files[url] = st;
+}
+
+
+static int stc_not_found(const char *url, GError **err)
+{
+    gfal2_set_error(err, domain, ENOENT, __func__, "%s not found", url);
+    return -1;
+}
+
+
+static int stc_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    ++stat_calls;
+    std::map<std::string, struct stat>::iterator i = files.find(url);
+    if (i == files.end()) {
+        return stc_not_found(url, err);
+    }
+    *buf = i->second;
+    return 0;
+}
+
+
+static int stc_plugin_unlink(plugin_handle plugin_data, const char *url, GError **err)
+{
+    if (files.erase(url) == 0) {
+        return stc_not_found(url, err);
+    }
+    return 0;
+}
+
+
+static int stc_plugin_mkdir(plugin_handle plugin_data, const char *url, mode_t mode,
+    gboolean rec_flag, GError **err)
+{
+    stc_create(url, S_IFDIR | mode);
+    files[url].st_nlink = 1;
+    std::string parent(url, strrchr(url, '/') - url);
+    files[parent].st_nlink += 1;
+    return 0;
+}
+
+
+static int stc_plugin_rename(plugin_handle plugin_data, const char *oldurl, const char *newurl, GError **err)
+{
+    if (files.find(oldurl) == files.end()) {
+        return stc_not_found(oldurl, err);
+    }
+    files[newurl] = files[oldurl];
+    files.erase(oldurl);
+    // and what is below, for a directory
+    std::string prefix = std::string(oldurl) + "/";
+    std::map<std::string, struct stat>::iterator i = files.lower_bound(prefix);
+    while (i != files.end() && i->first.compare(0, prefix.size(), prefix) == 0) {
+        files[newurl + i->first.substr(prefix.size() - 1)] = i->second;
+        files.erase(i++);
+    }
+    return 0;
+}
+
+
+static int stc_plugin_chmod(plugin_handle plugin_data, const char *url, mode_t mode, GError **err)
+{
+    files[url].st_mode = (files[url].st_mode & S_IFMT) | mode;
+    return 0;
+}
+
+
+// Lists every url under the directory
+static gfal_file_handle stc_plugin_opendir(plugin_handle plugin_data, const char *url, GError **err)
+{
+    return gfal_file_handle_new2(stc_plugin_get_name(), new std::string(), NULL, url);
+}
+
+
+static struct dirent *stc_plugin_readdirpp(plugin_handle plugin_data, gfal_file_handle fh,
+    struct stat *st, GError **err)
+{
+    static struct dirent ent;
+    std::string *last = (std::string*)gfal_file_handle_get_fdesc(fh);
+    std::string prefix = std::string(gfal_file_handle_get_path(fh)) + "/";
+    std::map<std::string, struct stat>::iterator i = files.upper_bound(last->empty() ? prefix : *last);
+    if (i == files.end() || i->first.compare(0, prefix.size(), prefix) != 0) {
+        return NULL;
+    }
+    *last = i->first;
+    *st = i->second;
+    g_strlcpy(ent.d_name, i->first.c_str() + prefix.size(), sizeof(ent.d_name));
+    return &ent;
+}
+
+
+static int stc_plugin_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
+{
+    delete (std::string*)gfal_file_handle_get_fdesc(fh);
+    gfal_file_handle_delete(fh);
+    return 0;
+}
+
+
+static gfal_file_handle stc_plugin_open(plugin_handle plugin_data, const char *url, int flag,
+    mode_t mode, GError **err)
+{
+    if (flag & O_CREAT) {
+        stc_create(url, S_IFREG | mode);
+    }
+    return gfal_file_handle_new2(stc_plugin_get_name(), NULL, NULL, url);
+}
+
+
+static ssize_t stc_plugin_write(plugin_handle plugin_data, gfal_file_handle fh, const void *buff,
+    size_t count, GError **err)
+{
+    files[gfal_file_handle_get_path(fh)].st_size += count;
+    return count;
+}
+
+
+static int stc_plugin_close(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
+{
+    gfal_file_handle_delete(fh);
+    return 0;
+}
+
+
+static int stc_plugin_check_copy(plugin_handle plugin_data, gfal2_context_t context,
+    const char *src, const char *dst, gfal_url2_check check)
+{
+    return strncmp(src, "stc://", 6) == 0 && strncmp(dst, "stc://", 6) == 0;
+}
+
+
+// Checks the destination is not there, writes it, and checks its size
+static int stc_plugin_copy(plugin_handle plugin_data, gfal2_context_t context, gfalt_params_t params,
+    const char *src, const char *dst, GError **err)
+{
+    struct stat st;
+    if (gfal2_stat(context, dst, &st, NULL) == 0) {
+        gfal2_set_error(err, domain, EEXIST, __func__, "%s exists", dst);
+        return -1;
+    }
+    files[dst] = files[src];
+    copy_dst_stat = gfal2_stat(context, dst, &st, err);
+    return copy_dst_stat;
+}
+
+
+class StatCacheTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+
+    void new_context(int capabilities) {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = stc_plugin_get_name;
+        plugin.check_plugin_url = stc_plugin_url;
+        plugin.statG = stc_plugin_stat;
+        plugin.unlinkG = stc_plugin_unlink;
+        plugin.mkdirpG = stc_plugin_mkdir;
+        plugin.renameG = stc_plugin_rename;
+        plugin.chmodG = stc_plugin_chmod;
+        plugin.rmdirG = stc_plugin_unlink;
+        plugin.opendirG = stc_plugin_opendir;
+        plugin.readdirppG = stc_plugin_readdirpp;
+        plugin.closedirG = stc_plugin_closedir;
+        plugin.openG = stc_plugin_open;
+        plugin.writeG = stc_plugin_write;
+        plugin.closeG = stc_plugin_close;
+        plugin.check_plugin_url_transfer = stc_plugin_check_copy;
+        plugin.copy_file = stc_plugin_copy;
+        plugin.capabilities = capabilities;
+        gfal2_register_plugin(context, &plugin, NULL);
+        gfal2_set_opt_boolean(context, "CORE", "STAT_CACHE", TRUE, NULL);
+    }
+
+public:
+    virtual void SetUp() {
+        new_context(GFAL_PLUGIN_CAP_READDIRPP_FULL_STAT);
+
+        files.clear();
+        stc_create("stc://host/dir", S_IFDIR | 0755);
+        stc_create("stc://host/dir/a", S_IFREG | 0644, 10);
+        stc_create("stc://host/dir/b", S_IFREG | 0644, 20);
+        stc_create("stc://host/dir/c", S_IFREG | 0644, 30);
+        stat_calls = 0;
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+
+    // st_size of url, or -errno
+    off_t stat_size(const char *url) {
+        struct stat st;
+        GError *error = NULL;
+        if (gfal2_stat(context, url, &st, &error) < 0) {
+            int code = error->code;
+            g_error_free(error);
+            return -code;
+        }
+        return st.st_size;
+    }
+
+    mode_t stat_mode(const char *url) {
+        struct stat st;
+        EXPECT_EQ(0, gfal2_stat(context, url, &st, NULL));
+        return st.st_mode;
+    }
+};
+
+
+TEST_F(StatCacheTest, Disabled)
+{
+    gfal2_set_opt_boolean(context, "CORE", "STAT_CACHE", FALSE, NULL);
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(2, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, Hit)
+{
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    files["stc://host/dir/a"].st_size = 11;
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(1, stat_calls);
+
+    // the trailing slashes do not matter
+    EXPECT_EQ(S_IFDIR | 0755, stat_mode("stc://host/dir"));
+    EXPECT_EQ(S_IFDIR | 0755, stat_mode("stc://host/dir/"));
+    EXPECT_EQ(2, stat_calls);
+
+    // each context has its own
+    gfal2_context_t other = gfal2_context_clone(context, NULL);
+    struct stat st;
+    ASSERT_EQ(0, gfal2_stat(other, "stc://host/dir/a", &st, NULL));
+    EXPECT_EQ(11, st.st_size);
+    gfal2_context_free(other);
+}
+
+
+TEST_F(StatCacheTest, Expiration)
+{
+    gfal2_set_opt_integer(context, "CORE", "STAT_CACHE_TTL", 1, NULL);
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    files["stc://host/dir/a"].st_size = 11;
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    usleep(1100000);
+    EXPECT_EQ(11, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(2, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, Negative)
+{
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/missing"));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/missing"));
+    EXPECT_EQ(1, stat_calls);
+
+    // the message of the plugin is kept
+    struct stat st;
+    GError *error = NULL;
+    EXPECT_EQ(-1, gfal2_stat(context, "stc://host/dir/missing", &st, &error));
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(domain, error->domain);
+    EXPECT_NE((char*)NULL, strstr(error->message, "stc://host/dir/missing not found"));
+    g_error_free(error);
+
+    gfal2_set_opt_integer(context, "CORE", "STAT_CACHE_NEGATIVE_TTL", 0, NULL);
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/other"));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/other"));
+    EXPECT_EQ(3, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, Invalidated)
+{
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    ASSERT_EQ(0, gfal2_unlink(context, "stc://host/dir/a", NULL));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/a"));
+
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/sub"));
+    ASSERT_EQ(0, gfal2_mkdir(context, "stc://host/dir/sub", 0700, NULL));
+    EXPECT_EQ(S_IFDIR | 0700, stat_mode("stc://host/dir/sub"));
+
+    ASSERT_EQ(0, gfal2_chmod(context, "stc://host/dir/sub", 0750, NULL));
+    EXPECT_EQ(S_IFDIR | 0750, stat_mode("stc://host/dir/sub"));
+
+    EXPECT_EQ(20, stat_size("stc://host/dir/b"));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/d"));
+    ASSERT_EQ(0, gfal2_rename(context, "stc://host/dir/b", "stc://host/dir/d", NULL));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/b"));
+    EXPECT_EQ(20, stat_size("stc://host/dir/d"));
+
+    ASSERT_EQ(0, gfal2_rmdir(context, "stc://host/dir/sub", NULL));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/sub"));
+    EXPECT_EQ(10, stat_calls);
+}
+
+
+// The entries below a renamed directory move with it
+TEST_F(StatCacheTest, InvalidatedTree)
+{
+    stc_create("stc://host/dir2", S_IFREG | 0644, 40);
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/moved/a"));
+    EXPECT_EQ(40, stat_size("stc://host/dir2"));
+
+    ASSERT_EQ(0, gfal2_rename(context, "stc://host/dir", "stc://host/moved", NULL));
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(10, stat_size("stc://host/moved/a"));
+    // not below the directory, even if its name starts the same
+    EXPECT_EQ(40, stat_size("stc://host/dir2"));
+    EXPECT_EQ(5, stat_calls);
+}
+
+
+// Creating or removing an entry changes its directory
+TEST_F(StatCacheTest, InvalidatedParent)
+{
+    struct stat st;
+    ASSERT_EQ(0, gfal2_stat(context, "stc://host/dir", &st, NULL));
+    EXPECT_EQ(0u, st.st_nlink);
+    ASSERT_EQ(0, gfal2_mkdir(context, "stc://host/dir/sub", 0700, NULL));
+    ASSERT_EQ(0, gfal2_stat(context, "stc://host/dir", &st, NULL));
+    EXPECT_EQ(1u, st.st_nlink);
+    EXPECT_EQ(2, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, Readdirpp)
+{
+    GError *error = NULL;
+    DIR *dir = gfal2_opendir(context, "stc://host/dir", &error);
+    ASSERT_NE((void*)NULL, dir);
+    struct stat st;
+    int entries = 0;
+    while (gfal2_readdirpp(context, dir, &st, &error) != NULL) {
+        ++entries;
+    }
+    EXPECT_EQ((void*)NULL, error);
+    gfal2_closedir(context, dir, NULL);
+    EXPECT_EQ(3, entries);
+
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(20, stat_size("stc://host/dir/b"));
+    EXPECT_EQ(30, stat_size("stc://host/dir/c"));
+    EXPECT_EQ(0, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, ReaddirppPartialStat)
+{
+    // the stat of the listings is not trusted unless the plugin says it is complete
+    gfal2_context_free(context);
+    new_context(0);
+
+    GError *error = NULL;
+    DIR *dir = gfal2_opendir(context, "stc://host/dir", &error);
+    ASSERT_NE((void*)NULL, dir);
+    struct stat st;
+    int entries = 0;
+    while (gfal2_readdirpp(context, dir, &st, &error) != NULL) {
+        ++entries;
+    }
+    EXPECT_EQ((void*)NULL, error);
+    gfal2_closedir(context, dir, NULL);
+    EXPECT_EQ(3, entries);
+
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(20, stat_size("stc://host/dir/b"));
+    EXPECT_EQ(2, stat_calls);
+    // the stat itself is kept
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+    EXPECT_EQ(2, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, StatList)
+{
+    EXPECT_EQ(10, stat_size("stc://host/dir/a"));
+
+    const char *urls[] = {"stc://host/dir/a", "stc://host/dir/b", "stc://host/dir/missing"};
+    struct stat buffs[3];
+    GError *errors[3] = {NULL, NULL, NULL};
+    EXPECT_LT(gfal2_stat_list(context, 3, urls, buffs, errors), 0);
+    EXPECT_EQ((void*)NULL, errors[0]);
+    EXPECT_EQ(10, buffs[0].st_size);
+    EXPECT_EQ((void*)NULL, errors[1]);
+    EXPECT_EQ(20, buffs[1].st_size);
+    ASSERT_NE((void*)NULL, errors[2]);
+    EXPECT_EQ(ENOENT, errors[2]->code);
+    g_error_free(errors[2]);
+    EXPECT_EQ(3, stat_calls);
+
+    // all of them are cached now
+    memset(errors, 0, sizeof(errors));
+    gfal2_stat_list(context, 3, urls, buffs, errors);
+    EXPECT_EQ(20, buffs[1].st_size);
+    ASSERT_NE((void*)NULL, errors[2]);
+    g_error_free(errors[2]);
+    EXPECT_EQ(3, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, Copy)
+{
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/copy"));
+
+    // the destination is not cached while written
+    GError *error = NULL;
+    ASSERT_EQ(0, gfalt_copy_file(context, NULL, "stc://host/dir/a", "stc://host/dir/copy", &error));
+    EXPECT_EQ((void*)NULL, error);
+    EXPECT_EQ(0, copy_dst_stat);
+
+    EXPECT_EQ(10, stat_size("stc://host/dir/copy"));
+    EXPECT_EQ(10, stat_size("stc://host/dir/copy"));
+    EXPECT_EQ(4, stat_calls);
+}
+
+
+TEST_F(StatCacheTest, Write)
+{
+    EXPECT_EQ(-ENOENT, stat_size("stc://host/dir/new"));
+
+    GError *error = NULL;
+    int fd = gfal2_open(context, "stc://host/dir/new", O_WRONLY | O_CREAT, &error);
+    ASSERT_GT(fd, 0);
+    EXPECT_EQ(0, stat_size("stc://host/dir/new"));
+    ASSERT_EQ(5, gfal2_write(context, fd, "12345", 5, NULL));
+    EXPECT_EQ(5, stat_size("stc://host/dir/new"));
+    ASSERT_EQ(0, gfal2_close(context, fd, NULL));
+
+    EXPECT_EQ(5, stat_size("stc://host/dir/new"));
+    EXPECT_EQ(5, stat_size("stc://host/dir/new"));
+
+    // read only, the cache is used
+    fd = gfal2_open(context, "stc://host/dir/new", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+    EXPECT_EQ(5, stat_size("stc://host/dir/new"));
+    gfal2_close(context, fd, NULL);
+    EXPECT_EQ(4, stat_calls);
+}
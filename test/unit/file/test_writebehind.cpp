@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <string>
+
+// Content written to the plugin, and number of writeG calls
+static std::string written;
+static int write_calls = 0;
+// writeG fails once the file is bigger than this
+static size_t fail_after = 0;
+
+
+static const char *wb_plugin_get_name(void)
+{
+    return "WRITEBEHIND PLUGIN";
+}
+
+
+static gboolean wb_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "wb://", 5) == 0;
+}
+
+
+static gfal_file_handle wb_plugin_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    if (flag & GFAL_O_WRITEBEHIND) {
+        gfal2_set_error(err, g_quark_from_static_string("WRITEBEHIND PLUGIN"), EINVAL, __func__, "Unexpected flag");
+        return NULL;
+    }
+    return gfal_file_handle_new(wb_plugin_get_name(), NULL);
+}
+
+
+static ssize_t wb_plugin_write(plugin_handle plugin_data, gfal_file_handle fd,
+    const void *buff, size_t count, GError **err)
+{
+    ++write_calls;
+    usleep(1000);
+    if (fail_after && written.size() + count > fail_after) {
+        gfal2_set_error(err, g_quark_from_static_string("WRITEBEHIND PLUGIN"), ENOSPC, __func__, "No space left");
+        return -1;
+    }
+    // partial writes
+    if (count > 10000) {
+        count = 10000;
+    }
+    written.append((const char*)buff, count);
+    return count;
+}
+
+
+static off_t wb_plugin_lseek(plugin_handle plugin_data, gfal_file_handle fd,
+    off_t offset, int whence, GError **err)
+{
+    return written.size();
+}
+
+
+static int wb_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class WriteBehindTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+
+public:
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = wb_plugin_get_name;
+        plugin.check_plugin_url = wb_plugin_url;
+        plugin.openG = wb_plugin_open;
+        plugin.writeG = wb_plugin_write;
+        plugin.lseekG = wb_plugin_lseek;
+        plugin.closeG = wb_plugin_close;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+        gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_WRITE_BEHIND_BUFFER_SIZE, 16 * 1024, NULL);
+        gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_WRITE_BEHIND_BUFFERS, 2, NULL);
+        written.clear();
+        write_calls = 0;
+        fail_after = 0;
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+
+    static std::string expected(size_t size) {
+        std::string content;
+        for (size_t i = 0; i < size; ++i) {
+            content.push_back('a' + i % 26);
+        }
+        return content;
+    }
+};
+
+
+TEST_F(WriteBehindTest, Coalesce)
+{
+    GError *error = NULL;
+    int fd = gfal2_open(context, "wb://host/file", O_WRONLY | O_CREAT | GFAL_O_WRITEBEHIND, &error);
+    ASSERT_GT(fd, 0);
+
+    const std::string content = expected(100000);
+    for (size_t i = 0; i < content.size(); i += 100) {
+        ASSERT_EQ(100, gfal2_write(context, fd, content.data() + i, 100, &error));
+    }
+    // at most the buffers in flight are still pending
+    ASSERT_GE(written.size(), content.size() - 3 * 16 * 1024);
+
+    ASSERT_EQ(0, gfal2_flush(context, fd, &error));
+    ASSERT_TRUE(content == written);
+    // two calls per buffer, as the plugin writes at most 10000 bytes
+    ASSERT_LE(write_calls, 2 * (100000 / (16 * 1024) + 1));
+
+    // big writes go straight to the plugin
+    std::string big = expected(40000);
+    ASSERT_EQ(40000, gfal2_write(context, fd, big.data(), big.size(), &error));
+    ASSERT_TRUE(content + big == written);
+
+    // unless there is data buffered, that must be written before
+    ASSERT_EQ(10, gfal2_write(context, fd, big.data(), 10, &error));
+    ASSERT_EQ(40000, gfal2_write(context, fd, big.data(), big.size(), &error));
+    ASSERT_EQ(0, gfal2_flush(context, fd, &error));
+    ASSERT_TRUE(content + big + big.substr(0, 10) + big == written);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(WriteBehindTest, FlushOnClose)
+{
+    GError *error = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_WRITE_BEHIND, TRUE, NULL);
+    int fd = gfal2_open(context, "wb://host/file", O_WRONLY | O_CREAT, &error);
+    ASSERT_GT(fd, 0);
+
+    ASSERT_EQ(5, gfal2_write(context, fd, "hello", 5, &error));
+    ASSERT_EQ(0, write_calls);
+
+    // other operations see the data written
+    ASSERT_EQ(5, gfal2_lseek(context, fd, 0, SEEK_CUR, &error));
+    ASSERT_EQ("hello", written);
+
+    ASSERT_EQ(6, gfal2_write(context, fd, " world", 6, &error));
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+    ASSERT_EQ("hello world", written);
+}
+
+
+TEST_F(WriteBehindTest, Errors)
+{
+    GError *error = NULL;
+    fail_after = 50000;
+    int fd = gfal2_open(context, "wb://host/file", O_WRONLY | O_CREAT | GFAL_O_WRITEBEHIND, &error);
+    ASSERT_GT(fd, 0);
+
+    // the failure is reported by a later call
+    const std::string content = expected(100000);
+    size_t i;
+    ssize_t ret = 0;
+    for (i = 0; i < content.size() && ret >= 0; i += 1000) {
+        ret = gfal2_write(context, fd, content.data() + i, 1000, &error);
+    }
+    ASSERT_EQ(-1, ret);
+    ASSERT_LT(i, content.size());
+    ASSERT_EQ(ENOSPC, error->code);
+    g_clear_error(&error);
+
+    ASSERT_EQ(-1, gfal2_flush(context, fd, &error));
+    ASSERT_EQ(ENOSPC, error->code);
+    g_clear_error(&error);
+
+    // close reports it too
+    ASSERT_EQ(-1, gfal2_close(context, fd, &error));
+    ASSERT_EQ(ENOSPC, error->code);
+    g_clear_error(&error);
+
+    // but the file is closed anyway
+    ASSERT_EQ(-1, gfal2_close(context, fd, &error));
+    ASSERT_EQ(EBADF, error->code);
+    g_clear_error(&error);
+}
@@ -100,3 +100,221 @@ TEST(gfalGlobal, registerPlugin)
 
     gfal2_context_free(c);
 }
+
+
+static const char *test_plugin_override_get_name(void)
+{
+    return "TEST PLUGIN OVERRIDE";
+}
+
+
+static int test_plugin_override_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    buf->st_mode = 54321;
+    return 0;
+}
+
+
+TEST(gfalGlobal, registerPluginDispatchCache)
+{
+    static const char* const test_schemes[] = {"test", NULL};
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+    test_plugin.getName = test_plugin_get_name;
+    test_plugin.check_plugin_url = test_plugin_url;
+    test_plugin.statG = test_plugin_stat;
+    test_plugin.schemes = test_schemes;
+
+    int ret = gfal2_register_plugin(c, &test_plugin, &tmp_err);
+    ASSERT_EQ(0, ret);
+
+    struct stat st;
+    // twice, so the second call goes through the cached election
+    for (int i = 0; i < 2; ++i) {
+        ret = gfal2_stat(c, "test://blah", &st, &tmp_err);
+        ASSERT_EQ(0, ret);
+        ASSERT_EQ(12345, st.st_mode);
+    }
+
+    // the election must still be confirmed by the plugin
+    ret = gfal2_stat(c, "test:blah", &st, &tmp_err);
+    ASSERT_EQ(-1, ret);
+    ASSERT_NE((void *) NULL, tmp_err);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    // a plugin with a higher priority invalidates the previous elections
+    gfal_plugin_interface override_plugin;
+    memset(&override_plugin, 0, sizeof(override_plugin));
+    override_plugin.getName = test_plugin_override_get_name;
+    override_plugin.check_plugin_url = test_plugin_url;
+    override_plugin.statG = test_plugin_override_stat;
+    override_plugin.priority = GFAL_PLUGIN_PRIORITY_CACHE;
+
+    ret = gfal2_register_plugin(c, &override_plugin, &tmp_err);
+    ASSERT_EQ(0, ret);
+
+    ret = gfal2_stat(c, "test://blah", &st, &tmp_err);
+    ASSERT_EQ(0, ret);
+    ASSERT_EQ(54321, st.st_mode);
+
+    gfal2_context_free(c);
+}
+
+
+
+static int split_checks = 0, foreign_checks = 0;
+
+
+static gboolean split_high_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    ++split_checks;
+    return strncmp(url, "split://high/", 13) == 0;
+}
+
+
+static gboolean split_low_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "split://", 8) == 0;
+}
+
+
+static gboolean split_foreign_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    ++foreign_checks;
+    return strncmp(url, "foreign://", 10) == 0;
+}
+
+
+static int split_high_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    buf->st_mode = 1;
+    return 0;
+}
+
+
+static int split_low_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    buf->st_mode = 2;
+    return 0;
+}
+
+
+// A plugin with a higher priority that takes only some urls of a scheme is always asked first
+TEST(gfalGlobal, registerPluginDispatchPriority)
+{
+    static const char* const split_schemes[] = {"split", NULL};
+    static const char* const foreign_schemes[] = {"foreign", NULL};
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+
+    gfal_plugin_interface plugin;
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = test_plugin_get_name;
+    plugin.check_plugin_url = split_low_url;
+    plugin.statG = split_low_stat;
+    plugin.schemes = split_schemes;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &plugin, &tmp_err));
+
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = test_plugin_override_get_name;
+    plugin.check_plugin_url = split_high_url;
+    plugin.statG = split_high_stat;
+    plugin.schemes = split_schemes;
+    plugin.priority = GFAL_PLUGIN_PRIORITY_CACHE;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &plugin, &tmp_err));
+
+    struct stat st;
+    split_checks = 0;
+    const char *urls[] = {"split://low/a", "split://high/b", "split://low/c", "split://high/d"};
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(0, gfal2_stat(c, urls[i], &st, &tmp_err));
+        EXPECT_EQ((i % 2) ? 1 : 2, st.st_mode) << urls[i];
+    }
+    EXPECT_EQ(4, split_checks);
+
+    // a plugin of another scheme does not prevent the election from being remembered
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = test_plugin_get_name;
+    plugin.check_plugin_url = split_foreign_url;
+    plugin.schemes = foreign_schemes;
+    // above GFAL_PLUGIN_PRIORITY_CACHE
+    plugin.priority = 300;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &plugin, &tmp_err));
+
+    foreign_checks = 0;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(0, gfal2_stat(c, "split://high/e", &st, &tmp_err));
+        EXPECT_EQ(1, st.st_mode);
+    }
+    EXPECT_EQ(1, foreign_checks);
+
+    gfal2_context_free(c);
+}
+
+TEST(gfalGlobal, cloneContext)
+{
+    GError *tmp_err = NULL;
+    gfal2_context_t parent = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, parent);
+
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+    test_plugin.getName = test_plugin_get_name;
+    test_plugin.check_plugin_url = test_plugin_url;
+    test_plugin.statG = test_plugin_stat;
+    ASSERT_EQ(0, gfal2_register_plugin(parent, &test_plugin, &tmp_err));
+
+    gfal2_set_opt_string(parent, "TEST", "KEY", "parent", NULL);
+    gfal2_set_user_agent(parent, "test-agent", "1.0", NULL);
+    gfal2_add_client_info(parent, "job", "42", NULL);
+
+    gfal2_context_t clone = gfal2_context_clone(parent, &tmp_err);
+    if (tmp_err)
+        printf("%s\n", tmp_err->message);
+    ASSERT_NE((void *) NULL, clone);
+
+    // parameters are copied
+    gchar *value = gfal2_get_opt_string(clone, "TEST", "KEY", NULL);
+    ASSERT_STREQ("parent", value);
+    g_free(value);
+
+    const char *agent, *version, *info;
+    gfal2_get_user_agent(clone, &agent, &version);
+    ASSERT_STREQ("test-agent", agent);
+    ASSERT_STREQ("1.0", version);
+    ASSERT_EQ(0, gfal2_get_client_info_value(clone, "job", &info, NULL));
+    ASSERT_STREQ("42", info);
+
+    // but not shared
+    gfal2_set_opt_string(clone, "TEST", "KEY", "clone", NULL);
+    value = gfal2_get_opt_string(parent, "TEST", "KEY", NULL);
+    ASSERT_STREQ("parent", value);
+    g_free(value);
+
+    // so are the plugins
+    gchar **parent_plugins = gfal2_get_plugin_names(parent);
+    gchar **clone_plugins = gfal2_get_plugin_names(clone);
+    ASSERT_EQ(g_strv_length(parent_plugins), g_strv_length(clone_plugins));
+    g_strfreev(parent_plugins);
+    g_strfreev(clone_plugins);
+
+    struct stat st;
+    ASSERT_EQ(0, gfal2_stat(clone, "test://blah", &st, &tmp_err));
+    ASSERT_EQ(12345, st.st_mode);
+
+    gfal2_context_free(clone);
+
+    // the parent is still usable
+    ASSERT_EQ(0, gfal2_stat(parent, "test://blah", &st, &tmp_err));
+    gfal2_context_free(parent);
+}
+
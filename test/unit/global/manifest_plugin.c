@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Plugin library listed in the manifest of test_plugin_manifest.cpp
+// It serves "lazy://" urls, all of them being files of 42 bytes
+
+#include <string.h>
+#include <gfal_plugins_api.h>
+
+
+static const char* manifest_plugin_get_name(void)
+{
+    return "MANIFEST TEST PLUGIN";
+}
+
+
+static gboolean manifest_plugin_check_url(plugin_handle plugin_data, const char* url,
+        plugin_mode operation, GError** err)
+{
+    return strncmp(url, "lazy://", 7) == 0;
+}
+
+
+static int manifest_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    buf->st_size = 42;
+    return 0;
+}
+
+
+gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
+{
+    gfal_plugin_interface plugin;
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = manifest_plugin_get_name;
+    plugin.check_plugin_url = manifest_plugin_check_url;
+    plugin.statG = manifest_plugin_stat;
+    return plugin;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_plugin_internal.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+// The registry is built once per process, by the first context, from a plugin directory with
+//  - libgfal_plugin_manifest_test.so, see manifest_plugin.c, for lazy://
+//  - libgfal_plugin_broken.so, which is not a library, for lazy:// and broken://
+//    with a higher priority, so it is tried first
+// both listed in the manifest
+static char plugin_dir[] = "/tmp/gfal2_manifest_XXXXXX";
+
+
+class ManifestEnvironment: public testing::Environment {
+public:
+    virtual void SetUp() {
+        ASSERT_NE((char*)NULL, mkdtemp(plugin_dir));
+        std::string dir(plugin_dir);
+
+        ASSERT_EQ(0, symlink(MANIFEST_PLUGIN_PATH, (dir + "/libgfal_plugin_manifest_test.so").c_str()));
+
+        FILE *f = fopen((dir + "/libgfal_plugin_broken.so").c_str(), "w");
+        ASSERT_NE((FILE*)NULL, f);
+        fputs("not a library\n", f);
+        fclose(f);
+
+        f = fopen((dir + "/test.manifest").c_str(), "w");
+        ASSERT_NE((FILE*)NULL, f);
+        fputs("[libgfal_plugin_manifest_test.so]\n"
+              "SCHEMES=lazy\n"
+              "PRIORITY=0\n"
+              "\n"
+              "[libgfal_plugin_broken.so]\n"
+              "SCHEMES=lazy;broken\n"
+              "PRIORITY=100\n", f);
+        fclose(f);
+
+        setenv("GFAL_PLUGIN_DIR", plugin_dir, 1);
+    }
+
+    virtual void TearDown() {
+        std::string cmd = std::string("rm -rf ") + plugin_dir;
+        ASSERT_EQ(0, system(cmd.c_str()));
+    }
+};
+
+static testing::Environment* const manifest_environment =
+    testing::AddGlobalTestEnvironment(new ManifestEnvironment);
+
+
+static const gfal_plugin_module* find_module(const gfal_registry* registry, const char* library)
+{
+    for (int i = 0; i < registry->module_number; ++i) {
+        if (g_str_has_suffix(registry->modules[i].path, library))
+            return &registry->modules[i];
+    }
+    return NULL;
+}
+
+
+static const char *fallback_get_name(void)
+{
+    return "FALLBACK PLUGIN";
+}
+
+
+static gboolean fallback_check_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "broken://", 9) == 0;
+}
+
+
+static int fallback_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_size = 7;
+    return 0;
+}
+
+
+class ManifestTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+
+public:
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+        ASSERT_EQ((void*)NULL, error);
+    }
+
+    virtual void TearDown() {
+        gfal2_context_free(context);
+    }
+};
+
+
+// The tests run in order, the first ones before anything is loaded
+TEST_F(ManifestTest, Parsed)
+{
+    const gfal_registry *registry = gfal_registry_get(NULL);
+    ASSERT_NE((void*)NULL, registry);
+    ASSERT_EQ(2, registry->module_number);
+
+    const gfal_plugin_module *lazy = find_module(registry, "libgfal_plugin_manifest_test.so");
+    ASSERT_NE((void*)NULL, lazy);
+    EXPECT_TRUE(lazy->lazy);
+    EXPECT_EQ(0, lazy->priority);
+    ASSERT_NE((void*)NULL, lazy->schemes);
+    EXPECT_STREQ("lazy", lazy->schemes[0]);
+    EXPECT_EQ(NULL, lazy->schemes[1]);
+
+    const gfal_plugin_module *broken = find_module(registry, "libgfal_plugin_broken.so");
+    ASSERT_NE((void*)NULL, broken);
+    EXPECT_TRUE(broken->lazy);
+    EXPECT_EQ(100, broken->priority);
+    ASSERT_NE((void*)NULL, broken->schemes);
+    EXPECT_STREQ("lazy", broken->schemes[0]);
+    EXPECT_STREQ("broken", broken->schemes[1]);
+    EXPECT_EQ(NULL, broken->schemes[2]);
+}
+
+
+TEST_F(ManifestTest, Deferred)
+{
+    const gfal_registry *registry = gfal_registry_get(NULL);
+    const gfal_plugin_module *lazy = find_module(registry, "libgfal_plugin_manifest_test.so");
+    ASSERT_NE((void*)NULL, lazy);
+    EXPECT_EQ(NULL, lazy->dlhandle);
+
+    // other schemes do not open it
+    GError *error = NULL;
+    struct stat st;
+    EXPECT_LT(gfal2_stat(context, "other://host/file", &st, &error), 0);
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(EPROTONOSUPPORT, error->code);
+    g_clear_error(&error);
+    EXPECT_EQ(NULL, lazy->dlhandle);
+
+    // the broken plugin goes first, fails, and is skipped
+    ASSERT_EQ(0, gfal2_stat(context, "lazy://host/file", &st, &error));
+    EXPECT_EQ((void*)NULL, error);
+    EXPECT_EQ(42, st.st_size);
+    EXPECT_NE((void*)NULL, lazy->dlhandle);
+
+    // and is not tried again
+    ASSERT_EQ(0, gfal2_stat(context, "lazy://host/other", &st, &error));
+    EXPECT_EQ(42, st.st_size);
+}
+
+
+TEST_F(ManifestTest, Broken)
+{
+    GError *error = NULL;
+    struct stat st;
+
+    // nobody else for this scheme
+    EXPECT_LT(gfal2_stat(context, "broken://host/file", &st, &error), 0);
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(EPROTONOSUPPORT, error->code);
+    g_clear_error(&error);
+
+    gfal_plugin_interface fallback;
+    memset(&fallback, 0, sizeof(fallback));
+    fallback.getName = fallback_get_name;
+    fallback.check_plugin_url = fallback_check_url;
+    fallback.statG = fallback_stat;
+    ASSERT_EQ(0, gfal2_register_plugin(context, &fallback, NULL));
+
+    ASSERT_EQ(0, gfal2_stat(context, "broken://host/file", &st, &error));
+    EXPECT_EQ((void*)NULL, error);
+    EXPECT_EQ(7, st.st_size);
+
+    // still listed, by the name of its library
+    gchar **names = gfal2_get_plugin_names(context);
+    ASSERT_NE((void*)NULL, names);
+    bool broken_listed = false, lazy_listed = false;
+    for (gchar **name = names; *name != NULL; ++name) {
+        broken_listed |= g_str_has_suffix(*name, "libgfal_plugin_broken.so");
+        lazy_listed |= (strcmp(*name, "MANIFEST TEST PLUGIN") == 0);
+    }
+    g_strfreev(names);
+    EXPECT_TRUE(broken_listed);
+    EXPECT_TRUE(lazy_listed);
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/gsimplecache/gcachemain.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <string>
+#include <unistd.h>
+
+
+static void int_copy(gpointer original, gpointer copy)
+{
+    *(int*)copy = *(int*)original;
+}
+
+
+static GSimpleCache *new_cache(guint64 size, gint64 ttl_ms = 0,
+    GSimpleCache_Admission admission = GSIMPLECACHE_ADMIT_ALL)
+{
+    // a single shard, so the order of the evictions is known
+    return gsimplecache_new_full(size, 1, ttl_ms, admission, int_copy, sizeof(int));
+}
+
+
+static void add(GSimpleCache *cache, const std::string &key, int value)
+{
+    gsimplecache_add_item_kstr(cache, key.c_str(), &value);
+}
+
+
+static bool has(GSimpleCache *cache, const std::string &key, int *value = NULL)
+{
+    int dummy;
+    return gsimplecache_get_kstr(cache, key.c_str(), value ? value : &dummy) == 0;
+}
+
+
+static std::string key(int i)
+{
+    return "srm://host/path/file" + std::to_string(i);
+}
+
+
+TEST(GSimpleCache, ReadMany)
+{
+    GSimpleCache *cache = new_cache(10);
+    int value = 0;
+
+    EXPECT_FALSE(has(cache, "a"));
+    add(cache, "a", 1);
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(has(cache, "a", &value));
+        EXPECT_EQ(1, value);
+    }
+
+    // a second add replaces the value
+    add(cache, "a", 2);
+    ASSERT_TRUE(has(cache, "a", &value));
+    EXPECT_EQ(2, value);
+
+    EXPECT_TRUE(gsimplecache_remove_kstr(cache, "a"));
+    EXPECT_FALSE(gsimplecache_remove_kstr(cache, "a"));
+    EXPECT_FALSE(has(cache, "a"));
+
+    GSimpleCache_Stats stats;
+    gsimplecache_get_stats(cache, &stats);
+    EXPECT_EQ(6u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(2u, stats.insertions);
+    EXPECT_EQ(0u, stats.size);
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, RemovePrefix)
+{
+    GSimpleCache *cache = gsimplecache_new_full(10, 4, 0, GSIMPLECACHE_ADMIT_ALL, int_copy, sizeof(int));
+    add(cache, "dir", 1);
+    add(cache, "dir/a", 2);
+    add(cache, "dir/b", 3);
+    add(cache, "dir/sub/c", 4);
+    add(cache, "dir2", 5);
+
+    EXPECT_EQ(3u, gsimplecache_remove_prefix(cache, "dir/"));
+    EXPECT_TRUE(has(cache, "dir"));
+    EXPECT_FALSE(has(cache, "dir/a"));
+    EXPECT_FALSE(has(cache, "dir/b"));
+    EXPECT_FALSE(has(cache, "dir/sub/c"));
+    EXPECT_TRUE(has(cache, "dir2"));
+    EXPECT_EQ(0u, gsimplecache_remove_prefix(cache, "dir/"));
+
+    GSimpleCache_Stats stats;
+    gsimplecache_get_stats(cache, &stats);
+    EXPECT_EQ(2u, stats.size);
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, LeastRecentlyUsed)
+{
+    GSimpleCache *cache = new_cache(3);
+    add(cache, "a", 1);
+    add(cache, "b", 2);
+    add(cache, "c", 3);
+    EXPECT_TRUE(has(cache, "a"));
+
+    // only the least recently used goes, not the whole table
+    add(cache, "d", 4);
+    EXPECT_FALSE(has(cache, "b"));
+    EXPECT_TRUE(has(cache, "a"));
+    EXPECT_TRUE(has(cache, "c"));
+    EXPECT_TRUE(has(cache, "d"));
+
+    GSimpleCache_Stats stats;
+    gsimplecache_get_stats(cache, &stats);
+    EXPECT_EQ(1u, stats.evictions);
+    EXPECT_EQ(3u, stats.size);
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, Expiration)
+{
+    GSimpleCache *cache = new_cache(10, 50);
+    int value = 10;
+    add(cache, "a", 1);
+    gsimplecache_add_item_kstr_ttl(cache, "b", &value, 0);
+    EXPECT_TRUE(has(cache, "a"));
+
+    usleep(100000);
+    EXPECT_FALSE(has(cache, "a"));
+    EXPECT_TRUE(has(cache, "b"));
+
+    // replacing the value restarts the ttl
+    add(cache, "c", 1);
+    usleep(30000);
+    add(cache, "c", 2);
+    usleep(30000);
+    EXPECT_TRUE(has(cache, "c"));
+
+    GSimpleCache_Stats stats;
+    gsimplecache_get_stats(cache, &stats);
+    EXPECT_EQ(1u, stats.expirations);
+    gsimplecache_delete(cache);
+}
+
+
+// A listing as large as the cache does not push out the entries being used
+TEST(GSimpleCache, AdmissionScan)
+{
+    const int size = 100;
+    GSimpleCache *caches[2] = {
+        new_cache(size, 0, GSIMPLECACHE_ADMIT_ALL),
+        new_cache(size, 0, GSIMPLECACHE_ADMIT_FREQUENT)
+    };
+
+    for (int c = 0; c < 2; ++c) {
+        for (int i = 0; i < size; ++i) {
+            add(caches[c], key(i), i);
+        }
+        for (int i = 0; i < size / 2; ++i) {
+            EXPECT_TRUE(has(caches[c], key(i)));
+        }
+        for (int i = size; i < 2 * size; ++i) {
+            add(caches[c], key(i), i);
+        }
+    }
+
+    int kept[2] = {0, 0};
+    for (int c = 0; c < 2; ++c) {
+        for (int i = 0; i < size / 2; ++i) {
+            kept[c] += has(caches[c], key(i));
+        }
+    }
+    EXPECT_EQ(0, kept[0]);
+    EXPECT_EQ(size / 2, kept[1]);
+
+    GSimpleCache_Stats stats;
+    gsimplecache_get_stats(caches[1], &stats);
+    EXPECT_EQ((guint64)size / 2, stats.rejections);
+    EXPECT_EQ((guint64)size / 2, stats.evictions);
+    EXPECT_EQ((guint64)size, stats.size);
+
+    gsimplecache_delete(caches[0]);
+    gsimplecache_delete(caches[1]);
+}
+
+
+// A key offered again soon enough is stored
+TEST(GSimpleCache, AdmissionSecondOffer)
+{
+    GSimpleCache *cache = new_cache(2, 0, GSIMPLECACHE_ADMIT_FREQUENT);
+    add(cache, "a", 1);
+    add(cache, "b", 2);
+    EXPECT_TRUE(has(cache, "a"));
+    EXPECT_TRUE(has(cache, "b"));
+
+    add(cache, "c", 3);
+    EXPECT_FALSE(has(cache, "c"));
+    add(cache, "c", 3);
+    EXPECT_TRUE(has(cache, "c"));
+    EXPECT_EQ(1, has(cache, "a") + has(cache, "b"));
+    gsimplecache_delete(cache);
+}
+
+
+static void *concurrent_worker(void *data)
+{
+    GSimpleCache *cache = (GSimpleCache*)data;
+    for (int i = 0; i < 20000; ++i) {
+        int n = (i * 7919) % 500;
+        int value;
+        if (gsimplecache_get_kstr(cache, key(n).c_str(), &value) == 0) {
+            EXPECT_EQ(n, value);
+        }
+        else {
+            add(cache, key(n), n);
+        }
+        if (i % 97 == 0) {
+            gsimplecache_remove_kstr(cache, key(n).c_str());
+        }
+    }
+    return NULL;
+}
+
+
+TEST(GSimpleCache, Concurrent)
+{
+    GSimpleCache *cache = gsimplecache_new(200, int_copy, sizeof(int));
+    pthread_t threads[4];
+    for (int i = 0; i < 4; ++i) {
+        pthread_create(&threads[i], NULL, concurrent_worker, cache);
+    }
+    for (int i = 0; i < 4; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    GSimpleCache_Stats stats;
+    gsimplecache_get_stats(cache, &stats);
+    EXPECT_EQ(80000u, stats.hits + stats.misses);
+    // the capacity is rounded up to a multiple of the shards
+    EXPECT_LE(stats.size, 208u);
+    gsimplecache_delete(cache);
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+
+static std::vector<std::string> log_messages;
+static pthread_mutex_t log_messages_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void logger_test_handler(const gchar *log_domain, GLogLevelFlags log_level,
+    const gchar *message, gpointer user_data)
+{
+    pthread_mutex_lock(&log_messages_lock);
+    log_messages.push_back(message);
+    pthread_mutex_unlock(&log_messages_lock);
+}
+
+
+class LoggerTest: public testing::Test {
+protected:
+    guint handler_id;
+
+    void SetUp() {
+        log_messages.clear();
+        handler_id = gfal2_log_set_handler(logger_test_handler, NULL);
+        gfal2_log_set_level(G_LOG_LEVEL_WARNING);
+    }
+
+    void TearDown() {
+        gfal2_log_set_mode(GFAL2_LOG_SYNC);
+        gfal2_log_set_level(G_LOG_LEVEL_WARNING);
+        g_log_remove_handler("GFAL2", handler_id);
+    }
+};
+
+
+static int evaluated = 0;
+
+static int logger_count_evaluation(void)
+{
+    return ++evaluated;
+}
+
+
+TEST_F(LoggerTest, DomainLevels)
+{
+    gfal2_log(G_LOG_LEVEL_DEBUG, "hidden");
+    gfal2_log_domain("LOGGER TEST", G_LOG_LEVEL_DEBUG, "hidden");
+    EXPECT_EQ(0, log_messages.size());
+
+    ASSERT_EQ(0, gfal2_log_set_domain_level("LOGGER TEST", G_LOG_LEVEL_DEBUG));
+    EXPECT_EQ(G_LOG_LEVEL_DEBUG, gfal2_log_get_domain_level("LOGGER TEST"));
+    EXPECT_EQ(G_LOG_LEVEL_WARNING, gfal2_log_get_level());
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "hidden");
+    gfal2_log_domain("OTHER DOMAIN", G_LOG_LEVEL_DEBUG, "hidden");
+    gfal2_log_domain("LOGGER TEST", G_LOG_LEVEL_DEBUG, "visible %d", 1);
+    ASSERT_EQ(1, log_messages.size());
+    EXPECT_EQ("visible 1", log_messages[0]);
+
+    // the arguments are not evaluated for a disabled level
+    evaluated = 0;
+    GFAL2_LOG_DOMAIN("OTHER DOMAIN", G_LOG_LEVEL_DEBUG, "%d", logger_count_evaluation());
+    EXPECT_EQ(0, evaluated);
+    GFAL2_LOG_DOMAIN("LOGGER TEST", G_LOG_LEVEL_DEBUG, "%d", logger_count_evaluation());
+    EXPECT_EQ(1, evaluated);
+
+    // back to the default
+    gfal2_log_set_domain_level("LOGGER TEST", (GLogLevelFlags)0);
+    EXPECT_EQ(G_LOG_LEVEL_WARNING, gfal2_log_get_domain_level("LOGGER TEST"));
+    EXPECT_FALSE(gfal2_log_is_enabled("LOGGER TEST", G_LOG_LEVEL_DEBUG));
+    EXPECT_TRUE(gfal2_log_is_enabled("LOGGER TEST", G_LOG_LEVEL_WARNING));
+}
+
+
+TEST_F(LoggerTest, Async)
+{
+    ASSERT_EQ(0, gfal2_log_set_mode(GFAL2_LOG_ASYNC));
+    EXPECT_EQ(GFAL2_LOG_ASYNC, gfal2_log_get_mode());
+
+    std::string long_message(2000, 'x');
+    for (int i = 0; i < 5000; ++i) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "message %d", i);
+    }
+    gfal2_log(G_LOG_LEVEL_WARNING, "%s", long_message.c_str());
+    gfal2_log_flush();
+
+    ASSERT_EQ(5001, log_messages.size());
+    EXPECT_EQ("message 0", log_messages[0]);
+    EXPECT_EQ("message 4999", log_messages[4999]);
+    EXPECT_EQ(long_message, log_messages[5000]);
+
+    // switching back drains the ring
+    gfal2_log(G_LOG_LEVEL_WARNING, "last");
+    ASSERT_EQ(0, gfal2_log_set_mode(GFAL2_LOG_SYNC));
+    EXPECT_EQ("last", log_messages.back());
+}
+
+
+TEST_F(LoggerTest, AsyncBinary)
+{
+    ASSERT_EQ(0, gfal2_log_set_mode(GFAL2_LOG_ASYNC_BINARY));
+
+    char url[64];
+    strcpy(url, "gsiftp://host/path");
+    gfal2_log(G_LOG_LEVEL_WARNING, "%s %d %5.2f %lld %zu %x %c %% %-6s| %.*s %hhd %lu",
+        url, -42, 3.14159, 1234567890123LL, (size_t)17, 255, 'z', "ab", 3, "abcdef", 300, 42UL);
+    // the argument is copied when queued
+    strcpy(url, "overwritten");
+    // not handled by the binary mode, formatted when queued
+    gfal2_log(G_LOG_LEVEL_WARNING, "%2$s %1$s", "world", "hello");
+    gfal2_log_flush();
+
+    ASSERT_EQ(2, log_messages.size());
+    char expected[256];
+    snprintf(expected, sizeof(expected), "%s %d %5.2f %lld %zu %x %c %% %-6s| %.*s %hhd %lu",
+        "gsiftp://host/path", -42, 3.14159, 1234567890123LL, (size_t)17, 255, 'z', "ab", 3, "abcdef", 300, 42UL);
+    EXPECT_EQ(expected, log_messages[0]);
+    EXPECT_EQ("hello world", log_messages[1]);
+}
+
+
+static void* logger_producer(void* data)
+{
+    for (int i = 0; i < 10000; ++i) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "thread message %d", i);
+    }
+    return NULL;
+}
+
+
+TEST_F(LoggerTest, AsyncConcurrent)
+{
+    ASSERT_EQ(0, gfal2_log_set_mode(GFAL2_LOG_ASYNC));
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; ++i)
+        pthread_create(&threads[i], NULL, logger_producer, NULL);
+    for (int i = 0; i < 4; ++i)
+        pthread_join(threads[i], NULL);
+    gfal2_log_flush();
+
+    EXPECT_EQ(40000, log_messages.size());
+}
+
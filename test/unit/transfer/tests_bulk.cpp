@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_config.h>
+#include <checksums/checksums.h>
+#include <pthread.h>
+#include <map>
+#include <vector>
+#include <string>
+#include <unistd.h>
+
+
+// Files stored as bulk://host/path
+struct BulkStorage {
+    std::map<std::string, std::string> files;
+    pthread_mutex_t lock;
+    useconds_t read_delay;
+
+    // copies reading from or writing to each host
+    std::map<std::string, int> running;
+    std::map<std::string, int> max_running;
+    int sources_open;
+    int max_sources_open;
+    // sources opened by a thread without this operation attached
+    gfal_operation_t operation;
+    int opened_outside_operation;
+};
+
+
+struct BulkFile {
+    std::string url;
+    std::string host;
+    bool is_source;
+    size_t offset;
+};
+
+
+static std::string bulk_host(const char *url)
+{
+    std::string host(url + 7);
+    return host.substr(0, host.find('/'));
+}
+
+
+static const char *bulk_get_name(void)
+{
+    return "BULK PLUGIN";
+}
+
+
+static gboolean bulk_check_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "bulk://", 7) == 0;
+}
+
+
+static int bulk_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    pthread_mutex_lock(&storage->lock);
+    std::map<std::string, std::string>::iterator i = storage->files.find(url);
+    int ret = -1;
+    if (i == storage->files.end()) {
+        gfal2_set_error(err, g_quark_from_static_string("BULK"), ENOENT, __func__, "No such file");
+    }
+    else {
+        memset(buf, 0, sizeof(*buf));
+        buf->st_mode = S_IFREG | 0644;
+        buf->st_size = i->second.size();
+        ret = 0;
+    }
+    pthread_mutex_unlock(&storage->lock);
+    return ret;
+}
+
+
+static int bulk_unlink(plugin_handle plugin_data, const char *url, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    pthread_mutex_lock(&storage->lock);
+    storage->files.erase(url);
+    pthread_mutex_unlock(&storage->lock);
+    return 0;
+}
+
+
+static gfal_file_handle bulk_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    BulkFile *file = new BulkFile;
+    file->url = url;
+    file->host = bulk_host(url);
+    file->is_source = ((flag & O_ACCMODE) == O_RDONLY);
+    file->offset = 0;
+
+    pthread_mutex_lock(&storage->lock);
+    if (file->is_source) {
+        if (storage->files.find(url) == storage->files.end()) {
+            pthread_mutex_unlock(&storage->lock);
+            gfal2_set_error(err, g_quark_from_static_string("BULK"), ENOENT, __func__, "No such file");
+            delete file;
+            return NULL;
+        }
+        storage->sources_open += 1;
+        if (gfal2_operation_get_attached() != storage->operation)
+            storage->opened_outside_operation += 1;
+        storage->max_sources_open = std::max(storage->max_sources_open, storage->sources_open);
+    }
+    else {
+        storage->files[url].clear();
+    }
+    int running = ++storage->running[file->host];
+    storage->max_running[file->host] = std::max(storage->max_running[file->host], running);
+    pthread_mutex_unlock(&storage->lock);
+
+    return gfal_file_handle_new(bulk_get_name(), file);
+}
+
+
+static ssize_t bulk_read(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    BulkFile *file = (BulkFile*)gfal_file_handle_get_fdesc(fd);
+
+    usleep(storage->read_delay);
+
+    pthread_mutex_lock(&storage->lock);
+    const std::string &data = storage->files[file->url];
+    size_t n = std::min(count, data.size() - file->offset);
+    memcpy(buff, data.data() + file->offset, n);
+    pthread_mutex_unlock(&storage->lock);
+    file->offset += n;
+    return n;
+}
+
+
+static ssize_t bulk_write(plugin_handle plugin_data, gfal_file_handle fd,
+    const void *buff, size_t count, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    BulkFile *file = (BulkFile*)gfal_file_handle_get_fdesc(fd);
+
+    pthread_mutex_lock(&storage->lock);
+    storage->files[file->url].append((const char*)buff, count);
+    pthread_mutex_unlock(&storage->lock);
+    return count;
+}
+
+
+static int bulk_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    BulkFile *file = (BulkFile*)gfal_file_handle_get_fdesc(fd);
+
+    pthread_mutex_lock(&storage->lock);
+    if (file->is_source)
+        storage->sources_open -= 1;
+    storage->running[file->host] -= 1;
+    pthread_mutex_unlock(&storage->lock);
+
+    delete file;
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static int bulk_checksum(plugin_handle plugin_data, const char *url, const char *check_type,
+    char *checksum_buffer, size_t buffer_length, off_t start_offset, size_t data_length, GError **err)
+{
+    BulkStorage *storage = (BulkStorage*)plugin_data;
+    gfal_checksum_stream_t stream = gfal_checksum_stream_new(check_type);
+    if (stream == NULL) {
+        gfal2_set_error(err, g_quark_from_static_string("BULK"), ENOSYS, __func__, "Not supported");
+        return -1;
+    }
+    pthread_mutex_lock(&storage->lock);
+    std::map<std::string, std::string>::iterator i = storage->files.find(url);
+    if (i == storage->files.end()) {
+        pthread_mutex_unlock(&storage->lock);
+        gfal_checksum_stream_free(stream);
+        gfal2_set_error(err, g_quark_from_static_string("BULK"), ENOENT, __func__, "No such file");
+        return -1;
+    }
+    gfal_checksum_stream_update(stream, i->second.data(), i->second.size());
+    pthread_mutex_unlock(&storage->lock);
+    gfal_checksum_stream_final(stream, checksum_buffer, buffer_length);
+    gfal_checksum_stream_free(stream);
+    return 0;
+}
+
+
+class BulkCopyTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    BulkStorage storage;
+    std::vector<std::string> sources, destinations;
+
+    void SetUp() {
+        context = gfal2_context_new(NULL);
+        ASSERT_TRUE(context != NULL);
+        params = gfalt_params_handle_new(NULL);
+        gfalt_set_replace_existing_file(params, TRUE, NULL);
+
+        pthread_mutex_init(&storage.lock, NULL);
+        storage.read_delay = 20000;
+        storage.sources_open = storage.max_sources_open = 0;
+        storage.operation = NULL;
+        storage.opened_outside_operation = 0;
+
+        // 12 files on 3 source hosts, to 2 destination hosts
+        for (int i = 0; i < 12; ++i) {
+            char src[64], dst[64];
+            snprintf(src, sizeof(src), "bulk://source%d/file%d", i % 3, i);
+            snprintf(dst, sizeof(dst), "bulk://destination%d/file%d", i % 2, i);
+            sources.push_back(src);
+            destinations.push_back(dst);
+            storage.files[src] = std::string(1000 + i * 100, (char)('a' + i));
+        }
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.plugin_data = &storage;
+        plugin.getName = bulk_get_name;
+        plugin.check_plugin_url = bulk_check_url;
+        plugin.statG = bulk_stat;
+        plugin.unlinkG = bulk_unlink;
+        plugin.openG = bulk_open;
+        plugin.readG = bulk_read;
+        plugin.writeG = bulk_write;
+        plugin.closeG = bulk_close;
+        plugin.checksum_calcG = bulk_checksum;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+        gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, "COPY_BUFFERSIZE", 500, NULL);
+    }
+
+    void TearDown() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+        pthread_mutex_destroy(&storage.lock);
+    }
+
+    int copy(const char* const* checksums, GError **op_error, GError ***file_errors) {
+        std::vector<const char*> srcs, dsts;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            srcs.push_back(sources[i].c_str());
+            dsts.push_back(destinations[i].c_str());
+        }
+        return gfalt_copy_bulk(context, params, sources.size(), &srcs[0], &dsts[0], checksums,
+            op_error, file_errors);
+    }
+
+    void free_errors(GError **file_errors) {
+        for (size_t i = 0; i < sources.size(); ++i)
+            g_clear_error(&file_errors[i]);
+        g_free(file_errors);
+    }
+
+    void expect_copied() {
+        for (size_t i = 0; i < sources.size(); ++i)
+            EXPECT_EQ(storage.files[sources[i]], storage.files[destinations[i]]) << sources[i];
+    }
+};
+
+
+TEST_F(BulkCopyTest, Serial)
+{
+    GError *op_error = NULL, **file_errors = NULL;
+
+    ASSERT_EQ(0, copy(NULL, &op_error, &file_errors));
+    ASSERT_TRUE(op_error == NULL);
+    for (size_t i = 0; i < sources.size(); ++i)
+        EXPECT_TRUE(file_errors[i] == NULL);
+    expect_copied();
+    EXPECT_EQ(1, storage.max_sources_open);
+    free_errors(file_errors);
+}
+
+
+TEST_F(BulkCopyTest, Concurrent)
+{
+    GError *op_error = NULL, **file_errors = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_BULK_CONCURRENCY, 4, NULL);
+
+    ASSERT_EQ(0, copy(NULL, &op_error, &file_errors));
+    ASSERT_TRUE(op_error == NULL);
+    for (size_t i = 0; i < sources.size(); ++i)
+        EXPECT_TRUE(file_errors[i] == NULL);
+    expect_copied();
+    EXPECT_LE(storage.max_sources_open, 4);
+    EXPECT_GT(storage.max_sources_open, 1);
+    free_errors(file_errors);
+}
+
+
+TEST_F(BulkCopyTest, ConcurrentOperation)
+{
+    GError *op_error = NULL, **file_errors = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_BULK_CONCURRENCY, 4, NULL);
+
+    // the workers copy on behalf of the operation of the caller
+    storage.operation = gfal2_operation_new(context);
+    gfal_operation_t previous = gfal2_operation_attach(storage.operation);
+    ASSERT_EQ(0, copy(NULL, &op_error, &file_errors));
+    gfal2_operation_attach(previous);
+    gfal2_operation_free(storage.operation);
+
+    ASSERT_TRUE(op_error == NULL);
+    expect_copied();
+    EXPECT_GT(storage.max_sources_open, 1);
+    EXPECT_EQ(0, storage.opened_outside_operation);
+    free_errors(file_errors);
+}
+
+
+TEST_F(BulkCopyTest, ConcurrentPerHost)
+{
+    GError *op_error = NULL, **file_errors = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_BULK_CONCURRENCY, 6, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_BULK_CONCURRENCY_PER_HOST, 1, NULL);
+
+    ASSERT_EQ(0, copy(NULL, &op_error, &file_errors));
+    ASSERT_TRUE(op_error == NULL);
+    expect_copied();
+    // limited by the two destinations
+    EXPECT_LE(storage.max_sources_open, 2);
+    std::map<std::string, int>::const_iterator i;
+    for (i = storage.max_running.begin(); i != storage.max_running.end(); ++i)
+        EXPECT_EQ(1, i->second) << i->first;
+    free_errors(file_errors);
+}
+
+
+TEST_F(BulkCopyTest, ConcurrentChecksums)
+{
+    GError *op_error = NULL, **file_errors = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_BULK_CONCURRENCY, 4, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, NULL, NULL, NULL);
+
+    // a wrong checksum for one file, the right one for the others
+    std::vector<std::string> values;
+    std::vector<const char*> checksums;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        char buffer[64];
+        bulk_checksum(&storage, sources[i].c_str(), "ADLER32", buffer, sizeof(buffer), 0, 0, NULL);
+        values.push_back(i == 5 ? std::string("ADLER32:00000001") : std::string("ADLER32:") + buffer);
+    }
+    for (size_t i = 0; i < sources.size(); ++i)
+        checksums.push_back(values[i].c_str());
+    // a missing source
+    sources[7] = "bulk://source1/missing";
+
+    ASSERT_EQ(-2, copy(&checksums[0], &op_error, &file_errors));
+    ASSERT_TRUE(op_error == NULL);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (i == 5) {
+            ASSERT_TRUE(file_errors[i] != NULL);
+            EXPECT_EQ(EIO, file_errors[i]->code);
+        }
+        else if (i == 7) {
+            ASSERT_TRUE(file_errors[i] != NULL);
+            EXPECT_EQ(ENOENT, file_errors[i]->code);
+        }
+        else {
+            EXPECT_TRUE(file_errors[i] == NULL) << file_errors[i]->message;
+            EXPECT_EQ(storage.files[sources[i]], storage.files[destinations[i]]);
+        }
+    }
+    // the shared parameters are untouched
+    char type[64], value[64];
+    gfalt_get_checksum(params, type, sizeof(type), value, sizeof(value), NULL);
+    EXPECT_STREQ("", value);
+    free_errors(file_errors);
+}
@@ -206,3 +206,36 @@ TEST(gfalTransfer, test_inject_callback_bulk)
 
     gfalt_params_handle_delete(params, NULL);
 }
+
+
+TEST(gfalTransfer, test_inject_callback_async)
+{
+    int counter = 0;
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+
+    test_plugin.getName = test_plugin_name;
+    test_plugin.copy_enter_hook = test_plugin_enter_hook;
+    test_plugin.plugin_data = &counter;
+    test_plugin.check_plugin_url_transfer = test_plugin_check_transfer;
+    test_plugin.copy_file = test_plugin_copy;
+
+    gfal2_context_t context = gfal2_context_new(NULL);
+    gfal2_register_plugin(context, &test_plugin, NULL);
+
+    gfal2_async_queue_t queue = gfal2_async_queue_new(context, NULL);
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfal2_async_op_t op = gfal2_async_copy(queue, params, "test://", "test://", &counter, NULL);
+    g_assert(op != NULL);
+    gfalt_params_handle_delete(params, NULL);
+
+    g_assert(gfal2_async_wait(queue, -1) == op);
+    g_assert(gfal2_async_get_type(op) == GFAL_ASYNC_COPY);
+    g_assert(gfal2_async_get_user_data(op) == &counter);
+    g_assert(gfal2_async_get_result(op, NULL) == 0);
+    g_assert(counter == 4);
+    gfal2_async_op_free(op);
+
+    gfal2_async_queue_free(queue);
+    gfal2_context_free(context);
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/fs.h>
+
+// Copies between local files, done by the file plugin built into this test
+extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+
+
+// The kernel calls tried by the plugin are replaced, so each method can be made to fail
+static bool clone_works = false;
+static int range_errno = 0;
+static int sendfile_errno = 0;
+static int clone_calls = 0;
+static int range_calls = 0;
+static int sendfile_calls = 0;
+
+
+extern "C" int ioctl(int fd, unsigned long request, ...)
+{
+    va_list args;
+    va_start(args, request);
+    void *arg = va_arg(args, void*);
+    va_end(args);
+
+#ifdef FICLONE
+    if (request == FICLONE) {
+        ++clone_calls;
+        if (!clone_works) {
+            errno = EOPNOTSUPP;
+            return -1;
+        }
+        // as a reflink would, without moving the offsets
+        int src_fd = (int)(long)arg;
+        char buffer[65536];
+        off_t offset = 0;
+        ssize_t n;
+        while ((n = pread(src_fd, buffer, sizeof(buffer), offset)) > 0) {
+            if (pwrite(fd, buffer, n, offset) != n)
+                return -1;
+            offset += n;
+        }
+        return (n < 0) ? -1 : 0;
+    }
+#endif
+    typedef int (*ioctl_t)(int, unsigned long, ...);
+    static ioctl_t real_ioctl = (ioctl_t)dlsym(RTLD_NEXT, "ioctl");
+    return real_ioctl(fd, request, arg);
+}
+
+
+extern "C" ssize_t copy_file_range(int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
+    size_t len, unsigned int flags)
+{
+    ++range_calls;
+    if (range_errno) {
+        errno = range_errno;
+        return -1;
+    }
+    typedef ssize_t (*copy_file_range_t)(int, off64_t*, int, off64_t*, size_t, unsigned int);
+    static copy_file_range_t real_copy_file_range = (copy_file_range_t)dlsym(RTLD_NEXT, "copy_file_range");
+    if (real_copy_file_range == NULL) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return real_copy_file_range(fd_in, off_in, fd_out, off_out, len, flags);
+}
+
+
+extern "C" ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    ++sendfile_calls;
+    if (sendfile_errno) {
+        errno = sendfile_errno;
+        return -1;
+    }
+    typedef ssize_t (*sendfile_t)(int, int, off_t*, size_t);
+    static sendfile_t real_sendfile = (sendfile_t)dlsym(RTLD_NEXT, "sendfile");
+    return real_sendfile(out_fd, in_fd, offset, count);
+}
+
+
+class FileCopyTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    char dir[64];
+    std::string content;
+    std::string src, dst;
+
+public:
+    virtual void SetUp() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_NE((void*)NULL, context);
+        gfal_plugin_interface plugin = gfal_plugin_init(context, NULL);
+        gfal2_register_plugin(context, &plugin, NULL);
+        // several chunks per copy
+        gfal2_set_opt_integer(context, "CORE", "COPY_BUFFERSIZE", 65536, NULL);
+        params = gfalt_params_handle_new(NULL);
+
+        strcpy(dir, "/tmp/gfal2_filecopy_XXXXXX");
+        ASSERT_NE((char*)NULL, mkdtemp(dir));
+        src = std::string("file://") + dir + "/source";
+        dst = std::string("file://") + dir + "/destination";
+
+        content.resize(300000);
+        for (size_t i = 0; i < content.size(); ++i) {
+            content[i] = (char)(i * 7 + i / 251);
+        }
+        write_file(src, content);
+
+        clone_works = false;
+        range_errno = sendfile_errno = 0;
+        clone_calls = range_calls = sendfile_calls = 0;
+    }
+
+    virtual void TearDown() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+        std::string cmd = std::string("rm -rf ") + dir;
+        ASSERT_EQ(0, system(cmd.c_str()));
+    }
+
+    void write_file(const std::string &url, const std::string &data) {
+        int fd = open(url.c_str() + 7, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ((ssize_t)data.size(), write(fd, data.data(), data.size()));
+        close(fd);
+    }
+
+    std::string read_file(const std::string &url) {
+        std::string data;
+        char buffer[65536];
+        int fd = open(url.c_str() + 7, O_RDONLY);
+        if (fd < 0)
+            return "<missing>";
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+            data.append(buffer, n);
+        close(fd);
+        return data;
+    }
+
+    int copy(GError **err) {
+        return gfalt_copy_file(context, params, src.c_str(), dst.c_str(), err);
+    }
+};
+
+
+#ifdef FICLONE
+TEST_F(FileCopyTest, Clone)
+{
+    GError *err = NULL;
+    clone_works = true;
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+    EXPECT_EQ(1, clone_calls);
+    EXPECT_EQ(0, range_calls);
+    EXPECT_EQ(0, sendfile_calls);
+}
+#endif
+
+
+TEST_F(FileCopyTest, CopyFileRange)
+{
+    GError *err = NULL;
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+    // the system call itself may not be there, then sendfile takes over
+    EXPECT_GE(range_calls, 1);
+}
+
+
+TEST_F(FileCopyTest, SendfileFallback)
+{
+    GError *err = NULL;
+    range_errno = EXDEV;
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+    // not tried again once it failed
+    EXPECT_EQ(1, range_calls);
+    EXPECT_GE(sendfile_calls, 1);
+}
+
+
+TEST_F(FileCopyTest, ReadWriteFallback)
+{
+    GError *err = NULL;
+    range_errno = ENOSYS;
+    sendfile_errno = EINVAL;
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+    EXPECT_EQ(1, range_calls);
+    EXPECT_EQ(1, sendfile_calls);
+}
+
+
+TEST_F(FileCopyTest, Failure)
+{
+    GError *err = NULL;
+    range_errno = EIO;
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(EIO, err->code);
+    EXPECT_EQ(0, sendfile_calls);
+    g_error_free(err);
+}
+
+
+TEST_F(FileCopyTest, EmptySource)
+{
+    GError *err = NULL;
+    write_file(src, "");
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_EQ("", read_file(dst));
+    // nothing to clone, read until the end
+    EXPECT_EQ(0, clone_calls);
+    EXPECT_EQ(0, range_calls);
+}
+
+
+TEST_F(FileCopyTest, Overwrite)
+{
+    GError *err = NULL;
+    write_file(dst, "previous");
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(EEXIST, err->code);
+    g_clear_error(&err);
+    EXPECT_EQ("previous", read_file(dst));
+
+    gfalt_set_replace_existing_file(params, TRUE, NULL);
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+}
+
+
+TEST_F(FileCopyTest, CreateParent)
+{
+    GError *err = NULL;
+    dst = std::string("file://") + dir + "/a/b/destination";
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(ENOENT, err->code);
+    g_clear_error(&err);
+
+    gfalt_set_create_parent_dir(params, TRUE, NULL);
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+}
+
+
+TEST_F(FileCopyTest, Checksum)
+{
+    GError *err = NULL;
+    char checksum[64];
+    ASSERT_EQ(0, gfal2_checksum(context, src.c_str(), "ADLER32", 0, 0, checksum, sizeof(checksum), &err));
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, "ADLER32", checksum, NULL);
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_TRUE(read_file(dst) == content);
+}
+
+
+TEST_F(FileCopyTest, ChecksumMismatch)
+{
+    GError *err = NULL;
+    // the source is checked before anything is written
+    gfalt_set_checksum(params, GFALT_CHECKSUM_SOURCE, "ADLER32", "12345678", NULL);
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(EIO, err->code);
+    g_clear_error(&err);
+    EXPECT_EQ("<missing>", read_file(dst));
+
+    // the destination after the copy
+    gfalt_set_checksum(params, GFALT_CHECKSUM_TARGET, "ADLER32", "12345678", NULL);
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(EIO, err->code);
+    EXPECT_TRUE(strstr(err->message, "MISMATCH") != NULL);
+    g_clear_error(&err);
+}
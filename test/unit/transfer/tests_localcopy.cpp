@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_config.h>
+#include <checksums/checksums.h>
+#include <pthread.h>
+#include <string>
+#include <unistd.h>
+
+
+// Copies from memory://source to memory://destination
+struct MemoryStorage {
+    std::string source;
+    std::string destination;
+    pthread_mutex_t lock;
+    // the plugin never returns more than this per read
+    size_t max_read;
+    useconds_t read_delay;
+    // fail when reading or writing past these offsets
+    size_t fail_read_at;
+    size_t fail_write_at;
+
+    size_t read_total;
+    size_t written_total;
+    // most bytes read and not yet written
+    size_t max_pending;
+    size_t pread_calls;
+    size_t source_checksum_calls;
+    size_t destination_checksum_calls;
+    // reads done by a thread without this operation attached
+    gfal_operation_t operation;
+    size_t reads_outside_operation;
+};
+
+
+struct MemoryFile {
+    bool is_source;
+    size_t offset;
+};
+
+
+static const char *memory_get_name(void)
+{
+    return "MEMORY PLUGIN";
+}
+
+
+static gboolean memory_check_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "memory://", 9) == 0;
+}
+
+
+static int memory_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    MemoryStorage *storage = (MemoryStorage*)plugin_data;
+    if (strcmp(url, "memory://source") != 0) {
+        gfal2_set_error(err, g_quark_from_static_string("MEMORY"), ENOENT, __func__, "No such file");
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    buf->st_size = storage->source.size();
+    return 0;
+}
+
+
+static gfal_file_handle memory_open(plugin_handle plugin_data, const char *url,
+    int flag, mode_t mode, GError **err)
+{
+    MemoryFile *file = new MemoryFile;
+    file->is_source = (strcmp(url, "memory://source") == 0);
+    file->offset = 0;
+    return gfal_file_handle_new(memory_get_name(), file);
+}
+
+
+static ssize_t memory_read(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, GError **err)
+{
+    MemoryStorage *storage = (MemoryStorage*)plugin_data;
+    MemoryFile *file = (MemoryFile*)gfal_file_handle_get_fdesc(fd);
+
+    if (storage->read_delay)
+        usleep(storage->read_delay);
+    if (file->offset >= storage->fail_read_at) {
+        gfal2_set_error(err, g_quark_from_static_string("MEMORY"), EIO, __func__, "Read failure");
+        return -1;
+    }
+
+    size_t n = std::min(std::min(count, storage->max_read), storage->source.size() - file->offset);
+    memcpy(buff, storage->source.data() + file->offset, n);
+    file->offset += n;
+
+    pthread_mutex_lock(&storage->lock);
+    storage->read_total += n;
+    if (gfal2_operation_get_attached() != storage->operation)
+        storage->reads_outside_operation += 1;
+    pthread_mutex_unlock(&storage->lock);
+    return n;
+}
+
+
+static ssize_t memory_write(plugin_handle plugin_data, gfal_file_handle fd,
+    const void *buff, size_t count, GError **err)
+{
+    MemoryStorage *storage = (MemoryStorage*)plugin_data;
+    MemoryFile *file = (MemoryFile*)gfal_file_handle_get_fdesc(fd);
+
+    if (file->offset + count > storage->fail_write_at) {
+        gfal2_set_error(err, g_quark_from_static_string("MEMORY"), ENOSPC, __func__, "Write failure");
+        return -1;
+    }
+
+    pthread_mutex_lock(&storage->lock);
+    storage->max_pending = std::max(storage->max_pending, storage->read_total - storage->written_total);
+    storage->written_total += count;
+    pthread_mutex_unlock(&storage->lock);
+
+    storage->destination.append((const char*)buff, count);
+    file->offset += count;
+    return count;
+}
+
+
+static ssize_t memory_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err)
+{
+    MemoryStorage *storage = (MemoryStorage*)plugin_data;
+
+    if ((size_t)offset >= storage->fail_read_at) {
+        gfal2_set_error(err, g_quark_from_static_string("MEMORY"), EIO, __func__, "Read failure");
+        return -1;
+    }
+
+    size_t n = std::min(std::min(count, storage->max_read), storage->source.size() - offset);
+    memcpy(buff, storage->source.data() + offset, n);
+
+    pthread_mutex_lock(&storage->lock);
+    storage->read_total += n;
+    storage->pread_calls += 1;
+    if (gfal2_operation_get_attached() != storage->operation)
+        storage->reads_outside_operation += 1;
+    pthread_mutex_unlock(&storage->lock);
+    return n;
+}
+
+
+static ssize_t memory_pwrite(plugin_handle plugin_data, gfal_file_handle fd,
+    const void *buff, size_t count, off_t offset, GError **err)
+{
+    MemoryStorage *storage = (MemoryStorage*)plugin_data;
+
+    if (offset + count > storage->fail_write_at) {
+        gfal2_set_error(err, g_quark_from_static_string("MEMORY"), ENOSPC, __func__, "Write failure");
+        return -1;
+    }
+
+    pthread_mutex_lock(&storage->lock);
+    if (storage->destination.size() < offset + count)
+        storage->destination.resize(offset + count);
+    memcpy(&storage->destination[offset], buff, count);
+    storage->written_total += count;
+    pthread_mutex_unlock(&storage->lock);
+    return count;
+}
+
+
+static int memory_checksum(plugin_handle plugin_data, const char *url, const char *check_type,
+    char *checksum_buffer, size_t buffer_length, off_t start_offset, size_t data_length, GError **err)
+{
+    MemoryStorage *storage = (MemoryStorage*)plugin_data;
+    const std::string *data = &storage->destination;
+    if (strcmp(url, "memory://source") == 0) {
+        data = &storage->source;
+        storage->source_checksum_calls += 1;
+    }
+    else {
+        storage->destination_checksum_calls += 1;
+    }
+
+    gfal_checksum_stream_t stream = gfal_checksum_stream_new(check_type);
+    if (stream == NULL) {
+        gfal2_set_error(err, g_quark_from_static_string("MEMORY"), ENOSYS, __func__, "Not supported");
+        return -1;
+    }
+    gfal_checksum_stream_update(stream, data->data(), data->size());
+    gfal_checksum_stream_final(stream, checksum_buffer, buffer_length);
+    gfal_checksum_stream_free(stream);
+    return 0;
+}
+
+
+static int memory_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    delete (MemoryFile*)gfal_file_handle_get_fdesc(fd);
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class LocalCopyTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    MemoryStorage storage;
+    // register pread and pwrite
+    bool positional;
+
+    LocalCopyTest(): positional(true) {
+    }
+
+    void SetUp() {
+        context = gfal2_context_new(NULL);
+        ASSERT_TRUE(context != NULL);
+        params = gfalt_params_handle_new(NULL);
+        gfalt_set_replace_existing_file(params, TRUE, NULL);
+
+        storage.source.clear();
+        for (size_t i = 0; i < 1000003; ++i) {
+            storage.source.push_back((char)(i * 7 + i / 251));
+        }
+        storage.destination.clear();
+        pthread_mutex_init(&storage.lock, NULL);
+        storage.max_read = 100000;
+        storage.read_delay = 0;
+        storage.fail_read_at = storage.fail_write_at = (size_t)-1;
+        storage.read_total = storage.written_total = storage.max_pending = 0;
+        storage.pread_calls = 0;
+        storage.source_checksum_calls = storage.destination_checksum_calls = 0;
+        storage.operation = NULL;
+        storage.reads_outside_operation = 0;
+
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.plugin_data = &storage;
+        plugin.getName = memory_get_name;
+        plugin.check_plugin_url = memory_check_url;
+        plugin.statG = memory_stat;
+        plugin.openG = memory_open;
+        plugin.readG = memory_read;
+        plugin.writeG = memory_write;
+        plugin.closeG = memory_close;
+        plugin.checksum_calcG = memory_checksum;
+        if (positional) {
+            plugin.preadG = memory_pread;
+            plugin.pwriteG = memory_pwrite;
+        }
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, NULL));
+
+        gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, "COPY_BUFFERSIZE", 65536, NULL);
+    }
+
+    void TearDown() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+        pthread_mutex_destroy(&storage.lock);
+    }
+
+    int copy(GError **err) {
+        return gfalt_copy_file(context, params, "memory://source", "memory://destination", err);
+    }
+
+    // copy on behalf of an operation, which the threads reading the source must have attached
+    void copy_attached() {
+        GError *err = NULL;
+        storage.operation = gfal2_operation_new(context);
+        gfal_operation_t previous = gfal2_operation_attach(storage.operation);
+        EXPECT_EQ(0, copy(&err));
+        EXPECT_TRUE(err == NULL);
+        g_clear_error(&err);
+        gfal2_operation_attach(previous);
+        gfal2_operation_free(storage.operation);
+        EXPECT_TRUE(storage.source == storage.destination);
+        EXPECT_GT(storage.read_total, 0);
+        EXPECT_EQ(0, storage.reads_outside_operation);
+    }
+};
+
+
+TEST_F(LocalCopyTest, Serial)
+{
+    GError *err = NULL;
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    ASSERT_TRUE(storage.source == storage.destination);
+    EXPECT_LE(storage.max_pending, storage.max_read);
+}
+
+
+TEST_F(LocalCopyTest, Pipelined)
+{
+    GError *err = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, TRUE, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE_BUFFERS, 3, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    ASSERT_TRUE(storage.source == storage.destination);
+    // never more than the ring ahead of the destination
+    EXPECT_LE(storage.max_pending, 3 * 65536);
+}
+
+
+TEST_F(LocalCopyTest, PipelinedOperation)
+{
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, TRUE, NULL);
+    copy_attached();
+}
+
+
+TEST_F(LocalCopyTest, PipelinedReadError)
+{
+    GError *err = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, TRUE, NULL);
+    storage.fail_read_at = 500000;
+
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(EIO, err->code);
+    g_error_free(err);
+    // the buffers read before the failure are written
+    EXPECT_EQ(8 * 65536, storage.destination.size());
+}
+
+
+TEST_F(LocalCopyTest, PipelinedWriteError)
+{
+    GError *err = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, TRUE, NULL);
+    storage.fail_write_at = 300000;
+
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(ENOSPC, err->code);
+    g_error_free(err);
+    EXPECT_LT(storage.read_total, storage.source.size());
+}
+
+
+TEST_F(LocalCopyTest, PipelinedTimeout)
+{
+    GError *err = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, TRUE, NULL);
+    gfalt_set_timeout(params, 1, NULL);
+    storage.max_read = 1000;
+    storage.read_delay = 100000;
+
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(ETIMEDOUT, err->code);
+    g_error_free(err);
+}
+
+
+TEST_F(LocalCopyTest, Parallel)
+{
+    GError *err = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_STREAMS, 4, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, 150000, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    ASSERT_TRUE(storage.source == storage.destination);
+    EXPECT_GT(storage.pread_calls, 0);
+}
+
+
+TEST_F(LocalCopyTest, ParallelOperation)
+{
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_STREAMS, 4, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, 150000, NULL);
+    copy_attached();
+    EXPECT_GT(storage.pread_calls, 0);
+}
+
+
+TEST_F(LocalCopyTest, ParallelSmallFile)
+{
+    GError *err = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_STREAMS, 4, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, 2000000, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(storage.source == storage.destination);
+    // a single range, so the serial copy
+    EXPECT_EQ(0, storage.pread_calls);
+}
+
+
+TEST_F(LocalCopyTest, ParallelWriteError)
+{
+    GError *err = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_STREAMS, 4, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, 150000, NULL);
+    storage.fail_write_at = 700000;
+
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(ENOSPC, err->code);
+    g_error_free(err);
+}
+
+
+static void checksum_event_callback(const gfalt_event_t e, gpointer user_data)
+{
+    std::string *description = (std::string*)user_data;
+    if (e->side == GFAL_EVENT_SOURCE && e->stage == GFAL_EVENT_CHECKSUM_EXIT)
+        *description = e->description;
+}
+
+
+TEST_F(LocalCopyTest, ChecksumOnTheFly)
+{
+    GError *err = NULL;
+    std::string event;
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, "ADLER32", NULL, NULL);
+    gfalt_add_event_callback(params, checksum_event_callback, &event, NULL, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    ASSERT_TRUE(storage.source == storage.destination);
+    // only the destination is asked
+    EXPECT_EQ(0, storage.source_checksum_calls);
+    EXPECT_EQ(1, storage.destination_checksum_calls);
+
+    char expected[64];
+    memory_checksum(&storage, "memory://source", "ADLER32", expected, sizeof(expected), 0, 0, NULL);
+    EXPECT_EQ(std::string("ADLER32:") + expected, event);
+}
+
+
+TEST_F(LocalCopyTest, ChecksumOnTheFlyPipelined)
+{
+    GError *err = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PIPELINE, TRUE, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_STREAMS, 4, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, 150000, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, "MD5", NULL, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    ASSERT_TRUE(storage.source == storage.destination);
+    EXPECT_EQ(0, storage.source_checksum_calls);
+    // the ranges can not be hashed in order
+    EXPECT_EQ(0, storage.pread_calls);
+}
+
+
+TEST_F(LocalCopyTest, ChecksumOnTheFlyUserMismatch)
+{
+    GError *err = NULL;
+    gfalt_set_checksum(params, GFALT_CHECKSUM_SOURCE, "ADLER32", "12345678", NULL);
+    storage.destination = "previous";
+
+    ASSERT_EQ(-1, copy(&err));
+    ASSERT_TRUE(err != NULL);
+    EXPECT_EQ(EIO, err->code);
+    g_error_free(err);
+    // the source is checked before anything is written
+    EXPECT_EQ(1, storage.source_checksum_calls);
+    EXPECT_EQ(0, storage.written_total);
+    EXPECT_EQ("previous", storage.destination);
+}
+
+
+TEST_F(LocalCopyTest, ChecksumOnTheFlyDisabled)
+{
+    GError *err = NULL;
+    gfal2_set_opt_boolean(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_CHECKSUM_ON_THE_FLY, FALSE, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, "CRC32", NULL, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    EXPECT_EQ(1, storage.source_checksum_calls);
+    EXPECT_EQ(1, storage.destination_checksum_calls);
+}
+
+
+TEST(ChecksumStream, KnownValues)
+{
+    char buffer[64];
+    gfal_checksum_stream_t stream;
+
+    stream = gfal_checksum_stream_new("adler32");
+    gfal_checksum_stream_update(stream, "Wiki", 4);
+    gfal_checksum_stream_update(stream, "pedia", 5);
+    ASSERT_EQ(0, gfal_checksum_stream_final(stream, buffer, sizeof(buffer)));
+    EXPECT_STREQ("11e60398", buffer);
+    gfal_checksum_stream_free(stream);
+
+    stream = gfal_checksum_stream_new("CRC32");
+    gfal_checksum_stream_update(stream, "The quick brown fox jumps over the lazy dog", 43);
+    ASSERT_EQ(0, gfal_checksum_stream_final(stream, buffer, sizeof(buffer)));
+    EXPECT_STREQ("1095738169", buffer);
+    gfal_checksum_stream_free(stream);
+
+    stream = gfal_checksum_stream_new("md5");
+    ASSERT_EQ(0, gfal_checksum_stream_final(stream, buffer, sizeof(buffer)));
+    EXPECT_STREQ("d41d8cd98f00b204e9800998ecf8427e", buffer);
+    EXPECT_EQ(-1, gfal_checksum_stream_final(stream, buffer, 10));
+    gfal_checksum_stream_free(stream);
+
+    EXPECT_TRUE(gfal_checksum_stream_new("sha512") == NULL);
+}
+
+
+class LocalCopyNoPositionalTest: public LocalCopyTest {
+protected:
+    LocalCopyNoPositionalTest() {
+        positional = false;
+    }
+};
+
+
+TEST_F(LocalCopyNoPositionalTest, ParallelFallback)
+{
+    GError *err = NULL;
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_STREAMS, 4, NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, CORE_CONFIG_COPY_PARALLEL_CHUNK_SIZE, 150000, NULL);
+
+    ASSERT_EQ(0, copy(&err));
+    ASSERT_TRUE(err == NULL);
+    ASSERT_TRUE(storage.source == storage.destination);
+    EXPECT_EQ(0, storage.pread_calls);
+}
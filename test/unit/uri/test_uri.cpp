@@ -229,3 +229,38 @@ TEST(gfalURI, special)
 
     gfal2_free_uri(parsed);
 }
+
+
+TEST(gfalURI, view)
+{
+    const char *URI = "gsiftp://user@host.cern.ch:2811/path?a=b#frag";
+    GError* tmp_err = NULL;
+    gfal2_uri_view parsed;
+
+    ASSERT_EQ(0, gfal2_parse_uri_view(URI, &parsed, &tmp_err));
+    ASSERT_EQ(NULL, tmp_err);
+
+    ASSERT_TRUE(gfal2_uri_view_equal(&parsed, &parsed.scheme, "gsiftp"));
+    ASSERT_TRUE(gfal2_uri_view_equal(&parsed, &parsed.userinfo, "user"));
+    ASSERT_TRUE(gfal2_uri_view_equal(&parsed, &parsed.host, "host.cern.ch"));
+    ASSERT_FALSE(gfal2_uri_view_equal(&parsed, &parsed.host, "host"));
+    ASSERT_EQ(2811, parsed.port);
+    ASSERT_EQ(31, parsed.path.offset);
+    ASSERT_EQ(5, parsed.path.length);
+    ASSERT_TRUE(gfal2_uri_view_equal(&parsed, &parsed.query, "a=b"));
+    ASSERT_TRUE(gfal2_uri_view_equal(&parsed, &parsed.fragment, "frag"));
+
+    char buffer[8];
+    ASSERT_EQ(5, gfal2_uri_view_copy(&parsed, &parsed.path, buffer, sizeof(buffer)));
+    ASSERT_STREQ("/path", buffer);
+    ASSERT_EQ(-1, gfal2_uri_view_copy(&parsed, &parsed.host, buffer, sizeof(buffer)));
+
+    // Undefined versus empty
+    ASSERT_EQ(0, gfal2_parse_uri_view("file:/path", &parsed, &tmp_err));
+    ASSERT_EQ(-1, parsed.host.offset);
+    ASSERT_FALSE(gfal2_uri_view_equal(&parsed, &parsed.host, ""));
+    ASSERT_EQ(NULL, gfal2_uri_view_dup(&parsed, &parsed.host));
+
+    ASSERT_EQ(0, gfal2_parse_uri_view("file:///path", &parsed, &tmp_err));
+    ASSERT_TRUE(gfal2_uri_view_equal(&parsed, &parsed.host, ""));
+}